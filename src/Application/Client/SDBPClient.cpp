@@ -11,6 +11,7 @@
 #include "System/Threading/ThreadPool.h"
 #include "System/Threading/LockGuard.h"
 #include "Framework/Replication/PaxosLease/PaxosLease.h"
+#include "Framework/Messaging/MessageUtil.h"
 #include "Application/Common/ClientRequest.h"
 #include "Application/Common/ClientResponse.h"
 
@@ -869,6 +870,68 @@ int Client::Count(
     return result->GetCommandStatus();
 }
 
+int Client::MultiGet(uint64_t tableID, unsigned numKeys, const ReadBuffer* keys)
+{
+    Request*    req;
+    unsigned    i;
+
+    if (numKeys == 0)
+        return SDBP_API_ERROR;
+
+    for (i = 0; i < numKeys; i++)
+    {
+        if (keys[i].GetLength() == 0)
+            return SDBP_API_ERROR;
+    }
+
+    VALIDATE_CONTROLLERS();
+    CLIENT_MUTEX_GUARD_DECLARE();
+
+    req = new Request;
+    req->MultiGet(NextCommandID(), configState.paxosID, tableID);
+    for (i = 0; i < numKeys; i++)
+        req->AppendMultiKey((ReadBuffer&) keys[i]);
+
+    AppendDataRequest(req);
+
+    CLIENT_MUTEX_GUARD_UNLOCK();
+    EventLoop();
+    CLIENT_MUTEX_GUARD_LOCK();
+
+    return GetMultiStatus();
+}
+
+int Client::MultiSet(uint64_t tableID, unsigned numKeys, const ReadBuffer* keys, const ReadBuffer* values)
+{
+    Request*    req;
+    unsigned    i;
+
+    if (numKeys == 0 || InTransaction())
+        return SDBP_API_ERROR;
+
+    for (i = 0; i < numKeys; i++)
+    {
+        if (keys[i].GetLength() == 0)
+            return SDBP_API_ERROR;
+    }
+
+    VALIDATE_CONTROLLERS();
+    CLIENT_MUTEX_GUARD_DECLARE();
+
+    req = new Request;
+    req->MultiSet(NextCommandID(), configState.paxosID, tableID);
+    for (i = 0; i < numKeys; i++)
+        req->AppendMultiKeyValue((ReadBuffer&) keys[i], (ReadBuffer&) values[i]);
+
+    AppendDataRequest(req);
+
+    CLIENT_MUTEX_GUARD_UNLOCK();
+    EventLoop();
+    CLIENT_MUTEX_GUARD_LOCK();
+
+    return GetMultiStatus();
+}
+
 uint64_t Client::GetQuorumPaxosID(uint64_t quorumID)
 {
     uint64_t paxosID;
@@ -1354,6 +1417,21 @@ void Client::SetConfigState(ConfigState& configState_)
 {
     configState = configState_;
 
+    OnConfigStateChanged();
+}
+
+void Client::SetConfigStateDelta(ReadBuffer delta, ConfigState& configState_, bool reconfigure)
+{
+    // fall back to copying the controller's state if our copy fell behind
+    if (!configState.ReadDelta(delta))
+        configState = configState_;
+
+    if (reconfigure)
+        OnConfigStateChanged();
+}
+
+void Client::OnConfigStateChanged()
+{
     Log_Debug("configState.paxosID = %U", configState.paxosID);
     // we know the state of the system, so we can start sending requests
     if (configState.paxosID != 0)
@@ -1398,7 +1476,8 @@ void Client::ReassignRequest(Request* req)
     {
         // find quorum by key
         key.Wrap(req->key);
-        if (!GetQuorumID(req->tableID, key, quorumID))
+        if (!GetQuorumID(req->tableID, key, quorumID) ||
+         (req->IsMulti() && !SplitMultiRequest(req, quorumID)))
         {
             ClientResponse  response;
 
@@ -1422,6 +1501,107 @@ void Client::ReassignRequest(Request* req)
         AddRequestToQuorum(req);
 }
 
+bool Client::SplitMultiRequest(Request* req, uint64_t quorumID)
+{
+    bool            split;
+    uint64_t        i;
+    uint64_t        keyQuorumID;
+    uint64_t        ownCount;
+    ReadBuffer      items;
+    ReadBuffer      key;
+    ReadBuffer      value;
+    Buffer          own;
+    Request*        part;
+    RequestList     parts;
+
+    // usually all keys are in the quorum of the first key
+    items.Wrap(req->value);
+    MessageReader   check(items);
+    split = false;
+    for (i = 0; i < req->count; i++)
+    {
+        check.ReadData(key);
+        if (req->type == CLIENTREQUEST_MULTI_SET)
+            check.ReadData(value);
+        if (!GetQuorumID(req->tableID, key, keyQuorumID))
+            return false;
+        if (keyQuorumID != quorumID)
+            split = true;
+    }
+
+    if (!split)
+        return true;
+
+    // move the keys of other quorums to new requests, one per quorum
+    MessageReader   reader(items);
+    ownCount = 0;
+    for (i = 0; i < req->count; i++)
+    {
+        reader.ReadData(key);
+        if (req->type == CLIENTREQUEST_MULTI_SET)
+            reader.ReadData(value);
+        GetQuorumID(req->tableID, key, keyQuorumID);
+
+        if (keyQuorumID == quorumID)
+        {
+            MessageUtil::WriteData(own, key);
+            if (req->type == CLIENTREQUEST_MULTI_SET)
+                MessageUtil::WriteData(own, value);
+            ownCount++;
+            continue;
+        }
+
+        FOREACH (part, parts)
+        {
+            if (part->quorumID == keyQuorumID)
+                break;
+        }
+
+        if (part == NULL)
+        {
+            part = new Request;
+            if (req->type == CLIENTREQUEST_MULTI_SET)
+                part->MultiSet(NextCommandID(), req->configPaxosID, req->tableID);
+            else
+                part->MultiGet(NextCommandID(), req->configPaxosID, req->tableID);
+            part->quorumID = keyQuorumID;
+            parts.Append(part);
+        }
+
+        if (req->type == CLIENTREQUEST_MULTI_SET)
+            part->AppendMultiKeyValue(key, value);
+        else
+            part->AppendMultiKey(key);
+    }
+
+    // the first key stays in this request
+    req->value.Write(own);
+    req->count = ownCount;
+
+    FOREACH_FIRST (part, parts)
+    {
+        parts.Remove(part);
+        result->AppendRequest(part);
+        ReassignRequest(part);
+    }
+
+    return true;
+}
+
+int Client::GetMultiStatus()
+{
+    Request*    it;
+
+    // the request may have been split by quorums, it fails if any of its parts failed
+    FOREACH (it, result->requests)
+    {
+        if (it->status != SDBP_SUCCESS)
+            return it->status;
+    }
+
+    return result->GetTransportStatus();
+}
+
 void Client::AssignRequestsToQuorums()
 {
     Request*        request;
@@ -114,6 +114,11 @@ public:
     int                     Count(uint64_t tableID, const ReadBuffer& startKey, const ReadBuffer& endKey, 
                              const ReadBuffer& prefix, bool forwardDirection);    
 
+    // Multi-key requests are sent as one request per quorum, they bypass batching
+    int                     MultiGet(uint64_t tableID, unsigned numKeys, const ReadBuffer* keys);
+    int                     MultiSet(uint64_t tableID, unsigned numKeys, const ReadBuffer* keys,
+                             const ReadBuffer* values);
+
     int                     Filter(uint64_t tableID, const ReadBuffer& startKey, const ReadBuffer& endKey,
                              const ReadBuffer& prefix, unsigned count, uint64_t& commandID);
     int                     Receive(uint64_t commandID);
@@ -160,11 +165,16 @@ private:
     void                    OnGlobalTimeout();
     void                    OnMasterTimeout();
     void                    SetConfigState(ConfigState& configState);
+    void                    SetConfigStateDelta(ReadBuffer delta, ConfigState& configState,
+                             bool reconfigure);
+    void                    OnConfigStateChanged();
 
     void                    AppendDataRequest(Request* req);
     void                    ReassignRequest(Request* req);
     void                    AssignRequestsToQuorums();
     bool                    GetQuorumID(uint64_t tableID, ReadBuffer& key, uint64_t& quorumID);
+    bool                    SplitMultiRequest(Request* req, uint64_t quorumID);
+    int                     GetMultiStatus();
     void                    AddRequestToQuorum(Request* req, bool end = true);
     void                    SendQuorumRequest(ShardConnection* conn, uint64_t quorumID);
     void                    SendQuorumRequests();
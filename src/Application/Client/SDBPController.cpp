@@ -200,6 +200,37 @@ void Controller::OnNoService(ControllerConnection* conn)
     OnDisconnected(conn);
 }
 
+static void GetConfigQuorumPrimaries(ConfigState* configState, List<uint64_t>& primaryIDs)
+{
+    ConfigQuorum*   quorum;
+    uint64_t        primaryID;
+
+    FOREACH (quorum, configState->quorums)
+    {
+        primaryID = quorum->hasPrimary ? quorum->primaryID : 0;
+        primaryIDs.Append(primaryID);
+    }
+}
+
+static bool IsConfigQuorumPrimaryChanged(ConfigState* configState, List<uint64_t>& primaryIDs)
+{
+    ConfigQuorum*   quorum;
+    uint64_t*       primaryID;
+
+    if (configState->quorums.GetLength() != primaryIDs.GetLength())
+        return true;
+
+    for (quorum = configState->quorums.First(), primaryID = primaryIDs.First();
+      quorum && primaryID;
+      quorum = configState->quorums.Next(quorum), primaryID = primaryIDs.Next(primaryID))
+    {
+        if ((quorum->hasPrimary ? quorum->primaryID : 0) != *primaryID)
+            return true;
+    }
+
+    return false;
+}
+
 bool IsConfigQuorumPrimaryChanged(ConfigState* configState, ConfigState* oldConfigState)
 {
     ConfigQuorum*   quorum;
@@ -247,6 +278,64 @@ void Controller::SetConfigState(ControllerConnection* conn, ConfigState* configS
     }
 }
 
+bool Controller::SetConfigStateDelta(ControllerConnection* conn, ReadBuffer& delta)
+{
+    uint64_t        nodeID;
+    uint64_t        baseVersion;
+    uint64_t        version;
+    uint64_t        paxosID;
+    bool            updateClients;
+    ConfigState     newConfigState;
+    List<uint64_t>  primaryIDs;
+    ReadBuffer      buffer;
+    Client*         client;
+
+    if (!ConfigState::ReadDeltaVersions(delta, baseVersion, version))
+        return false;
+
+    nodeID = conn->GetNodeID();
+
+    // a snapshot replaces the whole state
+    if (baseVersion == 0)
+    {
+        if (!newConfigState.ReadDelta(delta))
+            return false;
+        SetConfigState(conn, &newConfigState);
+        return true;
+    }
+
+    MutexGuard  mutexGuard(mutex);
+
+    if (!configState.hasMaster || configState.masterID != nodeID)
+        return false;
+
+    paxosID = configState.paxosID;
+    GetConfigQuorumPrimaries(&configState, primaryIDs);
+    buffer = delta;
+    if (!configState.ReadDelta(buffer))
+        return false;
+
+    // same optimization as in SetConfigState()
+    updateClients = false;
+    if (configState.paxosID > paxosID)
+        updateClients = true;
+    if (!updateClients && IsConfigQuorumPrimaryChanged(&configState, primaryIDs))
+        updateClients = true;
+
+    // the clients apply the delta to their own copy, so that they don't fall
+    // behind even if they are not reconfigured
+    FOREACH (client, clients)
+    {
+        client->Lock();
+        client->SetConfigStateDelta(delta, configState, updateClients);
+        if (updateClients)
+            client->TryWake();
+        client->Unlock();
+    }
+
+    return true;
+}
+
 void Controller::OnConfigStateChanged()
 {
     Client*     client;
@@ -47,6 +47,7 @@ public:
     void                    OnRequestResponse(Request* request, ClientResponse* response);
     void                    OnNoService(ControllerConnection* conn);
     void                    SetConfigState(ControllerConnection* conn, ConfigState* configState);
+    bool                    SetConfigStateDelta(ControllerConnection* conn, ReadBuffer& delta);
 
     TreeNode                treeNode;
 
@@ -28,6 +28,7 @@ ControllerConnection::ControllerConnection(Controller* controller_, uint64_t nod
     nodeID = nodeID_;
     endpoint = endpoint_;
     getConfigStateTime = 0;
+    acceptsConfigStateDelta = false;
     getConfigStateTimeout.SetDelay(GETCONFIGSTATE_TIMEOUT);
     getConfigStateTimeout.SetCallable(MFUNC(ControllerConnection, OnGetConfigStateTimeout));
     SetPriority(true);
@@ -125,10 +126,12 @@ bool ControllerConnection::OnMessage(ReadBuffer& rbuf)
     if (sw.Elapsed() > 500)
         Log_Debug("ControllerConnection::OnMessage took %U msecs", sw.Elapsed());
         
-    // we don't care about Hello messages
+    // the config state is requested once the protocol version of the controller is known
     if (resp->type == CLIENTRESPONSE_HELLO)
     {
+        acceptsConfigStateDelta = (resp->number >= SDBP_PROTOCOL_VERSION_DELTA);
         delete resp;
+        SendGetConfigState();
         return false;
     }
     
@@ -152,7 +155,9 @@ void ControllerConnection::OnWrite()
 void ControllerConnection::OnConnect()
 {
     MessageConnection::OnConnect();
-    SendGetConfigState();
+    acceptsConfigStateDelta = false;
+    // in case the HELLO message does not arrive
+    EventLoop::Reset(&getConfigStateTimeout);
 
     controller->OnConnected(this);
 }
@@ -198,6 +203,8 @@ bool ControllerConnection::ProcessResponse(ClientResponse* resp)
 {
     if (resp->type == CLIENTRESPONSE_CONFIG_STATE)
         return ProcessGetConfigState(resp);
+    if (resp->type == CLIENTRESPONSE_CONFIG_STATE_DELTA)
+        return ProcessConfigStateDelta(resp);
 
     return ProcessCommandResponse(resp);
 }
@@ -214,6 +221,20 @@ bool ControllerConnection::ProcessGetConfigState(ClientResponse* resp)
     return false;
 }
 
+bool ControllerConnection::ProcessConfigStateDelta(ClientResponse* resp)
+{
+    EventLoop::Remove(&getConfigStateTimeout);
+
+    // the delta does not follow our version, ask for a snapshot
+    if (!controller->SetConfigStateDelta(this, resp->value))
+    {
+        Log_Debug("Cannot apply config state delta, requesting snapshot");
+        SendGetConfigState();
+    }
+
+    return false;
+}
+
 bool ControllerConnection::ProcessCommandResponse(ClientResponse* resp)
 {
     Log_Trace();
@@ -266,7 +287,7 @@ void ControllerConnection::SendGetConfigState()
     ASSERT(state == CONNECTED);
 
     request = new Request;
-    request->GetConfigState(controller->NextCommandID());
+    request->GetConfigState(controller->NextCommandID(), 0, acceptsConfigStateDelta);
         
     // send request but don't append to the request queue
     msg.request = request;        
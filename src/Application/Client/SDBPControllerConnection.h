@@ -46,6 +46,7 @@ private:
 
     bool            ProcessResponse(ClientResponse* resp);
     bool            ProcessGetConfigState(ClientResponse* resp);
+    bool            ProcessConfigStateDelta(ClientResponse* resp);
     bool            ProcessCommandResponse(ClientResponse* resp);
     Request*        RemoveRequest(uint64_t commandID);
     void            Connect();
@@ -58,6 +59,7 @@ private:
     uint64_t        getConfigStateTime;
     Countdown       getConfigStateTimeout;
     bool            getConfigStateSent;
+    bool            acceptsConfigStateDelta;
     RequestList     requests;
 };
 
@@ -1,5 +1,6 @@
 #include "SDBPPooledShardConnection.h"
 #include "SDBPShardConnection.h"
+#include "Application/SDBP/SDBPResponseMessage.h"
 #include "System/Containers/HashMap.h"
 #include "System/Threading/Mutex.h"
 #include "System/Events/EventLoop.h"
@@ -255,10 +256,11 @@ bool PooledShardConnection::SendRequest(SDBPRequestMessage& msg)
 {
     ASSERT(state == CONNECTED);
 
+    msg.binary = binary;
     Write(msg);
 
     // buffer is saturated
-    if (GetWriteBuffer().GetLength() >= MESSAGING_BUFFER_THRESHOLD)
+    if (GetWriteLength() >= MESSAGING_BUFFER_THRESHOLD)
         return false;
     
     return true;
@@ -266,6 +268,9 @@ bool PooledShardConnection::SendRequest(SDBPRequestMessage& msg)
 
 bool PooledShardConnection::OnMessage(ReadBuffer& msg)
 {
+    if (msg.GetLength() > 0 && msg.GetCharAt(0) == CLIENTRESPONSE_HELLO)
+        OnHello(msg);
+
     if (conn == NULL)
     {
         Log_Debug("message: %R", &msg);
@@ -284,6 +289,8 @@ void PooledShardConnection::OnWrite()
 
 void PooledShardConnection::OnConnect()
 {
+    // text until the server's HELLO says otherwise
+    binary = false;
     MessageConnection::OnConnect();
 
     if (conn != NULL)
@@ -312,6 +319,19 @@ void PooledShardConnection::OnClose()
     }
 }
 
+void PooledShardConnection::OnHello(ReadBuffer& msg)
+{
+    ClientResponse      response;
+    SDBPResponseMessage hello;
+
+    hello.response = &response;
+    if (!hello.Read(msg))
+        return;
+
+    binary = (response.number >= SDBP_PROTOCOL_VERSION_BINARY);
+    Log_Debug("Shard connection %B: SDBP version %U", &name, response.number);
+}
+
 PooledShardConnection::PooledShardConnection(Endpoint& endpoint_)
 {
     autoFlush = false;
@@ -319,6 +339,7 @@ PooledShardConnection::PooledShardConnection(Endpoint& endpoint_)
     prev = next = this;
     conn = NULL;
     lastUsed = 0;
+    binary = false;
     name.Write(endpoint.ToString());
     
     ASSERT(name.GetLength() > 0);
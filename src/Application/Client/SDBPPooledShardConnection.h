@@ -53,10 +53,13 @@ public:
 private:
     PooledShardConnection(Endpoint& endpoint);
 
+    void                                OnHello(ReadBuffer& msg);
+
     ShardConnection*                    conn;
     Buffer                              name;
     Endpoint                            endpoint;
     uint64_t                            lastUsed;
+    bool                                binary;     // the server speaks binary SDBP
 };
 
 };  // namespace
@@ -48,6 +48,9 @@ void Result::Begin()
     requestCursor = requests.First();
     responseCursor = requestCursor ? requestCursor->responses.First() : NULL;
     responsePos = 0;
+
+    if (requestCursor && requestCursor->type == CLIENTREQUEST_MULTI_GET)
+        SkipEmptyResponses();
 }
 
 void Result::Next()
@@ -58,24 +61,36 @@ void Result::Next()
     if (requestCursor->IsList())
     {
         responsePos++;
+        SkipEmptyResponses();
+        return;
+    }
 
-        // skip fragments that contain zero keys
-        while (responsePos >= (*responseCursor)->numKeys)
-        {
+    requestCursor = requests.Next(requestCursor);
+}
+
+void Result::SkipEmptyResponses()
+{
+    // skip fragments that contain zero keys, a split MULTI_GET continues with the next request
+    while (responseCursor == NULL || responsePos >= (*responseCursor)->numKeys)
+    {
+        if (responseCursor != NULL)
             responseCursor = requestCursor->responses.Next(responseCursor);
-            responsePos = 0;
-            if (responseCursor == NULL)
-            {
-                // reached the end
-                requestCursor = NULL;
-                break;
-            }
+        responsePos = 0;
+        if (responseCursor != NULL)
+            continue;
+
+        if (requestCursor->type != CLIENTREQUEST_MULTI_GET)
+        {
+            // reached the end
+            requestCursor = NULL;
+            break;
         }
 
-        return;
+        requestCursor = requests.Next(requestCursor);
+        if (requestCursor == NULL)
+            break;
+        responseCursor = requestCursor->responses.First();
     }
-
-    requestCursor = requests.Next(requestCursor);
 }
 
 bool Result::IsEnd()
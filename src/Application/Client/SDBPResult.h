@@ -65,6 +65,8 @@ public:
     RequestMap          requests;
 
 private:
+    void                SkipEmptyResponses();
+
     int                 transportStatus;
     int                 timeoutStatus;
     int                 connectivityStatus;
@@ -1,10 +1,11 @@
 #include "CatchupMessage.h"
 
-bool CatchupMessage::CatchupRequest(uint64_t nodeID_, uint64_t quorumID_)
+bool CatchupMessage::CatchupRequest(uint64_t nodeID_, uint64_t quorumID_, bool useFileChunks_)
 {
     type = CATCHUPMESSAGE_REQUEST;
     nodeID = nodeID_;
     quorumID = quorumID_;
+    useFileChunks = useFileChunks_;
     return true;
 }
 
@@ -32,6 +33,41 @@ bool CatchupMessage::Delete(uint64_t shardID_, ReadBuffer key_)
     return true;
 }
 
+bool CatchupMessage::BeginFileChunk(uint64_t shardID_, uint64_t chunkID_, uint64_t size_)
+{
+    type = CATCHUPMESSAGE_BEGIN_FILE_CHUNK;
+    shardID = shardID_;
+    chunkID = chunkID_;
+    size = size_;
+    return true;
+}
+
+bool CatchupMessage::FileChunkData(uint64_t shardID_, uint64_t offset_, ReadBuffer data)
+{
+    type = CATCHUPMESSAGE_FILE_CHUNK_DATA;
+    shardID = shardID_;
+    offset = offset_;
+    value = data;
+    checksum = value.GetChecksum();
+    return true;
+}
+
+bool CatchupMessage::EndFileChunk(uint64_t shardID_, uint64_t chunkID_)
+{
+    type = CATCHUPMESSAGE_END_FILE_CHUNK;
+    shardID = shardID_;
+    chunkID = chunkID_;
+    return true;
+}
+
+bool CatchupMessage::UseFileChunk(uint64_t shardID_, uint64_t chunkID_)
+{
+    type = CATCHUPMESSAGE_USE_FILE_CHUNK;
+    shardID = shardID_;
+    chunkID = chunkID_;
+    return true;
+}
+
 bool CatchupMessage::Commit(uint64_t paxosID_)
 {
     type = CATCHUPMESSAGE_COMMIT;
@@ -58,6 +94,13 @@ bool CatchupMessage::Read(ReadBuffer& buffer)
         case CATCHUPMESSAGE_REQUEST:
             read = buffer.Readf("%c:%c:%U:%U",
              &proto, &type, &nodeID, &quorumID);
+            useFileChunks = false;
+            // nodes that can receive chunk files say so at the end of the request
+            if (read > 0 && read < (signed) buffer.GetLength())
+            {
+                buffer.Advance(read);
+                read = buffer.Readf(":%b", &useFileChunks);
+            }
             break;
         case CATCHUPMESSAGE_BEGIN_SHARD:
             read = buffer.Readf("%c:%c:%U",
@@ -71,6 +114,22 @@ bool CatchupMessage::Read(ReadBuffer& buffer)
             read = buffer.Readf("%c:%c:%U:%#R",
              &proto, &type, &shardID, &key);
             break;
+        case CATCHUPMESSAGE_BEGIN_FILE_CHUNK:
+            read = buffer.Readf("%c:%c:%U:%U:%U",
+             &proto, &type, &shardID, &chunkID, &size);
+            break;
+        case CATCHUPMESSAGE_FILE_CHUNK_DATA:
+            read = buffer.Readf("%c:%c:%U:%U:%u:%#R",
+             &proto, &type, &shardID, &offset, &checksum, &value);
+            break;
+        case CATCHUPMESSAGE_END_FILE_CHUNK:
+            read = buffer.Readf("%c:%c:%U:%U",
+             &proto, &type, &shardID, &chunkID);
+            break;
+        case CATCHUPMESSAGE_USE_FILE_CHUNK:
+            read = buffer.Readf("%c:%c:%U:%U",
+             &proto, &type, &shardID, &chunkID);
+            break;
         case CATCHUPMESSAGE_COMMIT:
             read = buffer.Readf("%c:%c:%U",
              &proto, &type, &paxosID);
@@ -95,6 +154,8 @@ bool CatchupMessage::Write(Buffer& buffer)
         case CATCHUPMESSAGE_REQUEST:
             buffer.Writef("%c:%c:%U:%U",
              proto, type, nodeID, quorumID);
+            if (useFileChunks)
+                buffer.Appendf(":%b", useFileChunks);
             return true;
         case CATCHUPMESSAGE_BEGIN_SHARD:
             buffer.Writef("%c:%c:%U",
@@ -108,6 +169,22 @@ bool CatchupMessage::Write(Buffer& buffer)
             buffer.Writef("%c:%c:%U:%#R",
              proto, type, shardID, &key);
             return true;
+        case CATCHUPMESSAGE_BEGIN_FILE_CHUNK:
+            buffer.Writef("%c:%c:%U:%U:%U",
+             proto, type, shardID, chunkID, size);
+            return true;
+        case CATCHUPMESSAGE_FILE_CHUNK_DATA:
+            buffer.Writef("%c:%c:%U:%U:%u:%#R",
+             proto, type, shardID, offset, checksum, &value);
+            return true;
+        case CATCHUPMESSAGE_END_FILE_CHUNK:
+            buffer.Writef("%c:%c:%U:%U",
+             proto, type, shardID, chunkID);
+            return true;
+        case CATCHUPMESSAGE_USE_FILE_CHUNK:
+            buffer.Writef("%c:%c:%U:%U",
+             proto, type, shardID, chunkID);
+            return true;
         case CATCHUPMESSAGE_COMMIT:
             buffer.Writef("%c:%c:%U",
              proto, type, paxosID);
@@ -11,6 +11,13 @@
 #define CATCHUPMESSAGE_DELETE          'D'
 #define CATCHUPMESSAGE_COMMIT          'C'
 #define CATCHUPMESSAGE_ABORT           'A'
+
+// chunk files sent byte-for-byte, USE_FILE_CHUNK adds a chunk already sent for another shard
+#define CATCHUPMESSAGE_BEGIN_FILE_CHUNK 'F'
+#define CATCHUPMESSAGE_FILE_CHUNK_DATA  'W'
+#define CATCHUPMESSAGE_END_FILE_CHUNK   'E'
+#define CATCHUPMESSAGE_USE_FILE_CHUNK   'U'
+
 /*
 ===============================================================================================
 
@@ -27,13 +34,22 @@ public:
     uint64_t        paxosID;
     uint64_t        quorumID;
     uint64_t        shardID;
+    uint64_t        chunkID;
+    uint64_t        offset;
+    uint64_t        size;
+    uint32_t        checksum;
+    bool            useFileChunks;
     ReadBuffer      key;
     ReadBuffer      value;
     
-    bool            CatchupRequest(uint64_t nodeID, uint64_t quorumID);
+    bool            CatchupRequest(uint64_t nodeID, uint64_t quorumID, bool useFileChunks = false);
     bool            BeginShard(uint64_t shardID);
     bool            Set(uint64_t shardID, ReadBuffer key, ReadBuffer value);
     bool            Delete(uint64_t shardID, ReadBuffer key);
+    bool            BeginFileChunk(uint64_t shardID, uint64_t chunkID, uint64_t size);
+    bool            FileChunkData(uint64_t shardID, uint64_t offset, ReadBuffer data);
+    bool            EndFileChunk(uint64_t shardID, uint64_t chunkID);
+    bool            UseFileChunk(uint64_t shardID, uint64_t chunkID);
     bool            Commit(uint64_t paxosID);
     bool            Abort();
 
@@ -1,6 +1,7 @@
 #include "ClientRequest.h"
 #include "ClientSession.h"
 #include "System/Buffers/Buffer.h"
+#include "Framework/Messaging/MessageUtil.h"
 
 ClientRequest::ClientRequest()
 {
@@ -31,6 +32,8 @@ void ClientRequest::Init()
     count = 0;
     changeTimeout = 0;
     lastChangeTime = 0;
+    acceptsConfigStateDelta = false;
+    configStateVersion = 0;
 
     response.NoResponse();
     name.Clear();
@@ -101,6 +104,8 @@ bool ClientRequest::IsShardServerRequest()
         type == CLIENTREQUEST_LIST_KEYS             ||
         type == CLIENTREQUEST_LIST_KEYVALUES        ||
         type == CLIENTREQUEST_COUNT                 ||
+        type == CLIENTREQUEST_MULTI_GET             ||
+        type == CLIENTREQUEST_MULTI_SET             ||
         type == CLIENTREQUEST_START_TRANSACTION     ||
         type == CLIENTREQUEST_COMMIT_TRANSACTION    ||
         type == CLIENTREQUEST_ROLLBACK_TRANSACTION)
@@ -118,9 +123,20 @@ bool ClientRequest::IsReadRequest()
 
 bool ClientRequest::IsList()
 {
+    // MULTI_GET is answered like LIST_KEYVALUES
     if (type == CLIENTREQUEST_LIST_KEYS         ||
         type == CLIENTREQUEST_LIST_KEYVALUES    ||
-        type == CLIENTREQUEST_COUNT)
+        type == CLIENTREQUEST_COUNT             ||
+        type == CLIENTREQUEST_MULTI_GET)
+            return true;
+    
+    return false;
+}
+
+bool ClientRequest::IsMulti()
+{
+    if (type == CLIENTREQUEST_MULTI_GET         ||
+        type == CLIENTREQUEST_MULTI_SET)
             return true;
     
     return false;
@@ -159,11 +175,12 @@ void ClientRequest::GetMasterHTTP(
 }
 
 void ClientRequest::GetConfigState(
- uint64_t commandID_, uint64_t changeTimeout_)
+ uint64_t commandID_, uint64_t changeTimeout_, bool acceptsConfigStateDelta_)
 {
     type = CLIENTREQUEST_GET_CONFIG_STATE;
     commandID = commandID_;
     changeTimeout = changeTimeout_;
+    acceptsConfigStateDelta = acceptsConfigStateDelta_;
 }
 
 void ClientRequest::UnregisterShardServer(
@@ -537,6 +554,49 @@ void ClientRequest::Count(
     count = 0;
 }
 
+void ClientRequest::MultiGet(
+ uint64_t commandID_, uint64_t configPaxosID_, uint64_t tableID_)
+{
+    type = CLIENTREQUEST_MULTI_GET;
+    commandID = commandID_;
+    configPaxosID = configPaxosID_;
+    tableID = tableID_;
+    key.Clear();
+    value.Clear();
+    count = 0;
+}
+
+void ClientRequest::MultiSet(
+ uint64_t commandID_, uint64_t configPaxosID_, uint64_t tableID_)
+{
+    type = CLIENTREQUEST_MULTI_SET;
+    commandID = commandID_;
+    configPaxosID = configPaxosID_;
+    tableID = tableID_;
+    key.Clear();
+    value.Clear();
+    count = 0;
+}
+
+void ClientRequest::AppendMultiKey(ReadBuffer& key_)
+{
+    // the items are stored in value as varint length prefixed data,
+    // key holds the first key, the request is routed by that
+    if (count == 0)
+        key.Write(key_);
+    MessageUtil::WriteData(value, key_);
+    count++;
+}
+
+void ClientRequest::AppendMultiKeyValue(ReadBuffer& key_, ReadBuffer& value_)
+{
+    if (count == 0)
+        key.Write(key_);
+    MessageUtil::WriteData(value, key_);
+    MessageUtil::WriteData(value, value_);
+    count++;
+}
+
 void ClientRequest::StartTransaction(
  uint64_t commandID_, uint64_t configPaxosID_,
  uint64_t quorumID_, ReadBuffer& majorKey_)
@@ -44,6 +44,8 @@
 #define CLIENTREQUEST_LIST_KEYS                         'L'
 #define CLIENTREQUEST_LIST_KEYVALUES                    'l'
 #define CLIENTREQUEST_COUNT                             'O'
+#define CLIENTREQUEST_MULTI_GET                         'e'
+#define CLIENTREQUEST_MULTI_SET                         'E'
 #define CLIENTREQUEST_SPLIT_SHARD                       'h'
 #define CLIENTREQUEST_MIGRATE_SHARD                     'M'
 #define CLIENTREQUEST_START_TRANSACTION                 '<'
@@ -73,6 +75,7 @@ public:
     bool            IsShardServerRequest();
     bool            IsReadRequest();
     bool            IsList();
+    bool            IsMulti();
     bool            IsTransaction();
     bool            IsActive();
     
@@ -84,7 +87,8 @@ public:
 
     // Get config state: databases, tables, shards, quora
     void            GetConfigState(
-                     uint64_t commandID, uint64_t changeTimeout = 0);
+                     uint64_t commandID, uint64_t changeTimeout = 0,
+                     bool acceptsConfigStateDelta = false);
 
     // Shard servers
     void            UnregisterShardServer(
@@ -189,6 +193,16 @@ public:
                      ReadBuffer& startKey, ReadBuffer& endKey, ReadBuffer& prefix,
                      bool forwardDirection);
 
+    // Multi-key requests, the keys are added with AppendMultiKey() and AppendMultiKeyValue()
+    void            MultiGet(
+                     uint64_t commandID, uint64_t configPaxosID,
+                     uint64_t tableID);
+    void            MultiSet(
+                     uint64_t commandID, uint64_t configPaxosID,
+                     uint64_t tableID);
+    void            AppendMultiKey(ReadBuffer& key);
+    void            AppendMultiKeyValue(ReadBuffer& key, ReadBuffer& value);
+
     // Transactions
     void            StartTransaction(uint64_t commandID, uint64_t configPaxosID,
                      uint64_t quorumID, ReadBuffer& majorKey);
@@ -227,6 +241,8 @@ public:
     List<uint64_t>  nodes;
     uint64_t        changeTimeout;
     uint64_t        lastChangeTime;
+    bool            acceptsConfigStateDelta;
+    uint64_t        configStateVersion;
     
 };
 
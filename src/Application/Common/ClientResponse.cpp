@@ -186,6 +186,14 @@ bool ClientResponse::ConfigStateResponse(ConfigState& configState_)
     return true;
 }
 
+bool ClientResponse::ConfigStateDeltaResponse(ReadBuffer& delta)
+{
+    // the delta is not copied, the response must be written out before it changes
+    type = CLIENTRESPONSE_CONFIG_STATE_DELTA;
+    value = delta;
+    return true;
+}
+
 bool ClientResponse::NoService()
 {
     type = CLIENTRESPONSE_NOSERVICE;
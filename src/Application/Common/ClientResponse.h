@@ -12,6 +12,7 @@
 #define CLIENTRESPONSE_LIST_KEYS        'L'
 #define CLIENTRESPONSE_LIST_KEYVALUES   'l'
 #define CLIENTRESPONSE_CONFIG_STATE     'C'
+#define CLIENTRESPONSE_CONFIG_STATE_DELTA 'D'
 #define CLIENTRESPONSE_NOSERVICE        'S'
 #define CLIENTRESPONSE_BADSCHEMA        'B'
 #define CLIENTRESPONSE_FAILED           'F'
@@ -82,6 +83,7 @@ public:
     bool            ListKeys(unsigned numListKeys, ReadBuffer* keys);
     bool            ListKeyValues(unsigned numListKeys, ReadBuffer* keys, ReadBuffer* values);
     bool            ConfigStateResponse(ConfigState& configState);
+    bool            ConfigStateDeltaResponse(ReadBuffer& delta);
     bool            NoService();
     bool            BadSchema();
     bool            Failed();
@@ -23,7 +23,7 @@ bool ClusterMessage::UnregisterStop()
 
 bool ClusterMessage::Heartbeat(uint64_t nodeID_,
  List<QuorumInfo>& quorumInfos_, List<QuorumShardInfo>& quorumShardInfos_,
- unsigned httpPort_, unsigned sdbpPort_)
+ unsigned httpPort_, unsigned sdbpPort_, uint64_t configStateVersion_)
 {
     type = CLUSTERMESSAGE_HEARTBEAT;
     nodeID = nodeID_;
@@ -31,6 +31,8 @@ bool ClusterMessage::Heartbeat(uint64_t nodeID_,
     quorumShardInfos = quorumShardInfos_;
     httpPort = httpPort_;
     sdbpPort = sdbpPort_;
+    hasConfigStateVersion = true;
+    configStateVersion = configStateVersion_;
     return true;
 }
 
@@ -41,6 +43,13 @@ bool ClusterMessage::SetConfigState(ConfigState& configState_)
     return true;
 }
 
+bool ClusterMessage::SetConfigStateDelta(ReadBuffer delta)
+{
+    type = CLUSTERMESSAGE_SET_CONFIG_STATE_DELTA;
+    value = delta;
+    return true;
+}
+
 bool ClusterMessage::RequestLease(uint64_t nodeID_, uint64_t quorumID_,
  uint64_t proposalID_, uint64_t paxosID_, uint64_t configID_, unsigned duration_)
 {
@@ -112,6 +121,16 @@ bool ClusterMessage::ShardMigrationDelete(
     return true;
 }
 
+bool ClusterMessage::ShardMigrationBatch(
+ uint64_t quorumID_, uint64_t shardID_, ReadBuffer items_)
+{
+    type = CLUSTERMESSAGE_SHARDMIGRATION_BATCH;
+    quorumID = quorumID_;
+    shardID = shardID_;
+    value = items_;
+    return true;
+}
+
 bool ClusterMessage::ShardMigrationCommit(
  uint64_t quorumID_, uint64_t shardID_)
 {
@@ -130,6 +149,15 @@ bool ClusterMessage::ShardMigrationComplete(
     return true;
 }
 
+bool ClusterMessage::ShardMigrationAbort(
+ uint64_t quorumID_, uint64_t shardID_)
+{
+    type = CLUSTERMESSAGE_SHARDMIGRATION_ABORT;
+    quorumID = quorumID_;
+    shardID = shardID_;
+    return true;
+}
+
 bool ClusterMessage::ShardMigrationPause()
 {
     type = CLUSTERMESSAGE_SHARDMIGRATION_PAUSE;
@@ -192,11 +220,23 @@ bool ClusterMessage::Read(ReadBuffer& buffer)
             READ_SEPARATOR();
             if (!QuorumShardInfo::ReadList(buffer, quorumShardInfos))
                 return false;
+            // the config state version is optional, it is sent by shard servers
+            // that accept config state deltas
+            hasConfigStateVersion = false;
+            read = buffer.Readf(":V%U", &configStateVersion);
+            if (read > 2)
+                hasConfigStateVersion = true;
             return true;
             break;
         case CLUSTERMESSAGE_SET_CONFIG_STATE:
             type = CLUSTERMESSAGE_SET_CONFIG_STATE;
             return configState.Read(buffer, true);
+        case CLUSTERMESSAGE_SET_CONFIG_STATE_DELTA:
+            read = buffer.Readf("%c:", &type);
+            if (read < 2)
+                return false;
+            value.Wrap(buffer.GetBuffer() + read, buffer.GetLength() - read);
+            return true;
         case CLUSTERMESSAGE_REQUEST_LEASE:
             read = buffer.Readf("%c:%U:%U:%U:%U:%U:%u",
              &type, &nodeID, &quorumID, &proposalID, &paxosID, &configID, &duration);
@@ -231,11 +271,16 @@ bool ClusterMessage::Read(ReadBuffer& buffer)
             read = buffer.Readf("%c:%U:%U:%#R",
              &type, &quorumID, &shardID, &key);
             break;
+        case CLUSTERMESSAGE_SHARDMIGRATION_BATCH:
+            read = buffer.Readf("%c:%U:%U:%#R",
+             &type, &quorumID, &shardID, &value);
+            break;
         case CLUSTERMESSAGE_SHARDMIGRATION_COMMIT:
             read = buffer.Readf("%c:%U:%U",
              &type, &quorumID, &shardID);
             break;
         case CLUSTERMESSAGE_SHARDMIGRATION_COMPLETE:
+        case CLUSTERMESSAGE_SHARDMIGRATION_ABORT:
             read = buffer.Readf("%c:%U:%U",
              &type, &quorumID, &shardID);
             break;
@@ -285,10 +330,15 @@ bool ClusterMessage::Write(Buffer& buffer)
             QuorumInfo::WriteList(buffer, quorumInfos);
             buffer.Appendf(":");
             QuorumShardInfo::WriteList(buffer, quorumShardInfos);
+            buffer.Appendf(":V%U", configStateVersion);
             return true;
         case CLUSTERMESSAGE_SET_CONFIG_STATE:
             buffer.Clear();
             return configState.Write(buffer, true);
+        case CLUSTERMESSAGE_SET_CONFIG_STATE_DELTA:
+            buffer.Writef("%c:", type);
+            buffer.Append(value);
+            return true;
         case CLUSTERMESSAGE_REQUEST_LEASE:
             buffer.Writef("%c:%U:%U:%U:%U:%U:%u",
              type, nodeID, quorumID, proposalID, paxosID, configID, duration);
@@ -318,11 +368,16 @@ bool ClusterMessage::Write(Buffer& buffer)
             buffer.Writef("%c:%U:%U:%#R",
              type, quorumID, shardID, &key);
             return true;
+        case CLUSTERMESSAGE_SHARDMIGRATION_BATCH:
+            buffer.Writef("%c:%U:%U:%#R",
+             type, quorumID, shardID, &value);
+            return true;
         case CLUSTERMESSAGE_SHARDMIGRATION_COMMIT:
             buffer.Writef("%c:%U:%U",
              type, quorumID, shardID);
             return true;
         case CLUSTERMESSAGE_SHARDMIGRATION_COMPLETE:
+        case CLUSTERMESSAGE_SHARDMIGRATION_ABORT:
             buffer.Writef("%c:%U:%U",
              type, quorumID, shardID);
             return true;
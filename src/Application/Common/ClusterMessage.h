@@ -9,6 +9,7 @@
 #define CLUSTERMESSAGE_UNREGISTER_STOP          'S' // master => shard server
 #define CLUSTERMESSAGE_HEARTBEAT                'H' // shard server => controllers
 #define CLUSTERMESSAGE_SET_CONFIG_STATE         'C' // master => shard server
+#define CLUSTERMESSAGE_SET_CONFIG_STATE_DELTA   'D' // master => shard server
 #define CLUSTERMESSAGE_REQUEST_LEASE            'R' // shard server => master, also serves as heartbeat
 #define CLUSTERMESSAGE_RECEIVE_LEASE            'r' // master => shard server
 #define CLUSTERMESSAGE_CONFIG_CATCHUP           'c'
@@ -20,6 +21,8 @@
 #define CLUSTERMESSAGE_SHARDMIGRATION_COMPLETE  '5' // shard server => master
 #define CLUSTERMESSAGE_SHARDMIGRATION_PAUSE     '6' // shard server => master
 #define CLUSTERMESSAGE_SHARDMIGRATION_RESUME    '7' // shard server => master
+#define CLUSTERMESSAGE_SHARDMIGRATION_BATCH     '8' // shard server => shard server
+#define CLUSTERMESSAGE_SHARDMIGRATION_ABORT     '9' // shard server => master
 #define CLUSTERMESSAGE_HELLO                    '_'
 #define CLUSTERMESSAGE_HTTP_ENDPOINT            'h' // controller => controllers
 
@@ -53,6 +56,8 @@ public:
     ConfigState             configState;
     unsigned                httpPort;
     unsigned                sdbpPort;
+    bool                    hasConfigStateVersion;
+    uint64_t                configStateVersion;
     ReadBuffer              key;
     ReadBuffer              value;
     ReadBuffer              endpoint;
@@ -61,8 +66,9 @@ public:
     bool            UnregisterStop();
     bool            Heartbeat(uint64_t nodeID,
                      List<QuorumInfo>& quorumInfos, List<QuorumShardInfo>& quorumShardInfos,
-                     unsigned httpPort, unsigned sdbpPort);
+                     unsigned httpPort, unsigned sdbpPort, uint64_t configStateVersion);
     bool            SetConfigState(ConfigState& configState);
+    bool            SetConfigStateDelta(ReadBuffer delta);
     bool            RequestLease(uint64_t nodeID, uint64_t quorumID,
                      uint64_t proposalID, uint64_t paxosID, uint64_t configID, unsigned duration);
     bool            ReceiveLease(uint64_t nodeID, uint64_t quorumID,
@@ -74,8 +80,10 @@ public:
     bool            ShardMigrationBegin(uint64_t quorumID, uint64_t srcShardID, uint64_t dstShardID);
     bool            ShardMigrationSet(uint64_t quorumID, uint64_t shardID, ReadBuffer key, ReadBuffer value);
     bool            ShardMigrationDelete(uint64_t quorumID, uint64_t shardID, ReadBuffer key);
+    bool            ShardMigrationBatch(uint64_t quorumID, uint64_t shardID, ReadBuffer items);
     bool            ShardMigrationCommit(uint64_t quorumID, uint64_t shardID);
     bool            ShardMigrationComplete(uint64_t quorumID, uint64_t shardID);
+    bool            ShardMigrationAbort(uint64_t quorumID, uint64_t shardID);
     bool            ShardMigrationPause();
     bool            ShardMigrationResume();
     bool            Hello();
@@ -16,6 +16,7 @@ void ConfigDatabaseManager::Init(bool restoreMode)
     sc.SetChunkSize(            (uint64_t) configFile.GetInt64Value("database.chunkSize",				64*MiB  ));
     sc.SetLogSegmentSize(       (uint64_t) configFile.GetInt64Value("database.logSegmentSize",			64*MiB  ));
     sc.SetFileChunkCacheSize(   (uint64_t) configFile.GetInt64Value("database.fileChunkCacheSize",		256*MiB ));
+    sc.SetMetaPageCacheSize(    (uint64_t) configFile.GetInt64Value("database.metaPageCacheSize",		16*MiB ));
     sc.SetMemoChunkCacheSize(   (uint64_t) configFile.GetInt64Value("database.memoChunkCacheSize",		1*GiB   ));
     sc.SetLogSize(              (uint64_t) configFile.GetInt64Value("database.logSize",					64*MiB  ));
     sc.SetMergeBufferSize(      (uint64_t) configFile.GetInt64Value("database.mergeBufferSize",			10*MiB  ));
@@ -26,6 +27,18 @@ void ConfigDatabaseManager::Init(bool restoreMode)
     sc.SetAbortWaitingListsNum( (uint64_t) configFile.GetInt64Value("database.abortWaitingListsNum",	0       ));
     sc.SetListDataPageCacheSize((uint64_t) configFile.GetInt64Value("database.listDataPageCacheSize",   1*MB    ));
     sc.SetMaxChunkPerShard(     (unsigned) configFile.GetIntValue  ("database.maxChunkPerShard",        10      ));
+    sc.SetGroupCommitWindow(    (uint64_t) configFile.GetInt64Value("database.groupCommitWindow",       0       ));
+    sc.SetGroupCommitSize(      (uint64_t) configFile.GetInt64Value("database.groupCommitSize",         1*MiB   ));
+    if (configFile.GetBoolValue("database.compression", false))
+        sc.SetCompression(STORAGE_COMPRESSION_LZ);
+    else
+        sc.SetCompression(STORAGE_COMPRESSION_NONE);
+    sc.SetMapChunks(configFile.GetBoolValue("database.mapChunks", false));
+    if (strcmp(configFile.GetValue("database.memoChunkIndex", "tree"), "btree") == 0)
+        sc.SetMemoChunkIndex(STORAGE_MEMO_INDEX_BTREE);
+    else
+        sc.SetMemoChunkIndex(STORAGE_MEMO_INDEX_TREE);
+    sc.SetConcurrentMemoReads(configFile.GetBoolValue("database.concurrentMemoReads", false));
 
     envpath.Writef("%s", configFile.GetValue("database.dir", "db"));
     environment.Open(envpath, sc);
@@ -714,6 +714,7 @@ void ConfigHTTPClientSession::PrintStatistics()
     buffer.Appendf("numTCPBytesSent: %s\n", HumanBytes(iostat.numTCPBytesSent, humanBuf));
     buffer.Appendf("numTCPBytesReceived: %s\n", HumanBytes(iostat.numTCPBytesReceived, humanBuf));
     buffer.Appendf("numCompletions: %U\n", iostat.numCompletions);
+    buffer.Appendf("numWakeups: %U\n", iostat.numWakeups);
     buffer.Appendf("totalPollTime: %U\n", iostat.totalPollTime);
     buffer.Appendf("totalNumEvents: %U\n", iostat.totalNumEvents);
     buffer.Appendf("numDanglingIods: %d\n", iostat.numDanglingIods);
@@ -89,6 +89,17 @@ void ConfigHeartbeatManager::OnHeartbeatMessage(ClusterMessage& message)
     shardServer->httpPort = message.httpPort;
     shardServer->sdbpPort = message.sdbpPort;
     shardServer->hasHeartbeat = true;
+
+    // the shard server reports the config state version it has, the last delta may still
+    // be in flight, but if it is older than the version sent before, a delta was dropped
+    // or did not apply, and the next update is a snapshot
+    shardServer->acceptsConfigStateDelta = message.hasConfigStateVersion;
+    if (message.hasConfigStateVersion && (message.configStateVersion == 0 ||
+     message.configStateVersion < shardServer->prevConfigStateVersion))
+    {
+        shardServer->configStateVersion = 0;
+        shardServer->prevConfigStateVersion = 0;
+    }
     
     configServer->OnConfigStateChanged();
     
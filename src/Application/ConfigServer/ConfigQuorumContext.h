@@ -61,6 +61,8 @@ public:
 
     virtual void                    OnStartProposing();
     virtual void                    OnAppend(uint64_t paxosID, Buffer& value, bool ownAppend);
+    virtual void                    OnPipelineCleared() {}
+    virtual void                    OnNextValueProposed(uint64_t) {}
     virtual void                    OnMessage(ReadBuffer msg);
     virtual void                    OnMessageProcessed() {}
     virtual void                    OnStartCatchup();
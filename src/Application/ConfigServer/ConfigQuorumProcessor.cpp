@@ -12,8 +12,9 @@ void ConfigQuorumProcessor::Init(ConfigServer* configServer_, unsigned numConfig
     configServer = configServer_;
     
     isCatchingUp = false;
-    configStateChecksum = 0;
+    configStateDelta.Reset();
     lastConfigChangeTime = 0;
+    lastConfigStateDiffTime = 0;
 
     leaseKnown = false;
     leaseOwner = 0;
@@ -145,6 +146,12 @@ void ConfigQuorumProcessor::OnClientRequest(ClientRequest* request)
     }
     else if (request->type == CLIENTREQUEST_GET_CONFIG_STATE)
     {
+        if (request->acceptsConfigStateDelta)
+        {
+            OnConfigStateDeltaRequest(request);
+            return;
+        }
+
         listenRequests.Append(request);
         if (quorumContext.IsLeader())
         {
@@ -457,37 +464,65 @@ void ConfigQuorumProcessor::OnShardMigrationComplete(ClusterMessage& message)
     TryAppend();
 }
 
+void ConfigQuorumProcessor::OnShardMigrationAbort(ClusterMessage& message)
+{
+    if (!quorumContext.IsLeader() || !CONFIG_STATE->isMigrating)
+        return;
+
+    if (CONFIG_STATE->migrateQuorumID != message.quorumID ||
+     CONFIG_STATE->migrateDstShardID != message.shardID)
+        return;
+
+    // the same as losing the primary lease of a quorum taking part in the migration,
+    // the source stops sending once it learns the migration is over, and it can be retried
+    Log_Message("Aborting shard migration...");
+    CONFIG_STATE->OnAbortShardMigration();
+    configServer->OnConfigStateChanged();
+}
+
 void ConfigQuorumProcessor::UpdateListeners(bool force)
 {
     ClientRequest*                  itRequest;
     ConfigShardServer*              itShardServer;
     ClusterMessage                  message;
-    Buffer                          checksumBuffer;
+    ClusterMessage                  deltaMessage;
     bool                            configChanged;
+    bool                            sendConfigState;
+    bool                            isMessageSet;
     uint64_t                        now;
-    uint32_t                        checksum;
+    uint64_t                        version;
+    ReadBuffer                      delta;
 
     if (!quorumContext.IsLeader())
         return;
 
-    // check if the configState changed at all
-    configChanged = force;
-    CONFIG_STATE->Write(checksumBuffer, true);
-    checksum = checksumBuffer.GetChecksum();
-    if (checksum == 0 || checksum != configStateChecksum)
-    {
-        configChanged = true;
-        configStateChecksum = checksum;
-    }
+    now = EventLoop::Now();
 
-//    if (configChanged)
-//        Log_Debug("UpdateListeners: %b, %B", configChanged, &checksumBuffer);
+    // check if the configState changed at all, the shard sizes and split keys
+    // reported in the heartbeats are compared at most once a second
+    configChanged = configStateDelta.Update(*CONFIG_STATE,
+     force || lastConfigStateDiffTime <= now - 1000);
+    if (lastConfigStateDiffTime <= now - 1000)
+        lastConfigStateDiffTime = now;
+    if (force)
+        configChanged = true;
+    version = configStateDelta.GetVersion();
 
-    now = EventLoop::Now();
-    
     // update clients
     FOREACH (itRequest, listenRequests)
     {
+        if (itRequest->acceptsConfigStateDelta)
+        {
+            if (itRequest->configStateVersion != version)
+            {
+                delta = GetConfigStateDelta(itRequest->configStateVersion);
+                itRequest->response.ConfigStateDeltaResponse(delta);
+                itRequest->OnComplete(false);
+                itRequest->configStateVersion = version;
+            }
+            continue;
+        }
+
         if (configChanged ||
          (itRequest->changeTimeout != 0 && 
          itRequest->changeTimeout < now - itRequest->lastChangeTime) ||
@@ -507,16 +542,38 @@ void ConfigQuorumProcessor::UpdateListeners(bool force)
     if (!IsMaster())
         return;
     
-    if (configChanged || lastConfigChangeTime <= now - 1000)
-    {
+    sendConfigState = (configChanged || lastConfigChangeTime <= now - 1000);
+    if (sendConfigState)
         lastConfigChangeTime = now;
+
+    // update shard servers, the ones that send their config state version in the
+    // heartbeat only get the changes, the others the whole state once a second,
+    // sending a delta does not guarantee delivery, the heartbeat reports what arrived
+    isMessageSet = false;
+    FOREACH (itShardServer, CONFIG_STATE->shardServers)
+    {
+        if (itShardServer->acceptsConfigStateDelta)
+        {
+            if (itShardServer->configStateVersion != version)
+            {
+                deltaMessage.SetConfigStateDelta(
+                 GetConfigStateDelta(itShardServer->configStateVersion));
+                CONTEXT_TRANSPORT->SendClusterMessage(itShardServer->nodeID, deltaMessage);
+                itShardServer->prevConfigStateVersion = itShardServer->configStateVersion;
+                itShardServer->configStateVersion = version;
+            }
+            continue;
+        }
+
+        if (!sendConfigState)
+            continue;
         
-        // update shard servers
-        message.SetConfigState(*CONFIG_STATE);
-        FOREACH (itShardServer, CONFIG_STATE->shardServers)
+        if (!isMessageSet)
         {
-            CONTEXT_TRANSPORT->SendClusterMessage(itShardServer->nodeID, message);
+            message.SetConfigState(*CONFIG_STATE);
+            isMessageSet = true;
         }
+        CONTEXT_TRANSPORT->SendClusterMessage(itShardServer->nodeID, message);
     }
 }
 
@@ -532,7 +589,8 @@ void ConfigQuorumProcessor::OnLearnLease()
 
 void ConfigQuorumProcessor::OnLeaseTimeout()
 {
-    ClientRequest*  itRequest;
+    ClientRequest*      itRequest;
+    ConfigShardServer*  itShardServer;
  
     Log_Message("Node %U is no longer the master", leaseOwner);
 
@@ -551,6 +609,16 @@ void ConfigQuorumProcessor::OnLeaseTimeout()
     }
     ASSERT(requests.GetLength() == 0);
   
+    // the next master starts the listeners with a snapshot
+    configStateDelta.Reset();
+    FOREACH (itRequest, listenRequests)
+        itRequest->configStateVersion = 0;
+    FOREACH (itShardServer, CONFIG_STATE->shardServers)
+    {
+        itShardServer->configStateVersion = 0;
+        itShardServer->prevConfigStateVersion = 0;
+    }
+
     CONFIG_STATE->hasMaster = false;
     CONFIG_STATE->masterID = 0;
     CONFIG_STATE->paxosID = 0;
@@ -1041,6 +1109,9 @@ void ConfigQuorumProcessor::OnListenRequestTimeout()
 
     FOREACH (request, listenRequests)
     {
+        if (request->acceptsConfigStateDelta)
+            continue;
+
         if (request->changeTimeout + request->lastChangeTime <= now)
         {
             request->response.ConfigStateResponse(*CONFIG_STATE);
@@ -1060,3 +1131,33 @@ void ConfigQuorumProcessor::OnListenRequestTimeout()
         EventLoop::Add(&onListenRequestTimeout);
     }
 }
+
+void ConfigQuorumProcessor::OnConfigStateDeltaRequest(ClientRequest* request)
+{
+    ClientRequest*  it;
+
+    // a client that could not apply a delta asks again on the same session,
+    // its listen request is restarted with a snapshot
+    FOREACH (it, listenRequests)
+    {
+        if (it->session == request->session && it->acceptsConfigStateDelta)
+        {
+            it->configStateVersion = 0;
+            request->response.NoResponse();
+            request->OnComplete();
+            UpdateListeners();
+            return;
+        }
+    }
+
+    request->configStateVersion = 0;
+    listenRequests.Append(request);
+    UpdateListeners();
+}
+
+ReadBuffer ConfigQuorumProcessor::GetConfigStateDelta(uint64_t version)
+{
+    if (version != 0 && version + 1 == configStateDelta.GetVersion())
+        return configStateDelta.GetDelta();
+    return configStateDelta.GetSnapshot();
+}
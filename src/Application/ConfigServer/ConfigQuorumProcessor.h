@@ -4,6 +4,7 @@
 #include "Application/Common/ClusterMessage.h"
 #include "Application/Common/ClientRequest.h"
 #include "Application/Common/CatchupMessage.h"
+#include "Application/ConfigState/ConfigStateDelta.h"
 #include "ConfigQuorumContext.h"
 
 class ConfigServer; // forward
@@ -55,6 +56,7 @@ public:
     void                    TryTruncateTableComplete(uint64_t tableID);
     
     void                    OnShardMigrationComplete(ClusterMessage& message);
+    void                    OnShardMigrationAbort(ClusterMessage& message);
        
     void                    UpdateListeners(bool force = false);
 
@@ -74,6 +76,8 @@ private:
     void                    ConstructResponse(ConfigMessage* message, ClientResponse* response);
     void                    SendClientResponse(ConfigMessage& message);
     void                    OnListenRequestTimeout();
+    void                    OnConfigStateDeltaRequest(ClientRequest* request);
+    ReadBuffer              GetConfigStateDelta(uint64_t version);
 
     bool                    isCatchingUp;
 
@@ -85,8 +89,9 @@ private:
     MessageList             configMessages;
     RequestList             requests;
     RequestList             listenRequests;
-    uint32_t                configStateChecksum;
+    ConfigStateDelta        configStateDelta;
     uint64_t                lastConfigChangeTime;
+    uint64_t                lastConfigStateDiffTime;
     Countdown               onListenRequestTimeout;
 };
 
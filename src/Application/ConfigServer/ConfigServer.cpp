@@ -164,6 +164,9 @@ void ConfigServer::OnClusterMessage(uint64_t /*nodeID*/, ClusterMessage& message
         case CLUSTERMESSAGE_SHARDMIGRATION_COMPLETE:
             quorumProcessor.OnShardMigrationComplete(message);
             break;
+        case CLUSTERMESSAGE_SHARDMIGRATION_ABORT:
+            quorumProcessor.OnShardMigrationAbort(message);
+            break;
         case CLUSTERMESSAGE_HELLO:
             // TODO:
             break;
@@ -224,6 +227,11 @@ void ConfigServer::OnConnectionReady(uint64_t nodeID, Endpoint endpoint)
     
     if (quorumProcessor.IsMaster())
     {
+        // the full state resets the shard server, it may have been restarted with
+        // another version, so it gets full states until its next heartbeat
+        shardServer->acceptsConfigStateDelta = false;
+        shardServer->configStateVersion = 0;
+        shardServer->prevConfigStateVersion = 0;
         clusterMessage.SetConfigState(*CONFIG_STATE);
         CONTEXT_TRANSPORT->SendClusterMessage(nodeID, clusterMessage);
         
@@ -271,6 +279,9 @@ bool ConfigServer::OnAwaitingNodeID(Endpoint endpoint)
             CONTEXT_TRANSPORT->SendClusterMessage(shardServer->nodeID, clusterMessage);
             
             // send config state
+            shardServer->acceptsConfigStateDelta = false;
+            shardServer->configStateVersion = 0;
+            shardServer->prevConfigStateVersion = 0;
             clusterMessage.SetConfigState(*CONFIG_STATE);
             CONTEXT_TRANSPORT->SendClusterMessage(shardServer->nodeID, clusterMessage);
             return false;
@@ -134,6 +134,9 @@ ConfigShardServer::ConfigShardServer()
     httpPort = 0;
     sdbpPort = 0;
     hasHeartbeat = false;
+    acceptsConfigStateDelta = false;
+    configStateVersion = 0;
+    prevConfigStateVersion = 0;
 }
 
 ConfigShardServer::ConfigShardServer(const ConfigShardServer& other)
@@ -150,6 +153,9 @@ ConfigShardServer& ConfigShardServer::operator=(const ConfigShardServer& other)
     httpPort = other.httpPort;
     sdbpPort = other.sdbpPort;
     hasHeartbeat = other.hasHeartbeat;
+    acceptsConfigStateDelta = other.acceptsConfigStateDelta;
+    configStateVersion = other.configStateVersion;
+    prevConfigStateVersion = other.prevConfigStateVersion;
     
     quorumInfos = other.quorumInfos;
     quorumShardInfos = other.quorumShardInfos;
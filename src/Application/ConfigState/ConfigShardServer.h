@@ -113,6 +113,12 @@ public:
     unsigned                httpPort;
     unsigned                sdbpPort;
     bool                    hasHeartbeat;
+
+    // the config state version sent last, if the shard server accepts deltas,
+    // and the one sent before it, a heartbeat reporting an older one missed a delta
+    bool                    acceptsConfigStateDelta;
+    uint64_t                configStateVersion;
+    uint64_t                prevConfigStateVersion;
     // ========================================================================================
     
     ConfigShardServer*      prev;
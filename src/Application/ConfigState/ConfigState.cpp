@@ -1,5 +1,6 @@
 #include "ConfigState.h"
 #include "System/Macros.h"
+#include "System/Containers/HashMap.h"
 #include "Application/Common/DatabaseConsts.h"
 
 #define CONFIG_MESSAGE_PREFIX   'C'
@@ -19,6 +20,11 @@ inline bool LessThan(uint64_t a, uint64_t b)
     return (a < b);
 }
 
+static size_t Hash(uint64_t h)
+{
+    return h;
+}
+
 ConfigState::ConfigState()
 {
     Init();
@@ -66,6 +72,8 @@ ConfigState& ConfigState::operator=(const ConfigState& other)
     migrateQuorumID = other.migrateQuorumID;
     migrateSrcShardID = other.migrateSrcShardID;
     migrateDstShardID = other.migrateDstShardID;
+
+    version = other.version;
     
     FOREACH (quorum, other.quorums)
         quorums.Append(new ConfigQuorum(*quorum));
@@ -106,6 +114,8 @@ void ConfigState::Init()
     migrateQuorumID = 0;
     migrateSrcShardID = 0;
     migrateDstShardID = 0;
+
+    version = 0;
     
     quorums.DeleteList();
     databases.DeleteList();
@@ -135,6 +145,8 @@ void ConfigState::Transfer(ConfigState& other)
     other.migrateQuorumID = migrateQuorumID;
     other.migrateSrcShardID = migrateSrcShardID;
     other.migrateDstShardID = migrateDstShardID;
+
+    other.version = version;
     
     other.quorums = quorums;
     quorums.ClearMembers();
@@ -243,36 +255,8 @@ bool ConfigState::Read(ReadBuffer& buffer_, bool withVolatile)
         ASSERT(c == CONFIG_MESSAGE_PREFIX);
 
         READ_SEPARATOR();
-        c = NO;
-        read = buffer.Readf("%c", &c);
-        CHECK_ADVANCE(1);
-        if (c == YES)
-        {
-            READ_SEPARATOR();
-            read = buffer.Readf("%U", &masterID);
-            CHECK_ADVANCE(1);
-            hasMaster = true;
-
-            // paxosID is optional from version 0.9.8
-            read = buffer.Readf(":P%U", &paxosID);
-            if (read > 0)
-            {
-                CHECK_ADVANCE(3);
-            }
-        }
-        
-        READ_SEPARATOR();
-        c = NO;
-        read = buffer.Readf("%c", &c);
-        CHECK_ADVANCE(1);
-        if (c == YES)
-        {
-            READ_SEPARATOR();
-            read = buffer.Readf("%U:%U:%U", &migrateSrcShardID, &migrateDstShardID, &migrateQuorumID);
-            CHECK_ADVANCE(1);
-            isMigrating = true;
-        }
-
+        if (!ReadMaster(buffer))
+            return false;
         READ_SEPARATOR();
     }
     
@@ -305,22 +289,7 @@ bool ConfigState::Write(Buffer& buffer, bool withVolatile)
         buffer.Appendf("%c", CONFIG_MESSAGE_PREFIX);
 
         buffer.Appendf(":");
-        if (hasMaster)
-        {
-            buffer.Appendf("%c:%U", YES, masterID);
-            // as paxosID is optional from 0.9.8, it is prefixed with P
-            buffer.Appendf(":P%U", paxosID);
-        }
-        else
-            buffer.Appendf("%c", NO);
-
-
-        buffer.Appendf(":");        
-        if (isMigrating)
-            buffer.Appendf("%c:%U:%U:%U", YES, migrateSrcShardID, migrateDstShardID, migrateQuorumID);
-        else
-            buffer.Appendf("%c", NO);
-
+        WriteMaster(buffer);
         buffer.Appendf(":");        
     }
 
@@ -341,6 +310,89 @@ bool ConfigState::Write(Buffer& buffer, bool withVolatile)
     return true;
 }
 
+bool ConfigState::ReadDelta(ReadBuffer& buffer_)
+{
+    int             read;
+    uint64_t        baseVersion;
+    uint64_t        newVersion;
+    ReadBuffer      buffer;
+    ConfigState     delta;
+    List<uint64_t>  removedQuorums;
+    List<uint64_t>  removedDatabases;
+    List<uint64_t>  removedTables;
+    List<uint64_t>  removedShards;
+    List<uint64_t>  removedShardServers;
+    
+    buffer = buffer_; // because of Advance()
+
+    read = buffer.Readf("%U:%U", &baseVersion, &newVersion);
+    CHECK_ADVANCE(3);
+    if (baseVersion != 0 && baseVersion != version)
+        return false;
+
+    // the changed records are parsed into a separate state first,
+    // so that a malformed delta leaves this state untouched
+    READ_SEPARATOR();
+    if (!delta.ReadMaster(buffer))
+        return false;
+    READ_SEPARATOR();
+    if (!delta.ReadNextIDs(buffer))
+        return false;
+    READ_SEPARATOR();
+    if (!delta.ReadDeltaList(delta.quorums, removedQuorums, buffer))
+        return false;
+    READ_SEPARATOR();
+    if (!delta.ReadDeltaList(delta.databases, removedDatabases, buffer))
+        return false;
+    READ_SEPARATOR();
+    if (!delta.ReadDeltaList(delta.tables, removedTables, buffer))
+        return false;
+    READ_SEPARATOR();
+    if (!delta.ReadDeltaList(delta.shards, removedShards, buffer))
+        return false;
+    READ_SEPARATOR();
+    if (!delta.ReadDeltaList(delta.shardServers, removedShardServers, buffer))
+        return false;
+    if (buffer.GetLength() != 0)
+        return false;
+
+    if (baseVersion == 0)
+        Init();
+
+    nextQuorumID = delta.nextQuorumID;
+    nextDatabaseID = delta.nextDatabaseID;
+    nextTableID = delta.nextTableID;
+    nextShardID = delta.nextShardID;
+    nextNodeID = delta.nextNodeID;
+
+    hasMaster = delta.hasMaster;
+    masterID = delta.masterID;
+    paxosID = delta.paxosID;
+
+    isMigrating = delta.isMigrating;
+    migrateQuorumID = delta.migrateQuorumID;
+    migrateSrcShardID = delta.migrateSrcShardID;
+    migrateDstShardID = delta.migrateDstShardID;
+
+    ApplyDeltaList(quorums, delta.quorums, removedQuorums);
+    ApplyDeltaList(databases, delta.databases, removedDatabases);
+    ApplyDeltaList(tables, delta.tables, removedTables);
+    ApplyDeltaList(shards, delta.shards, removedShards);
+    ApplyDeltaList(shardServers, delta.shardServers, removedShardServers);
+
+    version = newVersion;
+    
+    return true;
+}
+
+bool ConfigState::ReadDeltaVersions(ReadBuffer buffer, uint64_t& baseVersion, uint64_t& version)
+{
+    int read;
+    
+    read = buffer.Readf("%U:%U", &baseVersion, &version);
+    return (read >= 3);
+}
+
 void ConfigState::OnAbortShardMigration()
 {
     ConfigShardServer*  shardServer;
@@ -1507,6 +1559,193 @@ void ConfigState::OnShardMigrationComplete(ConfigMessage& message)
     shard->quorumID = message.quorumID;
 }
 
+bool ConfigState::ReadMaster(ReadBuffer& buffer)
+{
+    char    c;
+    int     read;
+
+    hasMaster = false;
+    c = NO;
+    read = buffer.Readf("%c", &c);
+    CHECK_ADVANCE(1);
+    if (c == YES)
+    {
+        READ_SEPARATOR();
+        read = buffer.Readf("%U", &masterID);
+        CHECK_ADVANCE(1);
+        hasMaster = true;
+
+        // paxosID is optional from version 0.9.8
+        read = buffer.Readf(":P%U", &paxosID);
+        if (read > 0)
+        {
+            CHECK_ADVANCE(3);
+        }
+    }
+    
+    READ_SEPARATOR();
+    isMigrating = false;
+    c = NO;
+    read = buffer.Readf("%c", &c);
+    CHECK_ADVANCE(1);
+    if (c == YES)
+    {
+        READ_SEPARATOR();
+        read = buffer.Readf("%U:%U:%U", &migrateSrcShardID, &migrateDstShardID, &migrateQuorumID);
+        CHECK_ADVANCE(1);
+        isMigrating = true;
+    }
+
+    return true;
+}
+
+void ConfigState::WriteMaster(Buffer& buffer)
+{
+    if (hasMaster)
+    {
+        buffer.Appendf("%c:%U", YES, masterID);
+        // as paxosID is optional from 0.9.8, it is prefixed with P
+        buffer.Appendf(":P%U", paxosID);
+    }
+    else
+        buffer.Appendf("%c", NO);
+
+    buffer.Appendf(":");        
+    if (isMigrating)
+        buffer.Appendf("%c:%U:%U:%U", YES, migrateSrcShardID, migrateDstShardID, migrateQuorumID);
+    else
+        buffer.Appendf("%c", NO);
+}
+
+static uint64_t GetRecordID(ConfigQuorum* quorum)
+{
+    return quorum->quorumID;
+}
+
+static uint64_t GetRecordID(ConfigDatabase* database)
+{
+    return database->databaseID;
+}
+
+static uint64_t GetRecordID(ConfigTable* table)
+{
+    return table->tableID;
+}
+
+static uint64_t GetRecordID(ConfigShard* shard)
+{
+    return shard->shardID;
+}
+
+static uint64_t GetRecordID(ConfigShardServer* shardServer)
+{
+    return shardServer->nodeID;
+}
+
+template<typename T>
+bool ConfigState::ReadDeltaList(InList<T>& list, List<uint64_t>& removed, ReadBuffer& buffer)
+{
+    int         read;
+    unsigned    num, i;
+    T*          record;
+    
+    read = buffer.Readf("%u", &num);
+    CHECK_ADVANCE(1);
+    
+    for (i = 0; i < num; i++)
+    {
+        READ_SEPARATOR();
+        record = new T;
+        if (!ReadDeltaRecord(*record, buffer))
+        {
+            delete record;
+            return false;
+        }
+        list.Append(record);
+    }
+
+    READ_SEPARATOR();
+    return ReadIDList(removed, buffer);
+}
+
+template<typename T>
+void ConfigState::ApplyDeltaList(InList<T>& list, InList<T>& changed, List<uint64_t>& removed)
+{
+    T*          record;
+    T*          old;
+    uint64_t    ID;
+    uint64_t*   itID;
+
+    // a snapshot is applied to empty lists, there is nothing to replace or remove
+    if (list.GetLength() == 0)
+    {
+        FOREACH_FIRST (record, changed)
+        {
+            changed.Remove(record);
+            list.Append(record);
+        }
+        return;
+    }
+
+    HashMap<uint64_t, T*>   records(list.GetLength() + changed.GetLength());
+
+    FOREACH (record, list)
+    {
+        ID = GetRecordID(record);
+        records.Set(ID, record);
+    }
+
+    // changed records replace the old ones at the same position, so the order of
+    // the lists stays the same as on the master
+    FOREACH_FIRST (record, changed)
+    {
+        changed.Remove(record);
+        ID = GetRecordID(record);
+        if (records.Get(ID, old))
+        {
+            list.InsertAfter(old, record);
+            list.Delete(old);
+        }
+        else
+            list.Append(record);
+        records.Set(ID, record);
+    }
+
+    FOREACH (itID, removed)
+    {
+        if (records.Get(*itID, old))
+        {
+            list.Delete(old);
+            records.Remove(*itID);
+        }
+    }
+}
+
+bool ConfigState::ReadDeltaRecord(ConfigQuorum& quorum, ReadBuffer& buffer)
+{
+    return ReadQuorum(quorum, buffer, true);
+}
+
+bool ConfigState::ReadDeltaRecord(ConfigDatabase& database, ReadBuffer& buffer)
+{
+    return ReadDatabase(database, buffer);
+}
+
+bool ConfigState::ReadDeltaRecord(ConfigTable& table, ReadBuffer& buffer)
+{
+    return ReadTable(table, buffer);
+}
+
+bool ConfigState::ReadDeltaRecord(ConfigShard& shard, ReadBuffer& buffer)
+{
+    return ReadShard(shard, buffer, true);
+}
+
+bool ConfigState::ReadDeltaRecord(ConfigShardServer& shardServer, ReadBuffer& buffer)
+{
+    return ReadShardServer(shardServer, buffer, true);
+}
+
 bool ConfigState::ReadQuorums(ReadBuffer& buffer, bool withVolatile)
 {
     int             read;
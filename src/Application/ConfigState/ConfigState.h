@@ -53,6 +53,9 @@ public:
     uint64_t            migrateSrcShardID;
     uint64_t            migrateDstShardID;
     uint64_t            migrateQuorumID;
+
+    // the version of the state in the master's chain of deltas, 0 if unknown
+    uint64_t            version;
     // ========================================================================================
     
     Controllers         controllers;
@@ -93,6 +96,12 @@ public:
     bool                Read(ReadBuffer& buffer, bool withVolatile = false);
     bool                Write(Buffer& buffer, bool withVolatile = false);
 
+    // applies a delta written by ConfigStateDelta in place; fails without changing the
+    // state if the delta is not based on this version, a delta based on 0 is a snapshot
+    bool                ReadDelta(ReadBuffer& buffer);
+    static bool         ReadDeltaVersions(ReadBuffer buffer, uint64_t& baseVersion,
+                         uint64_t& version);
+
     void                OnAbortShardMigration();
 
     template<typename List>
@@ -102,6 +111,8 @@ public:
     static void         WriteIDList(List& numbers, Buffer& buffer);
 
 private:
+    friend class        ConfigStateDelta;
+
     bool                CompleteSetClusterID(ConfigMessage& message);
     bool                CompleteRegisterShardServer(ConfigMessage& message);
     bool                CompleteUnregisterShardServer(ConfigMessage& message);
@@ -157,6 +168,19 @@ private:
     void                OnShardMigrationBegin(ConfigMessage& message);
     void                OnShardMigrationComplete(ConfigMessage& message);
     
+    bool                ReadMaster(ReadBuffer& buffer);
+    void                WriteMaster(Buffer& buffer);
+
+    template<typename T>
+    bool                ReadDeltaList(InList<T>& list, List<uint64_t>& removed, ReadBuffer& buffer);
+    template<typename T>
+    void                ApplyDeltaList(InList<T>& list, InList<T>& changed, List<uint64_t>& removed);
+    bool                ReadDeltaRecord(ConfigQuorum& quorum, ReadBuffer& buffer);
+    bool                ReadDeltaRecord(ConfigDatabase& database, ReadBuffer& buffer);
+    bool                ReadDeltaRecord(ConfigTable& table, ReadBuffer& buffer);
+    bool                ReadDeltaRecord(ConfigShard& shard, ReadBuffer& buffer);
+    bool                ReadDeltaRecord(ConfigShardServer& shardServer, ReadBuffer& buffer);
+
     bool                ReadQuorums(ReadBuffer& buffer, bool withVolatile);
     void                WriteQuorums(Buffer& buffer, bool withVolatile);
 
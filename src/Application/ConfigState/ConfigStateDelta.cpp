@@ -0,0 +1,268 @@
+#include "System/Platform.h"
+
+// uint64_t keys are not found by argument-dependent lookup, so KeyCmp() has to be
+// declared before InTreeMap.h
+static inline int KeyCmp(uint64_t a, uint64_t b)
+{
+    if (a < b)
+        return -1;
+    if (a > b)
+        return 1;
+    return 0;
+}
+
+#include "ConfigStateDelta.h"
+
+static inline uint64_t Key(const ConfigStateRecord* record)
+{
+    return record->ID;
+}
+
+static uint64_t GetRecordID(ConfigQuorum* quorum)
+{
+    return quorum->quorumID;
+}
+
+static uint64_t GetRecordID(ConfigDatabase* database)
+{
+    return database->databaseID;
+}
+
+static uint64_t GetRecordID(ConfigTable* table)
+{
+    return table->tableID;
+}
+
+static uint64_t GetRecordID(ConfigShard* shard)
+{
+    return shard->shardID;
+}
+
+static uint64_t GetRecordID(ConfigShardServer* shardServer)
+{
+    return shardServer->nodeID;
+}
+
+ConfigStateDelta::ConfigStateDelta()
+{
+    version = 0;
+    snapshotVersion = 0;
+    Reset();
+}
+
+ConfigStateDelta::~ConfigStateDelta()
+{
+    Reset();
+}
+
+void ConfigStateDelta::Reset()
+{
+    // the version is not restarted, so that listeners never mistake the
+    // snapshot that follows for an older version
+    isTracking = false;
+    paxosID = 0;
+    mark = 0;
+    header.Clear();
+    delta.Clear();
+    snapshot.Clear();
+    snapshotVersion = 0;
+
+    quorums.DeleteTree();
+    databases.DeleteTree();
+    tables.DeleteTree();
+    shards.DeleteTree();
+    shardServers.DeleteTree();
+}
+
+bool ConfigStateDelta::Update(ConfigState& configState, bool force)
+{
+    Buffer      newHeader;
+    Buffer      sections[5];
+    bool        full;
+    bool        changed;
+    unsigned    i;
+
+    full = (force || !isTracking || configState.paxosID != paxosID);
+    mark++;
+
+    configState.WriteMaster(newHeader);
+    newHeader.Appendf(":");
+    configState.WriteNextIDs(newHeader);
+    changed = (!isTracking || Buffer::Cmp(header, newHeader) != 0);
+
+    if (UpdateList(configState, configState.quorums, quorums, sections[0]))
+        changed = true;
+
+    if (full)
+    {
+        if (UpdateList(configState, configState.databases, databases, sections[1]))
+            changed = true;
+        if (UpdateList(configState, configState.tables, tables, sections[2]))
+            changed = true;
+        if (UpdateList(configState, configState.shards, shards, sections[3]))
+            changed = true;
+        paxosID = configState.paxosID;
+    }
+    else
+    {
+        WriteEmptyList(sections[1]);
+        WriteEmptyList(sections[2]);
+        WriteEmptyList(sections[3]);
+    }
+
+    if (UpdateList(configState, configState.shardServers, shardServers, sections[4]))
+        changed = true;
+
+    if (!changed)
+        return false;
+
+    // the first delta after a Reset() is based on version 0, because it lacks
+    // the records removed in the meantime
+    delta.Writef("%U:%U:", isTracking ? version : 0, version + 1);
+    delta.Append(newHeader);
+    for (i = 0; i < SIZE(sections); i++)
+    {
+        delta.Appendf(":");
+        delta.Append(sections[i]);
+    }
+
+    header.Write(newHeader);
+    isTracking = true;
+    version++;
+
+    return true;
+}
+
+uint64_t ConfigStateDelta::GetVersion()
+{
+    return version;
+}
+
+ReadBuffer ConfigStateDelta::GetDelta()
+{
+    return ReadBuffer(delta);
+}
+
+ReadBuffer ConfigStateDelta::GetSnapshot()
+{
+    if (snapshotVersion != version)
+    {
+        snapshot.Writef("0:%U:", version);
+        snapshot.Append(header);
+        snapshot.Appendf(":");
+        WriteList(quorums, snapshot);
+        snapshot.Appendf(":");
+        WriteList(databases, snapshot);
+        snapshot.Appendf(":");
+        WriteList(tables, snapshot);
+        snapshot.Appendf(":");
+        WriteList(shards, snapshot);
+        snapshot.Appendf(":");
+        WriteList(shardServers, snapshot);
+        snapshotVersion = version;
+    }
+
+    return ReadBuffer(snapshot);
+}
+
+template<typename T>
+bool ConfigStateDelta::UpdateList(ConfigState& configState, InList<T>& list,
+ RecordMap& records, Buffer& section)
+{
+    T*                  it;
+    ConfigStateRecord*  record;
+    ConfigStateRecord*  next;
+    Buffer              data;
+    Buffer              changedRecords;
+    Buffer              removedIDs;
+    unsigned            numChanged;
+    unsigned            numRemoved;
+
+    numChanged = 0;
+    FOREACH (it, list)
+    {
+        data.Clear();
+        WriteRecord(configState, *it, data);
+
+        record = records.Get<uint64_t>(GetRecordID(it));
+        if (record == NULL)
+        {
+            record = new ConfigStateRecord;
+            record->ID = GetRecordID(it);
+            records.Insert<uint64_t>(record);
+        }
+        else if (Buffer::Cmp(record->data, data) == 0)
+        {
+            record->mark = mark;
+            continue;
+        }
+
+        record->data.Write(data);
+        record->mark = mark;
+        changedRecords.Appendf(":");
+        changedRecords.Append(data);
+        numChanged++;
+    }
+
+    numRemoved = 0;
+    for (record = records.First(); record != NULL; record = next)
+    {
+        next = records.Next(record);
+        if (record->mark == mark)
+            continue;
+        removedIDs.Appendf(":%U", record->ID);
+        records.Delete(record);
+        numRemoved++;
+    }
+
+    section.Writef("%u", numChanged);
+    section.Append(changedRecords);
+    section.Appendf(":%u", numRemoved);
+    section.Append(removedIDs);
+
+    return (numChanged > 0 || numRemoved > 0);
+}
+
+void ConfigStateDelta::WriteEmptyList(Buffer& section)
+{
+    section.Write("0:0");
+}
+
+void ConfigStateDelta::WriteList(RecordMap& records, Buffer& buffer)
+{
+    ConfigStateRecord*  record;
+
+    buffer.Appendf("%u", records.GetCount());
+    for (record = records.First(); record != NULL; record = records.Next(record))
+    {
+        buffer.Appendf(":");
+        buffer.Append(record->data);
+    }
+    buffer.Appendf(":0");
+}
+
+void ConfigStateDelta::WriteRecord(ConfigState& configState, ConfigQuorum& quorum, Buffer& buffer)
+{
+    configState.WriteQuorum(quorum, buffer, true);
+}
+
+void ConfigStateDelta::WriteRecord(ConfigState& configState, ConfigDatabase& database, Buffer& buffer)
+{
+    configState.WriteDatabase(database, buffer);
+}
+
+void ConfigStateDelta::WriteRecord(ConfigState& configState, ConfigTable& table, Buffer& buffer)
+{
+    configState.WriteTable(table, buffer);
+}
+
+void ConfigStateDelta::WriteRecord(ConfigState& configState, ConfigShard& shard, Buffer& buffer)
+{
+    configState.WriteShard(shard, buffer, true);
+}
+
+void ConfigStateDelta::WriteRecord(ConfigState& configState, ConfigShardServer& shardServer,
+ Buffer& buffer)
+{
+    configState.WriteShardServer(shardServer, buffer, true);
+}
@@ -0,0 +1,99 @@
+#ifndef CONFIGSTATEDELTA_H
+#define CONFIGSTATEDELTA_H
+
+#include "System/Common.h"
+#include "System/Buffers/Buffer.h"
+#include "System/Containers/InTreeMap.h"
+#include "ConfigState.h"
+
+/*
+===============================================================================================
+
+ ConfigStateRecord is the last serialized form of a quorum, database, table,
+ shard or shard server sent by the master.
+
+===============================================================================================
+*/
+
+class ConfigStateRecord
+{
+public:
+    typedef InTreeNode<ConfigStateRecord> TreeNode;
+
+    uint64_t                ID;
+    uint64_t                mark;
+    Buffer                  data;
+    TreeNode                treeNode;
+};
+
+/*
+===============================================================================================
+
+ ConfigStateDelta keeps track of the config state sent to the listeners and computes the
+ changes between consecutive versions.
+
+ Each change of the state is assigned a new version. A delta is written as
+
+    base:version:<master>:<nextIDs>:<quorums>:<databases>:<tables>:<shards>:<shardServers>
+
+ where each list is num{:record}:numRemoved{:ID}. A delta based on version 0 contains every
+ record, so it is a snapshot of the whole state.
+
+===============================================================================================
+*/
+
+class ConfigStateDelta
+{
+public:
+    typedef InTreeMap<ConfigStateRecord> RecordMap;
+
+    ConfigStateDelta();
+    ~ConfigStateDelta();
+
+    // drops the tracked records, the next delta will be a snapshot
+    void                    Reset();
+
+    // returns true if the state changed since the last call, the databases, tables and
+    // shards are only compared if the paxosID changed or if force is set
+    bool                    Update(ConfigState& configState, bool force = false);
+
+    uint64_t                GetVersion();
+    // the changes from GetVersion() - 1 to GetVersion()
+    ReadBuffer              GetDelta();
+    // the whole state at GetVersion()
+    ReadBuffer              GetSnapshot();
+
+private:
+    template<typename T>
+    bool                    UpdateList(ConfigState& configState, InList<T>& list,
+                             RecordMap& records, Buffer& section);
+    void                    WriteEmptyList(Buffer& section);
+    void                    WriteList(RecordMap& records, Buffer& buffer);
+
+    static void             WriteRecord(ConfigState& configState, ConfigQuorum& quorum,
+                             Buffer& buffer);
+    static void             WriteRecord(ConfigState& configState, ConfigDatabase& database,
+                             Buffer& buffer);
+    static void             WriteRecord(ConfigState& configState, ConfigTable& table,
+                             Buffer& buffer);
+    static void             WriteRecord(ConfigState& configState, ConfigShard& shard,
+                             Buffer& buffer);
+    static void             WriteRecord(ConfigState& configState, ConfigShardServer& shardServer,
+                             Buffer& buffer);
+
+    bool                    isTracking;
+    uint64_t                version;
+    uint64_t                paxosID;
+    uint64_t                mark;
+    Buffer                  header;
+    Buffer                  delta;
+    Buffer                  snapshot;
+    uint64_t                snapshotVersion;
+    RecordMap               quorums;
+    RecordMap               databases;
+    RecordMap               tables;
+    RecordMap               shards;
+    RecordMap               shardServers;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "SDBPConnection.h"
 #include "SDBPServer.h"
+#include "SDBPServerLoop.h"
 #include "SDBPContext.h"
 #include "SDBPRequestMessage.h"
 #include "SDBPResponseMessage.h"
@@ -14,8 +15,12 @@ SDBPConnection::SDBPConnection()
 {
     server = NULL;
     context = NULL;
+    loop = NULL;
+    closing = false;
+    closed = false;
     numPending = 0;
     numCompleted = 0;
+    binary = false;
     autoFlush = false;
     onKeepAlive.SetCallable(MFUNC(SDBPConnection, OnKeepAlive));
     onKeepAlive.SetDelay(0);
@@ -36,6 +41,8 @@ void SDBPConnection::Init(SDBPServer* server_)
     ClientSession::Init();
     
     numCompleted = 0;
+    binary = false;
+    closing = false;
     connectTimestamp = NowClock();
     server = server_;
     
@@ -43,6 +50,10 @@ void SDBPConnection::Init(SDBPServer* server_)
     Log_Message("[%s] Client connected", remoteEndpoint.ToString());
     
     resp.Hello();
+    if (configFile.GetBoolValue("sdbp.binaryProtocol", true))
+        resp.number = SDBP_PROTOCOL_VERSION_DELTA;
+    else
+        resp.number = SDBP_PROTOCOL_VERSION_TEXT;
     sdbpResponse.response = &resp;
     Write(sdbpResponse);
     Flush();
@@ -60,20 +71,39 @@ bool SDBPConnection::OnMessage(ReadBuffer& msg)
 {
     SDBPRequestMessage  sdbpRequest;
     ClientRequest*      request;
+    SDBPLoopMessage*    message;
 
     if (onKeepAlive.GetDelay() > 0)
         EventLoop::Reset(&onKeepAlive);
 
-    request = REQUEST_CACHE->CreateRequest();
+    // the request cache is not shared with the client loops
+    if (loop != NULL)
+        request = new ClientRequest;
+    else
+        request = REQUEST_CACHE->CreateRequest();
     request->session = this;
     sdbpRequest.request = request;
     if (!sdbpRequest.Read(msg) || !context->IsValidClientRequest(request))
     {
-        REQUEST_CACHE->DeleteRequest(request);
+        if (loop != NULL)
+            delete request;
+        else
+            REQUEST_CACHE->DeleteRequest(request);
         OnClose();
         return true;
     }
 
+    if (sdbpRequest.binary)
+        binary = true;
+
+    if (loop != NULL)
+    {
+        message = new SDBPLoopMessage(SDBPLoopMessage::REQUEST, this);
+        message->request = request;
+        server->PostToMain(message);
+        return false;
+    }
+
     numPending++;
     context->OnClientRequest(request);
     return false;
@@ -92,6 +122,9 @@ void SDBPConnection::OnWrite()
 void SDBPConnection::OnClose()
 {
     uint64_t    elapsed;
+
+    if (loop != NULL && closing)
+        return;
         
     if (onKeepAlive.GetDelay() > 0)
         EventLoop::Remove(&onKeepAlive);
@@ -100,6 +133,15 @@ void SDBPConnection::OnClose()
 
     Log_Message("[%s] Client disconnected (active: %u seconds, served: %u requests)", 
      remoteEndpoint.ToString(), (unsigned)(elapsed / 1000.0 + 0.5), numCompleted);
+
+    if (loop != NULL)
+    {
+        // the session is closed on the main event loop
+        closing = true;
+        MessageConnection::Close();
+        server->PostToMain(new SDBPLoopMessage(SDBPLoopMessage::CLOSE, this));
+        return;
+    }
     
     context->OnClientClose(this);
     MessageConnection::Close();
@@ -115,18 +157,25 @@ void SDBPConnection::OnComplete(ClientRequest* request, bool last)
 {
     SDBPResponseMessage sdbpResponse;
 
+    if (loop != NULL)
+    {
+        PostResponse(request, last);
+        return;
+    }
+
     if (last)
         numPending--;
 
     if (state == TCPConnection::CONNECTED &&
      request->response.type != CLIENTRESPONSE_NORESPONSE &&
      !(request->response.type == CLIENTRESPONSE_CONFIG_STATE &&
-      TCPConnection::GetWriteBuffer().GetLength() > SDBP_MAX_QUEUED_BYTES))
+      TCPConnection::GetWriteLength() > SDBP_MAX_QUEUED_BYTES))
     {
         sdbpResponse.response = &request->response;
+        sdbpResponse.binary = binary;
         Write(sdbpResponse);
         // TODO: HACK
-        if (TCPConnection::GetWriteBuffer().GetLength() >= MESSAGING_BUFFER_THRESHOLD || last ||
+        if (TCPConnection::GetWriteLength() >= MESSAGING_BUFFER_THRESHOLD || last ||
          request->type == CLIENTREQUEST_GET_CONFIG_STATE)
             Flush();
     }
@@ -146,6 +195,9 @@ void SDBPConnection::OnComplete(ClientRequest* request, bool last)
 
 bool SDBPConnection::IsActive()
 {
+    if (loop != NULL)
+        return !closed;
+
     if (state == DISCONNECTED)
         return false;
 
@@ -171,3 +223,99 @@ void SDBPConnection::OnKeepAlive()
     Log_Message("[%s] Keep alive timeout occured", remoteEndpoint.ToString());
     OnClose();
 }
+
+void SDBPConnection::SetLoop(SDBPServerLoop* loop_)
+{
+    loop = loop_;
+    closed = false;
+}
+
+SDBPServerLoop* SDBPConnection::GetLoop()
+{
+    return loop;
+}
+
+void SDBPConnection::OnLoopMessage(SDBPLoopMessage* message)
+{
+    switch (message->type)
+    {
+    // on the client loop
+    case SDBPLoopMessage::ACCEPT:
+        UseKeepAlive(message->keepAlive);
+        Init(loop->GetServer());
+        break;
+    case SDBPLoopMessage::RESPONSE:
+        OnResponse(message);
+        break;
+    case SDBPLoopMessage::CLOSED:
+        server->PostToMain(new SDBPLoopMessage(SDBPLoopMessage::RELEASE, this));
+        break;
+
+    // on the main event loop
+    case SDBPLoopMessage::REQUEST:
+        numPending++;
+        context->OnClientRequest(message->request);
+        break;
+    case SDBPLoopMessage::CLOSE:
+        context->OnClientClose(this);
+        closed = true;
+        if (numPending == 0)
+            loop->Post(new SDBPLoopMessage(SDBPLoopMessage::CLOSED, this));
+        break;
+    case SDBPLoopMessage::RELEASE:
+        Log_Message("[%s] Connection deleted", remoteEndpoint.ToString());
+        server->DeleteConn(this);
+        break;
+    }
+}
+
+void SDBPConnection::PostResponse(ClientRequest* request, bool last)
+{
+    SDBPResponseMessage sdbpResponse;
+    SDBPLoopMessage*    message;
+
+    // the response may point to buffers of the caller, it is serialized here
+    if (!closed && (last || request->response.type != CLIENTRESPONSE_NORESPONSE))
+    {
+        message = new SDBPLoopMessage(SDBPLoopMessage::RESPONSE, this);
+        if (request->response.type != CLIENTRESPONSE_NORESPONSE)
+        {
+            sdbpResponse.response = &request->response;
+            sdbpResponse.binary = binary;
+            message->response = new Buffer;
+            sdbpResponse.Write(*message->response);
+        }
+        message->last = last;
+        message->flush = (last || request->type == CLIENTREQUEST_GET_CONFIG_STATE);
+        message->configState = (request->response.type == CLIENTRESPONSE_CONFIG_STATE);
+        loop->Post(message);
+    }
+
+    if (!last)
+        return;
+
+    numPending--;
+    delete request;
+
+    if (closed && numPending == 0)
+        loop->Post(new SDBPLoopMessage(SDBPLoopMessage::CLOSED, this));
+}
+
+void SDBPConnection::OnResponse(SDBPLoopMessage* message)
+{
+    if (message->last)
+        numCompleted++;
+
+    if (state != TCPConnection::CONNECTED || message->response == NULL)
+        return;
+
+    if (message->configState &&
+     TCPConnection::GetWriteLength() > SDBP_MAX_QUEUED_BYTES)
+        return;
+
+    Write(message->response);
+    message->response = NULL;
+    if (TCPConnection::GetWriteLength() >= MESSAGING_BUFFER_THRESHOLD ||
+     message->flush)
+        Flush();
+}
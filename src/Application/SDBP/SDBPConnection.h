@@ -9,6 +9,8 @@
 
 class SDBPContext;
 class SDBPServer;
+class SDBPServerLoop;
+class SDBPLoopMessage;
 class ClientRequest;
 
 /*
@@ -16,6 +18,10 @@ class ClientRequest;
 
  SDBPConnection
 
+ When the connection is assigned to a client loop, the socket, the timers and the read
+ and write buffers are only used on that loop, the session and the pending requests only
+ on the main event loop, see SDBPLoopMessage.
+
 ===============================================================================================
 */
 
@@ -50,14 +56,25 @@ public:
     void                UseKeepAlive(bool useKeepAlive);
     void                OnKeepAlive();
 
+    void                SetLoop(SDBPServerLoop* loop);
+    SDBPServerLoop*     GetLoop();
+    void                OnLoopMessage(SDBPLoopMessage* message);
+
 private:
+    void                PostResponse(ClientRequest* request, bool last);
+    void                OnResponse(SDBPLoopMessage* message);
+
     SDBPServer*         server;
     SDBPContext*        context;
+    SDBPServerLoop*     loop;
+    bool                closing;    // on the client loop
+    bool                closed;     // on the main event loop
     Countdown           onKeepAlive;
     Endpoint            remoteEndpoint;
     unsigned            numPending;
     unsigned            numCompleted;
     uint64_t            connectTimestamp;
+    bool                binary;     // the client sent binary requests, answer in binary
 };
 
 #endif
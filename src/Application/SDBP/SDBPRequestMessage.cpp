@@ -1,4 +1,14 @@
 #include "SDBPRequestMessage.h"
+#include "Framework/Messaging/MessageUtil.h"
+
+#define READ_NUMBER(n)  if (!reader.ReadNumber(n)) return false
+#define READ_DATA(d)    if (!reader.ReadData(d)) return false
+
+SDBPRequestMessage::SDBPRequestMessage()
+{
+    request = NULL;
+    binary = false;
+}
 
 bool SDBPRequestMessage::Read(ReadBuffer& buffer)
 {
@@ -6,10 +16,17 @@ bool SDBPRequestMessage::Read(ReadBuffer& buffer)
     char        transactional;
     unsigned    i, numNodes;
     uint64_t    nodeID;
+    uint64_t    version;
     ReadBuffer  optional;
         
     if (buffer.GetLength() < 1)
         return false;
+
+    if (buffer.GetCharAt(0) == SDBP_BINARY_MARKER)
+    {
+        binary = true;
+        return ReadBinary(buffer);
+    }
     
     read = buffer.Readf("%c:", &transactional);
     if (read == 2 && transactional == CLIENTREQUEST_TRANSACTIONAL)
@@ -30,6 +47,15 @@ bool SDBPRequestMessage::Read(ReadBuffer& buffer)
         case CLIENTREQUEST_GET_CONFIG_STATE:
             read = buffer.Readf("%c:%U",
              &request->type, &request->commandID);
+            // clients that accept config state deltas send their protocol version
+            if (read > 0 && read < (signed) buffer.GetLength())
+            {
+                buffer.Advance(read);
+                read = buffer.Readf(":%U", &version);
+                if (read < 2)
+                    return false;
+                request->acceptsConfigStateDelta = (version >= SDBP_PROTOCOL_VERSION_DELTA);
+            }
             break;
 
         /* Shard servers */
@@ -207,6 +233,17 @@ bool SDBPRequestMessage::Read(ReadBuffer& buffer)
              &request->tableID, &request->key, &request->endKey, &request->prefix,
              &request->forwardDirection);
             break;
+        case CLIENTREQUEST_MULTI_GET:
+            read = buffer.Readf("%c:%U:%U:%U:%U:%#B:%U:%#B",
+             &request->type, &request->commandID, &request->configPaxosID,
+             &request->tableID, &request->paxosID, &request->key,
+             &request->count, &request->value);
+            break;
+        case CLIENTREQUEST_MULTI_SET:
+            read = buffer.Readf("%c:%U:%U:%U:%#B:%U:%#B",
+             &request->type, &request->commandID, &request->configPaxosID,
+             &request->tableID, &request->key, &request->count, &request->value);
+            break;
         
         /* Transactions */
         case CLIENTREQUEST_START_TRANSACTION:
@@ -230,6 +267,9 @@ bool SDBPRequestMessage::Read(ReadBuffer& buffer)
 bool SDBPRequestMessage::Write(Buffer& buffer)
 {
     uint64_t*   it;
+
+    if (binary)
+        return WriteBinary(buffer);
     
     if (request->transactional)
         buffer.Appendf("%c:", CLIENTREQUEST_TRANSACTIONAL);
@@ -246,6 +286,8 @@ bool SDBPRequestMessage::Write(Buffer& buffer)
         case CLIENTREQUEST_GET_CONFIG_STATE:
             buffer.Appendf("%c:%U",
              request->type, request->commandID);
+            if (request->acceptsConfigStateDelta)
+                buffer.Appendf(":%u", SDBP_PROTOCOL_VERSION_DELTA);
             return true;
 
         /* Shard servers */
@@ -410,6 +452,17 @@ bool SDBPRequestMessage::Write(Buffer& buffer)
              request->tableID, &request->key, &request->endKey, &request->prefix,
              request->forwardDirection);
             return true;
+        case CLIENTREQUEST_MULTI_GET:
+            buffer.Appendf("%c:%U:%U:%U:%U:%#B:%U:%#B",
+             request->type, request->commandID, request->configPaxosID,
+             request->tableID, request->paxosID, &request->key,
+             request->count, &request->value);
+            return true;
+        case CLIENTREQUEST_MULTI_SET:
+            buffer.Appendf("%c:%U:%U:%U:%#B:%U:%#B",
+             request->type, request->commandID, request->configPaxosID,
+             request->tableID, &request->key, request->count, &request->value);
+            return true;
         
         /* Transactions */
         case CLIENTREQUEST_START_TRANSACTION:
@@ -427,3 +480,391 @@ bool SDBPRequestMessage::Write(Buffer& buffer)
             return false;
     }
 }
+
+bool SDBPRequestMessage::ReadBinary(ReadBuffer& buffer)
+{
+    char            marker;
+    char            flags;
+    char            forwardDirection;
+    unsigned        i, numNodes;
+    uint64_t        nodeID;
+    uint64_t        version;
+    MessageReader   reader(buffer);
+
+    if (!reader.ReadChar(marker) ||
+     !reader.ReadChar(flags) ||
+     !reader.ReadChar(request->type))
+        return false;
+    if (flags & SDBP_BINARY_TRANSACTIONAL)
+        request->transactional = true;
+    READ_NUMBER(request->commandID);
+
+    switch (request->type)
+    {
+        /* Master query */
+        case CLIENTREQUEST_GET_MASTER:
+            break;
+
+        /* Get config state: databases, tables, shards, quora */
+        case CLIENTREQUEST_GET_CONFIG_STATE:
+            if (!reader.IsEnd())
+            {
+                READ_NUMBER(version);
+                request->acceptsConfigStateDelta = (version >= SDBP_PROTOCOL_VERSION_DELTA);
+            }
+            break;
+
+        /* Shard servers */
+        case CLIENTREQUEST_UNREGISTER_SHARDSERVER:
+        case CLIENTREQUEST_ACTIVATE_SHARDSERVER:
+            READ_NUMBER(request->nodeID);
+            break;
+
+        /* Quorum management */
+        case CLIENTREQUEST_CREATE_QUORUM:
+            READ_DATA(request->name);
+            READ_NUMBER(numNodes);
+            for (i = 0; i < numNodes; i++)
+            {
+                READ_NUMBER(nodeID);
+                request->nodes.Append(nodeID);
+            }
+            break;
+        case CLIENTREQUEST_RENAME_QUORUM:
+            READ_NUMBER(request->quorumID);
+            READ_DATA(request->name);
+            break;
+        case CLIENTREQUEST_DELETE_QUORUM:
+            READ_NUMBER(request->quorumID);
+            break;
+        case CLIENTREQUEST_ADD_SHARDSERVER_TO_QUORUM:
+        case CLIENTREQUEST_REMOVE_SHARDSERVER_FROM_QUORUM:
+            READ_NUMBER(request->quorumID);
+            READ_NUMBER(request->nodeID);
+            break;
+
+        /* Database management */
+        case CLIENTREQUEST_CREATE_DATABASE:
+            READ_DATA(request->name);
+            break;
+        case CLIENTREQUEST_RENAME_DATABASE:
+            READ_NUMBER(request->databaseID);
+            READ_DATA(request->name);
+            break;
+        case CLIENTREQUEST_DELETE_DATABASE:
+        case CLIENTREQUEST_FREEZE_DATABASE:
+        case CLIENTREQUEST_UNFREEZE_DATABASE:
+            READ_NUMBER(request->databaseID);
+            break;
+        case CLIENTREQUEST_SPLIT_SHARD:
+            READ_NUMBER(request->shardID);
+            READ_DATA(request->key);
+            break;
+        case CLIENTREQUEST_MIGRATE_SHARD:
+            READ_NUMBER(request->shardID);
+            READ_NUMBER(request->quorumID);
+            break;
+
+        /* Table management */
+        case CLIENTREQUEST_CREATE_TABLE:
+            READ_NUMBER(request->databaseID);
+            READ_NUMBER(request->quorumID);
+            READ_DATA(request->name);
+            break;
+        case CLIENTREQUEST_RENAME_TABLE:
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->name);
+            break;
+        case CLIENTREQUEST_DELETE_TABLE:
+        case CLIENTREQUEST_TRUNCATE_TABLE:
+        case CLIENTREQUEST_FREEZE_TABLE:
+        case CLIENTREQUEST_UNFREEZE_TABLE:
+            READ_NUMBER(request->tableID);
+            break;
+
+        /* Data operations */
+        case CLIENTREQUEST_GET:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_NUMBER(request->paxosID);
+            READ_DATA(request->key);
+            break;
+        case CLIENTREQUEST_SET:
+        case CLIENTREQUEST_SET_IF_NOT_EXISTS:
+        case CLIENTREQUEST_GET_AND_SET:
+        case CLIENTREQUEST_APPEND:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->key);
+            READ_DATA(request->value);
+            break;
+        case CLIENTREQUEST_TEST_AND_SET:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->key);
+            READ_DATA(request->test);
+            READ_DATA(request->value);
+            break;
+        case CLIENTREQUEST_TEST_AND_DELETE:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->key);
+            READ_DATA(request->test);
+            break;
+        case CLIENTREQUEST_ADD:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->key);
+            if (!reader.ReadSignedNumber(request->number))
+                return false;
+            break;
+        case CLIENTREQUEST_DELETE:
+        case CLIENTREQUEST_REMOVE:
+        case CLIENTREQUEST_SEQUENCE_NEXT:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->key);
+            break;
+        case CLIENTREQUEST_SEQUENCE_SET:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->key);
+            READ_NUMBER(request->sequence);
+            break;
+        case CLIENTREQUEST_LIST_KEYS:
+        case CLIENTREQUEST_LIST_KEYVALUES:
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->key);
+            READ_DATA(request->endKey);
+            READ_DATA(request->prefix);
+            READ_NUMBER(request->count);
+            if (!reader.ReadChar(forwardDirection))
+                return false;
+            request->forwardDirection = (forwardDirection != 0);
+            break;
+        case CLIENTREQUEST_COUNT:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->key);
+            READ_DATA(request->endKey);
+            READ_DATA(request->prefix);
+            if (!reader.ReadChar(forwardDirection))
+                return false;
+            request->forwardDirection = (forwardDirection != 0);
+            break;
+        case CLIENTREQUEST_MULTI_GET:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_NUMBER(request->paxosID);
+            READ_DATA(request->key);
+            READ_NUMBER(request->count);
+            READ_DATA(request->value);
+            break;
+        case CLIENTREQUEST_MULTI_SET:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->tableID);
+            READ_DATA(request->key);
+            READ_NUMBER(request->count);
+            READ_DATA(request->value);
+            break;
+
+        /* Transactions */
+        case CLIENTREQUEST_START_TRANSACTION:
+            READ_NUMBER(request->configPaxosID);
+            READ_NUMBER(request->quorumID);
+            READ_DATA(request->key);
+            break;
+        case CLIENTREQUEST_COMMIT_TRANSACTION:
+        case CLIENTREQUEST_ROLLBACK_TRANSACTION:
+            READ_NUMBER(request->quorumID);
+            break;
+
+        default:
+            return false;
+    }
+
+    return (reader.IsEnd());
+}
+
+bool SDBPRequestMessage::WriteBinary(Buffer& buffer)
+{
+    uint64_t*   it;
+
+    buffer.Append(SDBP_BINARY_MARKER);
+    buffer.Append((char) (request->transactional ? SDBP_BINARY_TRANSACTIONAL : 0));
+    buffer.Append(request->type);
+    MessageUtil::WriteNumber(buffer, request->commandID);
+
+    switch (request->type)
+    {
+        /* Master query */
+        case CLIENTREQUEST_GET_MASTER:
+            return true;
+
+        /* Get config state: databases, tables, shards, quora */
+        case CLIENTREQUEST_GET_CONFIG_STATE:
+            if (request->acceptsConfigStateDelta)
+                MessageUtil::WriteNumber(buffer, SDBP_PROTOCOL_VERSION_DELTA);
+            return true;
+
+        /* Shard servers */
+        case CLIENTREQUEST_UNREGISTER_SHARDSERVER:
+        case CLIENTREQUEST_ACTIVATE_SHARDSERVER:
+            MessageUtil::WriteNumber(buffer, request->nodeID);
+            return true;
+
+        /* Quorum management */
+        case CLIENTREQUEST_CREATE_QUORUM:
+            MessageUtil::WriteData(buffer, request->name);
+            MessageUtil::WriteNumber(buffer, request->nodes.GetLength());
+            for (it = request->nodes.First(); it != NULL; it = request->nodes.Next(it))
+                MessageUtil::WriteNumber(buffer, *it);
+            return true;
+        case CLIENTREQUEST_RENAME_QUORUM:
+            MessageUtil::WriteNumber(buffer, request->quorumID);
+            MessageUtil::WriteData(buffer, request->name);
+            return true;
+        case CLIENTREQUEST_DELETE_QUORUM:
+            MessageUtil::WriteNumber(buffer, request->quorumID);
+            return true;
+        case CLIENTREQUEST_ADD_SHARDSERVER_TO_QUORUM:
+        case CLIENTREQUEST_REMOVE_SHARDSERVER_FROM_QUORUM:
+            MessageUtil::WriteNumber(buffer, request->quorumID);
+            MessageUtil::WriteNumber(buffer, request->nodeID);
+            return true;
+
+        /* Database management */
+        case CLIENTREQUEST_CREATE_DATABASE:
+            MessageUtil::WriteData(buffer, request->name);
+            return true;
+        case CLIENTREQUEST_RENAME_DATABASE:
+            MessageUtil::WriteNumber(buffer, request->databaseID);
+            MessageUtil::WriteData(buffer, request->name);
+            return true;
+        case CLIENTREQUEST_DELETE_DATABASE:
+        case CLIENTREQUEST_FREEZE_DATABASE:
+        case CLIENTREQUEST_UNFREEZE_DATABASE:
+            MessageUtil::WriteNumber(buffer, request->databaseID);
+            return true;
+        case CLIENTREQUEST_SPLIT_SHARD:
+            MessageUtil::WriteNumber(buffer, request->shardID);
+            MessageUtil::WriteData(buffer, request->key);
+            return true;
+        case CLIENTREQUEST_MIGRATE_SHARD:
+            MessageUtil::WriteNumber(buffer, request->shardID);
+            MessageUtil::WriteNumber(buffer, request->quorumID);
+            return true;
+
+        /* Table management */
+        case CLIENTREQUEST_CREATE_TABLE:
+            MessageUtil::WriteNumber(buffer, request->databaseID);
+            MessageUtil::WriteNumber(buffer, request->quorumID);
+            MessageUtil::WriteData(buffer, request->name);
+            return true;
+        case CLIENTREQUEST_RENAME_TABLE:
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->name);
+            return true;
+        case CLIENTREQUEST_DELETE_TABLE:
+        case CLIENTREQUEST_TRUNCATE_TABLE:
+        case CLIENTREQUEST_FREEZE_TABLE:
+        case CLIENTREQUEST_UNFREEZE_TABLE:
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            return true;
+
+        /* Data operations */
+        case CLIENTREQUEST_GET:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteNumber(buffer, request->paxosID);
+            MessageUtil::WriteData(buffer, request->key);
+            return true;
+        case CLIENTREQUEST_SET:
+        case CLIENTREQUEST_SET_IF_NOT_EXISTS:
+        case CLIENTREQUEST_GET_AND_SET:
+        case CLIENTREQUEST_APPEND:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->key);
+            MessageUtil::WriteData(buffer, request->value);
+            return true;
+        case CLIENTREQUEST_TEST_AND_SET:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->key);
+            MessageUtil::WriteData(buffer, request->test);
+            MessageUtil::WriteData(buffer, request->value);
+            return true;
+        case CLIENTREQUEST_TEST_AND_DELETE:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->key);
+            MessageUtil::WriteData(buffer, request->test);
+            return true;
+        case CLIENTREQUEST_ADD:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->key);
+            MessageUtil::WriteSignedNumber(buffer, request->number);
+            return true;
+        case CLIENTREQUEST_DELETE:
+        case CLIENTREQUEST_REMOVE:
+        case CLIENTREQUEST_SEQUENCE_NEXT:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->key);
+            return true;
+        case CLIENTREQUEST_SEQUENCE_SET:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->key);
+            MessageUtil::WriteNumber(buffer, request->sequence);
+            return true;
+        case CLIENTREQUEST_LIST_KEYS:
+        case CLIENTREQUEST_LIST_KEYVALUES:
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->key);
+            MessageUtil::WriteData(buffer, request->endKey);
+            MessageUtil::WriteData(buffer, request->prefix);
+            MessageUtil::WriteNumber(buffer, request->count);
+            buffer.Append((char) (request->forwardDirection ? 1 : 0));
+            return true;
+        case CLIENTREQUEST_COUNT:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->key);
+            MessageUtil::WriteData(buffer, request->endKey);
+            MessageUtil::WriteData(buffer, request->prefix);
+            buffer.Append((char) (request->forwardDirection ? 1 : 0));
+            return true;
+        case CLIENTREQUEST_MULTI_GET:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteNumber(buffer, request->paxosID);
+            MessageUtil::WriteData(buffer, request->key);
+            MessageUtil::WriteNumber(buffer, request->count);
+            MessageUtil::WriteData(buffer, request->value);
+            return true;
+        case CLIENTREQUEST_MULTI_SET:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->tableID);
+            MessageUtil::WriteData(buffer, request->key);
+            MessageUtil::WriteNumber(buffer, request->count);
+            MessageUtil::WriteData(buffer, request->value);
+            return true;
+
+        /* Transactions */
+        case CLIENTREQUEST_START_TRANSACTION:
+            MessageUtil::WriteNumber(buffer, request->configPaxosID);
+            MessageUtil::WriteNumber(buffer, request->quorumID);
+            MessageUtil::WriteData(buffer, request->key);
+            return true;
+        case CLIENTREQUEST_COMMIT_TRANSACTION:
+        case CLIENTREQUEST_ROLLBACK_TRANSACTION:
+            MessageUtil::WriteNumber(buffer, request->quorumID);
+            return true;
+
+        default:
+            return false;
+    }
+}
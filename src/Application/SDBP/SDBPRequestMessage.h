@@ -4,13 +4,43 @@
 #include "Framework/Messaging/Message.h"
 #include "Application/Common/ClientRequest.h"
 
+// The server advertises the protocol version in the HELLO response. Clients only switch to
+// binary framing if the server supports it, and the server answers binary requests in binary.
+#define SDBP_PROTOCOL_VERSION_TEXT      1
+#define SDBP_PROTOCOL_VERSION_BINARY    2
+// binary servers also send config state deltas to clients that ask for them
+#define SDBP_PROTOCOL_VERSION_DELTA     3
+
+// binary messages start with this byte, text messages never do
+#define SDBP_BINARY_MARKER              '\x01'
+#define SDBP_BINARY_TRANSACTIONAL       0x01
+
+/*
+===============================================================================================
+
+ SDBPRequestMessage
+
+ Text format: colon separated fields, numbers in decimal, buffers as <length>:<data>.
+ Binary format: marker, flags, type byte, then the same fields as the text format with
+ numbers as varints and buffers as <varint length><data>.
+
+===============================================================================================
+*/
+
 class SDBPRequestMessage : public Message
 {
 public:
+    SDBPRequestMessage();
+
     ClientRequest*  request;
+    bool            binary;
     
     bool            Read(ReadBuffer& buffer);
     bool            Write(Buffer& buffer);
+
+private:
+    bool            ReadBinary(ReadBuffer& buffer);
+    bool            WriteBinary(Buffer& buffer);
 };
 
 #endif
@@ -1,13 +1,29 @@
 #include "SDBPResponseMessage.h"
 #include "Application/Common/ClientRequest.h"
+#include "Framework/Messaging/MessageUtil.h"
 #include "Version.h"
 
+#define READ_NUMBER(n)  if (!reader.ReadNumber(n)) return false
+#define READ_DATA(d)    if (!reader.ReadData(d)) return false
+
+SDBPResponseMessage::SDBPResponseMessage()
+{
+    response = NULL;
+    binary = false;
+}
+
 bool SDBPResponseMessage::Read(ReadBuffer& buffer)
 {
     int             read;
         
     if (buffer.GetLength() < 1)
         return false;
+
+    if (buffer.GetCharAt(0) == SDBP_BINARY_MARKER)
+    {
+        binary = true;
+        return ReadBinary(buffer);
+    }
     
     switch (buffer.GetCharAt(0))
     {
@@ -82,6 +98,13 @@ bool SDBPResponseMessage::Read(ReadBuffer& buffer)
                 return false;
             }
             return true;
+        case CLIENTRESPONSE_CONFIG_STATE_DELTA:
+            read = buffer.Readf("%c:%U:",
+             &response->type, &response->commandID);
+            if (read <= 0)
+                return false;
+            response->value.Wrap(buffer.GetBuffer() + read, buffer.GetLength() - read);
+            return true;
         case CLIENTRESPONSE_NOSERVICE:
         case CLIENTRESPONSE_BADSCHEMA:
         case CLIENTRESPONSE_FAILED:
@@ -107,6 +130,10 @@ bool SDBPResponseMessage::Read(ReadBuffer& buffer)
 
 bool SDBPResponseMessage::Write(Buffer& buffer)
 {
+    // HELLO is sent before the client could choose the protocol
+    if (binary && response->type != CLIENTRESPONSE_HELLO)
+        return WriteBinary(buffer);
+
     switch (response->type)
     {
         case CLIENTRESPONSE_OK:
@@ -145,6 +172,11 @@ bool SDBPResponseMessage::Write(Buffer& buffer)
             buffer.Writef("%c:%U:",
              response->type, response->request->commandID);
             return response->configState.Get()->Write(buffer, true);
+        case CLIENTRESPONSE_CONFIG_STATE_DELTA:
+            buffer.Writef("%c:%U:",
+             response->type, response->request->commandID);
+            buffer.Append(response->value);
+            return true;
         case CLIENTRESPONSE_NOSERVICE:
         case CLIENTRESPONSE_BADSCHEMA:
         case CLIENTRESPONSE_FAILED:
@@ -153,7 +185,7 @@ bool SDBPResponseMessage::Write(Buffer& buffer)
             return true;
         case CLIENTRESPONSE_HELLO:
             {
-                uint64_t    clientVersion = 1;
+                uint64_t    clientVersion = response->number;
                 uint64_t    commandID = 0;
                 Buffer      msg;
 
@@ -246,3 +278,164 @@ void SDBPResponseMessage::WriteOptionalParts(Buffer& buffer)
     if (response->isConditionalSuccess)
         buffer.Appendf(":%cb%b", CLIENTRESPONSE_OPT_VALUE_CHANGED, response->isConditionalSuccess);
 }
+
+bool SDBPResponseMessage::ReadBinary(ReadBuffer& buffer)
+{
+    char            marker;
+    char            isConditionalSuccess;
+    unsigned        i;
+    ReadBuffer*     keys;
+    ReadBuffer*     values;
+    ReadBuffer      configState;
+    MessageReader   reader(buffer);
+
+    if (!reader.ReadChar(marker) || !reader.ReadChar(response->type))
+        return false;
+    READ_NUMBER(response->commandID);
+
+    switch (response->type)
+    {
+        case CLIENTRESPONSE_OK:
+            break;
+        case CLIENTRESPONSE_NUMBER:
+            READ_NUMBER(response->number);
+            break;
+        case CLIENTRESPONSE_SNUMBER:
+            if (!reader.ReadSignedNumber(response->snumber))
+                return false;
+            break;
+        case CLIENTRESPONSE_VALUE:
+            READ_DATA(response->value);
+            break;
+        case CLIENTRESPONSE_LIST_KEYS:
+            READ_NUMBER(response->numKeys);
+            if (response->numKeys > reader.GetRemaining().GetLength())
+                return false;
+            if (response->numKeys != 0)
+            {
+                keys = new ReadBuffer[response->numKeys];
+                for (i = 0; i < response->numKeys; i++)
+                {
+                    if (!reader.ReadData(keys[i]))
+                    {
+                        delete[] keys;
+                        return false;
+                    }
+                }
+                response->ListKeys(response->numKeys, keys);
+                delete[] keys;
+            }
+            return (reader.IsEnd());
+        case CLIENTRESPONSE_LIST_KEYVALUES:
+            READ_NUMBER(response->numKeys);
+            if (response->numKeys > reader.GetRemaining().GetLength())
+                return false;
+            if (response->numKeys != 0)
+            {
+                keys = new ReadBuffer[response->numKeys];
+                values = new ReadBuffer[response->numKeys];
+                for (i = 0; i < response->numKeys; i++)
+                {
+                    if (!reader.ReadData(keys[i]) ||
+                     !reader.ReadData(values[i]))
+                    {
+                        delete[] keys;
+                        delete[] values;
+                        return false;
+                    }
+                }
+                response->ListKeyValues(response->numKeys, keys, values);
+                delete[] keys;
+                delete[] values;
+            }
+            return (reader.IsEnd());
+        case CLIENTRESPONSE_CONFIG_STATE:
+            // the config state is rare and large, it stays in text format
+            configState = reader.GetRemaining();
+            if (!response->configState.Get()->Read(configState, true))
+            {
+                response->configState.Free();
+                return false;
+            }
+            return true;
+        case CLIENTRESPONSE_CONFIG_STATE_DELTA:
+            response->value = reader.GetRemaining();
+            return true;
+        case CLIENTRESPONSE_NOSERVICE:
+        case CLIENTRESPONSE_BADSCHEMA:
+        case CLIENTRESPONSE_FAILED:
+            return (reader.IsEnd());
+        case CLIENTRESPONSE_NEXT:
+            READ_NUMBER(response->number);
+            READ_DATA(response->value);
+            READ_DATA(response->endKey);
+            return (reader.IsEnd());
+        default:
+            return false;
+    }
+
+    // optional parts of OK, NUMBER, SNUMBER and VALUE
+    READ_NUMBER(response->paxosID);
+    if (!reader.ReadChar(isConditionalSuccess))
+        return false;
+    response->isConditionalSuccess = (isConditionalSuccess != 0);
+
+    return (reader.IsEnd());
+}
+
+bool SDBPResponseMessage::WriteBinary(Buffer& buffer)
+{
+    unsigned    i;
+
+    buffer.Append(SDBP_BINARY_MARKER);
+    buffer.Append(response->type);
+    MessageUtil::WriteNumber(buffer, response->request->commandID);
+
+    switch (response->type)
+    {
+        case CLIENTRESPONSE_OK:
+            break;
+        case CLIENTRESPONSE_NUMBER:
+            MessageUtil::WriteNumber(buffer, response->number);
+            break;
+        case CLIENTRESPONSE_SNUMBER:
+            MessageUtil::WriteSignedNumber(buffer, response->snumber);
+            break;
+        case CLIENTRESPONSE_VALUE:
+            MessageUtil::WriteData(buffer, response->value);
+            break;
+        case CLIENTRESPONSE_LIST_KEYS:
+            MessageUtil::WriteNumber(buffer, response->numKeys);
+            for (i = 0; i < response->numKeys; i++)
+                MessageUtil::WriteData(buffer, response->keys[i]);
+            return true;
+        case CLIENTRESPONSE_LIST_KEYVALUES:
+            MessageUtil::WriteNumber(buffer, response->numKeys);
+            for (i = 0; i < response->numKeys; i++)
+            {
+                MessageUtil::WriteData(buffer, response->keys[i]);
+                MessageUtil::WriteData(buffer, response->values[i]);
+            }
+            return true;
+        case CLIENTRESPONSE_CONFIG_STATE:
+            return response->configState.Get()->Write(buffer, true);
+        case CLIENTRESPONSE_CONFIG_STATE_DELTA:
+            buffer.Append(response->value);
+            return true;
+        case CLIENTRESPONSE_NOSERVICE:
+        case CLIENTRESPONSE_BADSCHEMA:
+        case CLIENTRESPONSE_FAILED:
+            return true;
+        case CLIENTRESPONSE_NEXT:
+            MessageUtil::WriteNumber(buffer, response->number);
+            MessageUtil::WriteData(buffer, response->value);
+            MessageUtil::WriteData(buffer, response->endKey);
+            return true;
+        default:
+            return false;
+    }
+
+    MessageUtil::WriteNumber(buffer, response->paxosID);
+    buffer.Append((char) (response->isConditionalSuccess ? 1 : 0));
+    return true;
+}
@@ -3,17 +3,25 @@
 
 #include "Framework/Messaging/Message.h"
 #include "Application/Common/ClientResponse.h"
+#include "SDBPRequestMessage.h"
 
 class SDBPResponseMessage : public Message
 {
 public:
+    SDBPResponseMessage();
+
     ClientResponse* response;
+    bool            binary;
     
     bool            Read(ReadBuffer& buffer);
     bool            Write(Buffer& buffer);
     
     int             ReadOptionalParts(ReadBuffer buffer, int offset);
     void            WriteOptionalParts(Buffer& buffer);
+
+private:
+    bool            ReadBinary(ReadBuffer& buffer);
+    bool            WriteBinary(Buffer& buffer);
 };
 
 #endif
@@ -1,7 +1,22 @@
 #include "SDBPServer.h"
+#include "System/IO/IOProcessor.h"
 
 #define CONN_BACKLOG    1000
 
+SDBPServer::SDBPServer()
+{
+    useKeepAlive = false;
+    context = NULL;
+    loops = NULL;
+    numLoops = 0;
+    onLoopMessages = MFUNC(SDBPServer, OnLoopMessages);
+}
+
+SDBPServer::~SDBPServer()
+{
+    delete[] loops;
+}
+
 void SDBPServer::Init(int port)
 {
     if (!TCPServer<SDBPServer, SDBPConnection>::Init(port, true, CONN_BACKLOG))
@@ -11,11 +26,33 @@ void SDBPServer::Init(int port)
 
 void SDBPServer::Shutdown()
 {
+    unsigned    i;
+
+    // the loops close their connections when they stop
+    for (i = 0; i < numLoops; i++)
+        loops[i].Shutdown();
+    if (numLoops > 0)
+        OnLoopMessages();
+
     Close();
 }
 
 void SDBPServer::InitConn(SDBPConnection* conn)
 {
+    SDBPServerLoop*     loop;
+    SDBPLoopMessage*    message;
+
+    if (numLoops > 0)
+    {
+        loop = &loops[conn->GetSocket().fd % numLoops];
+        conn->SetContext(context);
+        conn->SetLoop(loop);
+        message = new SDBPLoopMessage(SDBPLoopMessage::ACCEPT, conn);
+        message->keepAlive = useKeepAlive;
+        loop->Post(message);
+        return;
+    }
+
     conn->UseKeepAlive(useKeepAlive);
     conn->Init(this);
     conn->SetContext(context);
@@ -30,3 +67,71 @@ void SDBPServer::UseKeepAlive(bool useKeepAlive_)
 {
     useKeepAlive = useKeepAlive_;
 }
+
+void SDBPServer::InitLoops(unsigned numLoops_)
+{
+    unsigned    i;
+
+    if (numLoops_ == 0)
+        return;
+
+    if (numLoops_ > IOPROCESSOR_MAX_LOOPS - 1)
+        numLoops_ = IOPROCESSOR_MAX_LOOPS - 1;
+
+    // loop 0 is the main event loop
+    loops = new SDBPServerLoop[numLoops_];
+    for (i = 0; i < numLoops_; i++)
+    {
+        if (!loops[i].Init(this, i + 1))
+            break;
+    }
+
+    if (i < numLoops_)
+    {
+        Log_Message("Cannot start client event loops, serving clients on the main event loop");
+        while (i > 0)
+            loops[--i].Shutdown();
+        delete[] loops;
+        loops = NULL;
+        return;
+    }
+
+    numLoops = numLoops_;
+    Log_Message("Serving clients on %u event loops", numLoops);
+}
+
+unsigned SDBPServer::GetNumLoops()
+{
+    return numLoops;
+}
+
+void SDBPServer::PostToMain(SDBPLoopMessage* message)
+{
+    if (loopMessages.Enqueue(message))
+        IOProcessor::Complete(&onLoopMessages);
+}
+
+void SDBPServer::CloseConns(SDBPServerLoop* loop)
+{
+    SDBPConnection*     it;
+    SDBPConnection*     next;
+
+    // runs on the stopping loop while the main event loop waits for it in Shutdown()
+    for (it = activeConns.First(); it != NULL; it = next)
+    {
+        next = activeConns.Next(it);
+        if (it->GetLoop() == loop)
+            it->OnClose();
+    }
+}
+
+void SDBPServer::OnLoopMessages()
+{
+    SDBPLoopMessage*    message;
+
+    while ((message = loopMessages.Dequeue()) != NULL)
+    {
+        message->conn->OnLoopMessage(message);
+        delete message;
+    }
+}
@@ -3,6 +3,7 @@
 
 #include "Framework/TCP/TCPServer.h"
 #include "SDBPConnection.h"
+#include "SDBPServerLoop.h"
 
 class SDBPContext; // forward
 
@@ -11,12 +12,18 @@ class SDBPContext; // forward
 
  SDBPServer
 
+ With client loops the connections are accepted on the main event loop and are assigned
+ to the loops by their socket, otherwise they are served on the main event loop.
+
 ===============================================================================================
 */
 
 class SDBPServer : public TCPServer<SDBPServer, SDBPConnection>
 {
 public:
+    SDBPServer();
+    ~SDBPServer();
+
     void            Init(int port);
     void            Shutdown();
     
@@ -24,9 +31,22 @@ public:
     void            SetContext(SDBPContext* context);
     void            UseKeepAlive(bool useKeepAlive_);
 
+    void            InitLoops(unsigned numLoops);
+    unsigned        GetNumLoops();
+    // called on the client loops
+    void            PostToMain(SDBPLoopMessage* message);
+    void            CloseConns(SDBPServerLoop* loop);
+
 private:
+    void            OnLoopMessages();
+
     bool            useKeepAlive;
     SDBPContext*    context;
+
+    SDBPServerLoop* loops;
+    unsigned        numLoops;
+    Callable        onLoopMessages;
+    InLockFreeQueue<SDBPLoopMessage> loopMessages;
 };
 
 #endif
@@ -0,0 +1,112 @@
+#include "SDBPServerLoop.h"
+#include "SDBPServer.h"
+#include "SDBPConnection.h"
+#include "System/Events/EventLoop.h"
+#include "System/IO/IOProcessor.h"
+
+SDBPLoopMessage::SDBPLoopMessage(Type type_, SDBPConnection* conn_)
+{
+    type = type_;
+    conn = conn_;
+    request = NULL;
+    response = NULL;
+    last = false;
+    flush = false;
+    configState = false;
+    keepAlive = false;
+    next = this;
+}
+
+SDBPLoopMessage::~SDBPLoopMessage()
+{
+    delete response;
+}
+
+SDBPServerLoop::SDBPServerLoop()
+{
+    server = NULL;
+    loopID = 0;
+    thread = NULL;
+    running = false;
+    onMessages = MFUNC(SDBPServerLoop, OnMessages);
+}
+
+bool SDBPServerLoop::Init(SDBPServer* server_, unsigned loopID_)
+{
+    server = server_;
+    loopID = loopID_;
+
+    if (!IOProcessor::InitLoop(loopID))
+        return false;
+
+    running = true;
+    thread = ThreadPool::Create(1);
+    thread->Execute(MFUNC(SDBPServerLoop, Run));
+    thread->Start();
+
+    return true;
+}
+
+void SDBPServerLoop::Shutdown()
+{
+    if (thread == NULL)
+        return;
+
+    running = false;
+    IOProcessor::Complete(&onMessages, loopID);
+    thread->Stop();
+    delete thread;
+    thread = NULL;
+
+    IOProcessor::ShutdownLoop(loopID);
+}
+
+SDBPServer* SDBPServerLoop::GetServer()
+{
+    return server;
+}
+
+void SDBPServerLoop::Post(SDBPLoopMessage* message)
+{
+    // the loop is stopped at shutdown, the connections are already closed
+    if (!running)
+    {
+        delete message;
+        return;
+    }
+
+    if (messages.Enqueue(message))
+        IOProcessor::Complete(&onMessages, loopID);
+}
+
+void SDBPServerLoop::Run()
+{
+    IOProcessor::SetThreadLoop(loopID);
+    EventLoop::InitThread();
+
+    Log_Debug("Client loop %u started", loopID);
+
+    while (running)
+    {
+        if (!EventLoop::RunOnce())
+            break;
+    }
+
+    // start the accepted connections, then close all of them
+    OnMessages();
+    server->CloseConns(this);
+
+    EventLoop::ShutdownThread();
+    IOProcessor::SetThreadLoop(0);
+}
+
+void SDBPServerLoop::OnMessages()
+{
+    SDBPLoopMessage*    message;
+
+    while ((message = messages.Dequeue()) != NULL)
+    {
+        message->conn->OnLoopMessage(message);
+        delete message;
+    }
+}
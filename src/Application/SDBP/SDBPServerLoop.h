@@ -0,0 +1,96 @@
+#ifndef SDBPSERVERLOOP_H
+#define SDBPSERVERLOOP_H
+
+#include "System/Containers/InLockFreeQueue.h"
+#include "System/Threading/ThreadPool.h"
+#include "System/Events/Callable.h"
+#include "System/Buffers/Buffer.h"
+
+class SDBPServer;       // forward
+class SDBPConnection;   // forward
+class ClientRequest;    // forward
+
+/*
+===============================================================================================
+
+ SDBPLoopMessage
+
+ Passed between the main event loop and the client loops:
+
+ ACCEPT     main -> loop    the connection was accepted, start serving it
+ REQUEST    loop -> main    a request was read
+ RESPONSE   main -> loop    the serialized response of a request
+ CLOSE      loop -> main    the client disconnected
+ CLOSED     main -> loop    the session was closed and there are no pending requests
+ RELEASE    loop -> main    the connection can be reused
+
+===============================================================================================
+*/
+
+class SDBPLoopMessage
+{
+public:
+    enum Type
+    {
+        ACCEPT,
+        REQUEST,
+        RESPONSE,
+        CLOSE,
+        CLOSED,
+        RELEASE
+    };
+
+    SDBPLoopMessage(Type type, SDBPConnection* conn);
+    ~SDBPLoopMessage();
+
+    Type                type;
+    SDBPConnection*     conn;
+    ClientRequest*      request;
+    Buffer*             response;       // handed off to the connection when written
+    bool                last;           // the last response of the request
+    bool                flush;
+    bool                configState;    // dropped when the client is slow
+    bool                keepAlive;
+
+    SDBPLoopMessage*    next;
+};
+
+/*
+===============================================================================================
+
+ SDBPServerLoop
+
+ An event loop on its own thread with its own epoll instance, which reads and writes the
+ client connections assigned to it. The requests are executed on the main event loop,
+ the messages between the two go through lock-free queues, the consumer is only woken
+ up when its queue was empty.
+
+===============================================================================================
+*/
+
+class SDBPServerLoop
+{
+public:
+    SDBPServerLoop();
+
+    bool                Init(SDBPServer* server, unsigned loopID);
+    void                Shutdown();
+
+    SDBPServer*         GetServer();
+
+    // called on the main event loop
+    void                Post(SDBPLoopMessage* message);
+
+private:
+    void                Run();
+    void                OnMessages();
+
+    SDBPServer*         server;
+    unsigned            loopID;
+    ThreadPool*         thread;
+    volatile bool       running;
+    Callable            onMessages;
+    InLockFreeQueue<SDBPLoopMessage> messages;
+};
+
+#endif
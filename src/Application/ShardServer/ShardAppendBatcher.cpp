@@ -0,0 +1,157 @@
+#include "ShardAppendBatcher.h"
+#include "Application/Common/DatabaseConsts.h"
+#include "System/Events/EventLoop.h"
+#include "System/Registry.h"
+
+// upper bounds of the batch size histogram buckets in KB, the last one is unbounded
+static const unsigned batchSizeBounds[APPEND_BATCH_SIZE_BUCKETS] =
+ {1, 4, 16, 64, 256, 1000, 4000, 0};
+
+// upper bounds of the queueing delay histogram buckets in msec, the last one is unbounded
+static const unsigned queueDelayBounds[APPEND_QUEUE_DELAY_BUCKETS] =
+ {1, 2, 5, 10, 20, 50, 100, 0};
+
+static unsigned FindBucket(const unsigned* bounds, unsigned numBuckets, uint64_t value)
+{
+    unsigned    i;
+
+    for (i = 0; i < numBuckets - 1; i++)
+    {
+        if (value < bounds[i])
+            break;
+    }
+    return i;
+}
+
+ShardAppendBatcher::ShardAppendBatcher()
+{
+    unsigned    i;
+    Buffer      name;
+
+    // the histograms are summed over all quorums of the shard server
+    for (i = 0; i < APPEND_BATCH_SIZE_BUCKETS; i++)
+    {
+        if (batchSizeBounds[i] > 0)
+            name.Writef("replication.batchSize.under%uKB", batchSizeBounds[i]);
+        else
+            name.Writef("replication.batchSize.over%uKB", batchSizeBounds[i - 1]);
+        batchSize[i] = Registry::GetUintPtr(name);
+    }
+
+    for (i = 0; i < APPEND_QUEUE_DELAY_BUCKETS; i++)
+    {
+        if (queueDelayBounds[i] > 0)
+            name.Writef("replication.queueDelay.under%ums", queueDelayBounds[i]);
+        else
+            name.Writef("replication.queueDelay.over%ums", queueDelayBounds[i - 1]);
+        queueDelays[i] = Registry::GetUintPtr(name);
+    }
+
+    Init();
+}
+
+void ShardAppendBatcher::Init()
+{
+    batchLimit = DATABASE_REPLICATION_SIZE;
+    messageSize = 0;
+    roundTime = 0;
+    minRoundTime = 0;
+    queueDelay = 0;
+    inflightHead = 0;
+    numInflight = 0;
+}
+
+unsigned ShardAppendBatcher::GetBatchLimit()
+{
+    return batchLimit;
+}
+
+bool ShardAppendBatcher::IsBatchReady(unsigned numQueued)
+{
+    // nothing in flight, do not delay the messages
+    if (numInflight == 0)
+        return true;
+
+    return ((uint64_t) numQueued * messageSize >= batchLimit);
+}
+
+void ShardAppendBatcher::OnAppend(unsigned length, unsigned numMessages, unsigned numQueued,
+ uint64_t queueDelay_)
+{
+    Append*     append;
+
+    if (numMessages == 0)
+        return;
+
+    (*batchSize[FindBucket(batchSizeBounds, APPEND_BATCH_SIZE_BUCKETS, length / KB)])++;
+    (*queueDelays[FindBucket(queueDelayBounds, APPEND_QUEUE_DELAY_BUCKETS, queueDelay_)])++;
+
+    if (messageSize == 0)
+        messageSize = length / numMessages;
+    else
+        messageSize = (7 * messageSize + length / numMessages) / 8;
+    queueDelay = (7 * queueDelay + queueDelay_) / 8;
+
+    if (numInflight == APPEND_MAX_INFLIGHT)
+        return;
+
+    append = &inflight[(inflightHead + numInflight) % APPEND_MAX_INFLIGHT];
+    append->startTime = EventLoop::Now();
+    // the value was cut by the limit and messages were left in the queue
+    append->full = (length >= batchLimit && numQueued > numMessages);
+    numInflight++;
+}
+
+void ShardAppendBatcher::OnAppendComplete()
+{
+    uint64_t    elapsed;
+    Append*     append;
+
+    if (numInflight == 0)
+        return;
+
+    append = &inflight[inflightHead];
+    inflightHead = (inflightHead + 1) % APPEND_MAX_INFLIGHT;
+    numInflight--;
+
+    elapsed = EventLoop::Now() - append->startTime;
+    if (minRoundTime == 0 || elapsed < minRoundTime)
+        minRoundTime = elapsed;
+    else
+        minRoundTime += (elapsed - minRoundTime) / 64; // follow slow changes of the baseline
+    roundTime = (7 * roundTime + elapsed) / 8;
+
+    if (roundTime > 2 * minRoundTime && roundTime > APPEND_BATCH_CONGESTION_TIME)
+    {
+        // multiplicative decrease
+        batchLimit = MAX(batchLimit / 2, APPEND_BATCH_MIN_SIZE);
+        roundTime = minRoundTime;
+    }
+    else if (append->full)
+    {
+        // additive increase
+        batchLimit = MIN(batchLimit + APPEND_BATCH_INCREMENT, APPEND_BATCH_MAX_SIZE);
+    }
+}
+
+void ShardAppendBatcher::OnAppendFailed()
+{
+    // the values in flight were not chosen, they will be appended again
+    inflightHead = 0;
+    numInflight = 0;
+}
+
+uint64_t ShardAppendBatcher::GetRoundTime()
+{
+    return roundTime;
+}
+
+uint64_t ShardAppendBatcher::GetMinRoundTime()
+{
+    return minRoundTime;
+}
+
+uint64_t ShardAppendBatcher::GetQueueDelay()
+{
+    return queueDelay;
+}
@@ -0,0 +1,69 @@
+#ifndef SHARDAPPENDBATCHER_H
+#define SHARDAPPENDBATCHER_H
+
+#include "System/Platform.h"
+#include "Framework/Replication/Paxos/PaxosMessage.h"
+
+#define APPEND_BATCH_MIN_SIZE           (64*KB)
+#define APPEND_BATCH_MAX_SIZE           (8*MB)
+#define APPEND_BATCH_INCREMENT          (64*KB)
+#define APPEND_BATCH_CONGESTION_TIME    (5)         // msec
+#define APPEND_BATCH_SIZE_BUCKETS       (8)
+#define APPEND_QUEUE_DELAY_BUCKETS      (8)
+#define APPEND_MAX_INFLIGHT             (PAXOS_MAX_PIPELINE_WINDOW + 1)
+
+/*
+===============================================================================================
+
+ ShardAppendBatcher
+
+ Sizes the Paxos values of a quorum with AIMD. While rounds complete in about the
+ fastest round time seen and the queue holds more than fits into a value, the
+ batch limit grows additively. When the round time (replication and log commit)
+ doubles, the limit is halved. Like Nagle's algorithm a small batch is only held
+ back while a previous value is still in flight, an idle quorum appends at once.
+
+===============================================================================================
+*/
+
+class ShardAppendBatcher
+{
+public:
+    ShardAppendBatcher();
+
+    void            Init();
+
+    unsigned        GetBatchLimit();
+    bool            IsBatchReady(unsigned numQueued);
+
+    void            OnAppend(unsigned length, unsigned numMessages, unsigned numQueued,
+                     uint64_t queueDelay);
+    void            OnAppendComplete();
+    void            OnAppendFailed();
+
+    uint64_t        GetRoundTime();
+    uint64_t        GetMinRoundTime();
+    uint64_t        GetQueueDelay();
+
+private:
+    struct Append
+    {
+        uint64_t    startTime;
+        bool        full;
+    };
+
+    unsigned        batchLimit;
+    unsigned        messageSize;    // average message size in bytes
+    uint64_t        roundTime;      // smoothed, in msec
+    uint64_t        minRoundTime;
+    uint64_t        queueDelay;     // smoothed, in msec
+
+    Append          inflight[APPEND_MAX_INFLIGHT];
+    unsigned        inflightHead;
+    unsigned        numInflight;
+
+    uint64_t*       batchSize[APPEND_BATCH_SIZE_BUCKETS];
+    uint64_t*       queueDelays[APPEND_QUEUE_DELAY_BUCKETS];
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "ShardCatchupReader.h"
 #include "System/Events/EventLoop.h"
+#include "System/FileSystem.h"
 #include "Application/ConfigState/ConfigState.h"
 #include "ShardQuorumProcessor.h"
 #include "ShardServer.h"
@@ -23,6 +24,8 @@ void ShardCatchupReader::Reset()
     bytesReceived = 0;
     prevBytesReceived = 0;
     nextCommit = 0;
+    AbortFileChunk();
+    chunks.Clear();
     EventLoop::Remove(&onTimeout);
 }
 
@@ -87,9 +90,124 @@ void ShardCatchupReader::OnDelete(CatchupMessage& msg)
     TryCommit();
 }
 
+void ShardCatchupReader::OnBeginFileChunk(CatchupMessage& msg)
+{
+    ShardCatchupChunk   chunk;
+
+    if (!isActive)
+        return;
+
+    if (chunkFD.GetFD() != INVALID_FD)
+    {
+        Log_Message("Chunk file %U started before the previous one ended", msg.chunkID);
+        Fail();
+        return;
+    }
+
+    chunk.remoteChunkID = msg.chunkID;
+    chunk.chunkID = environment->NextChunkID();
+    environment->GetChunkFilename(chunk.chunkID, chunkFilename);
+    if (chunkFD.Open(chunkFilename.GetBuffer(), FS_CREATE | FS_WRITEONLY | FS_TRUNCATE) == INVALID_FD)
+    {
+        Log_Message("Unable to create chunk file %s", chunkFilename.GetBuffer());
+        Fail();
+        return;
+    }
+    
+    chunks.Append(chunk);
+    chunkOffset = 0;
+    chunkSize = msg.size;
+    Log_Debug("Receiving chunk file %U as %U, size = %U", msg.chunkID, chunk.chunkID, msg.size);
+}
+
+void ShardCatchupReader::OnFileChunkData(CatchupMessage& msg)
+{
+    if (!isActive)
+        return;
+
+    if (chunkFD.GetFD() == INVALID_FD || msg.offset != chunkOffset ||
+     chunkOffset + msg.value.GetLength() > chunkSize)
+    {
+        Log_Message("Unexpected chunk file data at offset %U", msg.offset);
+        Fail();
+        return;
+    }
+
+    if (msg.value.GetChecksum() != msg.checksum)
+    {
+        Log_Message("Checksum mismatch in chunk file data at offset %U", msg.offset);
+        Fail();
+        return;
+    }
+    
+    if (FS_FileWrite(chunkFD.GetFD(), msg.value.GetBuffer(), msg.value.GetLength()) !=
+     (ssize_t) msg.value.GetLength())
+    {
+        Log_Message("Unable to write chunk file %s", chunkFilename.GetBuffer());
+        Fail();
+        return;
+    }
+
+    chunkOffset += msg.value.GetLength();
+    bytesReceived += msg.value.GetLength();
+}
+
+void ShardCatchupReader::OnEndFileChunk(CatchupMessage& msg)
+{
+    ShardCatchupChunk*  chunk;
+
+    if (!isActive)
+        return;
+
+    chunk = chunks.Last();
+    if (chunkFD.GetFD() == INVALID_FD || chunk == NULL || chunk->remoteChunkID != msg.chunkID ||
+     chunkOffset != chunkSize)
+    {
+        Log_Message("Chunk file %U is incomplete", msg.chunkID);
+        Fail();
+        return;
+    }
+
+    StorageEnvironment::Sync(chunkFD.GetFD());
+    chunkFD.Close();
+
+    // the shard's previous writes must be on disk before the chunk is added to it
+    environment->Commit(quorumProcessor->GetQuorumID());
+    if (!environment->ImportFileChunk(QUORUM_DATABASE_DATA_CONTEXT, msg.shardID, chunk->chunkID))
+    {
+        FS_Delete(chunkFilename.GetBuffer());
+        Fail();
+        return;
+    }
+}
+
+void ShardCatchupReader::OnUseFileChunk(CatchupMessage& msg)
+{
+    ShardCatchupChunk*  chunk;
+
+    if (!isActive)
+        return;
+
+    FOREACH (chunk, chunks)
+    {
+        if (chunk->remoteChunkID == msg.chunkID)
+            break;
+    }
+    
+    if (chunk == NULL || 
+     !environment->ImportFileChunk(QUORUM_DATABASE_DATA_CONTEXT, msg.shardID, chunk->chunkID))
+    {
+        Log_Message("Unable to use chunk file %U", msg.chunkID);
+        Fail();
+        return;
+    }
+}
+
 void ShardCatchupReader::OnCommit(CatchupMessage& message)
 {
-    ASSERT(isActive);
+    // the catchup may have failed on this side
+    if (!isActive)
+        return;
     
     quorumProcessor->SetPaxosID(message.paxosID);
 
@@ -115,13 +233,25 @@ void ShardCatchupReader::TryCommit()
     }
 }
 
+void ShardCatchupReader::AbortFileChunk()
+{
+    if (chunkFD.GetFD() == INVALID_FD)
+        return;
+    
+    chunkFD.Close();
+    FS_Delete(chunkFilename.GetBuffer());
+}
+
+void ShardCatchupReader::Fail()
+{
+    Abort();
+    quorumProcessor->ContinueReplication();
+}
+
 void ShardCatchupReader::OnTimeout()
 {
     if (bytesReceived == prevBytesReceived)
-    {
-        Abort();
-        quorumProcessor->ContinueReplication();
-    }
+        Fail();
     else
     {
         prevBytesReceived = bytesReceived;
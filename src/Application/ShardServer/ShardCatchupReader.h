@@ -3,6 +3,7 @@
 
 #include "Application/Common/CatchupMessage.h"
 #include "Framework/Storage/StorageEnvironment.h"
+#include "Framework/Storage/FDGuard.h"
 
 class ShardQuorumProcessor;
 
@@ -10,6 +11,21 @@ class ShardQuorumProcessor;
 #define SHARD_CATCHUP_READER_DELAY      60*1000 // msec
 
 
+/*
+===============================================================================================
+
+ ShardCatchupChunk is a chunk file received from the catchup writer, it is stored locally
+ with a new chunkID.
+
+===============================================================================================
+*/
+
+struct ShardCatchupChunk
+{
+    uint64_t                remoteChunkID;
+    uint64_t                chunkID;
+};
+
 /*
 ===============================================================================================
 
@@ -32,11 +48,17 @@ public:
     void                    OnBeginShard(CatchupMessage& msg);
     void                    OnSet(CatchupMessage& msg);
     void                    OnDelete(CatchupMessage& msg);
+    void                    OnBeginFileChunk(CatchupMessage& msg);
+    void                    OnFileChunkData(CatchupMessage& msg);
+    void                    OnEndFileChunk(CatchupMessage& msg);
+    void                    OnUseFileChunk(CatchupMessage& msg);
     void                    OnCommit(CatchupMessage& msg);
     void                    OnAbort(CatchupMessage& msg);
 
 private:
     void                    TryCommit();
+    void                    AbortFileChunk();
+    void                    Fail();
     void                    OnTimeout();
     
     bool                    isActive;
@@ -44,6 +66,11 @@ private:
     uint64_t                bytesReceived;
     uint64_t                prevBytesReceived;
     uint64_t                nextCommit;
+    uint64_t                chunkOffset;
+    uint64_t                chunkSize;
+    Buffer                  chunkFilename;
+    FDGuard                 chunkFD;
+    List<ShardCatchupChunk> chunks;
     ShardQuorumProcessor*   quorumProcessor;
     StorageEnvironment*     environment;
     Countdown               onTimeout;
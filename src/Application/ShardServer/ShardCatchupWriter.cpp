@@ -1,5 +1,6 @@
 #include "ShardCatchupWriter.h"
 #include "System/Events/EventLoop.h"
+#include "System/FileSystem.h"
 #include "ShardQuorumProcessor.h"
 #include "ShardServer.h"
 #include "Framework/Replication/ReplicationConfig.h"
@@ -30,6 +31,15 @@ void ShardCatchupWriter::Reset()
 {
     cursor = NULL;
     isActive = false;
+    useFileChunks = false;
+    chunkID = 0;
+    lastChunkID = 0;
+    chunkOffset = 0;
+    chunkSize = 0;
+    if (chunkFD.GetFD() != INVALID_FD)
+        chunkFD.Close();
+    fileChunkIDs.Clear();
+    sentChunkIDs.Clear();
     bytesSent = 0;
     startTime = 0;
     prevBytesSent = 0;
@@ -84,6 +94,7 @@ void ShardCatchupWriter::Begin(CatchupMessage& request)
     environment->SetMergeEnabled(false);
 
     isActive = true;
+    useFileChunks = request.useFileChunks;
     nodeID = request.nodeID;
     writeReadyness.nodeID = request.nodeID;
     quorumID = request.quorumID;
@@ -188,40 +199,22 @@ void ShardCatchupWriter::SendCommit()
 
 void ShardCatchupWriter::SendFirst()
 {
-    CatchupMessage      msg;
-    ReadBuffer          key;
-    ReadBuffer          value;
-
     ASSERT(quorumProcessor->GetConfigQuorum()->shards.GetLength() > 0);
     shardID = *(quorumProcessor->GetConfigQuorum()->shards.First());
 
-    ASSERT(cursor == NULL);
-    cursor = environment->GetBulkCursor(QUORUM_DATABASE_DATA_CONTEXT, shardID);
-    cursor->SetOnBlockShard(MFUNC(ShardCatchupWriter, OnBlockShard), MFUNC(ShardCatchupWriter, OnUnblockShard));
-    ASSERT(cursor != NULL);
-
-    msg.BeginShard(shardID);
-    CONTEXT_TRANSPORT->SendQuorumMessage(nodeID, quorumID, msg);
-
-
-    // send first KV
-    kv = cursor->First();
-    if (kv == NULL)
-    {
-        SendNext();
-        return;
-    }
-
-    TransformKeyValue(kv, msg);
-    CONTEXT_TRANSPORT->SendQuorumMessage(nodeID, quorumID, msg);
-    Log_Debug("Sending BEGIN SHARD %U", shardID);
+    SendBeginShard();
 }
 
 void ShardCatchupWriter::SendNext()
 {
-    uint64_t*           itShardID;
     CatchupMessage      msg;
 
+    if (chunkFD.GetFD() != INVALID_FD)
+    {
+        SendFileChunkData();
+        return;
+    }
+
     ASSERT(cursor != NULL);
     if (kv != NULL)
     {
@@ -238,6 +231,13 @@ void ShardCatchupWriter::SendNext()
     delete cursor;
     cursor = NULL;
     
+    SendNextShard();
+}
+
+void ShardCatchupWriter::SendNextShard()
+{
+    uint64_t*           itShardID;
+
     forwardShardIDs.Add(shardID);
     itShardID = NextShard();
     
@@ -248,17 +248,133 @@ void ShardCatchupWriter::SendNext()
     }    
 
     shardID = *itShardID;
+    SendBeginShard();
+}
 
-    cursor = quorumProcessor->GetShardServer()->GetDatabaseManager()->GetEnvironment()->GetBulkCursor(
-     QUORUM_DATABASE_DATA_CONTEXT, shardID);
-    cursor->SetOnBlockShard(MFUNC(ShardCatchupWriter, OnBlockShard), MFUNC(ShardCatchupWriter, OnUnblockShard));
+void ShardCatchupWriter::SendBeginShard()
+{
+    CatchupMessage      msg;
 
     msg.BeginShard(shardID);
     CONTEXT_TRANSPORT->SendQuorumMessage(nodeID, quorumID, msg);
     Log_Debug("Sending BEGIN SHARD %U", shardID);
 
+    // the written chunk files at the beginning of the shard are sent as they are,
+    // the rest of the shard is read with the cursor
+    fileChunkIDs.Clear();
+    lastChunkID = 0;
+    if (useFileChunks)
+    {
+        environment->GetWrittenFileChunkIDs(QUORUM_DATABASE_DATA_CONTEXT, shardID, fileChunkIDs);
+        if (fileChunkIDs.GetLength() > 0)
+            lastChunkID = *fileChunkIDs.Last();
+    }
+
+    if (SendBeginFileChunk())
+        return;
+    
+    OpenCursor();
+}
+
+bool ShardCatchupWriter::SendBeginFileChunk()
+{
+    StorageFileChunk*   fileChunk;
+    CatchupMessage      msg;
+
+    while (fileChunkIDs.GetLength() > 0)
+    {
+        chunkID = fileChunkIDs.Pop();
+
+        fileChunk = environment->GetFileChunk(chunkID);
+        if (fileChunk == NULL)
+            continue; // the shard was deleted
+
+        // the chunk is shared with a shard that was already sent
+        if (sentChunkIDs.Contains(chunkID))
+        {
+            msg.UseFileChunk(shardID, chunkID);
+            CONTEXT_TRANSPORT->SendQuorumMessage(nodeID, quorumID, msg);
+            continue;
+        }
+
+        // the file is read through our own descriptor, so it stays readable
+        // even if the chunk is deleted in the meantime
+        if (chunkFD.Open(fileChunk->GetFilename().GetBuffer(), FS_READONLY) == INVALID_FD)
+        {
+            Log_Message("Unable to open chunk file %B", &fileChunk->GetFilename());
+            Abort();
+            return true;
+        }
+
+        chunkOffset = 0;
+        chunkSize = FS_FileSize(chunkFD.GetFD());
+        msg.BeginFileChunk(shardID, chunkID, chunkSize);
+        CONTEXT_TRANSPORT->SendQuorumMessage(nodeID, quorumID, msg);
+        Log_Debug("Sending chunk file %U of shard %U, size = %U", chunkID, shardID, chunkSize);
+        return true;
+    }
+
+    return false;
+}
+
+void ShardCatchupWriter::SendFileChunkData()
+{
+    uint64_t            length;
+    CatchupMessage      msg;
+
+    if (chunkOffset < chunkSize)
+    {
+        length = MIN(chunkSize - chunkOffset, SHARD_CATCHUP_FILE_SEGMENT);
+        chunkBuffer.Allocate(length);
+        if (FS_FileReadOffs(chunkFD.GetFD(), chunkBuffer.GetBuffer(), length, chunkOffset) !=
+         (ssize_t) length)
+        {
+            Log_Message("Unable to read chunk file %U at offset %U", chunkID, chunkOffset);
+            Abort();
+            return;
+        }
+        chunkBuffer.SetLength(length);
+
+        msg.FileChunkData(shardID, chunkOffset, ReadBuffer(chunkBuffer));
+        CONTEXT_TRANSPORT->SendQuorumMessage(nodeID, quorumID, msg);
+        chunkOffset += length;
+        bytesSent += length;
+    }
+
+    if (chunkOffset < chunkSize)
+        return;
+
+    chunkFD.Close();
+    msg.EndFileChunk(shardID, chunkID);
+    CONTEXT_TRANSPORT->SendQuorumMessage(nodeID, quorumID, msg);
+    sentChunkIDs.Append(chunkID);
+
+    if (SendBeginFileChunk())
+        return;
+
+    OpenCursor();
+}
+
+void ShardCatchupWriter::OpenCursor()
+{
+    CatchupMessage      msg;
+
+    ASSERT(cursor == NULL);
+
+    if (!environment->ShardExists(QUORUM_DATABASE_DATA_CONTEXT, shardID))
+    {
+        SendNextShard();
+        return;
+    }
+
+    cursor = environment->GetBulkCursor(QUORUM_DATABASE_DATA_CONTEXT, shardID);
+    cursor->SetOnBlockShard(MFUNC(ShardCatchupWriter, OnBlockShard), MFUNC(ShardCatchupWriter, OnUnblockShard));
+
     // send first KV
-    kv = cursor->First();
+    if (lastChunkID != 0)
+        kv = cursor->FirstAfter(lastChunkID);
+    else
+        kv = cursor->First();
     if (!kv)
     {
         SendNext();
@@ -269,20 +385,22 @@ void ShardCatchupWriter::SendNext()
     CONTEXT_TRANSPORT->SendQuorumMessage(nodeID, quorumID, msg);
 }
 
+bool ShardCatchupWriter::IsSending()
+{
+    return (cursor != NULL || chunkFD.GetFD() != INVALID_FD);
+}
+
 void ShardCatchupWriter::OnWriteReadyness()
 {
     uint64_t bytesBegin;
+    uint64_t gran;
 
     bytesBegin = bytesSent;
+    gran = useFileChunks ? SHARD_CATCHUP_FILE_GRAN : SHARD_CATCHUP_WRITER_GRAN;
 
-    SendNext();
-
-    while (bytesSent < bytesBegin + SHARD_CATCHUP_WRITER_GRAN)
-    {
-        if (!cursor)
-            break;
+    // nothing to send while waiting for the commit
+    while (IsSending() && bytesSent < bytesBegin + gran)
         SendNext();
-    }
 }
 
 uint64_t* ShardCatchupWriter::NextShard()
@@ -4,6 +4,7 @@
 #include "System/Containers/List.h"
 #include "System/Events/Countdown.h"
 #include "Framework/Storage/StorageBulkCursor.h"
+#include "Framework/Storage/FDGuard.h"
 #include "Application/Common/CatchupMessage.h"
 #include "Application/Common/ContextTransport.h"
 
@@ -13,6 +14,9 @@ class ShardMessage;         // forward
 
 #define SHARD_CATCHUP_WRITER_DELAY  60*1000 // msec
 #define SHARD_CATCHUP_WRITER_GRAN   64*KiB
+// chunk files are sent in segments, several segments for each write readyness
+#define SHARD_CATCHUP_FILE_SEGMENT  64*KiB
+#define SHARD_CATCHUP_FILE_GRAN     1*MiB
 
 /*
 ===============================================================================================
@@ -49,12 +53,19 @@ public:
 private:
     void                    SendFirst();
     void                    SendNext();
+    void                    SendNextShard();
+    void                    SendBeginShard();
+    bool                    SendBeginFileChunk();
+    void                    SendFileChunkData();
+    void                    OpenCursor();
+    bool                    IsSending();
     void                    OnWriteReadyness();
     uint64_t*               NextShard();
     void                    TransformKeyValue(StorageKeyValue* kv, CatchupMessage& msg);
     void                    OnTimeout();
 
     bool                    isActive;
+    bool                    useFileChunks;
     uint64_t                nodeID;
     uint64_t                quorumID;
     uint64_t                shardID;
@@ -62,6 +73,14 @@ private:
     uint64_t                startTime;
     uint64_t                prevBytesSent;
     List<uint64_t>          forwardShardIDs;
+    List<uint64_t>          fileChunkIDs;       // still to send in the current shard
+    List<uint64_t>          sentChunkIDs;
+    uint64_t                chunkID;
+    uint64_t                lastChunkID;        // the cursor starts after this chunk
+    uint64_t                chunkOffset;
+    uint64_t                chunkSize;
+    FDGuard                 chunkFD;
+    Buffer                  chunkBuffer;
     ShardQuorumProcessor*   quorumProcessor;
     StorageEnvironment*     environment;
     StorageBulkCursor*      cursor;
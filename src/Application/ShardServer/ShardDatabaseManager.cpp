@@ -4,6 +4,7 @@
 #include "Application/Common/ClientSession.h"
 #include "ShardServer.h"
 #include "Framework/Replication/ReplicationConfig.h"
+#include "Framework/Messaging/MessageUtil.h"
 #include "Framework/Storage/StoragePageCache.h"
 #include "Framework/Storage/StorageListPageCache.h"
 
@@ -34,6 +35,30 @@ static size_t Hash(uint64_t h)
     return h;
 }
 
+static bool IsValidMigrationBatch(ReadBuffer& items)
+{
+    char            type;
+    ReadBuffer      key;
+    ReadBuffer      value;
+    MessageReader   reader(items);
+
+    while (!reader.IsEnd())
+    {
+        if (!reader.ReadChar(type) || !reader.ReadData(key))
+            return false;
+
+        if (type == SHARDMESSAGE_MIGRATION_SET)
+        {
+            if (!reader.ReadData(value))
+                return false;
+        }
+        else if (type != SHARDMESSAGE_MIGRATION_DELETE)
+            return false;
+    }
+
+    return true;
+}
+
 /*
 ===============================================================================================
 
@@ -72,14 +97,38 @@ ShardDatabaseSequence::ShardDatabaseSequence()
 ===============================================================================================
 */
 
+ShardDatabaseAsyncGet::ShardDatabaseAsyncGet()
+{
+    next = prev = this;
+    request = NULL;
+    multiGet = NULL;
+    manager = NULL;
+    active = false;
+    async = false;
+}
+
 void ShardDatabaseAsyncGet::OnRequestComplete()
 {
     uint64_t        paxosID;
     uint64_t        commandID;
     ReadBuffer      userValue;
+    ShardDatabaseMultiGet*  current;
 
     active = false;
 
+    if (multiGet != NULL)
+    {
+        multiGet->OnValue(ret, value);
+        current = multiGet;
+        multiGet = NULL;
+        // when completed synchronously the loop in ContinueMultiGet() goes on
+        if (!async)
+            return;
+        OnAsyncComplete();
+        manager->ContinueMultiGet(current);
+        return;
+    }
+
     if (!ret || !request->session->IsActive())
     {
         if (!request->session->IsActive())
@@ -88,8 +137,7 @@ void ShardDatabaseAsyncGet::OnRequestComplete()
             request->response.Failed();
             
         request->OnComplete();
-        if (async && !manager->executeReads.IsActive())
-            EventLoop::Add(&manager->executeReads);
+        OnAsyncComplete();
         return;
     }
     
@@ -97,7 +145,152 @@ void ShardDatabaseAsyncGet::OnRequestComplete()
     request->response.Value(userValue);
     request->OnComplete();
 
-    if (async && !manager->executeReads.IsActive())
+    OnAsyncComplete();
+}
+
+void ShardDatabaseAsyncGet::OnAsyncComplete()
+{
+    if (!async)
+        return;
+
+    // a slot is free again, continue with the blocking reads
+    manager->inactiveAsyncGets.Append(this);
+    if (!manager->executeReads.IsActive())
+        EventLoop::Add(&manager->executeReads);
+}
+
+/*
+===============================================================================================
+
+ ShardDatabaseMultiGet
+
+===============================================================================================
+*/
+
+ShardDatabaseMultiGet::ShardDatabaseMultiGet(ClientRequest* request_, unsigned numKeys_)
+{
+    next = prev = this;
+    request = request_;
+    numKeys = numKeys_;
+    numRead = 0;
+    numFound = 0;
+    keys = new ReadBuffer[numKeys];
+    foundKeys = new ReadBuffer[numKeys];
+    foundValues = new Buffer[numKeys];
+}
+
+ShardDatabaseMultiGet::~ShardDatabaseMultiGet()
+{
+    delete[] keys;
+    delete[] foundKeys;
+    delete[] foundValues;
+}
+
+void ShardDatabaseMultiGet::OnValue(bool found, ReadBuffer& value)
+{
+    uint64_t        paxosID;
+    uint64_t        commandID;
+    ReadBuffer      userValue;
+
+    if (found)
+    {
+        // the value is copied, because the page it points into may be evicted
+        ReadValue(value, paxosID, commandID, userValue);
+        foundKeys[numFound] = keys[numRead];
+        foundValues[numFound].Write(userValue);
+        numFound++;
+    }
+
+    numRead++;
+}
+
+void ShardDatabaseMultiGet::OnComplete()
+{
+    unsigned        i;
+    ReadBuffer*     values;
+
+    if (!request->session->IsActive())
+    {
+        request->response.NoResponse();
+        request->OnComplete();
+        return;
+    }
+
+    // the found keys are sent back in one LIST_KEYVALUES response, missing keys are left out
+    if (numFound > 0)
+    {
+        values = new ReadBuffer[numFound];
+        for (i = 0; i < numFound; i++)
+            values[i].Wrap(foundValues[i]);
+        request->response.ListKeyValues(numFound, foundKeys, values);
+        request->OnComplete(false);
+        delete[] values;
+    }
+    request->response.OK();
+    request->OnComplete();
+}
+
+/*
+===============================================================================================
+
+ ShardDatabaseAsyncMemoGet
+
+===============================================================================================
+*/
+
+ShardDatabaseAsyncMemoGet::ShardDatabaseAsyncMemoGet()
+{
+    next = prev = this;
+    manager = NULL;
+}
+
+void ShardDatabaseAsyncMemoGet::OnRequestsComplete()
+{
+    uint64_t        paxosID;
+    uint64_t        commandID;
+    unsigned        i;
+    ReadBuffer      value;
+    ReadBuffer      userValue;
+    ClientRequest*  request;
+
+    for (i = 0; i < num; i++)
+    {
+        request = requests[i];
+        if (!request->session->IsActive())
+        {
+            request->response.NoResponse();
+            request->OnComplete();
+            continue;
+        }
+
+        switch (results[i])
+        {
+        case StorageMemoChunk::READ_SET:
+            value.Wrap(values[i]);
+            ReadValue(value, paxosID, commandID, userValue);
+            request->response.Value(userValue);
+            request->OnComplete();
+            break;
+        case StorageMemoChunk::READ_DELETE:
+            request->response.Failed();
+            request->OnComplete();
+            break;
+        case StorageMemoChunk::READ_NOT_FOUND:
+            // the key may be in the older chunks of the shard, and the memo chunk
+            // may have been written since it was read
+            if (!manager->StartAsyncGet(request, false))
+                manager->blockingReadRequests.Append(request);
+            break;
+        default:
+            // the memo chunk was written during every attempt, read it on the main thread
+            manager->blockingReadRequests.Append(request);
+            break;
+        }
+    }
+
+    num = 0;
+    manager->inactiveAsyncMemoGets.Append(this);
+    if (manager->blockingReadRequests.GetLength() > 0 && !manager->executeReads.IsActive())
         EventLoop::Add(&manager->executeReads);
 }
 
@@ -342,6 +535,7 @@ void ShardDatabaseManager::Init(ShardServer* shardServer_)
     sc.SetChunkSize(            (uint64_t) configFile.GetInt64Value("database.chunkSize",				64*MiB  ));
     sc.SetLogSegmentSize(       (uint64_t) configFile.GetInt64Value("database.logSegmentSize",			64*MiB  ));
     sc.SetFileChunkCacheSize(   (uint64_t) configFile.GetInt64Value("database.fileChunkCacheSize",		256*MiB ));
+    sc.SetMetaPageCacheSize(    (uint64_t) configFile.GetInt64Value("database.metaPageCacheSize",		64*MiB ));
     sc.SetMemoChunkCacheSize(   (uint64_t) configFile.GetInt64Value("database.memoChunkCacheSize",		1*GiB   ));
     sc.SetLogSize(              (uint64_t) configFile.GetInt64Value("database.logSize",					20*GiB  ));
     sc.SetMergeBufferSize(      (uint64_t) configFile.GetInt64Value("database.mergeBufferSize",			10*MiB  ));
@@ -352,6 +546,18 @@ void ShardDatabaseManager::Init(ShardServer* shardServer_)
     sc.SetAbortWaitingListsNum( (uint64_t) configFile.GetInt64Value("database.abortWaitingListsNum",	0       ));
     sc.SetListDataPageCacheSize((uint64_t) configFile.GetInt64Value("database.listDataPageCacheSize",   64*MB   ));
     sc.SetMaxChunkPerShard(     (unsigned) configFile.GetIntValue  ("database.maxChunkPerShard",        10      ));
+    sc.SetGroupCommitWindow(    (uint64_t) configFile.GetInt64Value("database.groupCommitWindow",       0       ));
+    sc.SetGroupCommitSize(      (uint64_t) configFile.GetInt64Value("database.groupCommitSize",         1*MiB   ));
+    if (configFile.GetBoolValue("database.compression", false))
+        sc.SetCompression(STORAGE_COMPRESSION_LZ);
+    else
+        sc.SetCompression(STORAGE_COMPRESSION_NONE);
+    sc.SetMapChunks(configFile.GetBoolValue("database.mapChunks", false));
+    if (strcmp(configFile.GetValue("database.memoChunkIndex", "tree"), "btree") == 0)
+        sc.SetMemoChunkIndex(STORAGE_MEMO_INDEX_BTREE);
+    else
+        sc.SetMemoChunkIndex(STORAGE_MEMO_INDEX_TREE);
+    sc.SetConcurrentMemoReads(configFile.GetBoolValue("database.concurrentMemoReads", false));
 
     envPath.Writef("%s", configFile.GetValue("database.dir", "db"));
     environment.Open(envPath, sc);
@@ -371,9 +577,17 @@ void ShardDatabaseManager::Init(ShardServer* shardServer_)
     systemShard.Init(&environment, QUORUM_DATABASE_SYSTEM_CONTEXT, 1);
     REPLICATION_CONFIG->Init(&systemShard);
     
-    // Initialize async GET
-    asyncGet.active = false;
-    asyncGet.manager = this;
+    // Initialize async GET operations
+    nonblockingGet.manager = this;
+    asyncMemoGet = NULL;
+    numAsyncGets = configFile.GetIntValue("database.numAsyncGets", 32);
+    asyncGets = new ShardDatabaseAsyncGet*[numAsyncGets];
+    for (unsigned i = 0; i < numAsyncGets; i++)
+    {
+        asyncGets[i] = new ShardDatabaseAsyncGet;
+        asyncGets[i]->manager = this;
+        inactiveAsyncGets.Append(asyncGets[i]);
+    }
 
     // Initialize async LIST operations
     numAsyncLists = configFile.GetIntValue("database.numAsyncThreads", 10);
@@ -401,6 +615,7 @@ void ShardDatabaseManager::Shutdown()
         delete node->Value();
     
     readRequests.DeleteList();
+    blockingMultiGets.DeleteList();
     environment.Close();
     StoragePageCache::Shutdown();
     StorageListPageCache::Shutdown();
@@ -413,6 +628,15 @@ void ShardDatabaseManager::Shutdown()
     }
 
     delete[] asyncLists;
+
+    inactiveAsyncGets.ClearMembers();
+    for (unsigned i = 0; i < numAsyncGets; i++)
+        delete asyncGets[i];
+
+    delete asyncMemoGet;
+    inactiveAsyncMemoGets.DeleteList();
+
+    delete[] asyncGets;
 }
 
 StorageEnvironment* ShardDatabaseManager::GetEnvironment()
@@ -669,6 +893,9 @@ uint64_t ShardDatabaseManager::ExecuteMessage(uint64_t quorumID, uint64_t paxosI
             if (!environment.Delete(contextID, shardID, message.key))
                 RESPONSE_FAIL();
             break;
+        case SHARDMESSAGE_MULTI_SET:
+            shardID = ExecuteMultiSet(paxosID, commandID, message);
+            break;
         case SHARDMESSAGE_START_TRANSACTION:
             // nothing
             break;
@@ -829,7 +1056,7 @@ unsigned ShardDatabaseManager::GetNumReadRequests()
 
 unsigned ShardDatabaseManager::GetNumBlockingReadRequests()
 {
-    return blockingReadRequests.GetLength();
+    return blockingReadRequests.GetLength() + blockingMultiGets.GetLength();
 }
 
 unsigned ShardDatabaseManager::GetNumListRequests()
@@ -898,17 +1125,15 @@ void ShardDatabaseManager::DeleteDataShards(uint64_t quorumID)
 
 void ShardDatabaseManager::OnExecuteReads()
 {
-    uint64_t        start;
-    uint64_t        shardID;
-    int16_t         contextID;
-    ReadBuffer      key;
-    ClientRequest*  itRequest;
+    uint64_t                start;
+    uint64_t                shardID;
+    int16_t                 contextID;
+    ReadBuffer              key;
+    ClientRequest*          itRequest;
+    ShardDatabaseMultiGet*  itMultiGet;
 
-    Log_Trace("asyncGet: %b", asyncGet.active);
+    Log_Trace("inactive asyncGets: %u", inactiveAsyncGets.GetLength());
 
-    if (asyncGet.active)
-        return;
-    
     start = NowClock();
 
     FOREACH_FIRST (itRequest, readRequests)
@@ -925,30 +1150,60 @@ void ShardDatabaseManager::OnExecuteReads()
             continue;
         }
 
+        if (itRequest->type == CLIENTREQUEST_MULTI_GET)
+        {
+            nextGetRequestID += 1;
+            ExecuteMultiGet(itRequest);
+            continue;
+        }
+
         key.Wrap(itRequest->key);
         contextID = QUORUM_DATABASE_DATA_CONTEXT;
         shardID = environment.GetShardID(contextID, itRequest->tableID, key);
 
         nextGetRequestID += 1;
 
-        asyncGet.request = itRequest;
-        asyncGet.key = key;
-        asyncGet.onComplete = MFUNC_OF(ShardDatabaseAsyncGet, OnRequestComplete, &asyncGet);
-        asyncGet.active = true;
-        asyncGet.async = false;
-        if (!environment.TryNonblockingGet(contextID, shardID, &asyncGet))
+        if (AddAsyncMemoGet(itRequest, contextID, shardID, key))
+            continue;
+
+        nonblockingGet.request = itRequest;
+        nonblockingGet.key = key;
+        nonblockingGet.onComplete = MFUNC_OF(ShardDatabaseAsyncGet, OnRequestComplete, &nonblockingGet);
+        nonblockingGet.active = true;
+        nonblockingGet.async = false;
+        if (!environment.TryNonblockingGet(contextID, shardID, &nonblockingGet))
         {
             // HACK store timestamp for later comparison in order to avoid duplicate memo chunk search
-            asyncGet.active = false;
+            nonblockingGet.active = false;
             itRequest->changeTimeout = start;
             blockingReadRequests.Append(itRequest);
         }
     }
 
+    // the last batch is not full, but there is nothing left to add to it
+    if (asyncMemoGet != NULL && asyncMemoGet->num > 0)
+        ExecuteAsyncMemoGet();
+
     Log_Trace("blocking");
+
+    FOREACH_FIRST (itMultiGet, blockingMultiGets)
+    {
+        // all async GETs are in progress, continue when one of them completes
+        if (inactiveAsyncGets.GetLength() == 0)
+            return;
+
+        TRY_YIELD_RETURN(executeReads, start);
+
+        blockingMultiGets.Remove(itMultiGet);
+        ContinueMultiGet(itMultiGet);
+    }
         
     FOREACH_FIRST (itRequest, blockingReadRequests)
     {
+        // all async GETs are in progress, continue when one of them completes
+        if (inactiveAsyncGets.GetLength() == 0)
+            return;
+
         TRY_YIELD_RETURN(executeReads, start);
 
         blockingReadRequests.Remove(itRequest);
@@ -961,26 +1216,261 @@ void ShardDatabaseManager::OnExecuteReads()
             continue;
         }
 
-        key.Wrap(itRequest->key);
-        contextID = QUORUM_DATABASE_DATA_CONTEXT;
-        shardID = environment.GetShardID(contextID, itRequest->tableID, key);
+        StartAsyncGet(itRequest, itRequest->changeTimeout == start);
+    }
+}
+
+bool ShardDatabaseManager::AddAsyncMemoGet(ClientRequest* request, int16_t contextID,
+ uint64_t shardID, ReadBuffer& key)
+{
+    if (asyncMemoGet == NULL)
+    {
+        asyncMemoGet = inactiveAsyncMemoGets.Pop();
+        if (asyncMemoGet == NULL)
+        {
+            asyncMemoGet = new ShardDatabaseAsyncMemoGet;
+            asyncMemoGet->manager = this;
+            asyncMemoGet->onComplete = 
+             MFUNC_OF(ShardDatabaseAsyncMemoGet, OnRequestsComplete, asyncMemoGet);
+        }
+    }
+
+    // the environment checks that the memo chunk of the shard can be read concurrently
+    if (!environment.AddAsyncMemoGet(contextID, shardID, key, asyncMemoGet))
+        return false;
+
+    asyncMemoGet->requests[asyncMemoGet->num - 1] = request;
+    if (asyncMemoGet->IsFull())
+        ExecuteAsyncMemoGet();
+
+    return true;
+}
+
+void ShardDatabaseManager::ExecuteAsyncMemoGet()
+{
+    // completes in OnRequestsComplete, which puts it back to inactiveAsyncMemoGets
+    environment.AsyncMemoGet(asyncMemoGet);
+    asyncMemoGet = NULL;
+}
 
-        asyncGet.skipMemoChunk = false;
-        if (itRequest->changeTimeout == start)
-            asyncGet.skipMemoChunk = true;
-        asyncGet.request = itRequest;
-        asyncGet.key = key;
-        asyncGet.onComplete = MFUNC_OF(ShardDatabaseAsyncGet, OnRequestComplete, &asyncGet);
-        asyncGet.active = true;
-        asyncGet.async = false;
-        environment.AsyncGet(contextID, shardID, &asyncGet);
-        if (asyncGet.active)
+bool ShardDatabaseManager::StartAsyncGet(ClientRequest* request, bool skipMemoChunk)
+{
+    uint64_t                shardID;
+    int16_t                 contextID;
+    ReadBuffer              key;
+    ShardDatabaseAsyncGet*  asyncGet;
+
+    if (inactiveAsyncGets.GetLength() == 0)
+        return false;
+
+    key.Wrap(request->key);
+    contextID = QUORUM_DATABASE_DATA_CONTEXT;
+    shardID = environment.GetShardID(contextID, request->tableID, key);
+
+    asyncGet = inactiveAsyncGets.Pop();
+    asyncGet->skipMemoChunk = skipMemoChunk;
+    asyncGet->request = request;
+    asyncGet->key = key;
+    asyncGet->onComplete = MFUNC_OF(ShardDatabaseAsyncGet, OnRequestComplete, asyncGet);
+    asyncGet->active = true;
+    asyncGet->async = false;
+    environment.AsyncGet(contextID, shardID, asyncGet);
+    if (asyncGet->active)
+    {
+        // completes later in OnRequestComplete, which puts it back to inactiveAsyncGets
+        asyncGet->async = true;
+    }
+    else
+        inactiveAsyncGets.Append(asyncGet);
+
+    return true;
+}
+
+void ShardDatabaseManager::ExecuteMultiGet(ClientRequest* request)
+{
+    uint64_t                i;
+    int16_t                 contextID;
+    ReadBuffer              items;
+    ReadBuffer              key;
+    ShardDatabaseMultiGet*  multiGet;
+
+    // every key takes at least one byte
+    if (request->count > request->value.GetLength())
+    {
+        request->response.Failed();
+        request->OnComplete();
+        return;
+    }
+
+    contextID = QUORUM_DATABASE_DATA_CONTEXT;
+    multiGet = new ShardDatabaseMultiGet(request, (unsigned) request->count);
+
+    items.Wrap(request->value);
+    MessageReader reader(items);
+    for (i = 0; i < request->count; i++)
+    {
+        if (!reader.ReadData(key))
+            break;
+
+        if (environment.GetShardID(contextID, request->tableID, key) == 0)
         {
-            // TODO: HACK
-            asyncGet.async = true;
+            delete multiGet;
+            request->response.BadSchema();
+            request->OnComplete();
             return;
         }
+
+        multiGet->keys[i] = key;
     }
+
+    if (i < request->count || !reader.IsEnd())
+    {
+        delete multiGet;
+        request->response.Failed();
+        request->OnComplete();
+        return;
+    }
+
+    ContinueMultiGet(multiGet);
+}
+
+void ShardDatabaseManager::ContinueMultiGet(ShardDatabaseMultiGet* multiGet)
+{
+    uint64_t                shardID;
+    int16_t                 contextID;
+    ReadBuffer              key;
+    ShardDatabaseAsyncGet*  asyncGet;
+
+    contextID = QUORUM_DATABASE_DATA_CONTEXT;
+
+    // the keys are read like single GETs: found in the memo chunk on the main thread,
+    // otherwise in the file chunks by an async GET, which may load pages from disk
+    while (multiGet->numRead < multiGet->numKeys && multiGet->request->session->IsActive())
+    {
+        key = multiGet->keys[multiGet->numRead];
+        shardID = environment.GetShardID(contextID, multiGet->request->tableID, key);
+
+        nonblockingGet.key = key;
+        nonblockingGet.onComplete.Unset();
+        if (environment.TryNonblockingGet(contextID, shardID, &nonblockingGet))
+        {
+            multiGet->OnValue(nonblockingGet.ret, nonblockingGet.value);
+            continue;
+        }
+
+        if (inactiveAsyncGets.GetLength() == 0)
+        {
+            // continues in OnExecuteReads() when an async GET is free
+            blockingMultiGets.Append(multiGet);
+            return;
+        }
+
+        asyncGet = inactiveAsyncGets.Pop();
+        asyncGet->skipMemoChunk = true;
+        asyncGet->request = multiGet->request;
+        asyncGet->multiGet = multiGet;
+        asyncGet->key = key;
+        asyncGet->onComplete = MFUNC_OF(ShardDatabaseAsyncGet, OnRequestComplete, asyncGet);
+        asyncGet->active = true;
+        asyncGet->async = false;
+        environment.AsyncGet(contextID, shardID, asyncGet);
+        if (asyncGet->active)
+        {
+            // continues in OnRequestComplete
+            asyncGet->async = true;
+            return;
+        }
+        inactiveAsyncGets.Append(asyncGet);
+    }
+
+    multiGet->OnComplete();
+    delete multiGet;
+}
+
+uint64_t ShardDatabaseManager::ExecuteMultiSet(uint64_t paxosID, uint64_t commandID, ShardMessage& message)
+{
+    uint64_t        shardID;
+    uint64_t        firstShardID;
+    int64_t         i;
+    int16_t         contextID;
+    ReadBuffer      key;
+    ReadBuffer      value;
+    Buffer          buffer;
+
+    contextID = QUORUM_DATABASE_DATA_CONTEXT;
+    firstShardID = 0;
+
+    // check all pairs first, so that the batch is applied completely or not at all
+    MessageReader   check(message.value);
+    for (i = 0; i < message.number; i++)
+    {
+        if (!check.ReadData(key) || !check.ReadData(value))
+            break;
+
+        shardID = environment.GetShardID(contextID, message.tableID, key);
+        if (shardID == 0)
+        {
+            if (message.clientRequest)
+                message.clientRequest->response.BadSchema();
+            return 0;
+        }
+
+        if (firstShardID == 0)
+            firstShardID = shardID;
+    }
+
+    if (i < message.number || !check.IsEnd())
+    {
+        if (message.clientRequest)
+            message.clientRequest->response.Failed();
+        return 0;
+    }
+
+    MessageReader   reader(message.value);
+    for (i = 0; i < message.number; i++)
+    {
+        reader.ReadData(key);
+        reader.ReadData(value);
+
+        shardID = environment.GetShardID(contextID, message.tableID, key);
+        WriteValue(buffer, paxosID, commandID, value);
+        if (!environment.Set(contextID, shardID, key, buffer) && message.clientRequest)
+            message.clientRequest->response.Failed();
+    }
+
+    return firstShardID;
+}
+
+bool ShardDatabaseManager::ExecuteMigrationBatch(ShardMessage& message)
+{
+    char            type;
+    int16_t         contextID;
+    ReadBuffer      key;
+    ReadBuffer      value;
+    MessageReader   reader(message.value);
+
+    contextID = QUORUM_DATABASE_DATA_CONTEXT;
+
+    // the batch is checked first, so that an invalid batch is not applied partially
+    if (!IsValidMigrationBatch(message.value))
+        return false;
+
+    // the values are stored as they were on the source shard
+    while (!reader.IsEnd())
+    {
+        reader.ReadChar(type);
+        reader.ReadData(key);
+
+        if (type == SHARDMESSAGE_MIGRATION_SET)
+        {
+            reader.ReadData(value);
+            environment.Set(contextID, message.shardID, key, value);
+        }
+        else
+            environment.Delete(contextID, message.shardID, key);
+    }
+
+    return true;
 }
 
 void ShardDatabaseManager::OnExecuteLists()
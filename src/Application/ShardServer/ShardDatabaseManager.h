@@ -7,6 +7,7 @@
 #include "Framework/Storage/StorageEnvironment.h"
 #include "Framework/Storage/StorageShardProxy.h"
 #include "Framework/Storage/StorageAsyncGet.h"
+#include "Framework/Storage/StorageAsyncMemoGet.h"
 #include "Framework/Storage/StorageAsyncList.h"
 #include "Application/ConfigState/ConfigState.h"
 #include "Application/Common/ClientRequest.h"
@@ -14,6 +15,7 @@
 
 class ShardServer;              // forward
 class ShardDatabaseManager;     // forward
+class ShardDatabaseMultiGet;    // forward
 
 
 /*
@@ -51,12 +53,70 @@ public:
 class ShardDatabaseAsyncGet : public StorageAsyncGet
 {
 public:
+    ShardDatabaseAsyncGet*  next;
+    ShardDatabaseAsyncGet*  prev;
+
     ClientRequest*          request;
+    ShardDatabaseMultiGet*  multiGet;   // set when reading a key of a MULTI_GET
     ShardDatabaseManager*   manager;
     bool                    active;
     bool                    async;
     
+    ShardDatabaseAsyncGet();
+
     void                    OnRequestComplete();
+    void                    OnAsyncComplete();
+};
+
+/*
+===============================================================================================
+ 
+ ShardDatabaseAsyncMemoGet -- helper class for GET operations on the async GET thread
+ 
+===============================================================================================
+*/
+
+class ShardDatabaseAsyncMemoGet : public StorageAsyncMemoGet
+{
+public:
+    ShardDatabaseAsyncMemoGet*  next;
+    ShardDatabaseAsyncMemoGet*  prev;
+
+    ClientRequest*              requests[STORAGE_ASYNC_MEMO_GET_SIZE];
+    ShardDatabaseManager*       manager;
+
+    ShardDatabaseAsyncMemoGet();
+
+    void                        OnRequestsComplete();
+};
+
+/*
+===============================================================================================
+ 
+ ShardDatabaseMultiGet -- the keys of a MULTI_GET read one by one with the async GET machinery
+ 
+===============================================================================================
+*/
+
+class ShardDatabaseMultiGet
+{
+public:
+    ShardDatabaseMultiGet*  next;
+    ShardDatabaseMultiGet*  prev;
+
+    ClientRequest*          request;
+    unsigned                numKeys;
+    unsigned                numRead;
+    unsigned                numFound;
+    ReadBuffer*             keys;       // point into the request
+    ReadBuffer*             foundKeys;
+    Buffer*                 foundValues;
+
+    ShardDatabaseMultiGet(ClientRequest* request, unsigned numKeys);
+    ~ShardDatabaseMultiGet();
+
+    void                    OnValue(bool found, ReadBuffer& value);
+    void                    OnComplete();
 };
 
 /*
@@ -103,8 +163,12 @@ class ShardDatabaseManager
     typedef InList<ClientRequest>                   ClientRequestList;
     typedef InTreeMap<ShardDatabaseSequence>        Sequences;
     typedef InList<ShardDatabaseAsyncList>          ShardDatabaseAsyncListList;
+    typedef InList<ShardDatabaseAsyncGet>           ShardDatabaseAsyncGetList;
+    typedef InList<ShardDatabaseAsyncMemoGet>       ShardDatabaseAsyncMemoGetList;
+    typedef InList<ShardDatabaseMultiGet>           ShardDatabaseMultiGetList;
 
     friend class ShardDatabaseAsyncGet;
+    friend class ShardDatabaseAsyncMemoGet;
     friend class ShardDatabaseAsyncList;
 
 public:
@@ -128,6 +192,7 @@ public:
     void                        OnClientListRequest(ClientRequest* request);
     bool                        OnClientSequenceNext(ClientRequest* request);
     uint64_t                    ExecuteMessage(uint64_t quorumID, uint64_t paxosID, uint64_t commandID, ShardMessage& message);
+    bool                        ExecuteMigrationBatch(ShardMessage& message);
 
     void                        OnLeaseTimeout();
 
@@ -146,6 +211,13 @@ private:
 
     void                        OnExecuteReads();
     void                        OnExecuteLists();
+    void                        ExecuteMultiGet(ClientRequest* request);
+    void                        ContinueMultiGet(ShardDatabaseMultiGet* multiGet);
+    bool                        AddAsyncMemoGet(ClientRequest* request, int16_t contextID,
+                                 uint64_t shardID, ReadBuffer& key);
+    void                        ExecuteAsyncMemoGet();
+    bool                        StartAsyncGet(ClientRequest* request, bool skipMemoChunk);
+    uint64_t                    ExecuteMultiSet(uint64_t paxosID, uint64_t commandID, ShardMessage& message);
     bool                        IsEmptyListRange(ClientRequest* request);
 
     ShardServer*                shardServer;
@@ -157,7 +229,13 @@ private:
     ClientRequestList           blockingReadRequests;
     ClientRequestList           listRequests;
     YieldTimer                  executeReads;
-    ShardDatabaseAsyncGet       asyncGet;
+    ShardDatabaseAsyncGet       nonblockingGet;
+    unsigned                    numAsyncGets;
+    ShardDatabaseAsyncGet**     asyncGets;
+    ShardDatabaseAsyncGetList   inactiveAsyncGets;
+    ShardDatabaseMultiGetList   blockingMultiGets;
+    ShardDatabaseAsyncMemoGet*  asyncMemoGet;   // the batch being filled
+    ShardDatabaseAsyncMemoGetList inactiveAsyncMemoGets;
     YieldTimer                  executeLists;
     unsigned                    numAsyncLists;
     ShardDatabaseAsyncList**    asyncLists;
@@ -243,6 +243,8 @@ void ShardHTTPClientSession::PrintStatus()
     char                        humanBytesSent[5];
     char                        humanBytesTotal[5];
     char                        humanThroughput[5];
+    uint64_t                    bytesLeft;
+    uint64_t                    throughput;
 
     session.PrintPair("ScalienDB", "ShardServer");
     session.PrintPair("Version", VERSION_STRING);
@@ -319,10 +321,18 @@ void ShardHTTPClientSession::PrintStatus()
     keybuf.Writef("Migrating shard (sending)");
     keybuf.NullTerminate();
     if (SHARD_MIGRATION_WRITER->IsActive())
-        valbuf.Writef("yes (sent: %s/%s, aggregate throughput: %s/s)",
+    {
+        // the total is the size on disk, so the estimate is only approximate
+        bytesLeft = 0;
+        if (SHARD_MIGRATION_WRITER->GetBytesTotal() > SHARD_MIGRATION_WRITER->GetBytesSent())
+            bytesLeft = SHARD_MIGRATION_WRITER->GetBytesTotal() - SHARD_MIGRATION_WRITER->GetBytesSent();
+        throughput = SHARD_MIGRATION_WRITER->GetThroughput();
+        valbuf.Writef("yes (sent: %s/%s, aggregate throughput: %s/s, estimated time left: %U sec)",
          HumanBytes(SHARD_MIGRATION_WRITER->GetBytesSent(), humanBytesSent),
          HumanBytes(SHARD_MIGRATION_WRITER->GetBytesTotal(), humanBytesTotal),
-         HumanBytes(SHARD_MIGRATION_WRITER->GetThroughput(), humanThroughput));
+         HumanBytes(throughput, humanThroughput),
+         throughput > 0 ? bytesLeft / throughput : (uint64_t) 0);
+    }
     else
         valbuf.Writef("no");
     valbuf.NullTerminate();
@@ -378,6 +388,7 @@ void ShardHTTPClientSession::PrintStatistics()
     buffer.Appendf("numTCPBytesReceived: %s\n", FormatBytes(iostat.numTCPBytesReceived, formatBuf, formatType));
     buffer.Appendf("numTCPBytesSent: %s\n", FormatBytes(iostat.numTCPBytesSent, formatBuf, formatType));
     buffer.Appendf("numCompletions: %U\n", iostat.numCompletions);
+    buffer.Appendf("numWakeups: %U\n", iostat.numWakeups);
     buffer.Appendf("numLongCallbacks: %U\n", iostat.numLongCallbacks);
     buffer.Appendf("totalPollTime: %U\n", iostat.totalPollTime);
     buffer.Appendf("totalNumEvents: %U\n", iostat.totalNumEvents);
@@ -472,6 +483,14 @@ void ShardHTTPClientSession::PrintStatistics()
          quorumProcessor->GetMessageListLength());
         buffer.Appendf("quorum[%U].replicationThroughput: %s\n", quorumProcessor->GetQuorumID(), 
             FormatBytes(quorumProcessor->GetReplicationThroughput(), formatBuf, formatType));
+        buffer.Appendf("quorum[%U].appendBatchLimit: %s\n", quorumProcessor->GetQuorumID(), 
+            FormatBytes(quorumProcessor->GetAppendBatchLimit(), formatBuf, formatType));
+        buffer.Appendf("quorum[%U].appendRoundTime: %U\n", quorumProcessor->GetQuorumID(), 
+         quorumProcessor->GetAppendRoundTime());
+        buffer.Appendf("quorum[%U].appendMinRoundTime: %U\n", quorumProcessor->GetQuorumID(), 
+         quorumProcessor->GetAppendMinRoundTime());
+        buffer.Appendf("quorum[%U].appendQueueDelay: %U\n", quorumProcessor->GetQuorumID(), 
+         quorumProcessor->GetAppendQueueDelay());
 
     }
 
@@ -954,6 +973,9 @@ bool ShardHTTPClientSession::ProcessSettings()
 
     CHECK_AND_SET_POSITIVE_UINT64("system.maxFileCacheSize", SetMaxFileCacheSize);
 
+    CHECK_AND_SET_UINT64("migrationBatchSize",      SHARD_MIGRATION_WRITER->SetBatchSize);
+    CHECK_AND_SET_UINT64("migrationBandwidthLimit", SHARD_MIGRATION_WRITER->SetBandwidthLimit);
+
     session.Flush();
 
     return true;
@@ -106,7 +106,8 @@ void ShardHeartbeatManager::OnHeartbeatTimeout()
     sdbpPort = shardServer->GetSDBPPort();
     
     msg.Heartbeat(CONTEXT_TRANSPORT->GetSelfNodeID(),
-     quorumInfoList, quorumShardInfos, httpPort, sdbpPort);
+     quorumInfoList, quorumShardInfos, httpPort, sdbpPort,
+     shardServer->GetConfigState()->version);
     shardServer->BroadcastToControllers(msg);
 
     Log_Trace("Broadcasting heartbeat to controllers");
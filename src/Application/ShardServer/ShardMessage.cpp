@@ -1,4 +1,5 @@
 #include "ShardMessage.h"
+#include "Framework/Messaging/MessageUtil.h"
 
 ShardMessage::ShardMessage()
 {
@@ -6,6 +7,8 @@ ShardMessage::ShardMessage()
     prev = next = this;
     clientRequest = NULL;
     configPaxosID = 0;
+    queueTime = 0;
+    proposedValue = NULL;
 }
 
 bool ShardMessage::IsClientWrite()
@@ -13,7 +16,8 @@ bool ShardMessage::IsClientWrite()
     return (type == SHARDMESSAGE_SET ||
             type == SHARDMESSAGE_ADD ||
             type == SHARDMESSAGE_SEQUENCE_ADD ||
-            type == SHARDMESSAGE_DELETE);
+            type == SHARDMESSAGE_DELETE ||
+            type == SHARDMESSAGE_MULTI_SET);
 }
 
 void ShardMessage::SplitShard(uint64_t shardID_, uint64_t newShardID_, ReadBuffer& splitKey_)
@@ -56,6 +60,14 @@ void ShardMessage::ShardMigrationDelete(uint64_t shardID_, ReadBuffer& key_)
     key.Wrap(migrationKey);
 }
 
+void ShardMessage::ShardMigrationBatch(uint64_t shardID_, ReadBuffer& items_)
+{
+    type = SHARDMESSAGE_MIGRATION_BATCH;
+    shardID = shardID_;
+    migrationValue.Write(items_);
+    value.Wrap(migrationValue);
+}
+
 void ShardMessage::ShardMigrationComplete(uint64_t shardID_)
 {
     type = SHARDMESSAGE_MIGRATION_COMPLETE;
@@ -90,6 +102,10 @@ int ShardMessage::Read(ReadBuffer& buffer)
             read = buffer.Readf("%c:%U:%#R",
              &type, &tableID, &key);
             break;
+        case SHARDMESSAGE_MULTI_SET:
+            read = buffer.Readf("%c:%U:%I:%#R",
+             &type, &tableID, &number, &value);
+            break;
         // Transactions
         case SHARDMESSAGE_START_TRANSACTION:
         case SHARDMESSAGE_COMMIT_TRANSACTION:
@@ -122,6 +138,10 @@ int ShardMessage::Read(ReadBuffer& buffer)
             read = buffer.Readf("%c:%U",
              &type, &shardID);
             break;
+        case SHARDMESSAGE_MIGRATION_BATCH:
+            read = buffer.Readf("%c:%U:%#R",
+             &type, &shardID, &value);
+            break;
         default:
             return 0;
     }
@@ -147,6 +167,10 @@ bool ShardMessage::Append(Buffer& buffer)
             buffer.Appendf("%c:%U:%#R",
              type, tableID, &key);
             break;
+        case SHARDMESSAGE_MULTI_SET:
+            buffer.Appendf("%c:%U:%I:%#R",
+             type, tableID, number, &value);
+            break;
         // Transactions
         case SHARDMESSAGE_START_TRANSACTION:
         case SHARDMESSAGE_COMMIT_TRANSACTION:
@@ -179,9 +203,186 @@ bool ShardMessage::Append(Buffer& buffer)
             buffer.Appendf("%c:%U",
              type, shardID);
             break;
+        case SHARDMESSAGE_MIGRATION_BATCH:
+            buffer.Appendf("%c:%U:%#R",
+             type, shardID, &value);
+            break;
         default:
             return false;
     }
     
     return true;
 }
+
+int ShardMessage::ReadBinary(ReadBuffer& buffer)
+{
+    bool            ok;
+    MessageReader   reader(buffer);
+
+    if (!reader.ReadChar(type))
+        return 0;
+
+    switch (type)
+    {
+        // Data manipulation
+        case SHARDMESSAGE_SET:
+            ok = reader.ReadNumber(tableID) && reader.ReadData(key) && reader.ReadData(value);
+            break;
+        case SHARDMESSAGE_ADD:
+        case SHARDMESSAGE_SEQUENCE_ADD:
+            ok = reader.ReadNumber(tableID) && reader.ReadData(key) && reader.ReadSignedNumber(number);
+            break;
+        case SHARDMESSAGE_DELETE:
+            ok = reader.ReadNumber(tableID) && reader.ReadData(key);
+            break;
+        case SHARDMESSAGE_MULTI_SET:
+            ok = reader.ReadNumber(tableID) && reader.ReadSignedNumber(number) && reader.ReadData(value);
+            break;
+        // Transactions
+        case SHARDMESSAGE_START_TRANSACTION:
+        case SHARDMESSAGE_COMMIT_TRANSACTION:
+            ok = true;
+            break;
+        // Shard splitting
+        case SHARDMESSAGE_SPLIT_SHARD:
+            ok = reader.ReadNumber(shardID) && reader.ReadNumber(newShardID) && reader.ReadData(splitKey);
+            break;
+        // Shard manipulation
+        case SHARDMESSAGE_TRUNCATE_TABLE:
+            ok = reader.ReadNumber(tableID) && reader.ReadNumber(newShardID);
+            break;
+        case SHARDMESSAGE_MIGRATION_BEGIN:
+            ok = reader.ReadNumber(srcShardID) && reader.ReadNumber(dstShardID);
+            break;
+        case SHARDMESSAGE_MIGRATION_SET:
+            ok = reader.ReadNumber(shardID) && reader.ReadData(key) && reader.ReadData(value);
+            break;
+        case SHARDMESSAGE_MIGRATION_DELETE:
+            ok = reader.ReadNumber(shardID) && reader.ReadData(key);
+            break;
+        case SHARDMESSAGE_MIGRATION_COMPLETE:
+            ok = reader.ReadNumber(shardID);
+            break;
+        case SHARDMESSAGE_MIGRATION_BATCH:
+            ok = reader.ReadNumber(shardID) && reader.ReadData(value);
+            break;
+        default:
+            return 0;
+    }
+
+    if (!ok)
+        return 0;
+    
+    return buffer.GetLength() - reader.GetRemaining().GetLength();
+}
+
+bool ShardMessage::AppendBinary(Buffer& buffer)
+{
+    switch (type)
+    {
+        // Data manipulation
+        case SHARDMESSAGE_SET:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, tableID);
+            MessageUtil::WriteData(buffer, key);
+            MessageUtil::WriteData(buffer, value);
+            break;
+        case SHARDMESSAGE_ADD:
+        case SHARDMESSAGE_SEQUENCE_ADD:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, tableID);
+            MessageUtil::WriteData(buffer, key);
+            MessageUtil::WriteSignedNumber(buffer, number);
+            break;
+        case SHARDMESSAGE_DELETE:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, tableID);
+            MessageUtil::WriteData(buffer, key);
+            break;
+        case SHARDMESSAGE_MULTI_SET:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, tableID);
+            MessageUtil::WriteSignedNumber(buffer, number);
+            MessageUtil::WriteData(buffer, value);
+            break;
+        // Transactions
+        case SHARDMESSAGE_START_TRANSACTION:
+        case SHARDMESSAGE_COMMIT_TRANSACTION:
+            buffer.Append(type);
+            break;
+        // Shard splitting
+        case SHARDMESSAGE_SPLIT_SHARD:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, shardID);
+            MessageUtil::WriteNumber(buffer, newShardID);
+            MessageUtil::WriteData(buffer, ReadBuffer(splitKey));
+            break;
+        // Shard migration
+        case SHARDMESSAGE_TRUNCATE_TABLE:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, tableID);
+            MessageUtil::WriteNumber(buffer, newShardID);
+            break;
+        case SHARDMESSAGE_MIGRATION_BEGIN:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, srcShardID);
+            MessageUtil::WriteNumber(buffer, dstShardID);
+            break;
+        case SHARDMESSAGE_MIGRATION_SET:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, shardID);
+            MessageUtil::WriteData(buffer, key);
+            MessageUtil::WriteData(buffer, value);
+            break;
+        case SHARDMESSAGE_MIGRATION_DELETE:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, shardID);
+            MessageUtil::WriteData(buffer, key);
+            break;
+        case SHARDMESSAGE_MIGRATION_COMPLETE:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, shardID);
+            break;
+        case SHARDMESSAGE_MIGRATION_BATCH:
+            buffer.Append(type);
+            MessageUtil::WriteNumber(buffer, shardID);
+            MessageUtil::WriteData(buffer, value);
+            break;
+        default:
+            return false;
+    }
+    
+    return true;
+}
+
+void ShardMessage::AppendMigrationSet(Buffer& items, ReadBuffer key, ReadBuffer value)
+{
+    items.Append(SHARDMESSAGE_MIGRATION_SET);
+    MessageUtil::WriteData(items, key);
+    MessageUtil::WriteData(items, value);
+}
+
+void ShardMessage::AppendMigrationDelete(Buffer& items, ReadBuffer key)
+{
+    items.Append(SHARDMESSAGE_MIGRATION_DELETE);
+    MessageUtil::WriteData(items, key);
+}
+
+void ShardMessage::AppendValueHeader(Buffer& buffer)
+{
+    buffer.Append(SHARDMESSAGE_BINARY_MARKER);
+    buffer.Append((char) SHARDMESSAGE_VERSION_BINARY);
+}
+
+unsigned ShardMessage::ReadValueHeader(ReadBuffer& buffer)
+{
+    unsigned    version;
+
+    // values written before the binary format have no header
+    if (buffer.GetLength() < 2 || buffer.GetCharAt(0) != SHARDMESSAGE_BINARY_MARKER)
+        return SHARDMESSAGE_VERSION_TEXT;
+
+    version = (unsigned char) buffer.GetCharAt(1);
+    buffer.Advance(2);
+    return version;
+}
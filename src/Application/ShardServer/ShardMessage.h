@@ -8,6 +8,7 @@
 #define SHARDMESSAGE_ADD                    'a'
 #define SHARDMESSAGE_SEQUENCE_ADD           'A'
 #define SHARDMESSAGE_DELETE                 'X'
+#define SHARDMESSAGE_MULTI_SET              'M'
 #define SHARDMESSAGE_START_TRANSACTION      '<'
 #define SHARDMESSAGE_COMMIT_TRANSACTION     '>'
 #define SHARDMESSAGE_SPLIT_SHARD            'z'
@@ -16,14 +17,27 @@
 #define SHARDMESSAGE_MIGRATION_SET          '2'
 #define SHARDMESSAGE_MIGRATION_DELETE       '3'
 #define SHARDMESSAGE_MIGRATION_COMPLETE     '4'
+#define SHARDMESSAGE_MIGRATION_BATCH        '5'
+
+// binary values start with the marker and the format version byte,
+// text values start with a message type, which is never the marker
+#define SHARDMESSAGE_BINARY_MARKER          '\x01'
+#define SHARDMESSAGE_VERSION_TEXT           0
+#define SHARDMESSAGE_VERSION_BINARY         1
 
 class ClientRequest;
+struct ShardProposedValue;
 
 /*
 ===============================================================================================
 
  ShardMessage
 
+ Replicated values are a sequence of messages. Text values hold colon separated fields
+ and a space after each message. Binary values start with a header, followed by the
+ messages as a type byte and the same fields as the text format, with numbers as varints
+ and buffers as <varint length><data>.
+
 ===============================================================================================
 */
 
@@ -46,6 +60,8 @@ public:
     Buffer          migrationKey;
     Buffer          migrationValue;
     ClientRequest*  clientRequest;
+    uint64_t        queueTime;
+    ShardProposedValue* proposedValue;  // the value of ours this message is in
 
     // Constructor
     ShardMessage();
@@ -58,6 +74,7 @@ public:
     void            ShardMigrationBegin(uint64_t srcShardID, uint64_t dstShardID);
     void            ShardMigrationSet(uint64_t shardID, ReadBuffer& key, ReadBuffer& value);
     void            ShardMigrationDelete(uint64_t shardID, ReadBuffer& key);
+    void            ShardMigrationBatch(uint64_t shardID, ReadBuffer& items);
     void            ShardMigrationComplete(uint64_t shardID);
     
     void            StartTransaction();
@@ -65,6 +82,16 @@ public:
     // Serialization
     int             Read(ReadBuffer& buffer);
     bool            Append(Buffer& buffer);
+    int             ReadBinary(ReadBuffer& buffer);
+    bool            AppendBinary(Buffer& buffer);
+
+    // migration batch items are a type byte (MIGRATION_SET or MIGRATION_DELETE) followed by
+    // the key and for sets the value, as <varint length><data>
+    static void     AppendMigrationSet(Buffer& items, ReadBuffer key, ReadBuffer value);
+    static void     AppendMigrationDelete(Buffer& items, ReadBuffer key);
+
+    static void     AppendValueHeader(Buffer& buffer);
+    static unsigned ReadValueHeader(ReadBuffer& buffer);
 
     // For InList<>
     ShardMessage*   prev;
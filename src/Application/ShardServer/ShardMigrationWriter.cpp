@@ -1,4 +1,6 @@
 #include "ShardMigrationWriter.h"
+#include "System/Config.h"
+#include "Application/Common/DatabaseConsts.h"
 #include "ShardServer.h"
 #include "ShardQuorumProcessor.h"
 
@@ -6,6 +8,9 @@ ShardMigrationWriter::ShardMigrationWriter()
 {
     onTimeout.SetCallable(MFUNC(ShardMigrationWriter, OnTimeout));
     onTimeout.SetDelay(SHARD_MIGRATION_WRITER_DELAY);
+    onThrottle.SetCallable(MFUNC(ShardMigrationWriter, OnThrottle));
+    batchSize = SHARD_MIGRATION_BATCH_SIZE;
+    bandwidthLimit = 0;
     writeReadyness.SetCallable(MFUNC(ShardMigrationWriter, OnWriteReadyness));
     Reset();
 }
@@ -21,6 +26,9 @@ void ShardMigrationWriter::Init(ShardServer* shardServer_)
     shardServer = shardServer_;
     environment = shardServer->GetDatabaseManager()->GetEnvironment();
 
+    SetBatchSize(configFile.GetIntValue("migrationBatchSize", SHARD_MIGRATION_BATCH_SIZE));
+    SetBandwidthLimit(configFile.GetIntValue("migrationBandwidthLimit", 0));
+
     Reset();
 }
 
@@ -29,22 +37,43 @@ void ShardMigrationWriter::Reset()
     cursor = NULL;
     isActive = false;
     sendFirst = false;
+    isPaused = false;
     quorumProcessor = NULL;
     bytesSent = 0;
     bytesTotal = 0;
     startTime = 0;
     prevBytesSent = 0;
+    batch.Clear();
+    batchBytes = 0;
+    throttleLevel = 0;
+    throttleTime = 0;
+    throttleBytesSent = 0;
     EventLoop::Remove(&onTimeout);
+    EventLoop::Remove(&onThrottle);
 }
 
 void ShardMigrationWriter::Pause()
 {
+    isPaused = true;
     CONTEXT_TRANSPORT->UnregisterWriteReadyness(&writeReadyness);
 }
 
 void ShardMigrationWriter::Resume()
 {
-    CONTEXT_TRANSPORT->RegisterWriteReadyness(&writeReadyness);
+    isPaused = false;
+    if (!onThrottle.IsActive())
+        CONTEXT_TRANSPORT->RegisterWriteReadyness(&writeReadyness);
+}
+
+void ShardMigrationWriter::SetBatchSize(uint64_t batchSize_)
+{
+    // a batch must fit into one replicated value
+    batchSize = MIN(batchSize_, DATABASE_REPLICATION_SIZE);
+}
+
+void ShardMigrationWriter::SetBandwidthLimit(uint64_t bandwidthLimit_)
+{
+    bandwidthLimit = bandwidthLimit_;
 }
 
 bool ShardMigrationWriter::IsActive()
@@ -183,6 +212,8 @@ void ShardMigrationWriter::SendCommit()
 {
     ClusterMessage msg;
     
+    SendBatch();
+
     msg.ShardMigrationCommit(quorumID, dstShardID);
     CONTEXT_TRANSPORT->SendClusterMessage(nodeID, msg);
 
@@ -201,8 +232,36 @@ void ShardMigrationWriter::SendCommit()
 
 void ShardMigrationWriter::SendItem(StorageKeyValue* kv)
 {
-    ClusterMessage msg;
+    unsigned        itemSize;
+    ClusterMessage  msg;
     
+    if (batchSize > 0)
+    {
+        // send the batch before the item would take it over batchSize,
+        // the varint length prefixes are at most 10 bytes each
+        itemSize = 1 + 10 + kv->GetKey().GetLength();
+        if (kv->GetType() == STORAGE_KEYVALUE_TYPE_SET)
+            itemSize += 10 + kv->GetValue().GetLength();
+        if (batch.GetLength() > 0 && batch.GetLength() + itemSize > batchSize)
+            SendBatch();
+
+        if (kv->GetType() == STORAGE_KEYVALUE_TYPE_SET)
+        {
+            ShardMessage::AppendMigrationSet(batch, kv->GetKey(), kv->GetValue());
+            batchBytes += kv->GetKey().GetLength() + kv->GetValue().GetLength();
+        }
+        else
+        {
+            ShardMessage::AppendMigrationDelete(batch, kv->GetKey());
+            batchBytes += kv->GetKey().GetLength();
+        }
+
+        // an item larger than batchSize is sent by itself
+        if (batch.GetLength() >= batchSize)
+            SendBatch();
+        return;
+    }
+
     if (kv->GetType() == STORAGE_KEYVALUE_TYPE_SET)
     {
         msg.ShardMigrationSet(quorumID, dstShardID, kv->GetKey(), kv->GetValue());
@@ -217,6 +276,56 @@ void ShardMigrationWriter::SendItem(StorageKeyValue* kv)
     CONTEXT_TRANSPORT->SendClusterMessage(nodeID, msg);
 }
 
+void ShardMigrationWriter::SendBatch()
+{
+    ClusterMessage msg;
+
+    if (batch.GetLength() == 0)
+        return;
+
+    msg.ShardMigrationBatch(quorumID, dstShardID, ReadBuffer(batch));
+    CONTEXT_TRANSPORT->SendClusterMessage(nodeID, msg);
+    bytesSent += batchBytes;
+
+    batch.Clear();
+    batchBytes = 0;
+}
+
+bool ShardMigrationWriter::IsThrottled()
+{
+    uint64_t now;
+    uint64_t drained;
+
+    if (bandwidthLimit == 0)
+        return false;
+
+    // leaky bucket, the bytes sent drain at bandwidthLimit and at most
+    // one second worth of bytes is sent ahead
+    now = EventLoop::Now();
+    throttleLevel += bytesSent - throttleBytesSent;
+    throttleBytesSent = bytesSent;
+    if (throttleTime != 0)
+    {
+        drained = (now - throttleTime) * bandwidthLimit / 1000;
+        throttleLevel = throttleLevel > drained ? throttleLevel - drained : 0;
+    }
+    throttleTime = now;
+
+    if (throttleLevel < bandwidthLimit)
+        return false;
+
+    CONTEXT_TRANSPORT->UnregisterWriteReadyness(&writeReadyness);
+    onThrottle.SetDelay((throttleLevel - bandwidthLimit) * 1000 / bandwidthLimit + 1);
+    EventLoop::Add(&onThrottle);
+    return true;
+}
+
+void ShardMigrationWriter::OnThrottle()
+{
+    if (isActive && !isPaused)
+        CONTEXT_TRANSPORT->RegisterWriteReadyness(&writeReadyness);
+}
+
 void ShardMigrationWriter::OnWriteReadyness()
 {
     Log_Debug("ShardMigrationWriter::OnWriteReadyness()");
@@ -236,6 +345,9 @@ void ShardMigrationWriter::OnWriteReadyness()
         return;
     }
 
+    if (IsThrottled())
+        return;
+
     if (sendFirst)
     {
         sendFirst = false;
@@ -12,6 +12,10 @@ class ShardQuorumProcessor;
 
 #define SHARD_MIGRATION_WRITER_DELAY  (10*1000) // msec
 #define SHARD_MIGRATION_WRITER_GRAN   (10*KiB)
+// key-values are sent in batches of up to this size, each batch is appended in one round
+// by the receiving quorum, 0 sends each key-value in its own message, which is the only
+// format shard servers before batching understand
+#define SHARD_MIGRATION_BATCH_SIZE    (0)
 
 /*
 ===============================================================================================
@@ -32,6 +36,10 @@ public:
     
     void                    Pause();
     void                    Resume();
+
+    void                    SetBatchSize(uint64_t batchSize);
+    // in bytes per second, 0 means unlimited
+    void                    SetBandwidthLimit(uint64_t bandwidthLimit);
     
     bool                    IsActive();
     uint64_t                GetShardID();
@@ -51,6 +59,9 @@ private:
     void                    SendNext();
     void                    SendCommit();
     void                    SendItem(StorageKeyValue* kv);
+    void                    SendBatch();
+    bool                    IsThrottled();
+    void                    OnThrottle();
     void                    OnWriteReadyness();
     void                    OnBlockShard();
     void                    OnUnblockShard();
@@ -58,6 +69,7 @@ private:
 
     bool                    isActive;
     bool                    sendFirst;
+    bool                    isPaused;
     uint64_t                nodeID;
     uint64_t                quorumID;
     uint64_t                srcShardID;
@@ -66,12 +78,20 @@ private:
     uint64_t                bytesTotal;
     uint64_t                startTime;
     uint64_t                prevBytesSent;
+    uint64_t                batchSize;
+    uint64_t                batchBytes;
+    Buffer                  batch;
+    uint64_t                bandwidthLimit;
+    uint64_t                throttleLevel;
+    uint64_t                throttleTime;
+    uint64_t                throttleBytesSent;
     ShardServer*            shardServer;
     ShardQuorumProcessor*   quorumProcessor;
     StorageEnvironment*     environment;
     StorageBulkCursor*      cursor;
     StorageKeyValue*        kv;
     Countdown               onTimeout;
+    Countdown               onThrottle;
     WriteReadyness          writeReadyness;
 };
 
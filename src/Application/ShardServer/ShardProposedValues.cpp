@@ -0,0 +1,193 @@
+#include "ShardProposedValues.h"
+
+ShardProposedValue::ShardProposedValue()
+{
+    prev = next = this;
+    paxosID = 0;
+    length = 0;
+    checksum = 0;
+    numMessages = 0;
+    first = NULL;
+}
+
+ShardProposedValues::ShardProposedValues()
+{
+    shardMessages = NULL;
+    building = NULL;
+    chosen = NULL;
+    numMessages = 0;
+}
+
+ShardProposedValues::~ShardProposedValues()
+{
+    values.DeleteList();
+    delete building;
+    delete chosen;
+}
+
+void ShardProposedValues::Init(MessageList* shardMessages_)
+{
+    shardMessages = shardMessages_;
+}
+
+void ShardProposedValues::Clear()
+{
+    ShardMessage*   message;
+
+    FOREACH (message, *shardMessages)
+        message->proposedValue = NULL;
+
+    values.DeleteList();
+    delete building;
+    building = NULL;
+    delete chosen;
+    chosen = NULL;
+    numMessages = 0;
+}
+
+unsigned ShardProposedValues::GetNumMessages()
+{
+    return numMessages;
+}
+
+unsigned ShardProposedValues::GetNumValues()
+{
+    return values.GetLength();
+}
+
+void ShardProposedValues::Add(ShardMessage* message)
+{
+    ASSERT(message->proposedValue == NULL);
+
+    if (building == NULL)
+    {
+        building = new ShardProposedValue;
+        building->first = message;
+    }
+
+    message->proposedValue = building;
+    building->numMessages++;
+    numMessages++;
+}
+
+void ShardProposedValues::OnAppend(Buffer& value)
+{
+    ASSERT(building != NULL);
+
+    building->length = value.GetLength();
+    building->checksum = value.GetChecksum();
+    values.Append(building);
+    building = NULL;
+}
+
+void ShardProposedValues::OnPropose(uint64_t paxosID)
+{
+    ShardProposedValue* proposedValue;
+
+    // without pipelining the value is proposed again if its round chose a dummy
+    proposedValue = values.Last();
+    ASSERT(proposedValue != NULL);
+    proposedValue->paxosID = paxosID;
+}
+
+ShardMessage* ShardProposedValues::OnChosen(uint64_t paxosID, Buffer& value)
+{
+    ShardProposedValue* proposedValue;
+    ShardProposedValue* nextValue;
+
+    ASSERT(chosen == NULL);
+
+    // after a pipeline clear a round may have an old pipelined value and a new one of ours,
+    // the others proposed for this round or before will not be chosen
+    for (proposedValue = values.First(); proposedValue != NULL; proposedValue = nextValue)
+    {
+        nextValue = values.Next(proposedValue);
+        if (proposedValue->paxosID == 0 || proposedValue->paxosID > paxosID)
+            continue;
+
+        if (chosen == NULL && proposedValue->paxosID == paxosID &&
+         proposedValue->length == value.GetLength() && proposedValue->checksum == value.GetChecksum())
+        {
+            chosen = proposedValue;
+            values.Remove(chosen);
+        }
+        else
+            Release(proposedValue);
+    }
+
+    return (chosen ? chosen->first : NULL);
+}
+
+ShardMessage* ShardProposedValues::Next(ShardMessage* message)
+{
+    ShardProposedValue* proposedValue;
+
+    proposedValue = message->proposedValue;
+    do
+        message = shardMessages->Next(message);
+    while (message != NULL && message->proposedValue != proposedValue);
+
+    return message;
+}
+
+void ShardProposedValues::OnExecute(ShardMessage* message)
+{
+    ASSERT(chosen != NULL && message->proposedValue == chosen);
+    ASSERT(numMessages > 0);
+
+    message->proposedValue = NULL;
+    numMessages--;
+}
+
+void ShardProposedValues::OnChosenExecuted()
+{
+    delete chosen;
+    chosen = NULL;
+}
+
+void ShardProposedValues::ReleaseUnproposed()
+{
+    ShardProposedValue* proposedValue;
+
+    proposedValue = values.Last();
+    if (proposedValue && proposedValue->paxosID == 0)
+        Release(proposedValue);
+}
+
+void ShardProposedValues::ReleaseBefore(uint64_t paxosID, bool keepLast)
+{
+    ShardProposedValue* proposedValue;
+    ShardProposedValue* nextValue;
+
+    for (proposedValue = values.First(); proposedValue != NULL; proposedValue = nextValue)
+    {
+        nextValue = values.Next(proposedValue);
+        if (proposedValue->paxosID == 0 || proposedValue->paxosID >= paxosID)
+            continue;
+        if (keepLast && nextValue == NULL)
+            continue;
+        Release(proposedValue);
+    }
+}
+
+void ShardProposedValues::Release(ShardProposedValue* proposedValue)
+{
+    unsigned        num;
+    ShardMessage*   message;
+
+    // the messages are in queue order, starting at the first one
+    num = 0;
+    for (message = proposedValue->first; message != NULL && num < proposedValue->numMessages;
+     message = shardMessages->Next(message))
+    {
+        if (message->proposedValue != proposedValue)
+            continue;
+        message->proposedValue = NULL;
+        num++;
+    }
+    ASSERT(num == proposedValue->numMessages);
+    ASSERT(numMessages >= num);
+    numMessages -= num;
+
+    values.Delete(proposedValue);
+}
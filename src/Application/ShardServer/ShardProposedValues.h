@@ -0,0 +1,84 @@
+#ifndef SHARDPROPOSEDVALUES_H
+#define SHARDPROPOSEDVALUES_H
+
+#include "System/Containers/InList.h"
+#include "System/Buffers/Buffer.h"
+#include "ShardMessage.h"
+
+/*
+===============================================================================================
+
+ ShardProposedValue
+
+===============================================================================================
+*/
+
+struct ShardProposedValue
+{
+    ShardProposedValue();
+
+    ShardProposedValue* prev;
+    ShardProposedValue* next;
+
+    uint64_t            paxosID;        // 0 until the value is proposed
+    unsigned            length;
+    uint32_t            checksum;
+    unsigned            numMessages;
+    ShardMessage*       first;          // the messages are the ones pointing to this value
+};
+
+/*
+===============================================================================================
+
+ ShardProposedValues
+
+ The values a primary proposed and the queued messages in them. A value is kept until
+ its round is decided, so its messages are not proposed again while the acceptors may
+ still choose it, and they are executed as ours even if the value is chosen after a
+ prepare phase or does not start at the head of the queue. A chosen value is found by
+ its paxosID, length and checksum, the values of the same and earlier rounds are
+ released and their messages are proposed again.
+
+===============================================================================================
+*/
+
+class ShardProposedValues
+{
+    typedef InList<ShardMessage>        MessageList;
+    typedef InList<ShardProposedValue>  ValueList;
+
+public:
+    ShardProposedValues();
+    ~ShardProposedValues();
+
+    void                    Init(MessageList* shardMessages);
+    void                    Clear();
+
+    unsigned                GetNumMessages();   // messages in values not decided yet
+    unsigned                GetNumValues();
+
+    // building and proposing the next value
+    void                    Add(ShardMessage* message);
+    void                    OnAppend(Buffer& value);
+    void                    OnPropose(uint64_t paxosID);
+
+    // returns the first message of the chosen value if it is ours, NULL otherwise
+    ShardMessage*           OnChosen(uint64_t paxosID, Buffer& value);
+    ShardMessage*           Next(ShardMessage* message);
+    void                    OnExecute(ShardMessage* message);
+    void                    OnChosenExecuted();
+
+    void                    ReleaseUnproposed();
+    void                    ReleaseBefore(uint64_t paxosID, bool keepLast);
+
+private:
+    void                    Release(ShardProposedValue* proposedValue);
+
+    MessageList*            shardMessages;
+    ValueList               values;
+    ShardProposedValue*     building;
+    ShardProposedValue*     chosen;
+    unsigned                numMessages;
+};
+
+#endif
@@ -50,6 +50,11 @@ void ShardQuorumContext::SetQuorumNodes(SortedList<uint64_t>& activeNodes)
         quorum.AddNode(*it);
 }
 
+void ShardQuorumContext::SetReplicationWindow(unsigned replicationWindow)
+{
+    replicatedLog.SetPipelineWindow(replicationWindow);
+}
+
 void ShardQuorumContext::RestartReplication()
 {
     replicatedLog.Restart();
@@ -78,6 +83,11 @@ bool ShardQuorumContext::IsAppending()
     return (nextValue.GetLength() != 0);
 }
 
+bool ShardQuorumContext::IsLeaderReadable()
+{
+    return IsLeader() && replicatedLog.IsLeaderReadable();
+}
+
 void ShardQuorumContext::OnAppendComplete()
 {
     replicatedLog.OnAppendComplete();
@@ -181,11 +191,24 @@ void ShardQuorumContext::OnStartProposing()
 
 void ShardQuorumContext::OnAppend(uint64_t paxosID, Buffer& value, bool ownAppend)
 {
-    nextValue.Clear();
+    // in pipelined mode nextValue is cleared when it is proposed,
+    // and holds the next value to propose
+    if (replicatedLog.GetPipelineWindow() <= 1)
+        nextValue.Clear();
 
     quorumProcessor->OnAppend(paxosID, value, ownAppend);
 }
 
+void ShardQuorumContext::OnPipelineCleared()
+{
+    quorumProcessor->OnPipelineCleared();
+}
+
+void ShardQuorumContext::OnNextValueProposed(uint64_t paxosID)
+{
+    quorumProcessor->OnNextValueProposed(paxosID);
+}
+
 bool ShardQuorumContext::UseSyncCommit()
 {
     return false; // async
@@ -339,7 +362,11 @@ void ShardQuorumContext::OnPaxosMessage(ReadBuffer buffer)
         }
     }
 
-    RegisterPaxosID(msg.paxosID);
-    replicatedLog.RegisterPaxosID(msg.paxosID, msg.nodeID);
+    // pipelined proposals are ahead of the current paxosID without this node lagging
+    if (!replicatedLog.IsPipelined(msg))
+    {
+        RegisterPaxosID(msg.paxosID);
+        replicatedLog.RegisterPaxosID(msg.paxosID, msg.nodeID);
+    }
     replicatedLog.OnMessage(msg);
 }
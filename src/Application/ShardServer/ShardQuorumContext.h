@@ -27,11 +27,13 @@ public:
     void                            Shutdown();
     
     void                            SetQuorumNodes(SortedList<uint64_t>& activeNodes);
+    void                            SetReplicationWindow(unsigned replicationWindow);
     void                            RestartReplication();
     void                            TryReplicationCatchup();
     void                            AppendDummy();
     void                            Append(); // nextValue was filled up using GetNextValue()
     bool                            IsAppending();
+    bool                            IsLeaderReadable();
     void                            OnAppendComplete();
     void                            WriteReplicationState();
     
@@ -63,6 +65,8 @@ public:
 
     virtual void                    OnStartProposing();
     virtual void                    OnAppend(uint64_t paxosID, Buffer& value, bool ownAppend);
+    virtual void                    OnPipelineCleared();
+    virtual void                    OnNextValueProposed(uint64_t paxosID);
     virtual bool                    UseSyncCommit();
     virtual bool                    UseProposeTimeouts();
     virtual bool                    UseCommitChaining();
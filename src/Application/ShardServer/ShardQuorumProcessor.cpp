@@ -1,5 +1,6 @@
 #include "ShardQuorumProcessor.h"
 #include "Framework/Replication/ReplicationConfig.h"
+#include "Framework/Messaging/MessageUtil.h"
 #include "Application/Common/DatabaseConsts.h"
 #include "Application/Common/ContextTransport.h"
 #include "Application/Common/ClientSession.h"
@@ -26,8 +27,10 @@ ShardLeaseRequest::ShardLeaseRequest()
 void ShardAppendState::Reset()
 {
     currentAppend = false;
+    nextMessage = NULL;
     paxosID = 0;
     commandID = 0;
+    version = SHARDMESSAGE_VERSION_TEXT;
     valueBuffer.Reset();
     value.Reset();
 }
@@ -48,6 +51,7 @@ ShardQuorumProcessor::ShardQuorumProcessor()
     resumeBlockedAppend.SetDelay(CLOCK_RESOLUTION);
     resumeBlockedAppend.SetCallable(MFUNC(ShardQuorumProcessor, OnResumeBlockedAppend));
     mergeDisabled = false;
+    proposedValues.Init(&shardMessages);
 }
 
 ShardQuorumProcessor::~ShardQuorumProcessor()
@@ -64,12 +68,15 @@ void ShardQuorumProcessor::Init(ConfigQuorum* configQuorum, ShardServer* shardSe
     migrateShardID = 0;
     migrateNodeID = 0;
     migrateCache = 0;
+    migrateAborted = false;
     blockReplication = false;
     needCatchup = false;
     appendState.Reset();
     appendDelay = 0;
     prevAppendTime = 0;
     activationTargetPaxosID = 0;
+    binaryReplication = false;
+    appendBatcher.Init();
     quorumContext.Init(configQuorum, this);
     CONTEXT_TRANSPORT->AddQuorumContext(&quorumContext);
     messageCache.Init(100*1000);
@@ -81,6 +88,7 @@ void ShardQuorumProcessor::Shutdown()
     ShardMessage*   message;
     
     leaseRequests.DeleteList();
+    proposedValues.Clear();
   
     FOREACH(message, shardMessages)
     {
@@ -121,6 +129,12 @@ bool ShardQuorumProcessor::IsPrimary()
     return isPrimary;
 }
 
+bool ShardQuorumProcessor::IsLeaseValid()
+{
+    // the leaseTimeout may fire late on a busy event loop, the clock is authoritative
+    return isPrimary && Now() < leaseTimeout.GetExpireTime();
+}
+
 uint64_t ShardQuorumProcessor::GetQuorumID()
 {
     return quorumContext.GetQuorumID();
@@ -353,7 +367,23 @@ void ShardQuorumProcessor::OnAppend(uint64_t paxosID, Buffer& value, bool ownApp
     appendState.commandID = 0;
     appendState.valueBuffer.Write(value);
     appendState.value.Wrap(appendState.valueBuffer);
-    appendState.currentAppend = ownAppend && quorumContext.IsLeaseOwner();
+    appendState.version = ShardMessage::ReadValueHeader(appendState.value);
+    ASSERT(appendState.version <= SHARDMESSAGE_VERSION_BINARY);
+
+    // the chosen value may also be one we proposed earlier and the prepare phase adopted
+    if (quorumContext.IsLeaseOwner())
+        appendState.nextMessage = proposedValues.OnChosen(paxosID, value);
+    appendState.currentAppend = (appendState.nextMessage != NULL);
+
+    if (ownAppend && appendState.currentAppend)
+        appendBatcher.OnAppendComplete();
+    else
+    {
+        // propose the messages of the values that were not chosen again, in order
+        proposedValues.ReleaseUnproposed();
+        quorumContext.GetNextValue().Clear();
+        appendBatcher.OnAppendFailed();
+    }
 
     OnResumeAppend();
 }
@@ -432,6 +462,8 @@ void ShardQuorumProcessor::OnLeaseTimeout()
     }
     
     appendState.currentAppend = false;
+    proposedValues.Clear();
+    appendBatcher.OnAppendFailed();
     isPrimary = false;
     migrateShardID = 0;
     migrateNodeID = 0;
@@ -502,6 +534,20 @@ void ShardQuorumProcessor::OnClientRequest(ClientRequest* request)
         return;
     }
     
+    // strictly consistent reads are served from the local state without a paxos round,
+    // which only sees every acknowledged write while the lease is held by the clock
+    // and the rounds pipelined by the previous leader are learned
+    if (request->paxosID == 1 && request->IsReadRequest() &&
+     (!IsLeaseValid() || !quorumContext.IsLeaderReadable()))
+    {
+        Log_Trace();
+        if (request->session->IsTransactional())
+            TRANSACTION_MANAGER->ClearSessionTransaction(request->session);
+        request->response.NoService();
+        request->OnComplete();
+        return;
+    }
+    
     // read-your-write consistency
     // only serve RYW consistency requests I have learned
     // which means my paxosID is already bigger
@@ -516,6 +562,12 @@ void ShardQuorumProcessor::OnClientRequest(ClientRequest* request)
         return;
     }
     
+    if (request->type == CLIENTREQUEST_MULTI_GET)
+    {
+        DATABASE_MANAGER->OnClientReadRequest(request);
+        return;
+    }
+
     if (request->IsList())
     {
         DATABASE_MANAGER->OnClientListRequest(request);
@@ -596,6 +648,7 @@ void ShardQuorumProcessor::OnClientRequest(ClientRequest* request)
     TransformRequest(request, message);
     
     message->clientRequest = request;
+    message->queueTime = EventLoop::Now();
     shardMessages.Append(message);
 
     EventLoop::TryAdd(&tryAppend);
@@ -642,6 +695,7 @@ void ShardQuorumProcessor::TrySplitShard(uint64_t shardID, uint64_t newShardID,
     message = messageCache.Acquire();
     message->SplitShard(shardID, newShardID, splitKey);
     message->clientRequest = NULL;
+    message->queueTime = EventLoop::Now();
     shardMessages.Append(message);
 
     EventLoop::TryAdd(&tryAppend);
@@ -667,6 +721,7 @@ void ShardQuorumProcessor::TryTruncateTable(uint64_t tableID, uint64_t newShardI
     message = messageCache.Acquire();
     message->TruncateTable(tableID, newShardID);
     message->clientRequest = NULL;
+    message->queueTime = EventLoop::Now();
     shardMessages.Append(message);
 
     EventLoop::TryAdd(&tryAppend);
@@ -752,6 +807,11 @@ void ShardQuorumProcessor::OnShardMigrationClusterMessage(uint64_t nodeID, Clust
             migrateCache += clusterMessage.key.GetLength();
             //Log_Debug("ShardMigration DELETE");
             break;
+        case CLUSTERMESSAGE_SHARDMIGRATION_BATCH:
+            ASSERT(migrateShardID == clusterMessage.shardID);
+            shardMessage->ShardMigrationBatch(clusterMessage.shardID, clusterMessage.value);
+            migrateCache += clusterMessage.value.GetLength();
+            break;
         case CLUSTERMESSAGE_SHARDMIGRATION_COMMIT:
             ASSERT(migrateShardID == clusterMessage.shardID);
             Log_Debug("Received shard migration COMMIT");
@@ -761,6 +821,7 @@ void ShardQuorumProcessor::OnShardMigrationClusterMessage(uint64_t nodeID, Clust
             ASSERT_FAIL();
     }
 
+    shardMessage->queueTime = EventLoop::Now();
     shardMessages.Append(shardMessage);
     
     if (prevMigrateCache < DATABASE_REPLICATION_SIZE && migrateCache >= DATABASE_REPLICATION_SIZE)
@@ -783,6 +844,47 @@ void ShardQuorumProcessor::SetReplicationLimit(unsigned replicationLimit)
     appendDelay = (unsigned)(replicationLimit == 0 ? 0 : 1000.0 / replicationLimit);
 }
 
+void ShardQuorumProcessor::SetReplicationWindow(unsigned replicationWindow)
+{
+    quorumContext.SetReplicationWindow(replicationWindow);
+}
+
+void ShardQuorumProcessor::SetBinaryReplication(bool binaryReplication_)
+{
+    binaryReplication = binaryReplication_;
+}
+
+void ShardQuorumProcessor::OnPipelineCleared()
+{
+    // the cleared values stay in proposedValues, the acceptors may still choose them
+    appendBatcher.OnAppendFailed();
+}
+
+void ShardQuorumProcessor::OnNextValueProposed(uint64_t paxosID)
+{
+    proposedValues.OnPropose(paxosID);
+}
+
+unsigned ShardQuorumProcessor::GetAppendBatchLimit()
+{
+    return appendBatcher.GetBatchLimit();
+}
+
+uint64_t ShardQuorumProcessor::GetAppendRoundTime()
+{
+    return appendBatcher.GetRoundTime();
+}
+
+uint64_t ShardQuorumProcessor::GetAppendMinRoundTime()
+{
+    return appendBatcher.GetMinRoundTime();
+}
+
+uint64_t ShardQuorumProcessor::GetAppendQueueDelay()
+{
+    return appendBatcher.GetQueueDelay();
+}
+
 uint64_t ShardQuorumProcessor::GetMessageCacheSize()
 {
     return messageCache.GetMemorySize();
@@ -832,6 +934,13 @@ void ShardQuorumProcessor::TransformRequest(ClientRequest* request, ShardMessage
             message->tableID = request->tableID;
             message->key.Wrap(request->key);
             break;
+        case CLIENTREQUEST_MULTI_SET:
+            // all pairs go into one message, so they are appended in the same Paxos round
+            message->type = SHARDMESSAGE_MULTI_SET;
+            message->tableID = request->tableID;
+            message->number = request->count;
+            message->value.Wrap(request->value);
+            break;
         case CLIENTREQUEST_SEQUENCE_SET:
             message->type = SHARDMESSAGE_SET;
             message->tableID = request->tableID;
@@ -862,6 +971,7 @@ void ShardQuorumProcessor::ExecuteMessage(uint64_t paxosID, uint64_t commandID,
     
     if (shardMessage->type == SHARDMESSAGE_MIGRATION_BEGIN)
     {
+        migrateAborted = false;
         Log_Message("Disabling database merge for the duration of shard migration");
         DATABASE_MANAGER->GetEnvironment()->SetMergeEnabled(false);
     }
@@ -870,22 +980,49 @@ void ShardQuorumProcessor::ExecuteMessage(uint64_t paxosID, uint64_t commandID,
         migrateCache -= (shardMessage->key.GetLength() + shardMessage->value.GetLength());
     else if (shardMessage->type == SHARDMESSAGE_MIGRATION_DELETE && migrateCache > 0)
         migrateCache -= shardMessage->key.GetLength();
+    else if (shardMessage->type == SHARDMESSAGE_MIGRATION_BATCH && migrateCache > 0)
+        migrateCache -= shardMessage->value.GetLength();
 
     ASSERT(migrateCache >= 0);
     
     if (shardMessage->type == SHARDMESSAGE_MIGRATION_COMPLETE)
     {
-        Log_Message("Migration of shard %U complete...", migrateShardID);
-        Log_Message("Enabling database merge");
-        DATABASE_MANAGER->GetEnvironment()->SetMergeEnabled(true);
+        if (migrateAborted)
+        {
+            // the controllers were told to abort, the shard does not replace the source
+            Log_Message("Migration of shard %U was aborted, not completing", shardMessage->shardID);
+            migrateAborted = false;
+        }
+        else
+        {
+            Log_Message("Migration of shard %U complete...", migrateShardID);
+            Log_Message("Enabling database merge");
+            DATABASE_MANAGER->GetEnvironment()->SetMergeEnabled(true);
+
+            clusterMessage.ShardMigrationComplete(GetQuorumID(), migrateShardID);
+            if (IsPrimary())
+                shardServer->BroadcastToControllers(clusterMessage);
+        }
 
-        clusterMessage.ShardMigrationComplete(GetQuorumID(), migrateShardID);
         migrateShardID = 0;
         migrateNodeID = 0;
         migrateCache = 0;
-
-        if (IsPrimary())
-            shardServer->BroadcastToControllers(clusterMessage);
+    }
+    else if (shardMessage->type == SHARDMESSAGE_MIGRATION_BATCH)
+    {
+        // every replica executes the same batches, so they all abort at the same point,
+        // the primary tells the controllers, and the migration can be retried
+        if (!DATABASE_MANAGER->ExecuteMigrationBatch(*shardMessage) && !migrateAborted)
+        {
+            Log_Message("Invalid migration batch for shard %U, aborting migration", shardMessage->shardID);
+            Log_Message("Enabling database merge");
+            DATABASE_MANAGER->GetEnvironment()->SetMergeEnabled(true);
+            migrateAborted = true;
+
+            clusterMessage.ShardMigrationAbort(GetQuorumID(), shardMessage->shardID);
+            if (IsPrimary())
+                shardServer->BroadcastToControllers(clusterMessage);
+        }
     }
     else
     {
@@ -914,6 +1051,7 @@ void ShardQuorumProcessor::ExecuteMessage(uint64_t paxosID, uint64_t commandID,
             shardMessage->clientRequest->OnComplete(); // request deletes itself
         shardMessage->clientRequest = NULL;
     }
+    proposedValues.OnExecute(shardMessage);
     shardMessages.Remove(shardMessage);
     messageCache.Release(shardMessage);
 }
@@ -922,9 +1060,14 @@ void ShardQuorumProcessor::TryAppend()
 {
     bool            inTransaction;
     unsigned        numMessages;
+    unsigned        numQueued;
+    uint64_t        queueDelay;
     ShardMessage*   message;
-    
-    if (shardMessages.GetLength() == 0 || quorumContext.IsAppending())
+
+    // values proposed for rounds that chose a dummy are not passed to OnAppend()
+    proposedValues.ReleaseBefore(GetPaxosID(), quorumContext.IsAppending());
+
+    if (shardMessages.GetLength() <= proposedValues.GetNumMessages() || quorumContext.IsAppending())
         return;
 
     if (resumeAppend.IsActive())
@@ -933,6 +1076,12 @@ void ShardQuorumProcessor::TryAppend()
         return;
     }
 
+    // hold back small batches while a previous value is in flight,
+    // tryAppend is added again when it completes
+    numQueued = shardMessages.GetLength() - proposedValues.GetNumMessages();
+    if (!appendBatcher.IsBatchReady(numQueued))
+        return;
+
     // rate control
     if (EventLoop::Now() < prevAppendTime + appendDelay)
     {
@@ -942,10 +1091,15 @@ void ShardQuorumProcessor::TryAppend()
     }
     
     numMessages = 0;
+    queueDelay = 0;
     Buffer& nextValue = quorumContext.GetNextValue();
     inTransaction = false;
     FOREACH (message, shardMessages)
     {
+        // skip messages that are already proposed in previous values
+        if (message->proposedValue != NULL)
+            continue;
+
         if (!inTransaction && message->configPaxosID > CONFIG_STATE->paxosID)
             break;
 
@@ -956,8 +1110,21 @@ void ShardQuorumProcessor::TryAppend()
             break;
         }
 
-        message->Append(nextValue);
-        nextValue.Appendf(" ");
+        if (numMessages == 0)
+        {
+            queueDelay = EventLoop::Now() - message->queueTime;
+            if (binaryReplication)
+                ShardMessage::AppendValueHeader(nextValue);
+        }
+
+        if (binaryReplication)
+            message->AppendBinary(nextValue);
+        else
+        {
+            message->Append(nextValue);
+            nextValue.Appendf(" ");
+        }
+        proposedValues.Add(message);
         numMessages++;
 
         if (message->type == SHARDMESSAGE_START_TRANSACTION)
@@ -967,11 +1134,10 @@ void ShardQuorumProcessor::TryAppend()
 
         if (!inTransaction)
         {
-            if (message->type == SHARDMESSAGE_SPLIT_SHARD || nextValue.GetLength() >= DATABASE_REPLICATION_SIZE)
+            if (message->type == SHARDMESSAGE_SPLIT_SHARD || nextValue.GetLength() >= appendBatcher.GetBatchLimit())
                 break;
             
-            if (message->clientRequest && SHARD_MIGRATION_WRITER->IsActive() &&
-             SHARD_MIGRATION_WRITER->GetShardID() == message->clientRequest->shardID)
+            if (message->clientRequest && IsMigrationWrite(message))
                 break;
         }
     }
@@ -985,12 +1151,46 @@ void ShardQuorumProcessor::TryAppend()
 //    Log_Debug("numMessages = %u", numMessages);
 //    Log_Debug("length = %s", HUMAN_BYTES(appendValue.GetLength()));
     
+    appendBatcher.OnAppend(nextValue.GetLength(), numMessages, numQueued, queueDelay);
+
     if (nextValue.GetLength() > 0)
+    {
+        proposedValues.OnAppend(nextValue);
         quorumContext.Append();
+    }
     else
         EventLoop::Add(&tryAppend);
 }
 
+bool ShardQuorumProcessor::IsMigrationWrite(ShardMessage* message)
+{
+    uint64_t        i;
+    uint64_t        shardID;
+    ReadBuffer      key;
+    ReadBuffer      value;
+    ConfigShard*    configShard;
+
+    if (!SHARD_MIGRATION_WRITER->IsActive())
+        return false;
+
+    shardID = SHARD_MIGRATION_WRITER->GetShardID();
+    if (message->type != SHARDMESSAGE_MULTI_SET)
+        return (message->clientRequest->shardID == shardID);
+
+    // the request is routed by its first key, the other keys may be in other shards
+    MessageReader reader(message->value);
+    for (i = 0; i < message->number; i++)
+    {
+        if (!reader.ReadData(key) || !reader.ReadData(value))
+            break;
+        configShard = CONFIG_STATE->GetShard(message->tableID, key);
+        if (configShard && configShard->shardID == shardID)
+            return true;
+    }
+
+    return false;
+}
+
 void ShardQuorumProcessor::OnResumeAppend()
 {
     bool            inTransaction;
@@ -1013,18 +1213,28 @@ void ShardQuorumProcessor::OnResumeAppend()
     while (appendState.value.GetLength() > 0)
     {
         // parse message
-        read = shardMessage.Read(appendState.value);
-        ASSERT(read > 0);
-        appendState.value.Advance(read);
-        ASSERT(appendState.value.GetCharAt(0) == ' ');
-        appendState.value.Advance(1);
+        if (appendState.version == SHARDMESSAGE_VERSION_BINARY)
+        {
+            read = shardMessage.ReadBinary(appendState.value);
+            ASSERT(read > 0);
+            appendState.value.Advance(read);
+        }
+        else
+        {
+            read = shardMessage.Read(appendState.value);
+            ASSERT(read > 0);
+            appendState.value.Advance(read);
+            ASSERT(appendState.value.GetCharAt(0) == ' ');
+            appendState.value.Advance(1);
+        }
 
         itShardMessage = NULL;  // suppress compiler warning
         if (appendState.currentAppend)
         {
-            // find this message in the shardMessages list
-            itShardMessage = shardMessages.First();
+            // find this message in the shardMessages list, ExecuteMessage() removes it
+            itShardMessage = appendState.nextMessage;
             ASSERT(itShardMessage != NULL);
+            appendState.nextMessage = proposedValues.Next(itShardMessage);
         }
 
         prevMigrateCache = migrateCache;
@@ -1054,6 +1264,8 @@ void ShardQuorumProcessor::OnResumeAppend()
 
     Log_Debug("numOps: %U", appendState.commandID);
     
+    if (appendState.currentAppend)
+        proposedValues.OnChosenExecuted();
     appendState.Reset();
     
     quorumContext.OnAppendComplete();
@@ -1111,6 +1323,7 @@ void ShardQuorumProcessor::CommitTransaction(ClientRequest* request)
     message = messageCache.Acquire();
     message->StartTransaction();
     message->clientRequest = NULL;
+    message->queueTime = EventLoop::Now();
     shardMessages.Append(message);
 
     request->session->transaction.Append(request);
@@ -1125,6 +1338,7 @@ void ShardQuorumProcessor::CommitTransaction(ClientRequest* request)
         message = messageCache.Acquire();
         TransformRequest(it, message);            
         message->clientRequest = it;
+        message->queueTime = EventLoop::Now();
         shardMessages.Append(message);
     }
     ASSERT(shardMessages.Last()->type == SHARDMESSAGE_COMMIT_TRANSACTION);
@@ -6,6 +6,8 @@
 #include "Application/Common/ClientRequest.h"
 #include "ShardMessage.h"
 #include "ShardQuorumContext.h"
+#include "ShardAppendBatcher.h"
+#include "ShardProposedValues.h"
 
 class ShardServer;
 
@@ -47,8 +49,10 @@ struct ShardAppendState
     bool                    currentAppend;
     uint64_t                paxosID;
     uint64_t                commandID;
+    unsigned                version;        // format of the value, see ShardMessage
     Buffer                  valueBuffer;
     ReadBuffer              value;
+    ShardMessage*           nextMessage;    // next message of ours to execute, if currentAppend
     
     void                    Reset();
 };
@@ -79,6 +83,7 @@ public:
     ShardServer*            GetShardServer();
 
     bool                    IsPrimary();
+    bool                    IsLeaseValid();
     uint64_t                GetQuorumID();
     uint64_t                GetPaxosID();
     void                    SetPaxosID(uint64_t paxosID);
@@ -110,10 +115,16 @@ public:
     void                    OnShardMigrationClusterMessage(uint64_t nodeID, ClusterMessage& message);
     void                    SetBlockReplication(bool blockReplication);
     void                    SetReplicationLimit(unsigned replicationLimit);
+    void                    SetReplicationWindow(unsigned replicationWindow);
+    void                    SetBinaryReplication(bool binaryReplication);
     
     uint64_t                GetMessageCacheSize();
     uint64_t                GetMessageListSize();
     unsigned                GetMessageListLength();
+    unsigned                GetAppendBatchLimit();
+    uint64_t                GetAppendRoundTime();
+    uint64_t                GetAppendMinRoundTime();
+    uint64_t                GetAppendQueueDelay();
     uint64_t                GetShardAppendStateSize();
     uint64_t                GetQuorumContextSize();
 
@@ -124,6 +135,8 @@ public:
     void                    OnAppend(uint64_t paxosID, Buffer& value, bool ownAppend);
     void                    OnStartCatchup();
     bool                    IsPaxosBlocked();
+    void                    OnPipelineCleared();
+    void                    OnNextValueProposed(uint64_t paxosID);
     // ========================================================================================
 
     void                    OnRequestLeaseTimeout();
@@ -136,6 +149,7 @@ public:
 
 private:
     void                    TransformRequest(ClientRequest* request, ShardMessage* message);
+    bool                    IsMigrationWrite(ShardMessage* message);
     void                    ExecuteMessage(uint64_t paxosID, uint64_t commandID,
                              ShardMessage* message, bool ownCommand);
     void                    TryAppend();
@@ -150,8 +164,10 @@ private:
     uint64_t                configID;
     uint64_t                prevAppendTime;
     unsigned                appendDelay;
+    bool                    binaryReplication;
 
     ShardAppendState        appendState;
+    ShardAppendBatcher      appendBatcher;
 
     ShardServer*            shardServer;
     ShardQuorumContext      quorumContext;
@@ -160,10 +176,12 @@ private:
     LeaseRequestList        leaseRequests;
     MessageCache            messageCache;
     MessageList             shardMessages;
+    ShardProposedValues     proposedValues;
     
     uint64_t                migrateNodeID;
     uint64_t                migrateShardID;
     int64_t                 migrateCache; // in bytes
+    bool                    migrateAborted;
     bool                    blockReplication;
     bool                    mergeDisabled;
     bool                    needCatchup;
@@ -1,6 +1,7 @@
 #include "ShardServer.h"
 #include "System/Config.h"
 #include "Framework/Replication/ReplicationConfig.h"
+#include "Framework/Messaging/MessageUtil.h"
 #include "Framework/Storage/StoragePageCache.h"
 #include "Framework/Storage/StorageListPageCache.h"
 #include "Application/Common/ContextTransport.h"
@@ -180,6 +181,15 @@ void ShardServer::OnClientRequest(ClientRequest* request)
         return;
     }
     
+    // the request is routed by its first key, the others must be served by the same quorum
+    if (request->IsMulti() && !IsMultiRequestInQuorum(request, shard->quorumID))
+    {
+        Log_Trace();
+        request->response.BadSchema();
+        request->OnComplete();
+        return;
+    }
+
     quorumProcessor = GetQuorumProcessor(shard->quorumID);
     if (!quorumProcessor)
     {
@@ -192,6 +202,30 @@ void ShardServer::OnClientRequest(ClientRequest* request)
     quorumProcessor->OnClientRequest(request);
 }
 
+bool ShardServer::IsMultiRequestInQuorum(ClientRequest* request, uint64_t quorumID)
+{
+    uint64_t        i;
+    ReadBuffer      key;
+    ReadBuffer      value;
+    ConfigShard*    shard;
+    MessageReader   reader(request->value);
+
+    for (i = 0; i < request->count; i++)
+    {
+        // malformed requests are rejected when they are executed
+        if (!reader.ReadData(key))
+            break;
+        if (request->type == CLIENTREQUEST_MULTI_SET && !reader.ReadData(value))
+            break;
+
+        shard = configState.GetShard(request->tableID, key);
+        if (!shard || shard->quorumID != quorumID)
+            return false;
+    }
+
+    return true;
+}
+
 void ShardServer::OnClientClose(ClientSession* session)
 {
     ClientRequest* request;
@@ -250,6 +284,9 @@ void ShardServer::OnClusterMessage(uint64_t nodeID, ClusterMessage& message)
         case CLUSTERMESSAGE_SET_CONFIG_STATE:
             OnSetConfigState(nodeID, message);
             break;
+        case CLUSTERMESSAGE_SET_CONFIG_STATE_DELTA:
+            OnSetConfigStateDelta(nodeID, message);
+            break;
         case CLUSTERMESSAGE_RECEIVE_LEASE:
             quorumProcessor = GetQuorumProcessor(message.quorumID);
             if (quorumProcessor)
@@ -281,6 +318,7 @@ void ShardServer::OnClusterMessage(uint64_t nodeID, ClusterMessage& message)
         case CLUSTERMESSAGE_SHARDMIGRATION_BEGIN:
         case CLUSTERMESSAGE_SHARDMIGRATION_SET:
         case CLUSTERMESSAGE_SHARDMIGRATION_DELETE:
+        case CLUSTERMESSAGE_SHARDMIGRATION_BATCH:
         case CLUSTERMESSAGE_SHARDMIGRATION_COMMIT:
             quorumProcessor = GetQuorumProcessor(message.quorumID);
             ASSERT(quorumProcessor != NULL);
@@ -481,9 +519,6 @@ uint64_t ShardServer::GetNumRequests()
 
 void ShardServer::OnSetConfigState(uint64_t nodeID, ClusterMessage& message)
 {
-    ConfigQuorum*           configQuorum;
-    ShardQuorumProcessor*   quorumProcessor;
-    
     if (!message.configState.hasMaster)
         return;
 
@@ -492,6 +527,47 @@ void ShardServer::OnSetConfigState(uint64_t nodeID, ClusterMessage& message)
 
     configState = message.configState;
 
+    OnConfigStateChanged();
+}
+
+void ShardServer::OnSetConfigStateDelta(uint64_t nodeID, ClusterMessage& message)
+{
+    uint64_t    baseVersion;
+    uint64_t    version;
+
+    if (!ConfigState::ReadDeltaVersions(message.value, baseVersion, version))
+        return;
+
+    if (baseVersion == 0)
+    {
+        // a snapshot
+        if (!message.configState.ReadDelta(message.value))
+            return;
+        if (!message.configState.hasMaster || message.configState.masterID != nodeID)
+            return;
+        message.configState.Transfer(configState);
+    }
+    else
+    {
+        if (!configState.hasMaster || configState.masterID != nodeID ||
+         !configState.ReadDelta(message.value))
+        {
+            // the version is reported in the next heartbeat, so the master sends a snapshot
+            Log_Debug("Config state delta %U => %U does not apply to version %U",
+             baseVersion, version, configState.version);
+            configState.version = 0;
+            return;
+        }
+    }
+
+    OnConfigStateChanged();
+}
+
+void ShardServer::OnConfigStateChanged()
+{
+    ConfigQuorum*           configQuorum;
+    ShardQuorumProcessor*   quorumProcessor;
+
     ResetChangedConnections();
 
     TryDeleteQuorumProcessors();
@@ -600,6 +676,8 @@ void ShardServer::ConfigureQuorum(ConfigQuorum* configQuorum)
         quorumProcessor = new ShardQuorumProcessor;
         quorumProcessor->Init(configQuorum, this);
         quorumProcessor->SetReplicationLimit(configFile.GetIntValue("replicationLimit", 0));
+        quorumProcessor->SetReplicationWindow(configFile.GetIntValue("replicationWindow", 1));
+        quorumProcessor->SetBinaryReplication(configFile.GetBoolValue("binaryReplication", false));
         quorumProcessors.Append(quorumProcessor);
     }
 
@@ -68,6 +68,9 @@ public:
 
 private:
     void                    OnSetConfigState(uint64_t nodeID, ClusterMessage& message);
+    void                    OnSetConfigStateDelta(uint64_t nodeID, ClusterMessage& message);
+    void                    OnConfigStateChanged();
+    bool                    IsMultiRequestInQuorum(ClientRequest* request, uint64_t quorumID);
     void                    ResetChangedConnections();
     void                    TryDeleteQuorumProcessors();
     void                    TryDeleteQuorumProcessor(ShardQuorumProcessor* quorumProcessor);
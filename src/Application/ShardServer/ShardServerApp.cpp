@@ -23,6 +23,7 @@ void ShardServerApp::Init()
     sdbpServer.Init(sdbpPort);
     sdbpServer.SetContext(&shardServer);
     sdbpServer.UseKeepAlive(true);
+    sdbpServer.InitLoops(configFile.GetIntValue("sdbp.numEventLoops", 0));
 
     // start shardServer only after network servers are started
     shardServer.Init(this, restoreMode, setNodeID, nodeID);
@@ -157,7 +157,6 @@ bool ClusterTransport::SetConnectionNodeID(Endpoint& endpoint, uint64_t nodeID)
 
 void ClusterTransport::SendMessage(uint64_t nodeID, Buffer& prefix, Message& msg)
 {
-    bool                ret;
     ClusterConnection*  conn;
     
     conn = GetConnection(nodeID);
@@ -174,11 +173,8 @@ void ClusterTransport::SendMessage(uint64_t nodeID, Buffer& prefix, Message& msg
         return;
     }
     
-    msgBuffer.Clear();
-    ret = msg.Write(msgBuffer);
-    ASSERT(ret);
-    ASSERT(msgBuffer.GetLength() > 0);
-    conn->Write(prefix, msgBuffer);
+    // serialized directly for the connection, large messages are not copied again
+    conn->Write(prefix, msg);
 }
 
 void ClusterTransport::DropConnection(uint64_t nodeID)
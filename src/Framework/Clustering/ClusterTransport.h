@@ -69,7 +69,6 @@ private:
     uint64_t                    nodeID;
     uint64_t                    clusterID;
     Endpoint                    endpoint;
-    Buffer                      msgBuffer;
     ClusterServer               server;
     InList<ClusterConnection>   conns;
     InList<WriteReadyness>      writeReadynessList;
@@ -49,20 +49,33 @@ void MessageConnection::Write(Buffer& msg)
         Flush();
 }
 
-void MessageConnection::Write(Message& msg)
+void MessageConnection::Write(Buffer* msg)
 {
-    // TODO: optimize
-    
-    Buffer tmpBuffer;
-
-    msg.Write(tmpBuffer);
-
-    GetWriteBuffer().Appendf("%#B", &tmpBuffer);
+    // large messages are queued as segments instead of copying them again
+    if (msg->GetLength() >= MESSAGING_SEGMENT_THRESHOLD)
+    {
+        GetWriteBuffer().Appendf("%u:", msg->GetLength());
+        WriteSegment(msg);
+    }
+    else
+    {
+        GetWriteBuffer().Appendf("%#B", msg);
+        ReleaseSegment(msg);
+    }
 
     if (autoFlush)
         Flush();
 }
 
+void MessageConnection::Write(Message& msg)
+{
+    Buffer*     segment;
+
+    segment = AcquireSegment();
+    msg.Write(*segment);
+    Write(segment);
+}
+
 void MessageConnection::Write(Buffer& prefix, Buffer& msg)
 {
     unsigned length;
@@ -77,15 +90,23 @@ void MessageConnection::Write(Buffer& prefix, Buffer& msg)
 
 void MessageConnection::Write(Buffer& prefix, Message& msg)
 {
-    // TODO: optimize
-
     unsigned    length;
-    Buffer      tmpBuffer;
+    Buffer*     segment;
 
-    msg.Write(tmpBuffer);
-    length = prefix.GetLength() + 1 + tmpBuffer.GetLength();
+    segment = AcquireSegment();
+    msg.Write(*segment);
+    length = prefix.GetLength() + 1 + segment->GetLength();
 
-    GetWriteBuffer().Appendf("%u:%B:%B", length, &prefix, &tmpBuffer);
+    if (segment->GetLength() >= MESSAGING_SEGMENT_THRESHOLD)
+    {
+        GetWriteBuffer().Appendf("%u:%B:", length, &prefix);
+        WriteSegment(segment);
+    }
+    else
+    {
+        GetWriteBuffer().Appendf("%u:%B:%B", length, &prefix, segment);
+        ReleaseSegment(segment);
+    }
 
     if (autoFlush)
         Flush();
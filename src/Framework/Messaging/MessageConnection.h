@@ -9,6 +9,7 @@
 #define MESSAGING_CONNECT_TIMEOUT       (2*1000)
 #define MESSAGING_BUFFER_THRESHOLD      (10*1360)              // tuned to work well with Ethernet
 #define MESSAGING_MAX_SIZE              (128*MB)
+#define MESSAGING_SEGMENT_THRESHOLD     (16*KiB)               // larger messages are not copied
 
 /*
 ===============================================================================================
@@ -30,6 +31,8 @@ public:
     virtual void        Close();
 
     void                Write(Buffer& msg);
+    // takes ownership of msg
+    void                Write(Buffer* msg);
     void                Write(Message& msg);
     void                Write(Buffer& prefix, Buffer& msg);
     void                Write(Buffer& prefix, Message& msg);
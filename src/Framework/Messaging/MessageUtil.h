@@ -60,6 +60,126 @@ public:
         
         return true;
     }
+
+    // binary encoding helpers, see MessageReader for decoding
+    static void WriteNumber(Buffer& buffer, uint64_t number)
+    {
+        buffer.AppendVarint(number);
+    }
+
+    static void WriteSignedNumber(Buffer& buffer, int64_t number)
+    {
+        // zigzag encoding, so that small negative numbers are short too
+        buffer.AppendVarint(((uint64_t) number << 1) ^ (uint64_t) (number >> 63));
+    }
+
+    static void WriteData(Buffer& buffer, const ReadBuffer& data)
+    {
+        buffer.AppendVarint(data.GetLength());
+        buffer.Append(data);
+    }
+};
+
+/*
+===============================================================================================
+
+ MessageReader - decodes the binary encoding written by MessageUtil
+
+ Works on raw pointers so that parsing a message does not need a function call per field.
+
+===============================================================================================
+*/
+
+class MessageReader
+{
+public:
+    MessageReader(const ReadBuffer& buffer)
+    {
+        pos = buffer.GetBuffer();
+        end = pos + buffer.GetLength();
+    }
+
+    bool IsEnd()
+    {
+        return pos == end;
+    }
+
+    ReadBuffer GetRemaining()
+    {
+        return ReadBuffer((char*) pos, (unsigned) (end - pos));
+    }
+
+    bool ReadChar(char& c)
+    {
+        if (pos == end)
+            return false;
+        c = *pos++;
+        return true;
+    }
+
+    bool ReadNumber(uint64_t& number)
+    {
+        unsigned        shift;
+        unsigned char   c;
+
+        number = 0;
+        for (shift = 0; shift < 64; shift += 7)
+        {
+            if (pos == end)
+                return false;
+            c = (unsigned char) *pos++;
+            number |= (uint64_t) (c & 0x7F) << shift;
+            if ((c & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool ReadNumber(unsigned& number)
+    {
+        uint64_t    number64;
+
+        if (!ReadNumber(number64) || number64 > (uint64_t) (unsigned) -1)
+            return false;
+        number = (unsigned) number64;
+        return true;
+    }
+
+    bool ReadSignedNumber(int64_t& number)
+    {
+        uint64_t    zigzag;
+
+        if (!ReadNumber(zigzag))
+            return false;
+        number = (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+        return true;
+    }
+
+    bool ReadData(ReadBuffer& data)
+    {
+        uint64_t    length;
+
+        if (!ReadNumber(length) || length > (uint64_t) (end - pos))
+            return false;
+        data = ReadBuffer((char*) pos, (unsigned) length);
+        pos += length;
+        return true;
+    }
+
+    bool ReadData(Buffer& data)
+    {
+        uint64_t    length;
+
+        if (!ReadNumber(length) || length > (uint64_t) (end - pos))
+            return false;
+        data.Write(pos, (unsigned) length);
+        pos += length;
+        return true;
+    }
+
+private:
+    const char*     pos;
+    const char*     end;
 };
 
 #endif
@@ -9,8 +9,13 @@ PaxosAcceptor::PaxosAcceptor()
 
 void PaxosAcceptor::Init(QuorumContext* context_)
 {
+    unsigned    i;
+
     context = context_;
     isCommitting = false;
+
+    for (i = 0; i < PAXOS_MAX_PIPELINE_WINDOW; i++)
+        pipeline[i].paxosID = 0;
     
     ReadState();
 }
@@ -56,6 +61,63 @@ bool PaxosAcceptor::OnProposeRequest(PaxosMessage& imsg)
     return false; // OnMessageProcessed() will be called in OnStateWritten()
 }
 
+bool PaxosAcceptor::OnPipelinedProposeRequest(PaxosMessage& imsg)
+{
+    bool                reject;
+    PaxosAcceptorSlot*  slot;
+
+    Log_Trace("msg.paxosID: %U", imsg.paxosID);
+
+    ASSERT(imsg.paxosID > context->GetPaxosID());
+
+    reject = false;
+    // only multi paxos proposals are pipelined, these skip the prepare phase
+    if (imsg.proposalID != 0)
+        reject = true;
+    slot = GetSlot(imsg.paxosID);
+    if (slot && (slot->nodeID != imsg.nodeID || slot->runID != imsg.runID))
+        reject = true;
+    if (!IsPipelineChained(imsg))
+        reject = true;
+    if (isCommitting)
+        reject = true;
+    if (context->GetDatabase()->IsCommitting())
+        reject = true;
+    if (context->IsPaxosBlocked())
+        reject = true;
+
+    if (reject)
+    {
+        Log_Debug("Rejecting pipelined propose, imsg.paxosID = %U, context->GetPaxosID() = %U",
+         imsg.paxosID, context->GetPaxosID());
+        omsg.ProposeRejected(imsg.paxosID, MY_NODEID, imsg.proposalID);
+        context->GetTransport()->SendMessage(imsg.nodeID, omsg);
+        return true; // msg processed
+    }
+
+    slot = &pipeline[imsg.paxosID % PAXOS_MAX_PIPELINE_WINDOW];
+    slot->paxosID = imsg.paxosID;
+    slot->nodeID = imsg.nodeID;
+    slot->runID = imsg.runID;
+    ASSERT(imsg.value.GetLength() > 0);
+    slot->value.Write(imsg.value);
+
+    senderID = imsg.nodeID;
+    omsg.ProposeAccepted(imsg.paxosID, MY_NODEID, imsg.proposalID);
+
+    context->GetDatabase()->SetAcceptedValue(slot->paxosID, slot->value);
+    WritePipeline();
+    WriteState();
+    Commit();
+    return false; // OnMessageProcessed() will be called in OnStateWritten()
+}
+
+void PaxosAcceptor::OnNewPaxosRound()
+{
+    state.OnNewPaxosRound();
+    AcceptPipelined();
+}
+
 void PaxosAcceptor::OnCatchupStarted()
 {
     state.Init();
@@ -93,7 +155,14 @@ void PaxosAcceptor::WriteState()
 
 uint64_t PaxosAcceptor::GetMemoryUsage()
 {
-    return sizeof(PaxosAcceptor) + state.acceptedValue.GetSize();
+    unsigned    i;
+    uint64_t    size;
+
+    size = sizeof(PaxosAcceptor) + state.acceptedValue.GetSize();
+    for (i = 0; i < PAXOS_MAX_PIPELINE_WINDOW; i++)
+        size += pipeline[i].value.GetSize();
+
+    return size;
 }
 
 void PaxosAcceptor::Commit()
@@ -142,6 +211,136 @@ void PaxosAcceptor::ReadState()
         db->GetAcceptedValue(context->GetPaxosID(), state.acceptedValue);
         ASSERT(state.acceptedValue.GetLength() > 0);
     }
+
+    ReadPipeline();
+}
+
+void PaxosAcceptor::ReadPipeline()
+{
+    uint64_t            paxosID;
+    uint64_t            nodeID;
+    uint64_t            runID;
+    int                 read;
+    Buffer              value;
+    ReadBuffer          rb;
+    PaxosAcceptorSlot*  slot;
+
+    context->GetDatabase()->GetPipeline(value);
+    rb.Wrap(value);
+    while (rb.GetLength() > 0)
+    {
+        read = rb.Readf("%U:%U:%U ", &paxosID, &nodeID, &runID);
+        if (read < 0)
+        {
+            Log_Message("Invalid pipeline state in quorum %U", context->GetQuorumID());
+            break;
+        }
+        rb.Advance(read);
+
+        // entries at or below the current paxosID are stale
+        if (paxosID < context->GetPaxosID() ||
+         paxosID >= context->GetPaxosID() + PAXOS_MAX_PIPELINE_WINDOW)
+            continue;
+        if (paxosID == context->GetPaxosID() && state.accepted)
+            continue;
+
+        slot = &pipeline[paxosID % PAXOS_MAX_PIPELINE_WINDOW];
+        context->GetDatabase()->GetAcceptedValue(paxosID, slot->value);
+        if (slot->value.GetLength() == 0)
+            continue;
+        slot->paxosID = paxosID;
+        slot->nodeID = nodeID;
+        slot->runID = runID;
+    }
+
+    if (!state.accepted)
+        AcceptPipelined();
+}
+
+void PaxosAcceptor::WritePipeline()
+{
+    unsigned    i;
+    Buffer      value;
+    ReadBuffer  rb;
+
+    for (i = 0; i < PAXOS_MAX_PIPELINE_WINDOW; i++)
+    {
+        if (pipeline[i].paxosID <= context->GetPaxosID() || pipeline[i].value.GetLength() == 0)
+            continue;
+        value.Appendf("%U:%U:%U ", pipeline[i].paxosID, pipeline[i].nodeID, pipeline[i].runID);
+    }
+    
+    rb.Wrap(value);
+    context->GetDatabase()->SetPipeline(rb);
+}
+
+void PaxosAcceptor::AcceptPipelined()
+{
+    PaxosAcceptorSlot*  slot;
+
+    // a value accepted earlier in pipelined mode becomes the accepted value of this round
+    slot = GetSlot(context->GetPaxosID());
+    if (!slot)
+        return;
+
+    state.accepted = true;
+    state.acceptedProposalID = 0;
+    state.acceptedRunID = slot->runID;
+    state.acceptedValue.Write(slot->value);
+    slot->value.Clear();
+}
+
+bool PaxosAcceptor::IsPipelineChained(PaxosMessage& imsg)
+{
+    uint64_t            paxosID;
+    PaxosAcceptorSlot*  slot;
+
+    // a pipelined value is only accepted behind ballot 0 values of the same run,
+    // so it can only be chosen if the rounds before it chose the values of that run
+    if (!state.accepted || state.acceptedProposalID != 0 || state.acceptedRunID != imsg.runID)
+        return false;
+
+    // once a prepare was answered in this round, the new proposer knows the highest pipelined
+    // round of this acceptor, and that must not grow behind its back
+    if (state.promisedProposalID != 0)
+        return false;
+
+    for (paxosID = context->GetPaxosID() + 1; paxosID < imsg.paxosID; paxosID++)
+    {
+        slot = GetSlot(paxosID);
+        if (!slot || slot->nodeID != imsg.nodeID || slot->runID != imsg.runID)
+            return false;
+    }
+
+    return true;
+}
+
+uint64_t PaxosAcceptor::GetLastPipelinedPaxosID()
+{
+    unsigned    i;
+    uint64_t    paxosID;
+
+    paxosID = 0;
+    for (i = 0; i < PAXOS_MAX_PIPELINE_WINDOW; i++)
+    {
+        if (pipeline[i].paxosID <= context->GetPaxosID() || pipeline[i].value.GetLength() == 0)
+            continue;
+        if (pipeline[i].paxosID > paxosID)
+            paxosID = pipeline[i].paxosID;
+    }
+
+    return paxosID;
+}
+
+PaxosAcceptorSlot* PaxosAcceptor::GetSlot(uint64_t paxosID)
+{
+    PaxosAcceptorSlot*  slot;
+    
+    slot = &pipeline[paxosID % PAXOS_MAX_PIPELINE_WINDOW];
+    if (slot->paxosID != paxosID || slot->value.GetLength() == 0)
+        return NULL;
+    
+    return slot;
 }
 
 bool PaxosAcceptor::TestRejection(PaxosMessage& msg)
@@ -180,14 +379,15 @@ void PaxosAcceptor::AcceptPrepareRequest(PaxosMessage& imsg)
     senderID = imsg.nodeID;
     if (!state.accepted)
     {
-        omsg.PrepareCurrentlyOpen(imsg.paxosID, MY_NODEID, imsg.proposalID);
+        omsg.PrepareCurrentlyOpen(imsg.paxosID, MY_NODEID, imsg.proposalID,
+         GetLastPipelinedPaxosID());
     }
     else
     {
         ASSERT(state.acceptedValue.GetLength() > 0);
         omsg.PreparePreviouslyAccepted(imsg.paxosID, MY_NODEID,
          imsg.proposalID, state.acceptedProposalID,
-         state.acceptedRunID, state.acceptedValue);
+         state.acceptedRunID, state.acceptedValue, GetLastPipelinedPaxosID());
     }
     
     WriteState();
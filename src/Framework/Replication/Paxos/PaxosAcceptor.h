@@ -9,6 +9,24 @@
 
 class ReplicatedLog; // forward
 
+/*
+===============================================================================================
+
+ PaxosAcceptorSlot
+
+ A value accepted for a later paxosID in pipelined multi paxos mode.
+
+===============================================================================================
+*/
+
+struct PaxosAcceptorSlot
+{
+    uint64_t        paxosID;
+    uint64_t        nodeID;
+    uint64_t        runID;
+    Buffer          value;
+};
+
 /*
 ===============================================================================================
 
@@ -27,6 +45,8 @@ public:
     void            Init(QuorumContext* context);
     bool            OnPrepareRequest(PaxosMessage& msg);
     bool            OnProposeRequest(PaxosMessage& msg);
+    bool            OnPipelinedProposeRequest(PaxosMessage& msg);
+    void            OnNewPaxosRound();
     void            OnCatchupStarted();
     void            OnCatchupComplete();
     void            WriteState();
@@ -38,6 +58,12 @@ private:
     void            Commit();
     void            OnStateWritten();
     void            ReadState();
+    void            ReadPipeline();
+    void            WritePipeline();
+    void            AcceptPipelined();
+    bool            IsPipelineChained(PaxosMessage& msg);
+    uint64_t        GetLastPipelinedPaxosID();
+    PaxosAcceptorSlot* GetSlot(uint64_t paxosID);
     bool            TestRejection(PaxosMessage& msg);
     void            AcceptPrepareRequest(PaxosMessage& msg);
     void            AcceptProposeRequest(PaxosMessage& msg);
@@ -48,6 +74,7 @@ private:
     uint64_t        senderID;
     uint64_t        writtenPaxosID;
     Callable        onStateWritten;    
+    PaxosAcceptorSlot pipeline[PAXOS_MAX_PIPELINE_WINDOW];
 };
 
 #endif
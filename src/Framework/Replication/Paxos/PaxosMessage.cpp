@@ -6,6 +6,7 @@ void PaxosMessage::Init(uint64_t paxosID_, char type_, uint64_t nodeID_)
     paxosID = paxosID_;
     nodeID = nodeID_;
     type = type_;
+    pipelinedPaxosID = 0;
 }
 
 bool PaxosMessage::PrepareRequest(
@@ -33,23 +34,25 @@ bool PaxosMessage::PrepareRejected(
 bool PaxosMessage::PreparePreviouslyAccepted(
  uint64_t paxosID_, uint64_t nodeID_,
  uint64_t proposalID_, uint64_t acceptedProposalID_,
- uint64_t runID_, Buffer& value_)
+ uint64_t runID_, Buffer& value_, uint64_t pipelinedPaxosID_)
 {
     Init(paxosID_, PAXOS_PREPARE_PREVIOUSLY_ACCEPTED, nodeID_);
     proposalID = proposalID_;
     acceptedProposalID = acceptedProposalID_;
     runID = runID_;
     value.Wrap(value_);
+    pipelinedPaxosID = pipelinedPaxosID_;
     
     return true;
 }
 
 bool PaxosMessage::PrepareCurrentlyOpen(
  uint64_t paxosID_, uint64_t nodeID_,
- uint64_t proposalID_)
+ uint64_t proposalID_, uint64_t pipelinedPaxosID_)
 {
     Init(paxosID_, PAXOS_PREPARE_CURRENTLY_OPEN, nodeID_);
     proposalID = proposalID_;
+    pipelinedPaxosID = pipelinedPaxosID_;
 
     return true;
 }
@@ -161,6 +164,7 @@ bool PaxosMessage::Read(ReadBuffer& buffer)
     if (buffer.GetLength() < 3)
         return false;
 
+    pipelinedPaxosID = 0;
     switch (buffer.GetCharAt(2))
     {
         case PAXOS_PREPARE_REQUEST:
@@ -172,12 +176,20 @@ bool PaxosMessage::Read(ReadBuffer& buffer)
              &proto, &type, &paxosID, &nodeID, &proposalID, &promisedProposalID);
             break;
         case PAXOS_PREPARE_PREVIOUSLY_ACCEPTED:
-            read = buffer.Readf("%c:%c:%U:%U:%U:%U:%U:%#R",
-             &proto, &type, &paxosID, &nodeID, &proposalID, &acceptedProposalID, &runID, &value);
+            read = buffer.Readf("%c:%c:%U:%U:%U:%U:%U:%#R:%U",
+             &proto, &type, &paxosID, &nodeID, &proposalID, &acceptedProposalID, &runID, &value,
+             &pipelinedPaxosID);
+            // nodes without pipelining do not send pipelinedPaxosID
+            if (read != (signed)buffer.GetLength())
+                read = buffer.Readf("%c:%c:%U:%U:%U:%U:%U:%#R",
+                 &proto, &type, &paxosID, &nodeID, &proposalID, &acceptedProposalID, &runID, &value);
             break;
         case PAXOS_PREPARE_CURRENTLY_OPEN:
-            read = buffer.Readf("%c:%c:%U:%U:%U",
-             &proto, &type, &paxosID, &nodeID, &proposalID);
+            read = buffer.Readf("%c:%c:%U:%U:%U:%U",
+             &proto, &type, &paxosID, &nodeID, &proposalID, &pipelinedPaxosID);
+            if (read != (signed)buffer.GetLength())
+                read = buffer.Readf("%c:%c:%U:%U:%U",
+                 &proto, &type, &paxosID, &nodeID, &proposalID);
             break;
         case PAXOS_PROPOSE_REQUEST:
             read = buffer.Readf("%c:%c:%U:%U:%U:%U:%#R",
@@ -232,12 +244,13 @@ bool PaxosMessage::Write(Buffer& buffer)
              proto, type, paxosID, nodeID, proposalID, promisedProposalID);
             break;
         case PAXOS_PREPARE_PREVIOUSLY_ACCEPTED:
-            buffer.Writef("%c:%c:%U:%U:%U:%U:%U:%#R",
-             proto, type, paxosID, nodeID, proposalID, acceptedProposalID, runID, &value);
+            buffer.Writef("%c:%c:%U:%U:%U:%U:%U:%#R:%U",
+             proto, type, paxosID, nodeID, proposalID, acceptedProposalID, runID, &value,
+             pipelinedPaxosID);
             break;
         case PAXOS_PREPARE_CURRENTLY_OPEN:
-            buffer.Writef("%c:%c:%U:%U:%U",
-             proto, type, paxosID, nodeID, proposalID);
+            buffer.Writef("%c:%c:%U:%U:%U:%U",
+             proto, type, paxosID, nodeID, proposalID, pipelinedPaxosID);
             break;
         case PAXOS_PROPOSE_REQUEST:
             buffer.Writef("%c:%c:%U:%U:%U:%U:%#R",
@@ -16,6 +16,8 @@
 #define PAXOS_REQUEST_CHOSEN                '0'
 #define PAXOS_START_CATCHUP                 'c'
 
+#define PAXOS_MAX_PIPELINE_WINDOW           16
+
 /*
 ===============================================================================================
 
@@ -34,6 +36,7 @@ public:
     uint64_t        proposalID;
     uint64_t        acceptedProposalID;
     uint64_t        promisedProposalID;
+    uint64_t        pipelinedPaxosID;   // highest round the acceptor holds a pipelined value for
     ReadBuffer      value;
 
     void            Init(uint64_t paxosID, char type, uint64_t nodeID);
@@ -49,11 +52,11 @@ public:
     bool            PreparePreviouslyAccepted(
                      uint64_t paxosID, uint64_t nodeID,
                      uint64_t proposalID, uint64_t acceptedProposalID,
-                     uint64_t runID, Buffer& value);
+                     uint64_t runID, Buffer& value, uint64_t pipelinedPaxosID);
 
     bool            PrepareCurrentlyOpen(
                      uint64_t paxosID, uint64_t nodeID,
-                     uint64_t proposalID);
+                     uint64_t proposalID, uint64_t pipelinedPaxosID);
 
     bool            ProposeRequest(
                      uint64_t paxosID, uint64_t nodeID,
@@ -4,11 +4,17 @@
 
 PaxosProposer::~PaxosProposer()
 {
+    unsigned    i;
+
     delete vote;
+    for (i = 0; i < PAXOS_MAX_PIPELINE_WINDOW; i++)
+        delete pipeline[i].vote;
 }
 
 void PaxosProposer::Init(QuorumContext* context_)
 {
+    unsigned    i;
+
     context = context_;
     
     prepareTimeout.SetCallable(MFUNC(PaxosProposer, OnPrepareTimeout));
@@ -20,6 +26,12 @@ void PaxosProposer::Init(QuorumContext* context_)
 
     vote = NULL;
     state.Init();
+
+    pipelineStart = 0;
+    pipelineHead = 0;
+    numPipelined = 0;
+    for (i = 0; i < PAXOS_MAX_PIPELINE_WINDOW; i++)
+        pipeline[i].vote = NULL;
 }
 
 void PaxosProposer::RemoveTimers()
@@ -50,6 +62,11 @@ void PaxosProposer::OnPrepareResponse(PaxosMessage& imsg)
         vote->RegisterRejected(imsg.nodeID);
     else
         vote->RegisterAccepted(imsg.nodeID);
+
+    // the acceptor holds values pipelined by a previous leader up to this round, these
+    // may be chosen with ballot 0, so they are learned through the prepare phase
+    if (imsg.pipelinedPaxosID > 0 && imsg.pipelinedPaxosID >= pipelineStart)
+        pipelineStart = imsg.pipelinedPaxosID + 1;
     
     if (imsg.type == PAXOS_PREPARE_REJECTED)
     {
@@ -67,6 +84,8 @@ void PaxosProposer::OnPrepareResponse(PaxosMessage& imsg)
          * so it's ok
          */
         state.highestReceivedProposalID = imsg.acceptedProposalID;
+        if (state.proposedRunID != imsg.runID || !BUFCMP(&state.proposedValue, &imsg.value))
+            state.adopted = true;
         state.proposedRunID = imsg.runID;
         ASSERT(imsg.value.GetLength() > 0);
         state.proposedValue.Write(imsg.value);
@@ -83,8 +102,6 @@ void PaxosProposer::OnPrepareResponse(PaxosMessage& imsg)
 
 void PaxosProposer::OnProposeResponse(PaxosMessage& imsg)
 {
-    PaxosMessage omsg;
-    
     Log_Trace("msg.nodeID = %u", imsg.nodeID);
     
     if (!state.proposing || imsg.proposalID != state.proposalID)
@@ -106,10 +123,7 @@ void PaxosProposer::OnProposeResponse(PaxosMessage& imsg)
     else if (vote->IsAccepted())
     {
         // a majority have accepted our proposal, we have consensus
-        StopProposing();
-        omsg.LearnProposal(context->GetPaxosID(), MY_NODEID, state.proposalID);
-        BroadcastMessage(omsg);
-        state.learnSent = true;
+        BroadcastLearn();
     }
 }
 
@@ -123,8 +137,11 @@ void PaxosProposer::Propose(Buffer& value)
     state.proposedRunID = REPLICATION_CONFIG->GetRunID();
     ASSERT(value.GetLength() > 0);
     state.proposedValue.Write(value);
+    state.adopted = false;
 
-    if (state.multi && state.numProposals == 0)
+    // below pipelineStart acceptors may hold pipelined values of the previous leader,
+    // which are only found by running the prepare phase
+    if (state.multi && state.numProposals == 0 && context->GetPaxosID() >= pipelineStart)
     {
         state.numProposals++;
         StartProposing();
@@ -181,7 +198,161 @@ bool PaxosProposer::IsLearnSent()
 
 uint64_t PaxosProposer::GetMemoryUsage()
 {
-    return sizeof(PaxosProposer) + state.proposedValue.GetSize();
+    unsigned    i;
+    uint64_t    size;
+
+    size = sizeof(PaxosProposer) + state.proposedValue.GetSize();
+    for (i = 0; i < PAXOS_MAX_PIPELINE_WINDOW; i++)
+        size += pipeline[i].value.GetSize();
+    
+    return size;
+}
+
+void PaxosProposer::SetPipelineStart(uint64_t paxosID)
+{
+    pipelineStart = paxosID;
+}
+
+uint64_t PaxosProposer::GetPipelineStart()
+{
+    return pipelineStart;
+}
+
+bool PaxosProposer::IsLeaderReadable()
+{
+    // below pipelineStart values pipelined by the previous leader, or by us before the
+    // pipeline was cleared, may still be chosen
+    return state.multi && context->GetPaxosID() >= pipelineStart;
+}
+
+unsigned PaxosProposer::GetNumPipelined()
+{
+    return numPipelined;
+}
+
+void PaxosProposer::ProposePipelined(uint64_t paxosID, Buffer& value)
+{
+    PaxosMessage        omsg;
+    PaxosProposerSlot*  slot;
+
+    Log_Trace();
+
+    ASSERT(state.multi);
+    ASSERT(paxosID >= pipelineStart);
+    ASSERT(numPipelined < PAXOS_MAX_PIPELINE_WINDOW);
+    ASSERT(paxosID == context->GetPaxosID() + 1 + numPipelined);
+    ASSERT(value.GetLength() > 0);
+
+    slot = &pipeline[(pipelineHead + numPipelined) % PAXOS_MAX_PIPELINE_WINDOW];
+    numPipelined++;
+
+    slot->paxosID = paxosID;
+    slot->runID = REPLICATION_CONFIG->GetRunID();
+    slot->value.Write(value);
+    delete slot->vote;
+    slot->vote = context->GetQuorum()->NewVote();
+
+    // pipelined values are only proposed in multi paxos mode, without the prepare phase
+    omsg.ProposeRequest(paxosID, MY_NODEID, 0, slot->runID, slot->value);
+    context->GetTransport()->BroadcastMessage(omsg);
+}
+
+void PaxosProposer::OnPipelinedProposeResponse(PaxosMessage& imsg)
+{
+    unsigned            i;
+    PaxosProposerSlot*  slot;
+
+    Log_Trace("msg.nodeID = %u", imsg.nodeID);
+
+    if (imsg.proposalID != 0)
+        return;
+
+    for (i = 0; i < numPipelined; i++)
+    {
+        slot = &pipeline[(pipelineHead + i) % PAXOS_MAX_PIPELINE_WINDOW];
+        if (slot->paxosID != imsg.paxosID)
+            continue;
+
+        if (imsg.type == PAXOS_PROPOSE_REJECTED)
+        {
+            Log_Debug("Pipelined propose rejected, quorumID: %U, paxosID: %U",
+             context->GetQuorumID(), imsg.paxosID);
+            slot->vote->RegisterRejected(imsg.nodeID);
+        }
+        else
+            slot->vote->RegisterAccepted(imsg.nodeID);
+        return;
+    }
+}
+
+void PaxosProposer::OnNewPaxosRound()
+{
+    PaxosProposerSlot*  slot;
+
+    state.OnNewPaxosRound();
+    
+    if (numPipelined == 0)
+        return;
+
+    slot = &pipeline[pipelineHead];
+    if (slot->paxosID != context->GetPaxosID())
+    {
+        ClearPipeline();
+        return;
+    }
+
+    // the next pipelined value becomes the current round, with the votes it already has
+    pipelineHead = (pipelineHead + 1) % PAXOS_MAX_PIPELINE_WINDOW;
+    numPipelined--;
+
+    state.numProposals++;
+    state.proposedRunID = slot->runID;
+    state.proposedValue.Write(slot->value);
+    slot->value.Clear();
+    delete vote;
+    vote = slot->vote;
+    slot->vote = NULL;
+
+    if (vote->IsAccepted())
+    {
+        BroadcastLearn();
+    }
+    else if (vote->IsRejected())
+    {
+        // run the prepare phase for the value, it may have been accepted by some nodes
+        StartPreparing();
+    }
+    else
+    {
+        state.proposing = true;
+        EventLoop::Reset(&proposeTimeout);
+    }
+}
+
+void PaxosProposer::ClearPipeline()
+{
+    PaxosProposerSlot*  slot;
+
+    if (numPipelined == 0)
+        return;
+
+    // acceptors may hold the dropped values with ballot 0, so ballot 0 must not be
+    // reused for these rounds, they are proposed again after a prepare phase
+    slot = &pipeline[(pipelineHead + numPipelined - 1) % PAXOS_MAX_PIPELINE_WINDOW];
+    if (slot->paxosID >= pipelineStart)
+        pipelineStart = slot->paxosID + 1;
+
+    while (numPipelined > 0)
+    {
+        slot = &pipeline[pipelineHead];
+        slot->value.Clear();
+        delete slot->vote;
+        slot->vote = NULL;
+        pipelineHead = (pipelineHead + 1) % PAXOS_MAX_PIPELINE_WINDOW;
+        numPipelined--;
+    }
+
+    context->OnPipelineCleared();
 }
 
 void PaxosProposer::OnPrepareTimeout()
@@ -316,3 +487,13 @@ void PaxosProposer::NewVote()
     delete vote;
     vote = context->GetQuorum()->NewVote();
 }
+
+void PaxosProposer::BroadcastLearn()
+{
+    PaxosMessage omsg;
+
+    StopProposing();
+    omsg.LearnProposal(context->GetPaxosID(), MY_NODEID, state.proposalID);
+    BroadcastMessage(omsg);
+    state.learnSent = true;
+}
@@ -13,6 +13,24 @@ class ReplicatedLog; // forward
 #define PAXOS_ROUND_TIMEOUT     (5*1000)
 #define PAXOS_RESTART_TIMEOUT   (100)
 
+/*
+===============================================================================================
+
+ PaxosProposerSlot
+
+ A value proposed for a later paxosID while the current round is still running.
+
+===============================================================================================
+*/
+
+struct PaxosProposerSlot
+{
+    uint64_t        paxosID;
+    uint64_t        runID;
+    Buffer          value;
+    QuorumVote*     vote;
+};
+
 /*
 ===============================================================================================
 
@@ -40,6 +58,16 @@ public:
     bool            IsLearnSent();
     uint64_t        GetMemoryUsage();
 
+    // pipelined multi paxos:
+    void            SetPipelineStart(uint64_t paxosID);
+    uint64_t        GetPipelineStart();
+    bool            IsLeaderReadable();
+    unsigned        GetNumPipelined();
+    void            ProposePipelined(uint64_t paxosID, Buffer& value);
+    void            OnPipelinedProposeResponse(PaxosMessage& msg);
+    void            OnNewPaxosRound();
+    void            ClearPipeline();
+
     State           state;
 
 private:
@@ -52,6 +80,7 @@ private:
     void            StartPreparing();
     void            StartProposing();
     void            NewVote();
+    void            BroadcastLearn();
 
     bool            useTimeouts;
     QuorumContext*  context;
@@ -59,6 +88,11 @@ private:
     Countdown       prepareTimeout;
     Countdown       proposeTimeout;
     Countdown       restartTimeout;
+
+    uint64_t        pipelineStart;
+    unsigned        pipelineHead;
+    unsigned        numPipelined;
+    PaxosProposerSlot pipeline[PAXOS_MAX_PIPELINE_WINDOW];
 };
 
 #endif
@@ -27,6 +27,7 @@ struct PaxosProposerState
 
     uint64_t        proposedRunID;
     Buffer          proposedValue;
+    bool            adopted;      // proposedValue was replaced by a previously accepted value
 
     bool            multi;        // multi paxos
     unsigned        numProposals; // number of proposal runs in this Paxos round
@@ -52,6 +53,7 @@ inline void PaxosProposerState::OnNewPaxosRound()
     highestPromisedProposalID = 0;
     proposedRunID = 0;
     proposedValue.Clear();
+    adopted = false;
     numProposals = 0;
 }
 
@@ -49,6 +49,10 @@ public:
 
     virtual void                OnStartProposing()                                              = 0;
     virtual void                OnAppend(uint64_t paxosID, Buffer& value, bool ownAppend)       = 0;
+    // the value returned by GetNextValue() was proposed for paxosID
+    virtual void                OnNextValueProposed(uint64_t paxosID)                           = 0;
+    // pipelined values that were not chosen were dropped, they have to be proposed again
+    virtual void                OnPipelineCleared()                                             = 0;
     virtual void                OnMessage(ReadBuffer msg)                                       = 0;
     virtual void                OnMessageProcessed()                                            = 0;
     virtual void                OnStartCatchup()                                                = 0;
@@ -127,6 +127,24 @@ void QuorumDatabase::SetAcceptedValue(uint64_t paxosID, ReadBuffer value)
     logShard->Set(rbKey, value);
 }
 
+void QuorumDatabase::GetPipeline(Buffer& value)
+{
+    ReadBuffer  key("pipeline");
+    ReadBuffer  rbValue;
+
+    if (!paxosShard->Get(key, rbValue))
+        return;
+
+    value.Write(rbValue);
+}
+
+void QuorumDatabase::SetPipeline(ReadBuffer value)
+{
+    ReadBuffer  key("pipeline");
+
+    paxosShard->Set(key, value);
+}
+
 bool QuorumDatabase::IsCommitting()
 {
     return paxosShard->GetEnvironment()->IsCommitting(context->GetQuorumID());
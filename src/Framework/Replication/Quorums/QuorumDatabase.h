@@ -46,6 +46,9 @@ public:
     void                GetAcceptedValue(uint64_t paxosID, Buffer& value);
     void                SetAcceptedValue(uint64_t paxosID, ReadBuffer value);
 
+    void                GetPipeline(Buffer& value);
+    void                SetPipeline(ReadBuffer value);
+
     bool                IsCommitting();
     
     void                Commit();
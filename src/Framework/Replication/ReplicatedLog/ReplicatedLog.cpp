@@ -21,6 +21,7 @@ void ReplicatedLog::Init(QuorumContext* context_)
     paxosID = 0;
     waitingOnAppend = false;
     appendDummyNext = false;
+    pipelineWindow = 1;
     
     proposer.Init(context);
     acceptor.Init(context);
@@ -50,8 +51,19 @@ uint64_t ReplicatedLog::GetReplicationThroughput()
     return replicationThroughput;
 }
 
+void ReplicatedLog::SetPipelineWindow(unsigned pipelineWindow_)
+{
+    pipelineWindow = MAX(1, MIN(pipelineWindow_, PAXOS_MAX_PIPELINE_WINDOW));
+}
+
+unsigned ReplicatedLog::GetPipelineWindow()
+{
+    return pipelineWindow;
+}
+
 void ReplicatedLog::Stop()
 {
+    proposer.ClearPipeline();
     proposer.Stop();
 }
 
@@ -66,6 +78,11 @@ bool ReplicatedLog::IsMultiPaxosEnabled()
     return proposer.state.multi;
 }
 
+bool ReplicatedLog::IsLeaderReadable()
+{
+    return proposer.IsLeaderReadable();
+}
+
 bool ReplicatedLog::IsAppending()
 {
     return context->IsLeaseOwner() && proposer.state.numProposals > 0;
@@ -108,9 +125,15 @@ void ReplicatedLog::TryAppendNextValue()
     if (waitingOnAppend)
         return;
 
-    if (!context->IsLeaseOwner() || proposer.IsActive() || proposer.IsLearnSent() || !proposer.state.multi)
+    if (!context->IsLeaseOwner() || !proposer.state.multi)
         return;
 
+    if (proposer.IsActive() || proposer.IsLearnSent())
+    {
+        TryAppendPipelined();
+        return;
+    }
+
     if (appendDummyNext)
     {
         appendDummyNext = false;
@@ -120,10 +143,20 @@ void ReplicatedLog::TryAppendNextValue()
     
     Buffer& value = context->GetNextValue();
     if (value.GetLength() == 0)
+    {
+        // without client writes the rounds below pipelineStart are learned with dummies
+        if (!IsLeaderReadable())
+            TryAppendDummy();
         return;
+    }
     
     proposer.SetUseTimeouts(context->UseProposeTimeouts());
     Append(value);
+    context->OnNextValueProposed(paxosID);
+
+    // in pipelined mode the context may prepare the next value while this one is proposed
+    if (pipelineWindow > 1)
+        value.Clear();
 }
 
 void ReplicatedLog::TryCatchup()
@@ -143,6 +176,7 @@ void ReplicatedLog::Restart()
     context->OnStartProposing();
 
     proposer.state.multi = false;
+    proposer.ClearPipeline();
     if (proposer.IsActive())
         proposer.Restart();
 }
@@ -161,8 +195,8 @@ void ReplicatedLog::NewPaxosRound()
 {
     paxosID++;
     proposer.RemoveTimers();
-    proposer.state.OnNewPaxosRound();
-    acceptor.state.OnNewPaxosRound();
+    acceptor.OnNewPaxosRound();
+    proposer.OnNewPaxosRound();
     lastRequestChosenTime = 0;
 }
 
@@ -177,6 +211,19 @@ void ReplicatedLog::RegisterPaxosID(uint64_t paxosID, uint64_t nodeID)
     }
 }
 
+bool ReplicatedLog::IsPipelined(PaxosMessage& msg)
+{
+    // the leader's window may differ from ours, so the maximum window is used
+    if (msg.type != PAXOS_PROPOSE_REQUEST && !msg.IsProposeResponse())
+        return false;
+    
+    // pipelined values are only proposed with ballot 0
+    if (msg.proposalID != 0)
+        return false;
+    
+    return (msg.paxosID > paxosID && msg.paxosID < paxosID + PAXOS_MAX_PIPELINE_WINDOW);
+}
+
 void ReplicatedLog::OnMessage(PaxosMessage& imsg)
 {
     Log_Trace();
@@ -232,6 +279,7 @@ void ReplicatedLog::OnLearnLease()
 
 void ReplicatedLog::OnLeaseTimeout()
 {
+    proposer.ClearPipeline();
     proposer.Stop();
 }
 
@@ -285,6 +333,38 @@ void ReplicatedLog::Append(Buffer& value)
 #endif
 }
 
+void ReplicatedLog::TryAppendPipelined()
+{
+    uint64_t    nextPaxosID;
+
+    if (pipelineWindow <= 1 || appendDummyNext)
+        return;
+
+    // the current round and the pipelined rounds together are limited by the window
+    if (proposer.GetNumPipelined() + 1 >= pipelineWindow)
+        return;
+
+    nextPaxosID = paxosID + 1 + proposer.GetNumPipelined();
+    if (nextPaxosID < proposer.GetPipelineStart())
+        return;
+
+    // acceptors only take pipelined values following a ballot 0 value of ours
+    if (proposer.state.preparing || proposer.state.proposalID != 0)
+        return;
+
+    Buffer& value = context->GetNextValue();
+    if (value.GetLength() == 0)
+        return;
+
+    proposer.ProposePipelined(nextPaxosID, value);
+    context->OnNextValueProposed(nextPaxosID);
+    value.Clear();
+
+#ifdef RLOG_DEBUG_MESSAGES
+    Log_Debug("Proposing pipelined for paxosID = %U", nextPaxosID);
+#endif
+}
+
 bool ReplicatedLog::OnPrepareRequest(PaxosMessage& imsg)
 {
 #ifdef RLOG_DEBUG_MESSAGES
@@ -320,6 +400,9 @@ bool ReplicatedLog::OnProposeRequest(PaxosMessage& imsg)
 
     Log_Trace();
     
+    if (IsPipelined(imsg))
+        return acceptor.OnPipelinedProposeRequest(imsg);
+
     bool processed = acceptor.OnProposeRequest(imsg);
     
     OnRequest(imsg);
@@ -337,6 +420,8 @@ bool ReplicatedLog::OnProposeResponse(PaxosMessage& imsg)
 
     if (imsg.paxosID == paxosID)
         proposer.OnProposeResponse(imsg);
+    else if (imsg.paxosID > paxosID)
+        proposer.OnPipelinedProposeResponse(imsg);
 
     return true;
 }
@@ -530,6 +615,7 @@ void ReplicatedLog::ProcessLearnChosen(uint64_t nodeID, uint64_t runID)
     if (nodeID == MY_NODEID && runID == REPLICATION_CONFIG->GetRunID() && context->IsLeaseOwner())
     {
         proposer.state.multi = true;
+        // rounds the previous leader pipelined were reported in the prepare responses
         if (!ownAppend)
             context->OnIsLeader();
         Log_Trace("Multi paxos enabled");
@@ -541,6 +627,10 @@ void ReplicatedLog::ProcessLearnChosen(uint64_t nodeID, uint64_t runID)
     }
 
     ownAppend &= proposer.state.multi;
+    // the prepare phase may have replaced our value with a previously accepted one
+    ownAppend &= !proposer.state.adopted;
+    if (!ownAppend)
+        proposer.ClearPipeline();
 
     if (BUFCMP(&learnedValue, &dummy))
         OnAppendComplete();
@@ -28,11 +28,15 @@ public:
     uint64_t                GetLastLearnChosenTime();
     uint64_t                GetReplicationThroughput();
     void                    SetAlwaysUseDatabaseCatchup(bool alwaysUseDatabaseCatchup);
+    void                    SetPipelineWindow(unsigned pipelineWindow);
+    unsigned                GetPipelineWindow();
 
     void                    Stop();
     void                    Continue();
 
     bool                    IsMultiPaxosEnabled();
+    // the leader may serve reads once it learned the rounds the previous leader pipelined
+    bool                    IsLeaderReadable();
     bool                    IsAppending();
     bool                    IsWaitingOnAppend();
 
@@ -46,6 +50,7 @@ public:
     void                    NewPaxosRound();
     
     void                    RegisterPaxosID(uint64_t paxosID, uint64_t nodeID);
+    bool                    IsPipelined(PaxosMessage& msg);
     
     void                    OnMessage(PaxosMessage& msg);
     void                    OnCatchupStarted();
@@ -60,6 +65,7 @@ public:
 
 private:
     void                    Append(Buffer& value);
+    void                    TryAppendPipelined();
 
     bool                    OnPrepareRequest(PaxosMessage& msg);
     bool                    OnPrepareResponse(PaxosMessage& msg);
@@ -83,6 +89,7 @@ private:
     
     bool                    waitingOnAppend;
     bool                    appendDummyNext;
+    unsigned                pipelineWindow;
     uint64_t                lastRequestChosenTime;
     uint64_t                lastLearnChosenTime;
     uint64_t                replicationThroughput;
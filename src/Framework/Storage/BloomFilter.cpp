@@ -1,6 +1,8 @@
 #include "BloomFilter.h"
 #include "System/Log.h"
 
+#define BLOOMFILTER_BLOCK_BITS      (BLOOMFILTER_BLOCK_SIZE * 8)
+
 static int32_t table32[256];
 static int32_t table40[256];
 static int32_t table48[256];
@@ -51,6 +53,66 @@ static int32_t HashRabin(int32_t r)
     return w;
 }
 
+// MurmurHash64A
+static uint64_t Hash64(const char* p, unsigned length)
+{
+    const uint64_t  m = 0xC6A4A7935BD1E995ULL;
+    const int       r = 47;
+    uint64_t        h;
+    uint64_t        k;
+    const char*     end;
+
+    h = 0x5CA11E7DB0000000ULL ^ (length * m);
+
+    end = p + (length & ~7U);
+    for (; p != end; p += 8)
+    {
+        memcpy(&k, p, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    switch (length & 7)
+    {
+    case 7: h ^= (uint64_t) (unsigned char) p[6] << 48;
+            // fallthrough
+    case 6: h ^= (uint64_t) (unsigned char) p[5] << 40;
+            // fallthrough
+    case 5: h ^= (uint64_t) (unsigned char) p[4] << 32;
+            // fallthrough
+    case 4: h ^= (uint64_t) (unsigned char) p[3] << 24;
+            // fallthrough
+    case 3: h ^= (uint64_t) (unsigned char) p[2] << 16;
+            // fallthrough
+    case 2: h ^= (uint64_t) (unsigned char) p[1] << 8;
+            // fallthrough
+    case 1: h ^= (uint64_t) (unsigned char) p[0];
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return h;
+}
+
+BloomFilter::BloomFilter()
+{
+    version = BLOOMFILTER_VERSION;
+    size = 0;
+    data = NULL;
+    memory = NULL;
+}
+
+BloomFilter::~BloomFilter()
+{
+    Reset();
+}
+
 void BloomFilter::StaticInit()
 {
     unsigned i, j, c;
@@ -80,13 +142,30 @@ void BloomFilter::StaticInit()
     }
 }
 
-void BloomFilter::SetSize(uint32_t size)
+void BloomFilter::SetVersion(unsigned version_)
+{
+    version = version_;
+}
+
+unsigned BloomFilter::GetVersion()
+{
+    return version;
+}
+
+void BloomFilter::SetSize(uint32_t size_)
 {
 //    Log_Debug("bloom filter size: %u", size);
     
-    buffer.Allocate(size);
-    buffer.SetLength(size);
-    buffer.Zero();
+    ASSERT(size_ >= BLOOMFILTER_BLOCK_SIZE);
+
+    Reset();
+    memory = (char*) malloc(size_ + BLOOMFILTER_BLOCK_SIZE - 1);
+    if (memory == NULL)
+        STOP_FAIL(1, "Out of memory error");
+    data = (char*) (((uintptr_t) memory + BLOOMFILTER_BLOCK_SIZE - 1) &
+     ~((uintptr_t) BLOOMFILTER_BLOCK_SIZE - 1));
+    size = size_;
+    memset(data, 0, size);
 }
 
 void BloomFilter::Add(ReadBuffer& key)
@@ -94,6 +173,25 @@ void BloomFilter::Add(ReadBuffer& key)
     unsigned    i, k, j, bitindex;
     char*       p;
     unsigned    hashes[BLOOMFILTER_NUM_FUNCTIONS];
+    uint64_t    hash;
+    uint64_t*   block;
+    uint32_t    h, delta;
+
+    if (version >= BLOOMFILTER_VERSION)
+    {
+        // the block is chosen by the upper half of the hash, the bits in it by the lower
+        hash = Hash64(key.GetBuffer(), key.GetLength());
+        block = GetBlock(hash);
+        h = (uint32_t) hash;
+        delta = (h >> 17) | (h << 15);
+        for (i = 0; i < BLOOMFILTER_NUM_FUNCTIONS; i++)
+        {
+            bitindex = h % BLOOMFILTER_BLOCK_BITS;
+            block[bitindex / 64] |= (uint64_t) 1 << (bitindex % 64);
+            h += delta;
+        }
+        return;
+    }
 
     GetHashes(hashes, key);
 
@@ -102,14 +200,20 @@ void BloomFilter::Add(ReadBuffer& key)
         bitindex = hashes[i];
         k = bitindex / 8;
         j = bitindex % 8;
-        p = buffer.GetBuffer() + k;
+        p = data + k;
         *p |= (1 << j);
     }
 }
 
-void BloomFilter::SetBuffer(ReadBuffer& buffer_)
+ReadBuffer BloomFilter::GetData()
 {
-    buffer.Write(buffer_);
+    return ReadBuffer(data, size);
+}
+
+void BloomFilter::SetData(ReadBuffer& data_)
+{
+    SetSize(data_.GetLength());
+    memcpy(data, data_.GetBuffer(), size);
 }
 
 bool BloomFilter::Check(ReadBuffer& key)
@@ -118,6 +222,27 @@ bool BloomFilter::Check(ReadBuffer& key)
     unsigned    i, k, j, bitindex;
     char        c;
     unsigned    hashes[BLOOMFILTER_NUM_FUNCTIONS];
+    uint64_t    hash;
+    uint64_t*   block;
+    uint64_t    found;
+    uint32_t    h, delta;
+
+    if (version >= BLOOMFILTER_VERSION)
+    {
+        // all probes are in the same cache line, they are combined without branches
+        hash = Hash64(key.GetBuffer(), key.GetLength());
+        block = GetBlock(hash);
+        h = (uint32_t) hash;
+        delta = (h >> 17) | (h << 15);
+        found = 1;
+        for (i = 0; i < BLOOMFILTER_NUM_FUNCTIONS; i++)
+        {
+            bitindex = h % BLOOMFILTER_BLOCK_BITS;
+            found &= block[bitindex / 64] >> (bitindex % 64);
+            h += delta;
+        }
+        return (found != 0);
+    }
 
     res = true;
     
@@ -128,7 +253,7 @@ bool BloomFilter::Check(ReadBuffer& key)
         bitindex = hashes[i];
         k = bitindex / 8;
         j = bitindex % 8;
-        c = *(buffer.GetBuffer() + k);
+        c = *(data + k);
         res &= (((c >> j) & 1));
         if (!res)
             break;
@@ -137,14 +262,23 @@ bool BloomFilter::Check(ReadBuffer& key)
     return res;
 }
 
-Buffer& BloomFilter::GetBuffer()
+void BloomFilter::Reset()
 {
-    return buffer;
+    free(memory);
+    memory = NULL;
+    data = NULL;
+    size = 0;
 }
 
-void BloomFilter::Reset()
+uint64_t* BloomFilter::GetBlock(uint64_t hash)
 {
-    buffer.Reset();
+    uint64_t    numBlocks;
+    uint64_t    index;
+
+    // maps the upper 32 bits to [0, numBlocks) without a division
+    numBlocks = size / BLOOMFILTER_BLOCK_SIZE;
+    index = ((hash >> 32) * numBlocks) >> 32;
+    return (uint64_t*) (data + index * BLOOMFILTER_BLOCK_SIZE);
 }
 
 void BloomFilter::GetHashes(unsigned hashes[], ReadBuffer& key)
@@ -156,7 +290,7 @@ void BloomFilter::GetHashes(unsigned hashes[], ReadBuffer& key)
 
     for (i = 0; i < BLOOMFILTER_NUM_FUNCTIONS; i++)
     {
-        hashes[i] = hash % (buffer.GetLength() * 8);
+        hashes[i] = hash % (size * 8);
         hash = HashRabin(hash);
     }
 }
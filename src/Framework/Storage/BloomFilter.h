@@ -8,25 +8,39 @@
 #define BLOOMFILTER_P_DEGREE        32
 #define BLOOMFILTER_X_P_DEGREE      (1 << 31)
 
+// version 1 probes bits anywhere in the filter with repeated Rabin hashes,
+// version 2 probes bits in one 64 byte block with a 64 bit hash and double hashing
+#define BLOOMFILTER_VERSION_1       1
+#define BLOOMFILTER_VERSION         2
+#define BLOOMFILTER_BLOCK_SIZE      64
+
 /*
 ===============================================================================================
 
  BloomFilter
 
+ The bits are kept aligned to BLOOMFILTER_BLOCK_SIZE, so the probes of a version 2 lookup
+ touch a single cache line.
+
 ===============================================================================================
 */
 
 class BloomFilter
 {
 public:
+    BloomFilter();
+    ~BloomFilter();
+
     static void     StaticInit();
     
+    void            SetVersion(unsigned version);
+    unsigned        GetVersion();
     void            SetSize(uint32_t size);
     
     void            Add(ReadBuffer& key);
 
-    Buffer&         GetBuffer();
-    void            SetBuffer(ReadBuffer& buffer);
+    ReadBuffer      GetData();
+    void            SetData(ReadBuffer& data);
 
     void            Reset();
 
@@ -37,8 +51,12 @@ public:
 private:
     int32_t         GetHash(unsigned fnum, int32_t original);
     void            GetHashes(unsigned hashes[], ReadBuffer& key);
+    uint64_t*       GetBlock(uint64_t hash);
 
-    Buffer          buffer;
+    unsigned        version;
+    uint32_t        size;
+    char*           data;       // aligned inside memory
+    char*           memory;
 };
 
 #endif
@@ -7,7 +7,9 @@
 
 StorageAsyncGet::StorageAsyncGet()
 {
+    prev = next = this;
     lastLoadedPage = NULL;
+    loadedDataPage = NULL;
     ret = false;
     completed = false;
     skipMemoChunk = false;
@@ -132,6 +134,7 @@ void StorageAsyncGet::SetLastLoadedPage(StorageFileChunk* fileChunk)
         else if (fileChunk->dataPages[index] == NULL)
         {
             fileChunk->SetDataPage((StorageDataPage*) lastLoadedPage);
+            loadedDataPage = lastLoadedPage;
             lastLoadedPage = NULL;
         }
     }
@@ -163,10 +166,40 @@ void StorageAsyncGet::OnComplete()
     Call(onComplete);
 }
 
+// This function is executed in the main thread
+void StorageAsyncGet::LoadPage()
+{
+    StorageAsyncGet*    it;
+
+    // coalesce with the load of the same page if it is already in progress
+    FOREACH (it, env->asyncGetLoads)
+    {
+        if (it->IsLoading(chunkID, stage, index))
+        {
+            it->waiters.Append(this);
+            return;
+        }
+    }
+
+    env->asyncGetLoads.Append(this);
+    threadPool->Execute(MFUNC(StorageAsyncGet, AsyncLoadPage));
+}
+
+bool StorageAsyncGet::IsLoading(uint64_t chunkID_, Stage stage_, uint32_t index_)
+{
+    if (chunkID != chunkID_ || stage != stage_)
+        return false;
+    
+    if (stage == DATA_PAGE && index != index_)
+        return false;
+    
+    return true;
+}
+
 // This function is executed in the threadPool
 void StorageAsyncGet::AsyncLoadPage()
 {
-    Callable            asyncGet;
+    Callable            onPageLoaded;
 
     if (stage == BLOOM_PAGE)
         lastLoadedPage = loaderFileChunk.AsyncLoadBloomPage();
@@ -175,6 +208,24 @@ void StorageAsyncGet::AsyncLoadPage()
     else if (stage == DATA_PAGE)
         lastLoadedPage = loaderFileChunk.AsyncLoadDataPage(index, offset);
     
-    asyncGet = MFUNC(StorageAsyncGet, ExecuteAsyncGet);
-    IOProcessor::Complete(&asyncGet);
+    onPageLoaded = MFUNC(StorageAsyncGet, OnPageLoaded);
+    IOProcessor::Complete(&onPageLoaded);
+}
+
+// This function is executed in the main thread
+void StorageAsyncGet::OnPageLoaded()
+{
+    StorageAsyncGet*    waiter;
+    AsyncGetList        resumed;
+
+    env->asyncGetLoads.Remove(this);
+
+    // ExecuteAsyncGet may complete and delete this object
+    resumed.PrependList(waiters);
+
+    // this sets the loaded page in the chunk, so that the waiters find it in memory
+    ExecuteAsyncGet();
+
+    while ((waiter = resumed.Pop()) != NULL)
+        waiter->ExecuteAsyncGet();
 }
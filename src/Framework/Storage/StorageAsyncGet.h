@@ -3,6 +3,7 @@
 
 #include "System/Buffers/ReadBuffer.h"
 #include "System/Events/Callable.h"
+#include "System/Containers/InList.h"
 #include "StorageFileChunk.h"
 
 class StorageEnvironment;
@@ -21,6 +22,8 @@ class ThreadPool;
 
 class StorageAsyncGet
 {
+    typedef InList<StorageAsyncGet> AsyncGetList;
+
 public:
     enum Stage
     {
@@ -39,12 +42,17 @@ public:
     uint32_t            index;
     uint64_t            offset;
     StoragePage*        lastLoadedPage;
+    StoragePage*        loadedDataPage; // not a cache hit on the first access
     ThreadPool*         threadPool;
     uint16_t            contextID;
     uint64_t            shardID;
     uint64_t            chunkID;
     StorageEnvironment* env;
     StorageFileChunk    loaderFileChunk;
+    AsyncGetList        waiters;    // gets waiting for the page this one is loading
+
+    StorageAsyncGet*    prev;
+    StorageAsyncGet*    next;
     
     StorageAsyncGet();
 
@@ -53,7 +61,10 @@ public:
     void                SetLastLoadedPage(StorageFileChunk* fileChunk);
     void                SetupLoaderFileChunk(StorageFileChunk* fileChunk);
     void                OnComplete();
+    void                LoadPage();
+    bool                IsLoading(uint64_t chunkID, Stage stage, uint32_t index);
     void                AsyncLoadPage();
+    void                OnPageLoaded();
 };
 
 #endif
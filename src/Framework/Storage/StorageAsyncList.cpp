@@ -20,6 +20,9 @@ StorageAsyncListResult::StorageAsyncListResult(StorageAsyncList* asyncList_) :
 // this is called from main thread
 void StorageAsyncListResult::OnComplete()
 {
+    // the memo listers are loaded by now
+    asyncList->ReleaseMemoChunks();
+
     asyncList->lastResult = this;
     Call(onComplete);
     asyncList->lastResult = NULL;
@@ -60,6 +63,7 @@ void StorageAsyncList::Init()
     threadPool = NULL;
     iterators = NULL;
     listers = NULL;
+    memoChunks = NULL;
     numListers = 0;
     lastResult = NULL;
     env = NULL;
@@ -70,10 +74,15 @@ void StorageAsyncList::Clear()
 {
     unsigned    i;
 
+    // the readers of the memo chunks were removed on completion
+    delete[] memoChunks;
+    memoChunks = NULL;
+
     for (i = 0; i < numListers; i++)
         delete listers[i];
     delete[] listers;
     listers = NULL;
+    mergeTree.Clear();
     delete[] iterators;
     iterators = NULL;
     numListers = 0;
@@ -91,9 +100,11 @@ void StorageAsyncList::ExecuteAsyncList()
     StorageUnwrittenChunkLister*    unwrittenLister;
     StorageChunk::ChunkState        chunkState;
     bool                            keysOnly;
+    bool                            concurrent;
     
     Log_Debug("List[%U] StorageAsyncList START", requestID);
     keysOnly = (type == KEY || type == COUNT);
+    concurrent = env->IsConcurrentMemoReadable(shard);
 
     if (!forwardDirection && prefix.GetLength() > 0 && !startKey.BeginsWith(prefix) && count > 0)
         count++;
@@ -104,18 +115,23 @@ void StorageAsyncList::ExecuteAsyncList()
 
         listers = new StorageChunkLister*[numChunks];
         iterators = new StorageFileKeyValue*[numChunks];
+        memoChunks = new StorageMemoChunk*[numChunks];
         numListers = 0;
         preloadBufferSize = 0;  // preload only one page
 
         FOREACH (itChunk, shard->GetChunks())
         {
             chunkState = (*itChunk)->GetChunkState();
+            memoChunks[numListers] = NULL;
             
             if (chunkState == StorageChunk::Serialized)
             {
                 memoLister = new StorageMemoChunkLister;
-                memoLister->Init((StorageMemoChunk*) *itChunk, startKey, endKey, prefix, count, 
-                 keysOnly, forwardDirection);
+                if (concurrent)
+                    AddMemoChunk((StorageMemoChunk*) *itChunk);
+                else
+                    memoLister->Init((StorageMemoChunk*) *itChunk, startKey, endKey, prefix, count, 
+                     keysOnly, forwardDirection);
                 listers[numListers] = memoLister;
                 numListers++;
             }
@@ -143,7 +159,16 @@ void StorageAsyncList::ExecuteAsyncList()
 
     if (stage == MEMO_CHUNK)
     {
-        LoadMemoChunk(keysOnly);
+        memoChunks[numListers] = NULL;
+        if (concurrent)
+        {
+            // the memo listers are loaded on the list thread
+            AddMemoChunk(shard->GetMemoChunk());
+            listers[numListers] = new StorageMemoChunkLister;
+            numListers++;
+        }
+        else
+            LoadMemoChunk(keysOnly);
         stage = FILE_CHUNK;
     }
     
@@ -168,9 +193,96 @@ void StorageAsyncList::LoadMemoChunk(bool keysOnly)
     numListers++;
 }
 
+void StorageAsyncList::AddMemoChunk(StorageMemoChunk* memoChunk)
+{
+    memoChunk->AddReader();
+    memoChunks[numListers] = memoChunk;
+}
+
+void StorageAsyncList::ReleaseMemoChunks()
+{
+    unsigned    i;
+
+    if (memoChunks == NULL)
+        return;
+
+    for (i = 0; i < numListers; i++)
+    {
+        if (memoChunks[i] != NULL)
+        {
+            env->ReleaseMemoChunk(memoChunks[i]);
+            memoChunks[i] = NULL;
+        }
+    }
+}
+
+bool StorageAsyncList::AsyncLoadMemoChunks()
+{
+    unsigned                i;
+    unsigned                retry;
+    bool                    keysOnly;
+    StorageMemoChunk*       memoChunk;
+    StorageMemoChunkLister* memoLister;
+
+    keysOnly = (type == KEY || type == COUNT);
+
+    // the last one is the memo chunk of the shard, which the main thread may write, it
+    // is loaded first so that nothing has to be undone if the writes interfere
+    for (i = numListers; i > 0; i--)
+    {
+        memoChunk = memoChunks[i - 1];
+        if (memoChunk == NULL)
+            continue;
+
+        memoLister = (StorageMemoChunkLister*) listers[i - 1];
+        if (i < numListers)
+        {
+            // serialized chunks are not written any more
+            memoLister->Init(memoChunk, startKey, endKey, prefix, count, keysOnly, forwardDirection);
+            continue;
+        }
+
+        for (retry = 0; retry < STORAGE_MEMO_READ_RETRIES; retry++)
+        {
+            if (memoLister->ConcurrentInit(memoChunk, startKey, endKey, prefix, count, keysOnly, 
+             forwardDirection))
+                break;
+        }
+        if (retry == STORAGE_MEMO_READ_RETRIES)
+            return false;
+    }
+
+    return true;
+}
+
+void StorageAsyncList::OnMemoChunkConflict()
+{
+    bool                    keysOnly;
+    StorageMemoChunkLister* memoLister;
+    
+    keysOnly = (type == KEY || type == COUNT);
+
+    // the memo chunk was written during every attempt, load it on the main thread
+    memoLister = (StorageMemoChunkLister*) listers[numListers - 1];
+    memoLister->Init(memoChunks[numListers - 1], startKey, endKey, prefix, count, keysOnly, 
+     forwardDirection);
+    env->ReleaseMemoChunk(memoChunks[numListers - 1]);
+    memoChunks[numListers - 1] = NULL;
+
+    threadPool->Execute(MFUNC(StorageAsyncList, AsyncLoadChunks));
+}
+
 void StorageAsyncList::AsyncLoadChunks()
 {
     unsigned    i;
+    Callable    callable;
+
+    if (!AsyncLoadMemoChunks())
+    {
+        callable = MFUNC(StorageAsyncList, OnMemoChunkConflict);
+        IOProcessor::Complete(&callable);
+        return;
+    }
 
     for (i = 0; i < numListers; i++)
     {
@@ -180,6 +292,7 @@ void StorageAsyncList::AsyncLoadChunks()
         if (iterators[i] != NULL && !IsKeyInShard(iterators[i]->GetKeyReference()))
             iterators[i] = NULL;
     }
+    mergeTree.Init(iterators, numListers, forwardDirection);
     
     stage = MERGE;
     AsyncMergeResult();
@@ -321,67 +434,30 @@ bool StorageAsyncList::IsKeyInShard(const ReadBuffer& key)
     return true;
 }
 
-int StorageAsyncList::CompareSmallestKey(const ReadBuffer& key, const ReadBuffer& smallestKey)
-{
-    int     cmpres;
-
-    if (forwardDirection)
-    {
-        if (smallestKey.GetLength() == 0)
-            cmpres = -1;
-        else
-            cmpres = ReadBuffer::CmpWithOffset(key, smallestKey, prefix.GetLength());
-    }
-    else
-    {
-        if (key.GetLength() == 0)
-            cmpres = -1;
-        else
-        {
-            if (smallestKey.GetLength() == 0)
-                cmpres = 0;
-            else
-                cmpres = ReadBuffer::CmpWithOffset(smallestKey, key, prefix.GetLength());
-        }
-    }
-    
-    return cmpres;
-}
-
 StorageFileKeyValue* StorageAsyncList::GetSmallest()
 {
     unsigned                i;
     unsigned                smallestIndex;
-    ReadBuffer              smallestKey;
     StorageFileKeyValue*    smallestKv;
-    int                     cmpres;
-    ReadBuffer              tmp;
 
-    smallestIndex = 0;  // making the compiler happy by initializing
-    smallestKv = NULL;
-    // readers are sorted by relevance, first is the oldest, last is the latest
-        
-    for (i = 0; i < numListers; i++)
-    {
-        if (iterators[i] == NULL)
-            continue;
+    if (mergeTree.IsEmpty())
+        return NULL;
 
-        cmpres = CompareSmallestKey(iterators[i]->GetKeyReference(), smallestKey);
-        if (cmpres <= 0)
-        {
-            // advance the previously smallest if it is equal to the current
-            // because it is less relevant
-            if (smallestKv != NULL && cmpres == 0)
-                ADVANCE_ITERATOR(smallestIndex);
-            smallestKv = iterators[i];
-            smallestIndex = i;
-            smallestKey = smallestKv->GetKeyReference();
-        }
-    }
+    // listers are sorted by relevance, on equal keys the latest one wins
+    smallestIndex = mergeTree.Top();
+    smallestKv = iterators[smallestIndex];
+
+    // make progress in the lister that contained the smallest key
+    ADVANCE_ITERATOR(smallestIndex);
+    mergeTree.UpdateTop();
 
-    // make progress in the reader that contained the smallest key
-    if (smallestKv != NULL)
-        ADVANCE_ITERATOR(smallestIndex);
+    // skip the same key in older listers, because they are less relevant
+    while (!mergeTree.IsEmpty() && mergeTree.CompareTop(smallestKv->GetKeyReference()) == 0)
+    {
+        i = mergeTree.Top();
+        ADVANCE_ITERATOR(i);
+        mergeTree.UpdateTop();
+    }
 
     return smallestKv;
 }
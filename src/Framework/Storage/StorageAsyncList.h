@@ -6,9 +6,11 @@
 #include "System/Containers/List.h"
 #include "StorageChunkLister.h"
 #include "StorageDataPage.h"
+#include "StorageMergeTree.h"
 
 class StorageShard;
 class StorageChunk;
+class StorageMemoChunk;
 class StorageChunkReader;
 class StorageFileKeyValue;
 class StoragePage;
@@ -86,7 +88,9 @@ public:
     ThreadPool*             threadPool;
     StorageFileKeyValue**   iterators;
     StorageChunkLister**    listers;
+    StorageMemoChunk**      memoChunks;     // read by the memo listers on the list thread
     unsigned                numListers;
+    StorageMergeTree        mergeTree;
     StorageAsyncListResult* lastResult;
     StorageEnvironment*     env;
     uint64_t                requestID;
@@ -97,6 +101,10 @@ public:
     void                    Clear();
     void                    ExecuteAsyncList();
     void                    LoadMemoChunk(bool keysOnly);
+    void                    AddMemoChunk(StorageMemoChunk* memoChunk);
+    void                    ReleaseMemoChunks();
+    bool                    AsyncLoadMemoChunks();
+    void                    OnMemoChunkConflict();
     void                    AsyncLoadChunks();
     void                    AsyncMergeResult();
     void                    OnResult(StorageAsyncListResult* result);
@@ -104,7 +112,6 @@ public:
     bool                    IsAborted();
     void                    SetAborted(bool aborted);
     bool                    IsKeyInShard(const ReadBuffer& key);
-    int                     CompareSmallestKey(const ReadBuffer& key, const ReadBuffer& smallestKey);
     StorageFileKeyValue*    GetSmallest();
     StorageFileKeyValue*    Next();
 };
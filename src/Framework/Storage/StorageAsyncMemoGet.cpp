@@ -0,0 +1,41 @@
+#include "StorageAsyncMemoGet.h"
+#include "StorageEnvironment.h"
+#include "System/IO/IOProcessor.h"
+
+StorageAsyncMemoGet::StorageAsyncMemoGet()
+{
+    num = 0;
+    env = NULL;
+}
+
+bool StorageAsyncMemoGet::IsFull()
+{
+    return (num == STORAGE_ASYNC_MEMO_GET_SIZE);
+}
+
+// This function is executed in the async GET thread
+void StorageAsyncMemoGet::ExecuteAsyncMemoGet()
+{
+    unsigned    i;
+    Callable    callable;
+
+    for (i = 0; i < num; i++)
+    {
+        values[i].Clear();
+        results[i] = memoChunks[i]->ConcurrentGet(keys[i], values[i]);
+    }
+
+    callable = MFUNC(StorageAsyncMemoGet, OnComplete);
+    IOProcessor::Complete(&callable);
+}
+
+// This function is executed in the main thread
+void StorageAsyncMemoGet::OnComplete()
+{
+    unsigned    i;
+
+    for (i = 0; i < num; i++)
+        env->ReleaseMemoChunk(memoChunks[i]);
+
+    Call(onComplete);
+}
@@ -0,0 +1,45 @@
+#ifndef STORAGEASYNCMEMOGET_H
+#define STORAGEASYNCMEMOGET_H
+
+#include "System/Buffers/Buffer.h"
+#include "System/Events/Callable.h"
+#include "StorageMemoChunk.h"
+
+#define STORAGE_ASYNC_MEMO_GET_SIZE     64
+
+class StorageEnvironment;
+
+/*
+===============================================================================================
+
+ StorageAsyncMemoGet
+
+ A batch of GETs from the memo chunks of the shards, executed on the async GET thread
+ while the main thread keeps writing the chunks. The environment adds a reader to the
+ memo chunk of each key, the readers are removed on the main thread on completion.
+ The values are copied, because the memo chunks may change after the reads.
+
+===============================================================================================
+*/
+
+class StorageAsyncMemoGet
+{
+public:
+    typedef StorageMemoChunk::ReadResult ReadResult;
+
+    unsigned            num;
+    ReadBuffer          keys[STORAGE_ASYNC_MEMO_GET_SIZE];
+    Buffer              values[STORAGE_ASYNC_MEMO_GET_SIZE];
+    ReadResult          results[STORAGE_ASYNC_MEMO_GET_SIZE];
+    StorageMemoChunk*   memoChunks[STORAGE_ASYNC_MEMO_GET_SIZE];
+    Callable            onComplete;
+    StorageEnvironment* env;
+
+    StorageAsyncMemoGet();
+
+    bool                IsFull();
+    void                ExecuteAsyncMemoGet();
+    void                OnComplete();
+};
+
+#endif
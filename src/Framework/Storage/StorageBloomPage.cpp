@@ -25,6 +25,16 @@ uint32_t StorageBloomPage::GetMemorySize()
     return size;
 }
 
+void StorageBloomPage::SetVersion(unsigned version)
+{
+    bloomFilter.SetVersion(version);
+}
+
+unsigned StorageBloomPage::GetVersion()
+{
+    return bloomFilter.GetVersion();
+}
+
 void StorageBloomPage::SetNumKeys(uint64_t numKeys)
 {
     uint32_t    numBytes;
@@ -103,27 +113,29 @@ bool StorageBloomPage::Read(Buffer& buffer)
         goto Fail;
     parse.Advance(4);
 
-    bloomFilter.SetBuffer(parse);
+    bloomFilter.SetData(parse);
     this->size = size;
     return true;
 
 Fail:
-    bloomFilter.GetBuffer().Reset();
+    bloomFilter.Reset();
     return false;
 }
 
 void StorageBloomPage::Write(Buffer& buffer)
 {
     uint32_t    checksum;
+    ReadBuffer  data;
 
     buffer.Allocate(size);
     buffer.Zero();
 
-    checksum = bloomFilter.GetBuffer().GetChecksum();
+    data = bloomFilter.GetData();
+    checksum = data.GetChecksum();
 
     buffer.AppendLittle32(size);
     buffer.AppendLittle32(checksum);
-    buffer.Append(bloomFilter.GetBuffer());
+    buffer.Append(data);
 }
 
 bool StorageBloomPage::Check(ReadBuffer& key)
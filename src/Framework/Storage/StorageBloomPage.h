@@ -11,6 +11,9 @@ class StorageFileChunk;
 
  StorageBloomPage
 
+ The page does not store the version of its filter, it is given by the version of the
+ chunk's header page. New pages are written with BLOOMFILTER_VERSION.
+
 ===============================================================================================
 */
 
@@ -24,6 +27,9 @@ public:
     virtual uint32_t    GetSize();
     virtual uint32_t    GetMemorySize();
 
+    // must be set before Read()
+    void                SetVersion(unsigned version);
+    unsigned            GetVersion();
     void                SetNumKeys(uint64_t numKeys);
     void                Add(ReadBuffer key);
     
@@ -65,6 +65,28 @@ StorageKeyValue* StorageBulkCursor::First()
     return FromNextBunch(chunk);
 }
 
+StorageKeyValue* StorageBulkCursor::FirstAfter(uint64_t afterChunkID)
+{
+    StorageChunk**      itChunk;
+
+    FOREACH (itChunk, shard->chunks)
+    {
+        if ((*itChunk)->GetChunkID() == afterChunkID)
+            break;
+    }
+    
+    if (itChunk == NULL)
+        return First();
+
+    // pretend that the last bunch of afterChunkID was already read
+    chunkID = afterChunkID;
+    logSegmentID = (*itChunk)->GetMaxLogSegmentID();
+    logCommandID = (*itChunk)->GetMaxLogCommandID();
+    isLast = true;
+    
+    return FromNextBunch(*itChunk);
+}
+
 StorageKeyValue* StorageBulkCursor::Next(StorageKeyValue* it)
 {
     StorageKeyValue*    kv;
@@ -29,6 +29,9 @@ public:
     void                    SetOnBlockShard(Callable onBlockShard, Callable onUnblockShard);
     
     StorageKeyValue*        First();
+    // starts with the chunk following afterChunkID, the chunks up to and including
+    // afterChunkID are skipped
+    StorageKeyValue*        FirstAfter(uint64_t afterChunkID);
     StorageKeyValue*        Next(StorageKeyValue* it);
 
     void                    SetLast(bool last);
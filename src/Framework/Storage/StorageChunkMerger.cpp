@@ -63,6 +63,7 @@ bool StorageChunkMerger::Merge(
     iterators = new StorageFileKeyValue*[numReaders];
     for (i = 0; i < numReaders; i++)
         iterators[i] = readers[i].First(firstKey);
+    mergeTree.Init(iterators, numReaders);
     
     // open writer
     if (fd.Open(mergeChunk->GetFilename().GetBuffer(), FS_CREATE | FS_WRITEONLY | FS_TRUNCATE) == INVALID_FD)
@@ -72,6 +73,7 @@ bool StorageChunkMerger::Merge(
     lastSyncOffset = 0;
 
     mergeChunk->indexPage = new StorageIndexPage(mergeChunk);
+    mergeChunk->headerPage.SetCompression(env->GetConfig().GetCompression());
     if (mergeChunk->UseBloomFilter())
     {
         mergeChunk->bloomPage = new StorageBloomPage(mergeChunk);
@@ -115,6 +117,7 @@ bool StorageChunkMerger::Merge(
 
     delete[] readers;
     readers = NULL;
+    mergeTree.Clear();
     delete[] iterators;
     iterators = NULL;
 
@@ -127,6 +130,7 @@ void StorageChunkMerger::OnMergeFinished()
 {
     delete[] readers;
     readers = NULL;
+    mergeTree.Clear();
     delete[] iterators;
     iterators = NULL;
 
@@ -237,6 +241,7 @@ bool StorageChunkMerger::WriteDataPages(ReadBuffer /*firstKey*/, ReadBuffer last
     index = 0;
     pageOffset = offset;
     dataPage = new StorageDataPage(mergeChunk, index);
+    dataPage->SetCompression(mergeChunk->headerPage.GetCompression());
     dataPage->SetOffset(pageOffset);
     dataPageGuard.Set(dataPage);
     writeBuffer.Clear();
@@ -305,6 +310,7 @@ bool StorageChunkMerger::WriteDataPages(ReadBuffer /*firstKey*/, ReadBuffer last
                 mergeChunk->AppendDataPage(NULL);
                 index++;
                 dataPage = new StorageDataPage(mergeChunk, index);
+                dataPage->SetCompression(mergeChunk->headerPage.GetCompression());
                 dataPageGuard.Set(dataPage);
                 dataPage->SetOffset(pageOffset);
                 dataPage->Append(it);
@@ -366,19 +372,7 @@ bool StorageChunkMerger::WriteBloomPage()
 
 bool StorageChunkMerger::IsDone()
 {
-    unsigned    i;
-    unsigned    numActive;
-    
-    numActive = 0;
-    for (i = 0; i < numReaders; i++)
-    {
-        if (iterators[i] != NULL)
-            numActive++;
-    }
-    if (numActive == 0)
-        return true;
-
-    return false;
+    return mergeTree.IsEmpty();
 }
 
 #define ADVANCE_ITERATOR(i) iterators[i] = readers[i].Next(iterators[i])
@@ -387,39 +381,26 @@ StorageFileKeyValue* StorageChunkMerger::GetSmallest()
 {
     unsigned                i;
     unsigned                smallestIndex;
-    ReadBuffer              smallestKey;
     StorageFileKeyValue*    smallestKv;
-    int                     cmpres;
-
-    smallestIndex = 0;  // making the compiler happy by initializing
-    smallestKv = NULL;
-    // readers are sorted by relevance, first is the oldest, last is the latest
-    for (i = 0; i < numReaders; i++)
-    {
-        if (iterators[i] == NULL)
-            continue;
 
-        // do the comparison
-        if (smallestKey.GetLength() == 0)
-            cmpres = -1;
-        else
-            cmpres = ReadBuffer::Cmp(iterators[i]->GetKey(), smallestKey);
+    if (mergeTree.IsEmpty())
+        return NULL;
 
-        if (cmpres <= 0)
-        {
-            // advance the previously smallest if it is equal to the current
-            // because it is less relevant
-            if (smallestKv != NULL && cmpres == 0)
-                ADVANCE_ITERATOR(smallestIndex);
-            smallestKv = iterators[i];
-            smallestIndex = i;
-            smallestKey = smallestKv->GetKey();
-        }
-    }
+    // readers are sorted by relevance, on equal keys the latest one wins
+    smallestIndex = mergeTree.Top();
+    smallestKv = iterators[smallestIndex];
 
     // make progress in the reader that contained the smallest key
-    if (smallestKv != NULL)
-        ADVANCE_ITERATOR(smallestIndex);
+    ADVANCE_ITERATOR(smallestIndex);
+    mergeTree.UpdateTop();
+
+    // skip the same key in older readers, because they are less relevant
+    while (!mergeTree.IsEmpty() && mergeTree.CompareTop(smallestKv->GetKeyReference()) == 0)
+    {
+        i = mergeTree.Top();
+        ADVANCE_ITERATOR(i);
+        mergeTree.UpdateTop();
+    }
 
     return smallestKv;
 }
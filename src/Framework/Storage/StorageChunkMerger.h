@@ -9,6 +9,7 @@
 #include "StorageDataPage.h"
 #include "StorageIndexPage.h"
 #include "StorageBloomPage.h"
+#include "StorageMergeTree.h"
 
 class StorageEnvironment;   // forward
 class StorageChunk;         // forward
@@ -61,6 +62,7 @@ private:
     StorageChunkReader*     readers;
     unsigned                numReaders;
     StorageFileKeyValue**   iterators;
+    StorageMergeTree        mergeTree;
 
     StorageEnvironment*     env;
     StorageFileChunk*       mergeChunk;
@@ -306,7 +306,7 @@ void StorageChunkReader::PreloadDataPages()
             }
 
             //Log_Debug("Preloading datapage %u at offset %U from chunk %U", i, offset, fileChunk.GetChunkID());
-            pageSize = fileChunk.dataPages[i]->GetSize();
+            pageSize = fileChunk.dataPages[i]->GetCompressedSize();
             totalSize += pageSize;
             offset += pageSize;
             i++;
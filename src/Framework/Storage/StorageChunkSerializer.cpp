@@ -14,6 +14,7 @@ bool StorageChunkSerializer::Serialize(StorageEnvironment* env_, StorageMemoChun
     fileChunk = P(fileGuard);
     
     fileChunk->indexPage = new StorageIndexPage(fileChunk);
+    fileChunk->headerPage.SetCompression(env->GetConfig().GetCompression());
     
     if (memoChunk->UseBloomFilter())
     {
@@ -85,6 +86,7 @@ bool StorageChunkSerializer::WriteDataPages()
     dataPageIndex = 0;
 
     dataPage = new StorageDataPage(fileChunk, dataPageIndex);
+    dataPage->SetCompression(fileChunk->headerPage.GetCompression());
     dataPage->SetOffset(offset);
     FOREACH (it, memoChunk->keyValues)
     {
@@ -110,6 +112,7 @@ bool StorageChunkSerializer::WriteDataPages()
                 offset += dataPage->GetCompressedSize();
                 dataPageIndex++;
                 dataPage = new StorageDataPage(fileChunk, dataPageIndex);
+                dataPage->SetCompression(fileChunk->headerPage.GetCompression());
                 dataPage->SetOffset(offset);
                 dataPage->Append(it);
                 fileChunk->indexPage->Append(it->GetKey(), dataPageIndex, offset);
@@ -7,15 +7,112 @@ StorageCommitJob::StorageCommitJob(StorageEnvironment* env_,
     env = env_;
     logSegment = logSegment_;
     onCommit = onCommit_;
+    requestTime = NowClock();
+    startTime = 0;
+    written = false;
+    queued = false;
+    nextInGroup = NULL;
 }
 
 void StorageCommitJob::Execute()
 {
+    StorageCommitJob*   it;
+    IOUring*            ring;
+    unsigned            numQueued;
+
     startTime = NowClock();
-    logSegment->Commit();
+
+    // with io_uring the writes and syncs of the whole group are submitted together,
+    // rounds that are not queued are written and synced with system calls
+    ring = env->GetCommitRing();
+    numQueued = 0;
+    if (ring != NULL)
+    {
+        for (it = this; it != NULL; it = it->nextInGroup)
+        {
+            it->queued = it->logSegment->QueueRound(ring);
+            if (it->queued)
+                numQueued++;
+        }
+        if (numQueued > 0)
+            ring->Submit();
+    }
+
+    // write all rounds before the first sync, so the syncs
+    // of the group are issued back to back
+    for (it = this; it != NULL; it = it->nextInGroup)
+    {
+        if (!it->queued)
+            it->written = it->logSegment->WriteRound();
+    }
+
+    if (numQueued > 0)
+        WaitQueuedRounds(ring, numQueued);
+
+    for (it = this; it != NULL; it = it->nextInGroup)
+    {
+        if (it->written)
+            it->logSegment->SyncRound();
+    }
+}
+
+void StorageCommitJob::WaitQueuedRounds(IOUring* ring, unsigned numQueued)
+{
+    uint64_t            userData;
+    int                 result;
+
+    while (numQueued > 0)
+    {
+        if (!ring->Submit(1))
+            STOP_FAIL(1, "Unable to submit log segment writes");
+
+        // only the last sync of a round has userData
+        while (ring->GetCompletion(userData, result))
+        {
+            if (userData == 0)
+                continue;
+            ((StorageLogSegment*) userData)->OnQueuedRound(result);
+            numQueued--;
+        }
+    }
 }
 
 void StorageCommitJob::OnComplete()
 {
     env->OnCommit(this); // deletes this
 }
+
+void StorageCommitJob::Append(StorageCommitJob* job)
+{
+    StorageCommitJob*   it;
+
+    for (it = this; it->nextInGroup != NULL; it = it->nextInGroup)
+        ; // find last
+
+    it->nextInGroup = job;
+}
+
+bool StorageCommitJob::Contains(uint64_t trackID)
+{
+    StorageCommitJob*   it;
+
+    for (it = this; it != NULL; it = it->nextInGroup)
+    {
+        if (it->logSegment->GetTrackID() == trackID)
+            return true;
+    }
+
+    return false;
+}
+
+unsigned StorageCommitJob::GetGroupSize()
+{
+    unsigned            size;
+    StorageCommitJob*   it;
+
+    size = 0;
+    for (it = this; it != NULL; it = it->nextInGroup)
+        size++;
+
+    return size;
+}
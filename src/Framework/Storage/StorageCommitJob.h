@@ -11,6 +11,10 @@ class StorageEnvironment;
 
  StorageCommitJob
 
+ Commits of different tracks are chained with nextInGroup and executed as one job,
+ the log segments of the group are written first, then synced back to back.
+ If io.uring is set, the writes and syncs of the group are submitted as linked requests.
+
 ===============================================================================================
 */
 
@@ -23,11 +27,21 @@ public:
     
     void                Execute();
     void                OnComplete();
+
+    void                Append(StorageCommitJob* job);
+    bool                Contains(uint64_t trackID);
+    unsigned            GetGroupSize();
+    
+    void                WaitQueuedRounds(IOUring* ring, unsigned numQueued);
     
     StorageEnvironment* env;
     StorageLogSegment*  logSegment;
     Callable            onCommit;
+    uint64_t            requestTime;
     uint64_t            startTime;
+    bool                written;
+    bool                queued;
+    StorageCommitJob*   nextInGroup;
 };
 
 #endif
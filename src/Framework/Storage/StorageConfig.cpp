@@ -15,6 +15,11 @@ void StorageConfig::SetFileChunkCacheSize(uint64_t fileChunkCacheSize_)
     fileChunkCacheSize = fileChunkCacheSize_;
 }
 
+void StorageConfig::SetMetaPageCacheSize(uint64_t metaPageCacheSize_)
+{
+    metaPageCacheSize = metaPageCacheSize_;
+}
+
 void StorageConfig::SetMemoChunkCacheSize(uint64_t memoChunkCacheSize_)
 {
     memoChunkCacheSize = memoChunkCacheSize_;
@@ -67,6 +72,36 @@ void StorageConfig::SetMaxChunkPerShard(unsigned maxChunkPerShard_)
     maxChunkPerShard = maxChunkPerShard_;
 }
 
+void StorageConfig::SetCompression(char compression_)
+{
+    compression = compression_;
+}
+
+void StorageConfig::SetGroupCommitWindow(uint64_t groupCommitWindow_)
+{
+    groupCommitWindow = groupCommitWindow_;
+}
+
+void StorageConfig::SetGroupCommitSize(uint64_t groupCommitSize_)
+{
+    groupCommitSize = groupCommitSize_;
+}
+
+void StorageConfig::SetMapChunks(bool mapChunks_)
+{
+    mapChunks = mapChunks_;
+}
+
+void StorageConfig::SetMemoChunkIndex(char memoChunkIndex_)
+{
+    memoChunkIndex = memoChunkIndex_;
+}
+
+void StorageConfig::SetConcurrentMemoReads(bool concurrentMemoReads_)
+{
+    concurrentMemoReads = concurrentMemoReads_;
+}
+
 uint64_t StorageConfig::GetChunkSize()
 {
     return chunkSize;
@@ -82,6 +117,11 @@ uint64_t StorageConfig::GetFileChunkCacheSize()
     return fileChunkCacheSize;
 }
 
+uint64_t StorageConfig::GetMetaPageCacheSize()
+{
+    return metaPageCacheSize;
+}
+
 uint64_t StorageConfig::GetMemoChunkCacheSize()
 {
     return memoChunkCacheSize;
@@ -131,3 +171,33 @@ unsigned StorageConfig::GetMaxChunkPerShard()
 {
     return maxChunkPerShard;
 }
+
+char StorageConfig::GetCompression()
+{
+    return compression;
+}
+
+uint64_t StorageConfig::GetGroupCommitWindow()
+{
+    return groupCommitWindow;
+}
+
+uint64_t StorageConfig::GetGroupCommitSize()
+{
+    return groupCommitSize;
+}
+
+bool StorageConfig::GetMapChunks()
+{
+    return mapChunks;
+}
+
+char StorageConfig::GetMemoChunkIndex()
+{
+    return memoChunkIndex;
+}
+
+bool StorageConfig::GetConcurrentMemoReads()
+{
+    return concurrentMemoReads;
+}
@@ -17,6 +17,7 @@ public:
     void        SetChunkSize(uint64_t chunkSize);
     void        SetLogSegmentSize(uint64_t logSegmentSize);
     void        SetFileChunkCacheSize(uint64_t fileChunkCacheSize);
+    void        SetMetaPageCacheSize(uint64_t metaPageCacheSize);
     void        SetMemoChunkCacheSize(uint64_t memoChunkCacheSize);
     void        SetLogSize(uint64_t logSize);
     void        SetMergeBufferSize(uint64_t mergeBufferSize);
@@ -27,10 +28,17 @@ public:
     void		SetAbortWaitingListsNum(uint64_t abortWaitingListsNum);
     void        SetListDataPageCacheSize(uint64_t listDataPageCacheSize);
     void        SetMaxChunkPerShard(unsigned maxChunkPerShard);
+    void        SetCompression(char compression);
+    void        SetGroupCommitWindow(uint64_t groupCommitWindow);
+    void        SetGroupCommitSize(uint64_t groupCommitSize);
+    void        SetMapChunks(bool mapChunks);
+    void        SetMemoChunkIndex(char memoChunkIndex);
+    void        SetConcurrentMemoReads(bool concurrentMemoReads);
 
     uint64_t    GetChunkSize();
     uint64_t    GetLogSegmentSize();
     uint64_t    GetFileChunkCacheSize();
+    uint64_t    GetMetaPageCacheSize();
     uint64_t    GetMemoChunkCacheSize();
     uint64_t    GetNumLogSegments();
     uint64_t    GetMergeBufferSize();
@@ -41,11 +49,18 @@ public:
     uint64_t	GetAbortWaitingListsNum();
     uint64_t    GetListDataPageCacheSize();
     unsigned    GetMaxChunkPerShard();
+    char        GetCompression();
+    uint64_t    GetGroupCommitWindow();
+    uint64_t    GetGroupCommitSize();
+    bool        GetMapChunks();
+    char        GetMemoChunkIndex();
+    bool        GetConcurrentMemoReads();
 
 private:
     uint64_t    chunkSize;
     uint64_t    logSegmentSize;
     uint64_t    fileChunkCacheSize;
+    uint64_t    metaPageCacheSize;
     uint64_t    memoChunkCacheSize;
     uint64_t    numLogSegments;
     uint64_t    mergeBufferSize;
@@ -56,6 +71,12 @@ private:
     uint64_t	abortWaitingListsNum;
     uint64_t    listDataPageCacheSize;
     unsigned    maxChunkPerShard;
+    char        compression;
+    uint64_t    groupCommitWindow;  // msec
+    uint64_t    groupCommitSize;
+    bool        mapChunks;
+    char        memoChunkIndex;
+    bool        concurrentMemoReads;    // only with STORAGE_MEMO_INDEX_BTREE
 };
 
 #endif
@@ -2,8 +2,10 @@
 #include "StorageFileChunk.h"
 #include "System/Containers/InList.h"
 #include "System/Threading/Mutex.h"
+#include "System/Buffers/Compressor.h"
 
-#define STORAGE_DATAPAGE_HEADER_SIZE        16
+#define STORAGE_DATAPAGE_HEADER_SIZE                16
+#define STORAGE_DATAPAGE_COMPRESSED_HEADER_SIZE     20
 
 StorageDataPage::StorageDataPage()
 {
@@ -24,7 +26,9 @@ void StorageDataPage::Init(StorageFileChunk* owner_, uint32_t index_, unsigned b
 {
     size = 0;
     compressedSize = 0;
+    compression = STORAGE_COMPRESSION_NONE;
 
+    compressedBuffer.SetLength(0);
     keysBuffer.SetLength(0);
     valuesBuffer.SetLength(0);
 
@@ -38,6 +42,7 @@ void StorageDataPage::Init(StorageFileChunk* owner_, uint32_t index_, unsigned b
     buffer.AppendLittle32(0); // dummy for numKeys
     
     storageFileKeyValueBuffer.SetLength(0);
+    mappedBuffer.Reset();
 
     owner = owner_;
     index = index_;
@@ -49,6 +54,16 @@ void StorageDataPage::SetOwner(StorageFileChunk* owner_)
     owner = owner_;
 }
 
+void StorageDataPage::SetCompression(char compression_)
+{
+    compression = compression_;
+}
+
+char StorageDataPage::GetCompression()
+{
+    return compression;
+}
+
 uint32_t StorageDataPage::GetSize()
 {
     return size;
@@ -56,8 +71,8 @@ uint32_t StorageDataPage::GetSize()
 
 uint32_t StorageDataPage::GetMemorySize()
 {
-    return buffer.GetSize() + keysBuffer.GetSize() + 
-        valuesBuffer.GetSize() + storageFileKeyValueBuffer.GetSize();
+    return buffer.GetSize() + keysBuffer.GetSize() + valuesBuffer.GetSize() +
+        compressedBuffer.GetSize() + storageFileKeyValueBuffer.GetSize();
 }
 
 uint32_t StorageDataPage::GetCompressedSize()
@@ -216,26 +231,10 @@ void StorageDataPage::Finalize()
         }
     }
     
-#ifdef STORAGE_DATAPAGE_COMPRESSION
-    Buffer                  compressed;
-    Compressor              compressor;
-    
-    compressor.Compress(buffer, compressed);
-    buffer.SetLength(0);
-    buffer.AppendLittle32(0);
-    buffer.AppendLittle32(0);  // checksum
-    buffer.AppendLittle32(keysBuffer.GetLength());
-    buffer.AppendLittle32(buffer.GetLength());
-    buffer.Append(compressed);
-    
-    length = buffer.GetLength();
-    compressedSize = compressed.GetLength();
-    buffer.SetLength(0);
-    buffer.AppendLittle32(length);
-    buffer.SetLength(length);
-#else
-    compressedSize = size;
-#endif
+    if (compression != STORAGE_COMPRESSION_NONE)
+        Compress();
+    else
+        compressedSize = size;
 
     keysBuffer.Reset();
     valuesBuffer.Reset();
@@ -247,6 +246,8 @@ void StorageDataPage::Reset()
     
     keysBuffer.Reset();
     valuesBuffer.Reset();
+    compressedBuffer.Reset();
+    mappedBuffer.Reset();
     buffer.Reset();
     
     buffer.AppendLittle32(0); // dummy for size
@@ -334,6 +335,47 @@ StorageFileKeyValue* StorageDataPage::LocateKeyValue(ReadBuffer& key, int& cmpre
 }
 
 bool StorageDataPage::Read(Buffer& buffer_, bool keysOnly)
+{
+    ASSERT(GetNumKeys() == 0);
+    if (compression != STORAGE_COMPRESSION_NONE)
+    {
+        // compressed pages are always read in full
+        if (!Uncompress(buffer_))
+        {
+            buffer.Reset();
+            return false;
+        }
+        keysOnly = false;
+    }
+    else
+        buffer.Write(buffer_);
+
+    return Parse(ReadBuffer(buffer), keysOnly);
+}
+
+bool StorageDataPage::ReadMapped(ReadBuffer mapped, bool keysOnly)
+{
+    ASSERT(GetNumKeys() == 0);
+    ASSERT(compression == STORAGE_COMPRESSION_NONE);
+
+    // keys and values point into the mapped chunk file
+    buffer.Reset();
+    mappedBuffer = mapped;
+    if (!Parse(mapped, keysOnly))
+    {
+        mappedBuffer.Reset();
+        return false;
+    }
+
+    return true;
+}
+
+bool StorageDataPage::IsMapped()
+{
+    return mappedBuffer.GetLength() > 0;
+}
+
+bool StorageDataPage::Parse(ReadBuffer data, bool keysOnly)
 {
     char                    type;
     uint16_t                klen;
@@ -341,30 +383,14 @@ bool StorageDataPage::Read(Buffer& buffer_, bool keysOnly)
     ReadBuffer              dataPart, parse, kparse, vparse, key, value;
     StorageFileKeyValue     fkv;
     
-#ifdef STORAGE_DATAPAGE_COMPRESSION    
-    Compressor              compressor;
-    uint32_t                uncompressedSize;
-
-    Key - value seperation not implemented!
-
-    parse.Wrap(buffer_);
-    parse.ReadLittle32(compressedSize);
-    parse.Advance(sizeof(uint32_t));
-    parse.ReadLittle32(uncompressedSize);
-    parse.Advance(sizeof(uint32_t));
-    compressor.Uncompress(parse, buffer, uncompressedSize);
-#else
-    ASSERT(GetNumKeys() == 0);
-    buffer.Write(buffer_);
-#endif
-    parse.Wrap(buffer);
+    parse = data;
     
     // size
     parse.ReadLittle32(size);
     if (size < 12)
         goto Fail;
     if (!keysOnly)
-        if (buffer.GetLength() != size)
+        if (data.GetLength() != size)
             goto Fail;
     parse.Advance(4);
 
@@ -443,12 +469,9 @@ bool StorageDataPage::Read(Buffer& buffer_, bool keysOnly)
         }
     }
 
-#ifdef STORAGE_DATAPAGE_COMPRESSION
-    this->size = uncompressedSize;
-#else    
     this->size = size;
-    this->compressedSize = size;
-#endif
+    if (compression == STORAGE_COMPRESSION_NONE)
+        this->compressedSize = size;
     return true;
     
 Fail:
@@ -459,13 +482,33 @@ Fail:
 
 void StorageDataPage::Write(Buffer& buffer_)
 {
-    buffer_.Write(buffer);
+    buffer_.SetLength(0);
+    Serialize(buffer_);
 }
 
 unsigned StorageDataPage::Serialize(Buffer& buffer_)
 {
-    buffer_.Append(buffer);
-    return buffer.GetLength();
+    unsigned    length;
+
+    if (IsMapped())
+    {
+        buffer_.Append(mappedBuffer);
+        return mappedBuffer.GetLength();
+    }
+
+    if (compression == STORAGE_COMPRESSION_NONE)
+    {
+        buffer_.Append(buffer);
+        return buffer.GetLength();
+    }
+
+    // the compressed image is only needed until it is written out
+    if (compressedBuffer.GetLength() == 0)
+        Compress();
+    buffer_.Append(compressedBuffer);
+    length = compressedBuffer.GetLength();
+    compressedBuffer.Reset();
+    return length;
 }
 
 void StorageDataPage::Unload()
@@ -474,6 +517,92 @@ void StorageDataPage::Unload()
     owner->OnDataPageEvicted(index);
 }
 
+void StorageDataPage::Compress()
+{
+    uint32_t        div, mod, length, payloadLength;
+    char            codec;
+    Compressor      compressor;
+
+    // on-disk format of a compressed page:
+    // size, checksum, codec, uncompressedSize, payloadLength, payload, zero padding
+    compressedBuffer.SetLength(0);
+    compressedBuffer.AppendLittle32(0); // dummy for size
+    compressedBuffer.AppendLittle32(0); // checksum
+    compressedBuffer.AppendLittle32(0); // dummy for codec
+    compressedBuffer.AppendLittle32(size);
+    compressedBuffer.AppendLittle32(0); // dummy for payloadLength
+
+    codec = compression;
+    compressor.Compress(ReadBuffer(buffer), compressedBuffer);
+    if (compressedBuffer.GetLength() >= size)
+    {
+        // incompressible, store the page image as is
+        codec = STORAGE_COMPRESSION_NONE;
+        compressedBuffer.SetLength(STORAGE_DATAPAGE_COMPRESSED_HEADER_SIZE);
+        compressedBuffer.Append(buffer);
+    }
+    payloadLength = compressedBuffer.GetLength() - STORAGE_DATAPAGE_COMPRESSED_HEADER_SIZE;
+
+    length = compressedBuffer.GetLength();
+    div = length / STORAGE_DEFAULT_PAGE_GRAN;
+    mod = length % STORAGE_DEFAULT_PAGE_GRAN;
+    compressedSize = div * STORAGE_DEFAULT_PAGE_GRAN;
+    if (mod > 0)
+        compressedSize += STORAGE_DEFAULT_PAGE_GRAN;
+
+    compressedBuffer.Allocate(compressedSize);
+    compressedBuffer.ZeroRest();
+
+    compressedBuffer.SetLength(0);
+    compressedBuffer.AppendLittle32(compressedSize);
+    compressedBuffer.SetLength(8);
+    compressedBuffer.AppendLittle32(codec);
+    compressedBuffer.SetLength(16);
+    compressedBuffer.AppendLittle32(payloadLength);
+    compressedBuffer.SetLength(compressedSize);
+}
+
+bool StorageDataPage::Uncompress(Buffer& buffer_)
+{
+    uint32_t        outerSize, codec, uncompressedSize, payloadLength;
+    ReadBuffer      parse;
+    Compressor      compressor;
+
+    parse.Wrap(buffer_);
+    if (!parse.ReadLittle32(outerSize) || outerSize != buffer_.GetLength())
+        return false;
+    parse.Advance(8);
+    if (!parse.ReadLittle32(codec))
+        return false;
+    parse.Advance(4);
+    if (!parse.ReadLittle32(uncompressedSize))
+        return false;
+    parse.Advance(4);
+    if (!parse.ReadLittle32(payloadLength))
+        return false;
+    parse.Advance(4);
+    if (payloadLength > parse.GetLength())
+        return false;
+    parse.SetLength(payloadLength);
+
+    if (codec == STORAGE_COMPRESSION_NONE)
+    {
+        if (payloadLength != uncompressedSize)
+            return false;
+        buffer.Write(parse);
+    }
+    else if (codec == STORAGE_COMPRESSION_LZ)
+    {
+        if (!compressor.Uncompress(parse, buffer, uncompressedSize))
+            return false;
+    }
+    else
+        return false;
+
+    compressedSize = outerSize;
+    return true;
+}
+
 void StorageDataPage::AppendKeyValue(StorageFileKeyValue& kv)
 {
     ASSERT(kv.GetKey().GetLength() > 0);
@@ -31,6 +31,8 @@ public:
 
     void                    Init(StorageFileChunk* owner_, uint32_t index_, unsigned bufferSize);
     void                    SetOwner(StorageFileChunk* owner);
+    void                    SetCompression(char compression);
+    char                    GetCompression();
 
     uint32_t                GetSize();
     uint32_t                GetMemorySize();
@@ -56,6 +58,9 @@ public:
     StorageFileKeyValue*    LocateKeyValue(ReadBuffer& key, int& cmpres);
 
     bool                    Read(Buffer& buffer, bool keysOnly = false);
+    // zero-copy read, the page references the mapped memory until it is reset
+    bool                    ReadMapped(ReadBuffer mapped, bool keysOnly = false);
+    bool                    IsMapped();
     void                    Write(Buffer& buffer);
     // Serialize differs from Write in that it appends to the buffer
     unsigned                Serialize(Buffer& buffer);
@@ -67,15 +72,21 @@ public:
 
 private:
     void                    AppendKeyValue(StorageFileKeyValue& kv);
+    bool                    Parse(ReadBuffer data, bool keysOnly);
+    void                    Compress();
+    bool                    Uncompress(Buffer& buffer);
 
     uint32_t                size;
     uint32_t                compressedSize;
     uint32_t                index;
+    char                    compression;
     Buffer                  buffer;
+    Buffer                  compressedBuffer;
     Buffer                  keysBuffer;
     Buffer                  valuesBuffer;
     StorageFileChunk*       owner;
     Buffer                  storageFileKeyValueBuffer;
+    ReadBuffer              mappedBuffer;
 };
 
 #endif
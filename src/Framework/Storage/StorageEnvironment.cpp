@@ -11,6 +11,7 @@
 #include "StorageListPageCache.h"
 #include "StorageAsyncGet.h"
 #include "StorageAsyncList.h"
+#include "StorageAsyncMemoGet.h"
 #include "StorageSerializeChunkJob.h"
 #include "StorageWriteChunkJob.h"
 #include "StorageMergeChunkJob.h"
@@ -67,8 +68,15 @@ inline bool LessThan(ShardSize& a, ShardSize& b)
 }
 
 
+// upper bounds of the commit latency histogram buckets in msec, the last one is unbounded
+static const unsigned commitLatencyBounds[STORAGE_COMMIT_LATENCY_BUCKETS] =
+ {1, 2, 5, 10, 20, 50, 100, 200, 500, 0};
+
 StorageEnvironment::StorageEnvironment()
 {
+    unsigned    i;
+    Buffer      name;
+
     logManager.env = this;
     asyncListThread = NULL;
     asyncGetThread = NULL;
@@ -86,6 +94,22 @@ StorageEnvironment::StorageEnvironment()
     dumpMemoChunks = false;
     numWriteToc100 = Registry::GetUintPtr("numWriteToc100");
     numWriteToc1000 = Registry::GetUintPtr("numWriteToc1000");
+
+    onGroupCommitTimer = MFUNC(StorageEnvironment, OnGroupCommitTimer);
+    groupCommitTimer.SetCallable(onGroupCommitTimer);
+    pendingCommits = NULL;
+    pendingCommitSize = 0;
+    deferGroupCommit = false;
+    numCommits = Registry::GetUintPtr("storage.commit.numCommits");
+    numGroupCommits = Registry::GetUintPtr("storage.commit.numGroupCommits");
+    for (i = 0; i < STORAGE_COMMIT_LATENCY_BUCKETS; i++)
+    {
+        if (commitLatencyBounds[i] > 0)
+            name.Writef("storage.commit.latency.under%ums", commitLatencyBounds[i]);
+        else
+            name.Writef("storage.commit.latency.over%ums", commitLatencyBounds[i - 1]);
+        commitLatency[i] = Registry::GetUintPtr(name);
+    }
 }
 
 bool StorageEnvironment::Open(Buffer& envPath_, StorageConfig config_)
@@ -97,6 +121,8 @@ bool StorageEnvironment::Open(Buffer& envPath_, StorageConfig config_)
     config = config_;
 
     StorageFileDeleter::Init();
+    if (configFile.GetBoolValue("io.uring", false) && !commitRing.Init(STORAGE_COMMIT_RING_ENTRIES))
+        Log_Message("Cannot initialize io_uring, writing log segments with system calls");
     commitJobs.Start();
     serializeChunkJobs.Start();
     writeChunkJobs.Start();
@@ -107,7 +133,7 @@ bool StorageEnvironment::Open(Buffer& envPath_, StorageConfig config_)
     asyncListThread = ThreadPool::Create(configFile.GetIntValue("database.numAsyncThreads", 10));
     asyncListThread->Start();
 
-    asyncGetThread = ThreadPool::Create(1);
+    asyncGetThread = ThreadPool::Create(configFile.GetIntValue("database.numAsyncGetThreads", 4));
     asyncGetThread->Start();
 
     envPath.Write(envPath_);
@@ -172,6 +198,10 @@ bool StorageEnvironment::Open(Buffer& envPath_, StorageConfig config_)
     
     StoragePageCache::Init(config);
     StorageListPageCache::SetMaxCacheSize(config.GetListDataPageCacheSize());
+    StorageFileChunk::SetMapChunks(config.GetMapChunks());
+    StorageMemoChunk::SetIndexType(config.GetMemoChunkIndex());
+    if (config.GetConcurrentMemoReads() && config.GetMemoChunkIndex() != STORAGE_MEMO_INDEX_BTREE)
+        Log_Message("Concurrent memo chunk reads are only supported with the btree memo chunk index");
     
     if (!recovery.TryRecovery(this))
     {
@@ -189,17 +219,29 @@ bool StorageEnvironment::Open(Buffer& envPath_, StorageConfig config_)
 
     EventLoop::Add(&backgroundTimer);
 
+    groupCommitTimer.SetDelay(config.GetGroupCommitWindow());
+
     return true;
 }
 
 void StorageEnvironment::Close()
 {
     StorageFileChunk*   fileChunk;
+    StorageCommitJob*   job;
     
     shuttingDown = true;
 
     StorageFileDeleter::Shutdown();
+    EventLoop::Remove(&backgroundTimer);
+    EventLoop::Remove(&groupCommitTimer);
+    while (pendingCommits)
+    {
+        job = pendingCommits;
+        pendingCommits = job->nextInGroup;
+        delete job;
+    }
     commitJobs.Stop();
+    commitRing.Close();
     serializeChunkJobs.Stop();
     writeChunkJobs.Stop();
     mergeChunkJobs.Stop();
@@ -210,7 +252,9 @@ void StorageEnvironment::Close()
     asyncListThread->Stop();
     delete asyncListThread;
     delete asyncGetThread;
+    asyncGetLoads.ClearMembers();
     
+    shardIndex.Clear();
     shards.DeleteList();
 
     FOREACH (fileChunk, fileChunks)
@@ -226,6 +270,13 @@ void StorageEnvironment::Sync(FD fd)
 #endif
 }
 
+IOUring* StorageEnvironment::GetCommitRing()
+{
+    if (!commitRing.IsActive())
+        return NULL;
+    return &commitRing;
+}
+
 void StorageEnvironment::SetMergeEnabled(bool mergeEnabled)
 {
     if (mergeEnabled)
@@ -251,47 +302,29 @@ void StorageEnvironment::SetDeleteEnabled(bool deleteEnabled_)
 
 uint64_t StorageEnvironment::GetShardID(uint16_t contextID, uint64_t tableID, ReadBuffer& key)
 {
-    StorageShard* it;
+    StorageShard* shard;
 
-    FOREACH (it, shards)
-    {
-        if (it->GetContextID() == contextID && it->GetTableID() == tableID)
-        {
-            if (it->RangeContains(key))
-                return it->GetShardID();
-        }
-    }
+    shard = shardIndex.GetByKey(contextID, tableID, key);
+    if (shard == NULL)
+        return 0;
 
-    return 0;
+    return shard->GetShardID();
 }
 
 uint64_t StorageEnvironment::GetShardIDByLastKey(uint16_t contextID, uint64_t tableID, ReadBuffer& key)
 {
-    StorageShard* it;
+    StorageShard* shard;
 
-    FOREACH (it, shards)
-    {
-        if (it->GetContextID() == contextID && it->GetTableID() == tableID)
-        {
-            if (it->GetLastKey().Equals(key))
-                return it->GetShardID();
-        }
-    }
+    shard = shardIndex.GetByLastKey(contextID, tableID, key);
+    if (shard == NULL)
+        return 0;
 
-    return 0;
+    return shard->GetShardID();
 }
 
 bool StorageEnvironment::ShardExists(uint16_t contextID, uint64_t shardID)
 {
-    StorageShard* it;
-
-    FOREACH (it, shards)
-    {
-        if (it->GetContextID() == contextID && it->GetShardID() == shardID)
-            return true;
-    }
-
-    return false;
+    return (shardIndex.Get(contextID, shardID) != NULL);
 }
 
 void StorageEnvironment::GetShardIDs(uint64_t contextID, Buffer& shardIDs)
@@ -493,11 +526,52 @@ void StorageEnvironment::AsyncList(uint16_t contextID, uint64_t shardID, Storage
     asyncList->ExecuteAsyncList();
 }
 
+bool StorageEnvironment::IsConcurrentMemoReadable(StorageShard* shard)
+{
+    // log storage shards remove key-values from the memo chunk, readers must not see that
+    if (!config.GetConcurrentMemoReads() || shard->GetStorageType() == STORAGE_SHARD_TYPE_LOG)
+        return false;
+
+    return shard->GetMemoChunk()->IsConcurrentReadable();
+}
+
+bool StorageEnvironment::AddAsyncMemoGet(uint16_t contextID, uint64_t shardID, ReadBuffer& key,
+ StorageAsyncMemoGet* asyncMemoGet)
+{
+    StorageShard*       shard;
+    StorageMemoChunk*   memoChunk;
+
+    ASSERT(!asyncMemoGet->IsFull());
+
+    shard = GetShard(contextID, shardID);
+    if (shard == NULL || !shard->RangeContains(key) || !IsConcurrentMemoReadable(shard))
+        return false;
+
+    memoChunk = shard->GetMemoChunk();
+    memoChunk->AddReader();
+    asyncMemoGet->keys[asyncMemoGet->num] = key;
+    asyncMemoGet->memoChunks[asyncMemoGet->num] = memoChunk;
+    asyncMemoGet->num++;
+
+    return true;
+}
+
+void StorageEnvironment::AsyncMemoGet(StorageAsyncMemoGet* asyncMemoGet)
+{
+    asyncMemoGet->env = this;
+    asyncGetThread->Execute(MFUNC_OF(StorageAsyncMemoGet, ExecuteAsyncMemoGet, asyncMemoGet));
+}
+
+void StorageEnvironment::ReleaseMemoChunk(StorageMemoChunk* memoChunk)
+{
+    if (memoChunk->RemoveReader() == 0 && memoChunk->pendingDelete)
+        deleteChunkJobs.Execute(new StorageDeleteMemoChunkJob(memoChunk));
+}
+
 bool StorageEnvironment::Set(uint16_t contextID, uint64_t shardID, ReadBuffer key, ReadBuffer value)
 {
     int32_t             logCommandID;
     uint64_t            keyValueSize;
-    Job*                job;
     StorageShard*       shard;
     StorageMemoChunk*   memoChunk;
     StorageLogSegment*  logSegment;
@@ -512,8 +586,7 @@ bool StorageEnvironment::Set(uint16_t contextID, uint64_t shardID, ReadBuffer ke
     if (!logSegment)
         ASSERT_FAIL();
 
-    FOREACH(job, commitJobs)
-        ASSERT(((StorageCommitJob*)job)->logSegment->GetTrackID() != shard->GetTrackID());
+    ASSERT(!IsCommitting(shard->GetTrackID()));
 
     logCommandID = logSegment->AppendSet(contextID, shardID, key, value);
     if (logCommandID < 0)
@@ -543,7 +616,6 @@ bool StorageEnvironment::Set(uint16_t contextID, uint64_t shardID, ReadBuffer ke
 bool StorageEnvironment::Delete(uint16_t contextID, uint64_t shardID, ReadBuffer key)
 {
     int32_t             logCommandID;
-    Job*                job;
     StorageShard*       shard;
     StorageMemoChunk*   memoChunk;
     StorageLogSegment*  logSegment;
@@ -561,8 +633,7 @@ bool StorageEnvironment::Delete(uint16_t contextID, uint64_t shardID, ReadBuffer
     if (!logSegment)
         ASSERT_FAIL();
 
-    FOREACH(job, commitJobs)
-        ASSERT(((StorageCommitJob*)job)->logSegment->GetTrackID() != shard->GetTrackID());
+    ASSERT(!IsCommitting(shard->GetTrackID()));
 
     logCommandID = logSegment->AppendDelete(contextID, shardID, key);
     if (logCommandID < 0)
@@ -580,6 +651,86 @@ bool StorageEnvironment::Delete(uint16_t contextID, uint64_t shardID, ReadBuffer
     return true;
 }
 
+void StorageEnvironment::GetWrittenFileChunkIDs(uint16_t contextID, uint64_t shardID,
+ List<uint64_t>& chunkIDs)
+{
+    StorageShard*       shard;
+    StorageChunk**      itChunk;
+    uint64_t            chunkID;
+
+    shard = GetShard(contextID, shardID);
+    if (shard == NULL)
+        return;
+
+    // only the chunks before the first unwritten one, so that the rest of the shard
+    // can be read with a cursor in the same order
+    FOREACH (itChunk, shard->GetChunks())
+    {
+        if ((*itChunk)->GetChunkState() != StorageChunk::Written)
+            break;
+        chunkID = (*itChunk)->GetChunkID();
+        chunkIDs.Append(chunkID);
+    }
+}
+
+uint64_t StorageEnvironment::NextChunkID()
+{
+    return nextChunkID++;
+}
+
+void StorageEnvironment::GetChunkFilename(uint64_t chunkID, Buffer& filename)
+{
+    StorageFileChunk    fileChunk;
+
+    fileChunk.SetFilename(chunkPath, chunkID);
+    filename.Write(fileChunk.GetFilename());
+}
+
+bool StorageEnvironment::ImportFileChunk(uint16_t contextID, uint64_t shardID, uint64_t chunkID)
+{
+    StorageShard*       shard;
+    StorageChunk*       chunk;
+    StorageFileChunk*   fileChunk;
+    StorageLogSegment*  logSegment;
+
+    shard = GetShard(contextID, shardID);
+    if (shard == NULL)
+        return false;
+
+    // a chunk that was already imported for another shard is shared like after a split
+    fileChunk = GetFileChunk(chunkID);
+    if (fileChunk == NULL)
+    {
+        logSegment = logManager.GetHead(shard->GetTrackID());
+        ASSERT(logSegment);
+
+        // the chunk is ordered after the commands already in the log, and the commands
+        // appended later are replayed on top of it during recovery
+        fileChunk = new StorageFileChunk;
+        fileChunk->SetFilename(chunkPath, chunkID);
+        if (!fileChunk->RewriteHeaderPage(chunkID, logSegment->GetLogSegmentID(),
+         logSegment->GetLogCommandID() - 1))
+        {
+            Log_Message("Unable to import chunk file %B", &fileChunk->GetFilename());
+            delete fileChunk;
+            return false;
+        }
+        fileChunk->written = true;
+        fileChunk->ReadHeaderPage();
+        fileChunks.Append(fileChunk);
+    }
+
+    chunk = fileChunk;
+    if (shard->GetChunks().Contains(chunk))
+        return true;
+
+    Log_Message("Importing chunk %U into shard %u/%U", chunkID, contextID, shardID);
+
+    shard->PushChunk(chunk);
+    WriteTOC();
+    return true;
+}
+
 StorageBulkCursor* StorageEnvironment::GetBulkCursor(uint16_t contextID, uint64_t shardID)
 {
     StorageBulkCursor*  bc;
@@ -630,7 +781,7 @@ uint64_t StorageEnvironment::GetSize(uint16_t contextID, uint64_t shardID)
 
 bool StorageEnvironment::Commit(uint64_t trackID, Callable& onCommit)
 {
-    Job*                job;
+    StorageCommitJob*   job;
     StorageLogSegment*  logSegment;
 
     Log_Debug("Committing in track %U (async thread)", trackID);
@@ -638,17 +789,28 @@ bool StorageEnvironment::Commit(uint64_t trackID, Callable& onCommit)
     logSegment = logManager.GetHead(trackID);
     ASSERT(logSegment);
 
-    FOREACH(job, commitJobs)
-        ASSERT(((StorageCommitJob*)job)->logSegment->GetTrackID() != trackID);
+    ASSERT(!IsCommitting(trackID));
 
-    commitJobs.Execute(new StorageCommitJob(this, logSegment, onCommit));
+    // join the pending group, it is started when the running group is finished
+    job = new StorageCommitJob(this, logSegment, onCommit);
+    if (pendingCommits == NULL)
+    {
+        pendingCommits = job;
+        if (groupCommitTimer.GetDelay() > 0)
+            EventLoop::Reset(&groupCommitTimer);
+    }
+    else
+        pendingCommits->Append(job);
+
+    pendingCommitSize += logSegment->GetWriteBufferSize();
+
+    TryGroupCommit();
 
     return true;
 }
 
 bool StorageEnvironment::Commit(uint64_t trackID)
 {
-    Job*                job;
     StorageLogSegment*  logSegment;
 
     Log_Debug("Committing in track %U (main thread)", trackID);
@@ -656,8 +818,7 @@ bool StorageEnvironment::Commit(uint64_t trackID)
     logSegment = logManager.GetHead(trackID);
     ASSERT(logSegment);
 
-    FOREACH(job, commitJobs)
-        ASSERT(((StorageCommitJob*)job)->logSegment->GetTrackID() != trackID);
+    ASSERT(!IsCommitting(trackID));
 
     logSegment->Commit();
     OnCommit(NULL);
@@ -671,13 +832,38 @@ bool StorageEnvironment::IsCommitting(uint64_t trackID)
 
     FOREACH(job, commitJobs)
     {
-        if (((StorageCommitJob*)job)->logSegment->GetTrackID() == trackID)
+        if (((StorageCommitJob*)job)->Contains(trackID))
             return true;
     }
     
+    if (pendingCommits && pendingCommits->Contains(trackID))
+        return true;
+
     return false;
 }
 
+void StorageEnvironment::TryGroupCommit()
+{
+    if (pendingCommits == NULL || deferGroupCommit || commitJobs.IsActive())
+        return;
+
+    // wait until the window is over or enough data is collected
+    if (groupCommitTimer.IsActive() && pendingCommitSize < config.GetGroupCommitSize())
+        return;
+
+    EventLoop::Remove(&groupCommitTimer);
+
+    (*numGroupCommits)++;
+    commitJobs.Execute(pendingCommits);
+    pendingCommits = NULL;
+    pendingCommitSize = 0;
+}
+
+void StorageEnvironment::OnGroupCommitTimer()
+{
+    TryGroupCommit();
+}
+
 bool StorageEnvironment::PushMemoChunk(uint16_t contextID, uint64_t shardID)
 {
     StorageShard*       shard;
@@ -963,28 +1149,12 @@ StorageConfig& StorageEnvironment::GetConfig()
 
 StorageShard* StorageEnvironment::GetShard(uint16_t contextID, uint64_t shardID)
 {
-    StorageShard* it;
-
-    FOREACH (it, shards)
-    {
-        if (it->GetContextID() == contextID && it->GetShardID() == shardID)
-            return it;
-    }
-
-    return NULL;
+    return shardIndex.Get(contextID, shardID);
 }
 
 StorageShard* StorageEnvironment::GetShardByKey(uint16_t contextID, uint64_t tableID, ReadBuffer& key)
 {
-    StorageShard* it;
-
-    FOREACH (it, shards)
-    {
-        if (it->GetContextID() == contextID && it->GetTableID() == tableID && it->RangeContains(key))
-            return it;
-    }
-
-    return NULL;
+    return shardIndex.GetByKey(contextID, tableID, key);
 }
 
 bool StorageEnvironment::CreateShard(uint64_t trackID,
@@ -1027,6 +1197,7 @@ bool StorageEnvironment::CreateShard(uint64_t trackID,
     shard->PushMemoChunk(new StorageMemoChunk(nextChunkID++, useBloomFilter));
 
     shards.Append(shard);
+    shardIndex.Add(shard);
     WriteTOC();
     return true;
 }
@@ -1048,7 +1219,8 @@ void StorageEnvironment::DeleteShard(uint16_t contextID, uint64_t shardID, bool
 
     if (shard->GetMemoChunk() != NULL)
     {
-        deleteChunkJobs.Enqueue(new StorageDeleteMemoChunkJob(shard->GetMemoChunk())); // Enqueue() instead of Execute() because WriteTOC() is required before
+        if (!DeferMemoChunkDelete(shard->GetMemoChunk()))
+            deleteChunkJobs.Enqueue(new StorageDeleteMemoChunkJob(shard->GetMemoChunk())); // Enqueue() instead of Execute() because WriteTOC() is required before
         shard->memoChunk = NULL;
     }
 
@@ -1060,9 +1232,9 @@ void StorageEnvironment::DeleteShard(uint16_t contextID, uint64_t shardID, bool
         if ((*itChunk)->GetChunkState() <= StorageChunk::Serialized)
         {
             memoChunk = (StorageMemoChunk*) *itChunk;
-            if (serializeChunkJobs.IsActive() && SERIALIZECHUNKJOB->memoChunk == memoChunk)
+            if (IsSerializing(memoChunk))
                 memoChunk->deleted = true;
-            else
+            else if (!DeferMemoChunkDelete(memoChunk))
                 deleteChunkJobs.Enqueue(new StorageDeleteMemoChunkJob(memoChunk)); // Enqueue() instead of Execute() because WriteTOC() is required before
         }
         else
@@ -1086,6 +1258,7 @@ void StorageEnvironment::DeleteShard(uint16_t contextID, uint64_t shardID, bool
     if (mergeChunkJobs.IsActive() && MERGECHUNKJOB->contextID == contextID && MERGECHUNKJOB->shardID == shardID)
         MERGECHUNKJOB->mergeChunk->deleted = true;
 
+    shardIndex.Remove(shard);
     shards.Remove(shard);
     delete shard;
     
@@ -1105,9 +1278,7 @@ bool StorageEnvironment::SplitShard(uint16_t contextID,  uint64_t shardID,
     StorageShard*           shard;
     StorageShard*           newShard;
     StorageMemoChunk*       memoChunk;
-    StorageMemoChunk*       newMemoChunk;
     StorageChunk**          itChunk;
-    StorageMemoKeyValue*    itKeyValue;
     StorageLogSegment*      logSegment;
 
     shard = GetShard(contextID, newShardID);
@@ -1121,10 +1292,9 @@ bool StorageEnvironment::SplitShard(uint16_t contextID,  uint64_t shardID,
     logSegment = logManager.GetHead(shard->GetTrackID());
     if (!logSegment)
         ASSERT_FAIL();
-    
-    if (logSegment->HasUncommitted())
-        Commit(shard->GetTrackID()); // TODO
 
+    // the uncommitted writes are committed with the rest of the round, recovery
+    // replays them into the shard that contains the key after the split
     newShard = new StorageShard;
     newShard->SetTrackID(shard->GetTrackID());
     newShard->SetContextID(contextID);
@@ -1136,33 +1306,24 @@ bool StorageEnvironment::SplitShard(uint16_t contextID,  uint64_t shardID,
     newShard->SetLogSegmentID(logSegment->GetLogSegmentID());
     newShard->SetLogCommandID(logSegment->GetLogCommandID());
 
-    FOREACH (itChunk, shard->GetChunks())
-        newShard->PushChunk(*itChunk);
-
+    // instead of copying the memo chunk, it is frozen and shared by both shards like
+    // the file chunks, reads and cursors skip the keys outside the shard's range
     memoChunk = shard->GetMemoChunk();
-
-    newMemoChunk = new StorageMemoChunk(nextChunkID++, memoChunk->useBloomFilter);
-    newMemoChunk->minLogSegmentID = memoChunk->minLogSegmentID;
-    newMemoChunk->maxLogSegmentID = memoChunk->maxLogSegmentID;
-    newMemoChunk->maxLogCommandID = memoChunk->maxLogCommandID;
-
-    Log_Debug("SplitShard memoChunk copy begin");
-    FOREACH (itKeyValue, memoChunk->keyValues)
+    if (memoChunk->GetSize() > 0)
     {
-        ASSERT(itKeyValue->GetKey().GetLength() > 0);
-        if (newShard->RangeContains(itKeyValue->GetKey()))
-        {
-            if (itKeyValue->GetType() == STORAGE_KEYVALUE_TYPE_SET)
-                newMemoChunk->Set(itKeyValue->GetKey(), itKeyValue->GetValue());
-            else
-                newMemoChunk->Delete(itKeyValue->GetKey());
-        }
+        Log_Debug("Serializing chunk %U shared by split shards %U and %U",
+         memoChunk->GetChunkID(), shardID, newShardID);
+        shard->PushMemoChunk(new StorageMemoChunk(nextChunkID++, shard->UseBloomFilter()));
+        serializeChunkJobs.Execute(new StorageSerializeChunkJob(this, memoChunk));
     }
-    Log_Debug("SplitShard memoChunk copy end");
 
-    newShard->PushMemoChunk(newMemoChunk);
+    FOREACH (itChunk, shard->GetChunks())
+        newShard->PushChunk(*itChunk);
+
+    newShard->PushMemoChunk(new StorageMemoChunk(nextChunkID++, shard->UseBloomFilter()));
 
     shards.Append(newShard);
+    shardIndex.Add(newShard);
 
     shard->SetLastKey(splitKey);
     
@@ -1192,20 +1353,42 @@ bool StorageEnvironment::DeleteTrack(uint64_t trackID)
 
 void StorageEnvironment::OnCommit(StorageCommitJob* job)
 {
+    unsigned            i;
+    uint64_t            latency;
+    StorageCommitJob*   it;
+
     if (job)
     {
-        Log_Debug("Commiting done in track %U, elapsed: %U msec", 
-          job->logSegment->GetTrackID(),
+        Log_Debug("Commiting done in %u tracks, elapsed: %U msec", 
+          job->GetGroupSize(),
           NowClock() - job->startTime);
     }
 
     TryFinalizeLogSegments();
     TrySerializeChunks();
-        
-    if (job)
-        Call(job->onCommit);
 
-    delete job;
+    // commits issued by the callbacks are collected into one group
+    deferGroupCommit = true;
+    while (job)
+    {
+        it = job;
+        job = it->nextInGroup;
+
+        latency = NowClock() - it->requestTime;
+        for (i = 0; i < STORAGE_COMMIT_LATENCY_BUCKETS - 1; i++)
+        {
+            if (latency < commitLatencyBounds[i])
+                break;
+        }
+        (*commitLatency[i])++;
+        (*numCommits)++;
+
+        Call(it->onCommit);
+        delete it;
+    }
+    deferGroupCommit = false;
+
+    TryGroupCommit();
 }
 
 void StorageEnvironment::TryFinalizeLogSegments()
@@ -1222,6 +1405,10 @@ void StorageEnvironment::TryFinalizeLogSegments()
         if (logSegment->GetOffset() < config.GetLogSegmentSize())
             continue;
 
+        // the segment is finalized after its pending commit
+        if (IsCommitting(track->trackID))
+            continue;
+
         logSegment->Close();
     }
 }
@@ -1581,7 +1768,8 @@ void StorageEnvironment::OnChunkSerialize(StorageSerializeChunkJob* job)
         fileChunks.Append(fileChunk);
     }
 
-    deleteChunkJobs.Execute(new StorageDeleteMemoChunkJob(job->memoChunk));
+    if (!DeferMemoChunkDelete(job->memoChunk))
+        deleteChunkJobs.Execute(new StorageDeleteMemoChunkJob(job->memoChunk));
     
     TrySerializeChunks();
     TryWriteChunks();
@@ -1792,6 +1980,30 @@ void StorageEnvironment::OnChunkSerialized(StorageMemoChunk* memoChunk, StorageF
     }
 }
 
+// memo chunks are deleted when their last concurrent reader is removed
+bool StorageEnvironment::DeferMemoChunkDelete(StorageMemoChunk* memoChunk)
+{
+    if (memoChunk->GetNumReaders() == 0)
+        return false;
+
+    memoChunk->pendingDelete = true;
+    return true;
+}
+
+// the memo chunk is serialized by the active job or a queued one
+bool StorageEnvironment::IsSerializing(StorageMemoChunk* memoChunk)
+{
+    Job*    job;
+
+    for (job = serializeChunkJobs.First(); job != NULL; job = serializeChunkJobs.Next(job))
+    {
+        if (((StorageSerializeChunkJob*) job)->memoChunk == memoChunk)
+            return true;
+    }
+
+    return false;
+}
+
 unsigned StorageEnvironment::GetNumShards(StorageChunk* chunk)
 {
     unsigned        count;
@@ -9,20 +9,24 @@
 #include "System/Events/Countdown.h"
 #include "System/Threading/ThreadPool.h"
 #include "System/Threading/JobProcessor.h"
+#include "System/IO/IOUring.h"
 #include "StorageConfig.h"
 #include "StorageLogSegment.h"
 #include "StorageMemoChunk.h"
 #include "StorageFileChunk.h"
 #include "StorageShard.h"
+#include "StorageShardIndex.h"
 #include "StorageCommitJob.h"
 #include "StorageBulkCursor.h"
 #include "StorageAsyncBulkCursor.h"
+#include "StorageAsyncGet.h"
 #include "StorageLogManager.h"
 
 class StorageRecovery;
 class StorageEnvironmentWriter;
 class StorageArchiveLogSegmentJob;
 class StorageAsyncList;
+class StorageAsyncMemoGet;
 class StorageSerializeChunkJob;
 class StorageWriteChunkJob;
 class StorageMergeChunkJob;
@@ -39,8 +43,14 @@ class StorageArchiveLogSegmentJob;
 #define STORAGE_WRITE_GRANULARITY                   (64*KiB)
 #endif
 
+// the linked requests of a commit round must fit in the ring, larger rounds are
+// written with system calls
+#define STORAGE_COMMIT_RING_ENTRIES                 1024
+
 #define STORAGE_DEFAULT_MERGE_CPU_THRESHOLD         (50)
 
+#define STORAGE_COMMIT_LATENCY_BUCKETS              10
+
 struct ShardSize;
 
 /*
@@ -61,9 +71,11 @@ class StorageEnvironment
     friend class StorageArchiveLogSegmentJob;
     friend class StorageBulkCursor;
     friend class StorageAsyncBulkCursor;
+    friend class StorageAsyncGet;
     
     typedef InList<StorageShard> ShardList;
     typedef InList<StorageFileChunk> FileChunkList;
+    typedef InList<StorageAsyncGet> AsyncGetList;
     typedef StorageLogManager LogManager;
     typedef LogManager::Track Track;
     typedef List<Track> TrackList;
@@ -75,6 +87,8 @@ public:
     void                    Close();
 
     static void             Sync(FD fd);
+    // returns NULL unless io.uring is set and supported
+    IOUring*                GetCommitRing();
 
     void                    SetMergeEnabled(bool mergeEnabled);
     void                    SetMergeCpuThreshold(uint32_t mergeCpuThreshold);
@@ -105,6 +119,21 @@ public:
     void                    AsyncGet(uint16_t contextID, uint64_t shardID, StorageAsyncGet* asyncGet);
     void                    AsyncList(uint16_t contextID, uint64_t shardID, StorageAsyncList* asyncList);
 
+    // reads of the memo chunks on the async threads, see StorageMemoChunk
+    bool                    IsConcurrentMemoReadable(StorageShard* shard);
+    bool                    AddAsyncMemoGet(uint16_t contextID, uint64_t shardID, ReadBuffer& key,
+                             StorageAsyncMemoGet* asyncMemoGet);
+    void                    AsyncMemoGet(StorageAsyncMemoGet* asyncMemoGet);
+    void                    ReleaseMemoChunk(StorageMemoChunk* memoChunk);
+
+    // file chunks copied byte-for-byte from another node, the copy is written to the
+    // filename of a new chunkID and then added to the shard with ImportFileChunk()
+    void                    GetWrittenFileChunkIDs(uint16_t contextID, uint64_t shardID,
+                             List<uint64_t>& chunkIDs);
+    uint64_t                NextChunkID();
+    void                    GetChunkFilename(uint64_t chunkID, Buffer& filename);
+    bool                    ImportFileChunk(uint16_t contextID, uint64_t shardID, uint64_t chunkID);
+
     StorageBulkCursor*      GetBulkCursor(uint16_t contextID, uint64_t shardID);
     StorageAsyncBulkCursor* GetAsyncBulkCursor(uint16_t contextID, uint64_t shardID, Callable onResult);
     void                    DecreaseNumCursors();
@@ -137,6 +166,8 @@ public:
     StorageConfig&          GetConfig();
     
     void                    OnCommit(StorageCommitJob* job);
+    void                    TryGroupCommit();
+    void                    OnGroupCommitTimer();
     void                    TryFinalizeLogSegments();
     void                    TrySerializeChunks();
     void                    TryWriteChunks();
@@ -159,6 +190,8 @@ public:
     StorageFileChunk*       GetFileChunk(uint64_t chunkID);
     void                    EnqueueAsyncGet(StorageAsyncGet* asyncGet);
     void                    OnChunkSerialized(StorageMemoChunk* memoChunk, StorageFileChunk* fileChunk);
+    bool                    DeferMemoChunkDelete(StorageMemoChunk* memoChunk);
+    bool                    IsSerializing(StorageMemoChunk* memoChunk);
     unsigned                GetNumShards(StorageChunk* chunk);
     StorageShard*           GetFirstShard(StorageChunk* chunk);
     void                    ConstructShardSizes(InSortedList<ShardSize>& shardSizes);
@@ -174,14 +207,21 @@ public:
 
 private:
     ShardList               shards;
+    StorageShardIndex       shardIndex;
     FileChunkList           fileChunks;
     StorageConfig           config;
     LogManager              logManager;
 
     Countdown               backgroundTimer;
     Callable                onBackgroundTimer;
+    Countdown               groupCommitTimer;
+    Callable                onGroupCommitTimer;
 
     JobProcessor            commitJobs;
+    IOUring                 commitRing;         // only used on the commit job thread
+    StorageCommitJob*       pendingCommits;     // the group waiting for the running commit
+    uint64_t                pendingCommitSize;
+    bool                    deferGroupCommit;
     JobProcessor            serializeChunkJobs;
     JobProcessor            writeChunkJobs;
     JobProcessor            mergeChunkJobs;
@@ -189,6 +229,7 @@ private:
     JobProcessor            deleteChunkJobs;
     ThreadPool*             asyncListThread;
     ThreadPool*             asyncGetThread;
+    AsyncGetList            asyncGetLoads;
 
     uint64_t                nextChunkID;
     int                     mergeEnabledCounter; // enabled if > 0
@@ -201,6 +242,9 @@ private:
     bool                    dumpMemoChunks;
     uint64_t*               numWriteToc100;
     uint64_t*               numWriteToc1000;
+    uint64_t*               numCommits;
+    uint64_t*               numGroupCommits;
+    uint64_t*               commitLatency[STORAGE_COMMIT_LATENCY_BUCKETS];
 };
 
 #endif
@@ -4,6 +4,17 @@
 #include "StoragePageCache.h"
 #include "StorageEnvironment.h"
 #include "StorageAsyncGet.h"
+#include "FDGuard.h"
+
+// bulk reads of a mapped chunk ask the kernel to read ahead this much
+#define STORAGE_MAPPED_READAHEAD    (1*MiB)
+
+static bool mapChunks = false;
+
+void StorageFileChunk::SetMapChunks(bool mapChunks_)
+{
+    mapChunks = mapChunks_;
+}
 
 StorageFileChunk::StorageFileChunk()
 {
@@ -29,6 +40,9 @@ void StorageFileChunk::Init()
     useCache = true;
     deleted = false;
     fd = INVALID_FD;
+    mappedFile = NULL;
+    mappedSize = 0;
+    mapFailed = false;
 }
 
 void StorageFileChunk::Close()
@@ -51,6 +65,9 @@ void StorageFileChunk::Close()
     
     delete indexPage;
     delete bloomPage;
+
+    // pages may reference the mapping, so it is released last
+    FS_UnmapFile(mappedFile, mappedSize);
 }
 
 void StorageFileChunk::ReadHeaderPage()
@@ -90,6 +107,51 @@ void StorageFileChunk::ReadHeaderPage()
         LoadBloomPage();
 }
 
+bool StorageFileChunk::RewriteHeaderPage(uint64_t chunkID, uint64_t logSegmentID,
+ uint32_t logCommandID)
+{
+    StorageHeaderPage   page;
+    Buffer              buffer;
+    FDGuard             fdGuard;
+    int64_t             size;
+
+    if (fdGuard.Open(filename.GetBuffer(), FS_READWRITE) == INVALID_FD)
+        return false;
+
+    size = FS_FileSize(fdGuard.GetFD());
+    if (size < STORAGE_HEADER_PAGE_SIZE)
+        return false;
+
+    buffer.Allocate(STORAGE_HEADER_PAGE_SIZE);
+    if (FS_FileReadOffs(fdGuard.GetFD(), buffer.GetBuffer(), STORAGE_HEADER_PAGE_SIZE, 0) !=
+     STORAGE_HEADER_PAGE_SIZE)
+        return false;
+    buffer.SetLength(STORAGE_HEADER_PAGE_SIZE);
+    if (!page.Read(buffer))
+        return false;
+
+    // the copy must be complete
+    if (page.GetIndexPageOffset() + page.GetIndexPageSize() > (uint64_t) size)
+        return false;
+    if (page.UseBloomFilter() && page.GetBloomPageOffset() + page.GetBloomPageSize() > (uint64_t) size)
+        return false;
+
+    page.SetChunkID(chunkID);
+    page.SetMinLogSegmentID(logSegmentID);
+    page.SetMaxLogSegmentID(logSegmentID);
+    page.SetMaxLogCommandID(logCommandID);
+
+    buffer.Clear();
+    page.Write(buffer);
+    if (FS_FileWriteOffs(fdGuard.GetFD(), buffer.GetBuffer(), buffer.GetLength(), 0) !=
+     (ssize_t) buffer.GetLength())
+        return false;
+
+    StorageEnvironment::Sync(fdGuard.GetFD());
+
+    return true;
+}
+
 void StorageFileChunk::SetFilename(ReadBuffer filename_)
 {
     filename.Write(filename_);
@@ -217,8 +279,7 @@ StorageKeyValue* StorageFileChunk::Get(ReadBuffer& key)
     
     if (dataPages[index] == NULL)
         LoadDataPage(index, offset); // evicted, load back
-
-    if (dataPages[index]->IsCached())
+    else if (dataPages[index]->IsCached())
         StoragePageCache::RegisterDataHit(dataPages[index]);
     return dataPages[index]->Get(key);
 }
@@ -237,7 +298,7 @@ void StorageFileChunk::AsyncGet(StorageAsyncGet* asyncGet)
         if (bloomPage == NULL)
         {
             asyncGet->stage = StorageAsyncGet::BLOOM_PAGE;
-            asyncGet->threadPool->Execute(MFUNC_OF(StorageAsyncGet, AsyncLoadPage, asyncGet)); // evicted, load back
+            asyncGet->LoadPage(); // evicted, load back
             return;
         }
         if (bloomPage->IsCached())
@@ -252,7 +313,7 @@ void StorageFileChunk::AsyncGet(StorageAsyncGet* asyncGet)
     if (indexPage == NULL)
     {
         asyncGet->stage = StorageAsyncGet::INDEX_PAGE;
-        asyncGet->threadPool->Execute(MFUNC_OF(StorageAsyncGet, AsyncLoadPage, asyncGet)); // evicted, load back
+        asyncGet->LoadPage(); // evicted, load back
         return;
     }
     if (indexPage->IsCached())
@@ -268,11 +329,13 @@ void StorageFileChunk::AsyncGet(StorageAsyncGet* asyncGet)
         asyncGet->stage = StorageAsyncGet::DATA_PAGE;
         asyncGet->index = index;
         asyncGet->offset = offset;
-        asyncGet->threadPool->Execute(MFUNC_OF(StorageAsyncGet, AsyncLoadPage, asyncGet)); // evicted, load back
+        asyncGet->LoadPage(); // evicted, load back
         return;
     }
 
-    if (dataPages[index]->IsCached())
+    if (dataPages[index] == asyncGet->loadedDataPage)
+        asyncGet->loadedDataPage = NULL; // loaded by this get, not a hit
+    else if (dataPages[index]->IsCached())
         StoragePageCache::RegisterDataHit(dataPages[index]);
 
     kv = dataPages[index]->Get(asyncGet->key);
@@ -487,6 +550,7 @@ void StorageFileChunk::LoadBloomPage()
     }
     
     bloomPage = new StorageBloomPage(this);
+    bloomPage->SetVersion(headerPage.GetBloomFilterVersion());
     offset = headerPage.GetBloomPageOffset();
     bloomPage->SetOffset(offset);
     if (!ReadPage(offset, buffer))
@@ -512,6 +576,7 @@ void StorageFileChunk::LoadBloomPage()
 void StorageFileChunk::LoadIndexPage()
 {
     Buffer      buffer;
+    ReadBuffer  page;
     uint64_t    offset;
 
     if (fd == INVALID_FD)
@@ -529,14 +594,25 @@ void StorageFileChunk::LoadIndexPage()
     indexPage = new StorageIndexPage(this);
     offset = headerPage.GetIndexPageOffset();
     indexPage->SetOffset(offset);
-    if (!ReadPage(offset, buffer))
+    if (MapFile() && GetMappedPage(offset, page))
+    {
+        if (!indexPage->ReadMapped(page))
+        {
+            Log_Message("Unable to parse mapped index page of %s at offset %U with size %u",
+             filename.GetBuffer(), offset, page.GetLength());
+            Log_Message("This should not happen.");
+            Log_Message("Possible causes: software bug, damaged file, corrupted file...");
+            STOP_FAIL(1);
+        }
+    }
+    else if (!ReadPage(offset, buffer))
     {
         Log_Message("Unable to read index page from %s at offset %U", filename.GetBuffer(), offset);
         Log_Message("This should not happen.");
         Log_Message("Possible causes: software bug, damaged file, corrupted file...");
         STOP_FAIL(1);
     }
-    if (!indexPage->Read(buffer))
+    else if (!indexPage->Read(buffer))
     {
         Log_Message("Unable to parse index page read from %s at offset %U with size %u",
          filename.GetBuffer(), offset, buffer.GetLength());
@@ -554,8 +630,9 @@ void StorageFileChunk::LoadIndexPage()
 
 void StorageFileChunk::LoadDataPage(uint32_t index, uint64_t offset, bool bulk, bool keysOnly, StorageDataPage* dataPage)
 {
-    Buffer  buffer;
-    char    mem[STORAGE_DEFAULT_DATA_PAGE_SIZE];
+    Buffer      buffer;
+    ReadBuffer  page;
+    char        mem[STORAGE_DEFAULT_DATA_PAGE_SIZE];
 
     if (useCache)
         ASSERT(dataPage == NULL);
@@ -573,6 +650,30 @@ void StorageFileChunk::LoadDataPage(uint32_t index, uint64_t offset, bool bulk,
         return;
     }
 
+    // uncompressed pages of mapped chunks are not copied
+    if (dataPage == NULL && headerPage.GetCompression() == STORAGE_COMPRESSION_NONE &&
+     MapFile() && GetMappedPage(offset, page))
+    {
+        if (bulk)
+            FS_AdviseMapping(mappedFile + offset, MIN(STORAGE_MAPPED_READAHEAD, mappedSize - offset),
+             FS_ADVICE_WILLNEED);
+
+        dataPages[index] = new StorageDataPage(this, index);
+        dataPages[index]->SetOffset(offset);
+        if (!dataPages[index]->ReadMapped(page, keysOnly))
+        {
+            Log_Message("Unable to parse mapped data page of %s at offset %U with size %u",
+             filename.GetBuffer(), offset, page.GetLength());
+            Log_Message("This should not happen.");
+            Log_Message("Possible causes: software bug, damaged file, corrupted file...");
+            STOP_FAIL(1);
+        }
+
+        if (useCache)
+            StoragePageCache::AddDataPage(dataPages[index], bulk);
+        return;
+    }
+
     // use stack memory for buffer to read
     buffer.SetPreallocated(mem, sizeof(mem));
     if (dataPage == NULL)
@@ -585,6 +686,11 @@ void StorageFileChunk::LoadDataPage(uint32_t index, uint64_t offset, bool bulk,
         dataPages[index] = dataPage;
     }
 
+    // compressed pages cannot be read partially
+    if (headerPage.GetCompression() != STORAGE_COMPRESSION_NONE)
+        keysOnly = false;
+
+    dataPages[index]->SetCompression(headerPage.GetCompression());
     dataPages[index]->SetOffset(offset);
     if (!ReadPage(offset, buffer, keysOnly))
     {
@@ -625,6 +731,7 @@ StoragePage* StorageFileChunk::AsyncLoadBloomPage()
         OpenForReading();
     
     page = new StorageBloomPage(NULL);
+    page->SetVersion(headerPage.GetBloomFilterVersion());
     offset = headerPage.GetBloomPageOffset();
     page->SetOffset(offset);
     if (!ReadPage(offset, buffer))
@@ -700,6 +807,7 @@ StoragePage* StorageFileChunk::AsyncLoadDataPage(uint32_t index, uint64_t offset
         OpenForReading();
     
     page = new StorageDataPage(NULL, index);
+    page->SetCompression(headerPage.GetCompression());
     page->SetOffset(offset);
     if (!ReadPage(offset, buffer))
     {
@@ -836,8 +944,23 @@ bool StorageFileChunk::ReadPage(uint64_t offset, Buffer& buffer, bool keysOnly)
 {
     uint32_t    size, keysSize, rest;
     ssize_t     nread;
-    ReadBuffer  parse;
+    ReadBuffer  parse, keysPart;
     
+    // pages of mapped chunks are copied without a system call
+    if (mappedFile != NULL && GetMappedPage(offset, parse))
+    {
+        if (keysOnly)
+        {
+            // read only keys
+            keysPart = parse;
+            keysPart.Advance(8);
+            if (keysPart.ReadLittle32(keysSize) && 16 + keysSize < parse.GetLength())
+                parse.SetLength(16 + keysSize);
+        }
+        buffer.Write(parse);
+        return true;
+    }
+
     size = STORAGE_DEFAULT_PAGE_GRAN;
     buffer.Allocate(size);
     if ((nread = FS_FileReadOffs(fd, buffer.GetBuffer(), size, offset)) != (ssize_t) size)
@@ -893,3 +1016,50 @@ bool StorageFileChunk::ReadPage(uint64_t offset, Buffer& buffer, bool keysOnly)
     
     return true;
 }
+
+bool StorageFileChunk::MapFile()
+{
+    int64_t     size;
+
+    if (mappedFile != NULL)
+        return true;
+    
+    // only immutable chunks owned by the environment are mapped
+    if (!mapChunks || !useCache || !written || mapFailed)
+        return false;
+
+    if (fd == INVALID_FD && !OpenForReading())
+        return false;
+
+    size = FS_FileSize(fd);
+    if (size > 0)
+        mappedFile = FS_MapFile(fd, size);
+    if (mappedFile == NULL)
+    {
+        Log_Message("Unable to map chunk file %s, falling back to reads", filename.GetBuffer());
+        mapFailed = true;
+        return false;
+    }
+    mappedSize = size;
+
+    // point reads should not trigger the kernel's readahead
+    FS_AdviseMapping(mappedFile, mappedSize, FS_ADVICE_RANDOM);
+
+    return true;
+}
+
+bool StorageFileChunk::GetMappedPage(uint64_t offset, ReadBuffer& page)
+{
+    uint32_t    size;
+    
+    if (offset >= mappedSize)
+        return false;
+
+    // first 4 bytes on all pages is the page size
+    page.Wrap(mappedFile + offset, mappedSize - offset);
+    if (!page.ReadLittle32(size) || size < 4 || size > page.GetLength())
+        return false;
+
+    page.SetLength(size);
+    return true;
+}
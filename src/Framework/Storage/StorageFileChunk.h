@@ -21,6 +21,9 @@ class StorageAsyncGet;
 class StorageFileChunk : public StorageChunk
 {
 public:
+    // written chunks are mapped into memory and their pages reference the mapping
+    static void         SetMapChunks(bool mapChunks);
+
     StorageFileChunk();
     ~StorageFileChunk();
 
@@ -28,6 +31,9 @@ public:
     void                Close();
 
     void                ReadHeaderPage();
+    // for chunk files copied from another node, replaces the chunkID and the log position
+    bool                RewriteHeaderPage(uint64_t chunkID, uint64_t logSegmentID,
+                         uint32_t logCommandID);
 
     void                SetFilename(ReadBuffer filename);
     void                SetFilename(Buffer& chunkPath, uint64_t chunkID);
@@ -105,9 +111,14 @@ private:
     void                AllocateDataPageArray();
     void                ExtendDataPageArray();
     bool                ReadPage(uint64_t offset, Buffer& buffer, bool keysOnly = false);
+    bool                MapFile();
+    bool                GetMappedPage(uint64_t offset, ReadBuffer& page);
 
     Buffer              filename;
     FD                  fd;
+    char*               mappedFile;
+    uint64_t            mappedSize;
+    bool                mapFailed;
 };
 
 #endif
@@ -15,6 +15,8 @@ StorageHeaderPage::StorageHeaderPage()
     bloomPageOffset = 0;
     bloomPageSize = 0;
     merged = false;
+    compression = STORAGE_COMPRESSION_NONE;
+    bloomFilterVersion = BLOOMFILTER_VERSION;
 }
 
 uint32_t StorageHeaderPage::GetSize()
@@ -92,6 +94,16 @@ bool StorageHeaderPage::IsMerged()
     return merged;
 }
 
+char StorageHeaderPage::GetCompression()
+{
+    return compression;
+}
+
+unsigned StorageHeaderPage::GetBloomFilterVersion()
+{
+    return bloomFilterVersion;
+}
+
 void StorageHeaderPage::SetChunkID(uint64_t chunkID_)
 {
     chunkID = chunkID_;
@@ -162,6 +174,16 @@ void StorageHeaderPage::SetMerged(bool merged_)
     merged = merged_;
 }
 
+void StorageHeaderPage::SetCompression(char compression_)
+{
+    compression = compression_;
+}
+
+void StorageHeaderPage::SetBloomFilterVersion(unsigned bloomFilterVersion_)
+{
+    bloomFilterVersion = bloomFilterVersion_;
+}
+
 bool StorageHeaderPage::UseBloomFilter()
 {
     return useBloomFilter;
@@ -194,7 +216,8 @@ bool StorageHeaderPage::Read(Buffer& buffer)
 
     if (!parse.ReadLittle32(version))
         return false;
-    if (version != STORAGE_HEADER_PAGE_VERSION)
+    if (version != STORAGE_HEADER_PAGE_VERSION && version != STORAGE_HEADER_PAGE_VERSION_2 &&
+     version != STORAGE_HEADER_PAGE_VERSION_1)
         return false;
     parse.Advance(4);
 
@@ -241,6 +264,21 @@ bool StorageHeaderPage::Read(Buffer& buffer)
             return false;
         parse.Advance(4);
     }
+
+    if (version >= STORAGE_HEADER_PAGE_VERSION)
+        bloomFilterVersion = BLOOMFILTER_VERSION;
+    else
+        bloomFilterVersion = BLOOMFILTER_VERSION_1;
+
+    compression = STORAGE_COMPRESSION_NONE;
+    if (version >= STORAGE_HEADER_PAGE_VERSION_2)
+    {
+        if (!parse.ReadChar(compression))
+            return false;
+        if (compression != STORAGE_COMPRESSION_NONE && compression != STORAGE_COMPRESSION_LZ)
+            return false;
+        parse.Advance(1);
+    }
     
     if (!parse.ReadLittle32(firstLen))
         return false;
@@ -283,9 +321,17 @@ TooLongKey:
 void StorageHeaderPage::Write(Buffer& writeBuffer)
 {
     uint32_t    checksum;
+    uint32_t    version;
     Buffer      text;
     ReadBuffer  dataPart;
 
+    if (useBloomFilter && bloomFilterVersion >= BLOOMFILTER_VERSION)
+        version = STORAGE_HEADER_PAGE_VERSION;
+    else if (compression != STORAGE_COMPRESSION_NONE)
+        version = STORAGE_HEADER_PAGE_VERSION_2;
+    else
+        version = STORAGE_HEADER_PAGE_VERSION_1;
+
     text.Allocate(64);
     text.Zero();
     text.Write("ScalienDB Chunk File");
@@ -297,7 +343,7 @@ void StorageHeaderPage::Write(Buffer& writeBuffer)
 
     writeBuffer.AppendLittle32(STORAGE_HEADER_PAGE_SIZE);
     writeBuffer.AppendLittle32(0); // dummy for checksum
-    writeBuffer.AppendLittle32(STORAGE_HEADER_PAGE_VERSION);
+    writeBuffer.AppendLittle32(version);
     writeBuffer.Append(text);
     writeBuffer.AppendLittle64(chunkID);
     writeBuffer.AppendLittle64(minLogSegmentID);
@@ -312,6 +358,8 @@ void StorageHeaderPage::Write(Buffer& writeBuffer)
         writeBuffer.AppendLittle64(bloomPageOffset);
         writeBuffer.AppendLittle32(bloomPageSize);
     }
+    if (version >= STORAGE_HEADER_PAGE_VERSION_2)
+        writeBuffer.Append(compression);
 
     if (firstKey.GetLength() > MAX_KEY_LEN)
         firstKey.SetLength(MAX_KEY_LEN);
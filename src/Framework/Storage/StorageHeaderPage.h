@@ -3,8 +3,14 @@
 
 #include "System/Buffers/Buffer.h"
 #include "StoragePage.h"
+#include "BloomFilter.h"
 
-#define STORAGE_HEADER_PAGE_VERSION     1
+// version 2 adds the data page compression codec,
+// version 3 has the same fields, but its bloom page is a blocked BLOOMFILTER_VERSION filter,
+// chunks are written with the lowest version that describes them
+#define STORAGE_HEADER_PAGE_VERSION     3
+#define STORAGE_HEADER_PAGE_VERSION_2   2
+#define STORAGE_HEADER_PAGE_VERSION_1   1
 #define STORAGE_HEADER_PAGE_SIZE        STORAGE_DEFAULT_PAGE_GRAN
 
 class StorageFileChunk;
@@ -38,6 +44,8 @@ public:
     ReadBuffer          GetLastKey();
     ReadBuffer          GetMidpoint();
     bool                IsMerged();
+    char                GetCompression();
+    unsigned            GetBloomFilterVersion();
 
     void                SetChunkID(uint64_t chunkID);
     void                SetMinLogSegmentID(uint64_t logSegmentID);
@@ -53,6 +61,8 @@ public:
     void                SetLastKey(ReadBuffer lastKey);
     void                SetMidpoint(ReadBuffer midPoint);
     void                SetMerged(bool merged);
+    void                SetCompression(char compression);
+    void                SetBloomFilterVersion(unsigned bloomFilterVersion);
 
     bool                UseBloomFilter();
 
@@ -72,10 +82,12 @@ private:
     uint32_t            indexPageSize;
     uint64_t            bloomPageOffset;
     uint32_t            bloomPageSize;
+    unsigned            bloomFilterVersion;
     Buffer              firstKey;
     Buffer              lastKey;
     Buffer              midpoint;
     bool                merged;
+    char                compression;
 };
 
 #endif
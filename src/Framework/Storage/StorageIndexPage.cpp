@@ -45,6 +45,9 @@ uint32_t StorageIndexPage::GetSize()
 
 uint32_t StorageIndexPage::GetMemorySize()
 {
+    if (mappedBuffer.GetLength() > 0)
+        return indexTree.GetCount() * sizeof(StorageIndexRecord);
+
     return size + indexTree.GetCount() * sizeof(StorageIndexRecord);
 }
 
@@ -230,6 +233,30 @@ void StorageIndexPage::Finalize()
 }
 
 bool StorageIndexPage::Read(Buffer& buffer_)
+{
+    ASSERT(indexTree.GetCount() == 0);
+    
+    buffer.Write(buffer_);
+    return Parse(ReadBuffer(buffer));
+}
+
+bool StorageIndexPage::ReadMapped(ReadBuffer mapped)
+{
+    ASSERT(indexTree.GetCount() == 0);
+
+    // keys point into the mapped chunk file
+    buffer.Reset();
+    mappedBuffer = mapped;
+    if (!Parse(mapped))
+    {
+        mappedBuffer.Reset();
+        return false;
+    }
+
+    return true;
+}
+
+bool StorageIndexPage::Parse(ReadBuffer data)
 {
     uint16_t                klen;
     uint32_t                size, checksum, compChecksum, numKeys, i;
@@ -237,16 +264,13 @@ bool StorageIndexPage::Read(Buffer& buffer_)
     ReadBuffer              dataPart, parse, key;
     StorageIndexRecord*     it;
     
-    ASSERT(indexTree.GetCount() == 0);
-    
-    buffer.Write(buffer_);
-    parse.Wrap(buffer);
+    parse = data;
     
     // size
     parse.ReadLittle32(size);
     if (size < STORAGE_INDEXPAGE_HEADER_SIZE)
         goto Fail;
-    if (buffer.GetLength() != size)
+    if (data.GetLength() != size)
         goto Fail;
     parse.Advance(4);
 
@@ -254,7 +278,7 @@ bool StorageIndexPage::Read(Buffer& buffer_)
     if (false)  // TODO: make it switchable
     {
         parse.ReadLittle32(checksum);
-        dataPart.Wrap(buffer.GetBuffer() + 8, buffer.GetLength() - 8);
+        dataPart.Wrap(data.GetBuffer() + 8, data.GetLength() - 8);
         compChecksum = dataPart.GetChecksum();
         if (compChecksum != checksum)
             goto Fail;
@@ -305,12 +329,16 @@ Fail:
 
 void StorageIndexPage::Write(Buffer& buffer_)
 {
-    buffer_.Write(buffer);
+    if (mappedBuffer.GetLength() > 0)
+        buffer_.Write(mappedBuffer);
+    else
+        buffer_.Write(buffer);
 }
 
 void StorageIndexPage::Unload()
 {
     indexTree.DeleteTree();
+    mappedBuffer.Reset();
     buffer.Reset();
     owner->OnIndexPageEvicted();
 }
@@ -63,13 +63,18 @@ public:
     void                Finalize();
 
     bool                Read(Buffer& buffer);
+    // zero-copy read, the keys reference the mapped memory
+    bool                ReadMapped(ReadBuffer mapped);
     void                Write(Buffer& buffer);
 
     void                Unload();
 
 private:
+    bool                Parse(ReadBuffer data);
+
     uint32_t            size;
     Buffer              buffer;
+    ReadBuffer          mappedBuffer;
     IndexRecordTree     indexTree;
     ReadBuffer          midpoint;
     StorageFileChunk*   owner;
@@ -191,35 +191,25 @@ void StorageLogSegment::Undo()
 
 void StorageLogSegment::Commit()
 {
-    uint32_t    checksum;
+    if (WriteRound())
+        SyncRound();
+}
+
+bool StorageLogSegment::WriteRound()
+{
     uint64_t    length;
     uint64_t    writeSize;
     uint64_t    writeOffset;
     ssize_t     ret;
-    Stopwatch   sw;
     char        humanBuf[5];
-    char        humanBuf2[5];
-
-    commitStatus = true;
 
-    ASSERT(fd != INVALID_FD);
+    if (!PrepareRound())
+        return false; // empty round
 
     length = writeBuffer.GetLength();
 
-    ASSERT(length >= STORAGE_LOGSEGMENT_BLOCK_HEAD_SIZE);
-    
-    if (length == STORAGE_LOGSEGMENT_BLOCK_HEAD_SIZE)
-        return; // empty round
-
-    checksum = 0;
-
-    writeBuffer.SetLength(0);
-    writeBuffer.AppendLittle64(length);
-    writeBuffer.AppendLittle64(length - STORAGE_LOGSEGMENT_BLOCK_HEAD_SIZE);
-    writeBuffer.AppendLittle32(checksum);
-    writeBuffer.SetLength(length);
-    
-    sw.Start();
+    commitStopwatch.Reset();
+    commitStopwatch.Start();
     for (writeOffset = 0; writeOffset < length; writeOffset += writeSize)
     {
         writeSize = MIN(STORAGE_WRITE_GRANULARITY, length - writeOffset);
@@ -241,14 +231,134 @@ void StorageLogSegment::Commit()
     }
 
     offset += length;
+    commitStopwatch.Stop();
+
+    return true;
+}
 
+bool StorageLogSegment::QueueRound(IOUring* ring)
+{
+    uint64_t    length;
+    uint64_t    writeSize;
+    uint64_t    writeOffset;
+    uint64_t    syncOffset;
+    unsigned    numEntries;
+
+    ASSERT(fd != INVALID_FD);
+
+    length = writeBuffer.GetLength();
+    if (length == STORAGE_LOGSEGMENT_BLOCK_HEAD_SIZE)
+        return false; // empty round
+
+    // the writes and syncs of the round are linked, so the chain must be submitted at once
+    numEntries = 1;
+    syncOffset = lastSyncOffset;
+    for (writeOffset = 0; writeOffset < length; writeOffset += writeSize)
+    {
+        writeSize = MIN(STORAGE_WRITE_GRANULARITY, length - writeOffset);
+        numEntries++;
+        if (syncGranularity > 0 && writeOffset - syncOffset > syncGranularity)
+        {
+            numEntries++;
+            syncOffset = writeOffset;
+        }
+    }
+
+    if (numEntries > ring->GetNumFree())
+    {
+        ring->Submit();
+        if (numEntries > ring->GetNumFree())
+            return false;
+    }
+
+    PrepareRound();
+
+    commitStopwatch.Reset();
+    commitStopwatch.Start();
+    for (writeOffset = 0; writeOffset < length; writeOffset += writeSize)
+    {
+        writeSize = MIN(STORAGE_WRITE_GRANULARITY, length - writeOffset);
+        ring->Write(fd, writeBuffer.GetBuffer() + writeOffset, (unsigned) writeSize, 0, true);
+        if (syncGranularity > 0 && writeOffset - lastSyncOffset > syncGranularity)
+        {
+            ring->Sync(fd, 0, true);
+            lastSyncOffset = writeOffset;
+        }
+    }
+    // the completion of the last sync finishes the round
+    ring->Sync(fd, (uint64_t) (uintptr_t) this, false);
+
+    offset += length;
+
+    return true;
+}
+
+void StorageLogSegment::OnQueuedRound(int result)
+{
+    char        humanBuf[5];
+
+    commitStopwatch.Stop();
+
+    if (result < 0)
+    {
+        Log_Message("Unable to write log segment file %U to disk.", logSegmentID);
+        Log_Message("Error: %s", strerror(-result));
+        Log_Message("Free disk space: %s", HumanBytes(FS_FreeDiskSpace(filename.GetBuffer()), humanBuf));
+        Log_Message("This should not happen.");
+        Log_Message("Possible causes: not enough disk space, software bug...");
+        STOP_FAIL(1);
+    }
+
+    FinishRound();
+}
+
+void StorageLogSegment::SyncRound()
+{
+    commitStopwatch.Start();
     StorageEnvironment::Sync(fd);
+    commitStopwatch.Stop();
 
-    sw.Stop();
+    FinishRound();
+}
+
+bool StorageLogSegment::PrepareRound()
+{
+    uint32_t    checksum;
+    uint64_t    length;
+
+    commitStatus = true;
+
+    ASSERT(fd != INVALID_FD);
+
+    length = writeBuffer.GetLength();
+
+    ASSERT(length >= STORAGE_LOGSEGMENT_BLOCK_HEAD_SIZE);
+    
+    if (length == STORAGE_LOGSEGMENT_BLOCK_HEAD_SIZE)
+        return false;
+
+    checksum = 0;
+
+    writeBuffer.SetLength(0);
+    writeBuffer.AppendLittle64(length);
+    writeBuffer.AppendLittle64(length - STORAGE_LOGSEGMENT_BLOCK_HEAD_SIZE);
+    writeBuffer.AppendLittle32(checksum);
+    writeBuffer.SetLength(length);
+
+    return true;
+}
+
+void StorageLogSegment::FinishRound()
+{
+    uint64_t    length;
+    char        humanBuf[5];
+    char        humanBuf2[5];
+
+    length = writeBuffer.GetLength();
     Log_Debug("Committed track %U, elapsed: %U, size: %s, bps: %sB/s",
         trackID,
-        (uint64_t) sw.Elapsed(), HumanBytes(length, humanBuf),
-        HumanBytes(BYTE_PER_SEC(length, sw.Elapsed()), humanBuf2));
+        (uint64_t) commitStopwatch.Elapsed(), HumanBytes(length, humanBuf),
+        HumanBytes(BYTE_PER_SEC(length, commitStopwatch.Elapsed()), humanBuf2));
 
     NewRound();
     commitedLogCommandID = logCommandID - 1;
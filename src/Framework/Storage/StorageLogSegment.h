@@ -4,6 +4,8 @@
 #include "System/Buffers/Buffer.h"
 #include "System/Events/Callable.h"
 #include "System/IO/FD.h"
+#include "System/IO/IOUring.h"
+#include "System/Stopwatch.h"
 
 #define STORAGE_LOGSEGMENT_BLOCK_HEAD_SIZE      (8+8+4) // size + uncomressedLength + CRC
 #define STORAGE_LOGSEGMENT_COMMAND_SET          's'
@@ -50,6 +52,13 @@ public:
     void                Undo();
 
     void                Commit();
+    // Commit() in two steps, so that a group of segments can be written before syncing them
+    bool                WriteRound();
+    void                SyncRound();
+    // queues the writes and the sync of the round as linked requests instead,
+    // returns false if the round is empty or does not fit in the ring
+    bool                QueueRound(IOUring* ring);
+    void                OnQueuedRound(int result);
     bool                HasUncommitted();
     uint32_t            GetCommitedLogCommandID();
 
@@ -63,6 +72,8 @@ public:
 
 private:
     void                NewRound();
+    bool                PrepareRound();
+    void                FinishRound();
 
     FD                  fd;
     uint64_t            trackID;
@@ -77,6 +88,7 @@ private:
     Buffer              filename;
     Buffer              writeBuffer;
     Callable*           onCommit;
+    Stopwatch           commitStopwatch;
 
     bool                writeShardID;
     uint16_t            prevContextID;
@@ -0,0 +1,779 @@
+#include "StorageMemoBTree.h"
+#include "System/Threading/Atomic.h"
+
+// 8 bytes of the key after skip bytes in big-endian order, shorter keys are padded with
+// zeros, so different prefixes order the same way as the keys
+static inline uint64_t KeyPrefix(const ReadBuffer& key, unsigned skip)
+{
+    uint64_t        prefix;
+    unsigned        i;
+    unsigned        length;
+    const char*     buffer;
+
+    prefix = 0;
+    if (key.GetLength() <= skip)
+        return prefix;
+    buffer = key.GetBuffer() + skip;
+    length = MIN(key.GetLength() - skip, sizeof(uint64_t));
+    for (i = 0; i < length; i++)
+        prefix |= (uint64_t)(unsigned char) buffer[i] << (56 - 8 * i);
+
+    return prefix;
+}
+
+static inline int KeyCmp(uint64_t prefix, const ReadBuffer& key, uint64_t otherPrefix,
+ const StorageMemoKeyValue* other)
+{
+    if (prefix < otherPrefix)
+        return -1;
+    if (prefix > otherPrefix)
+        return 1;
+
+    return ReadBuffer::Cmp(key, other->GetKey());
+}
+
+// reads a field of a node which the main thread may be writing
+template<typename T>
+static inline T ReadOnce(T& field)
+{
+    return *(volatile T*) &field;
+}
+
+template<typename T>
+static inline unsigned ReadNum(T* node)
+{
+    return MIN(ReadOnce(node->num), (unsigned) STORAGE_MEMO_BTREE_ORDER);
+}
+
+// moves the elements one by one, so concurrent readers never see a torn pointer
+template<typename T>
+static inline void ShiftRight(T* array, unsigned pos, unsigned num)
+{
+    unsigned    i;
+
+    for (i = num; i > pos; i--)
+        *(volatile T*) &array[i] = array[i - 1];
+}
+
+static unsigned CommonPrefixLength(const StorageMemoKeyValue* a, const StorageMemoKeyValue* b)
+{
+    ReadBuffer  keyA;
+    ReadBuffer  keyB;
+    unsigned    i;
+    unsigned    length;
+
+    if (a == NULL || b == NULL)
+        return 0;
+
+    keyA = a->GetKey();
+    keyB = b->GetKey();
+    length = MIN(keyA.GetLength(), keyB.GetLength());
+    for (i = 0; i < length; i++)
+    {
+        if (keyA.GetBuffer()[i] != keyB.GetBuffer()[i])
+            break;
+    }
+
+    return i;
+}
+
+StorageMemoBTree::StorageMemoBTree()
+{
+    root = NULL;
+    height = 0;
+    head = NULL;
+    tail = NULL;
+    count = 0;
+    memoryUsage = 0;
+}
+
+StorageMemoBTree::~StorageMemoBTree()
+{
+    Clear();
+}
+
+unsigned StorageMemoBTree::GetCount()
+{
+    return count;
+}
+
+uint64_t StorageMemoBTree::GetMemoryUsage()
+{
+    return memoryUsage;
+}
+
+StorageMemoKeyValue* StorageMemoBTree::First()
+{
+    if (head == NULL)
+        return NULL;
+
+    return head->keyValues[0];
+}
+
+StorageMemoKeyValue* StorageMemoBTree::Last()
+{
+    if (tail == NULL)
+        return NULL;
+
+    return tail->keyValues[tail->num - 1];
+}
+
+StorageMemoKeyValue* StorageMemoBTree::Mid()
+{
+    Node*       node;
+    unsigned    level;
+
+    if (root == NULL)
+        return NULL;
+
+    node = root;
+    for (level = 0; level < height; level++)
+        node = ((Inner*) node)->children[node->num / 2];
+
+    return node->keyValues[node->num / 2];
+}
+
+StorageMemoKeyValue* StorageMemoBTree::Next(StorageMemoKeyValue* kv)
+{
+    Leaf*       leaf;
+    unsigned    i;
+
+    leaf = (Leaf*) kv->GetIndexLeaf();
+    for (i = 0; i < leaf->num; i++)
+    {
+        if (leaf->keyValues[i] == kv)
+            break;
+    }
+    ASSERT(i < leaf->num);
+
+    if (i + 1 < leaf->num)
+        return leaf->keyValues[i + 1];
+    if (leaf->next == NULL)
+        return NULL;
+    return leaf->next->keyValues[0];
+}
+
+StorageMemoKeyValue* StorageMemoBTree::Prev(StorageMemoKeyValue* kv)
+{
+    Leaf*       leaf;
+    unsigned    i;
+
+    leaf = (Leaf*) kv->GetIndexLeaf();
+    for (i = 0; i < leaf->num; i++)
+    {
+        if (leaf->keyValues[i] == kv)
+            break;
+    }
+    ASSERT(i < leaf->num);
+
+    if (i > 0)
+        return leaf->keyValues[i - 1];
+    if (leaf->prev == NULL)
+        return NULL;
+    return leaf->prev->keyValues[leaf->prev->num - 1];
+}
+
+StorageMemoKeyValue* StorageMemoBTree::Get(const ReadBuffer& key)
+{
+    Leaf*       leaf;
+    unsigned    pos;
+    int         cmpres;
+
+    if (root == NULL)
+        return NULL;
+
+    leaf = FindLeaf(key);
+    pos = LowerBound(leaf, leaf->num, leaf->skip, key, cmpres);
+    if (pos < leaf->num && cmpres == 0)
+        return leaf->keyValues[pos];
+
+    return NULL;
+}
+
+StorageMemoKeyValue* StorageMemoBTree::Locate(const ReadBuffer& key, int& cmpres)
+{
+    Leaf*       leaf;
+    unsigned    pos;
+
+    // same as InTreeMap::Locate, returns the first key-value not less than the key
+    // with cmpres < 0, or the last one with cmpres > 0 if all keys are less
+    cmpres = 0;
+    if (root == NULL)
+        return NULL;
+
+    leaf = FindLeaf(key);
+    pos = LowerBound(leaf, leaf->num, leaf->skip, key, cmpres);
+    if (pos < leaf->num)
+    {
+        if (cmpres != 0)
+            cmpres = -1;
+        return leaf->keyValues[pos];
+    }
+
+    if (leaf->next != NULL)
+    {
+        cmpres = -1;
+        return leaf->next->keyValues[0];
+    }
+
+    cmpres = 1;
+    return leaf->keyValues[leaf->num - 1];
+}
+
+StorageMemoKeyValue* StorageMemoBTree::Insert(StorageMemoKeyValue* kv)
+{
+    StorageMemoKeyValue*    old;
+    Node*                   node;
+    Leaf*                   leaf;
+    Leaf*                   newLeaf;
+    ReadBuffer              key;
+    unsigned                level;
+    unsigned                pos;
+    int                     cmpres;
+
+    if (root == NULL)
+    {
+        root = head = tail = NewLeaf();
+        height = 0;
+    }
+
+    key = kv->GetKey();
+    node = root;
+    for (level = 0; level < height; level++)
+    {
+        path[level] = (Inner*) node;
+        pathIndex[level] = FindChild((Inner*) node, node->num, node->skip, key);
+        node = ((Inner*) node)->children[pathIndex[level]];
+    }
+    leaf = (Leaf*) node;
+
+    pos = LowerBound(leaf, leaf->num, leaf->skip, key, cmpres);
+    if (pos < leaf->num && cmpres == 0)
+    {
+        old = leaf->keyValues[pos];
+        leaf->keyValues[pos] = kv;
+        kv->SetIndexLeaf(leaf);
+        return old;
+    }
+
+    count++;
+    if (leaf->num < STORAGE_MEMO_BTREE_ORDER)
+    {
+        InsertAt(leaf, pos, kv);
+        kv->SetIndexLeaf(leaf);
+        return NULL;
+    }
+
+    newLeaf = SplitLeaf(leaf, pos);
+    if (newLeaf->num == 0)
+    {
+        // the key is the new last one of the tree
+        SetFences(newLeaf, 0, kv, NULL);
+        SetFences(leaf, 0, leaf->low, kv);
+    }
+    if (pos <= leaf->num && leaf->num < STORAGE_MEMO_BTREE_ORDER)
+    {
+        InsertAt(leaf, pos, kv);
+        kv->SetIndexLeaf(leaf);
+    }
+    else
+    {
+        InsertAt(newLeaf, pos - leaf->num, kv);
+        kv->SetIndexLeaf(newLeaf);
+    }
+
+    InsertChild((int) height - 1, newLeaf);
+    return NULL;
+}
+
+StorageMemoKeyValue* StorageMemoBTree::RemoveFirst()
+{
+    StorageMemoKeyValue*    kv;
+    Node*                   node;
+    Inner*                  inner;
+    int                     level;
+
+    if (head == NULL)
+        return NULL;
+
+    kv = head->keyValues[0];
+    head->num--;
+    memmove(head->prefixes, head->prefixes + 1, head->num * sizeof(uint64_t));
+    memmove(head->keyValues, head->keyValues + 1, head->num * sizeof(StorageMemoKeyValue*));
+    count--;
+
+    if (head->num > 0)
+        return kv;
+
+    // the first leaf became empty, remove it and the inner nodes that became empty
+    node = root;
+    for (level = 0; level < (int) height; level++)
+    {
+        path[level] = (Inner*) node;
+        node = ((Inner*) node)->children[0];
+    }
+    ASSERT(node == head);
+
+    head = head->next;
+    if (head != NULL)
+        head->prev = NULL;
+    else
+        tail = NULL;
+    DeleteLeaf((Leaf*) node);
+
+    for (level = (int) height - 1; level >= 0; level--)
+    {
+        inner = path[level];
+        inner->num--;
+        memmove(inner->prefixes, inner->prefixes + 1, inner->num * sizeof(uint64_t));
+        memmove(inner->keyValues, inner->keyValues + 1, inner->num * sizeof(StorageMemoKeyValue*));
+        memmove(inner->children, inner->children + 1, inner->num * sizeof(Node*));
+        if (inner->num > 0)
+            break;
+        DeleteInner(inner);
+    }
+
+    if (level < 0)
+    {
+        // the tree became empty
+        root = NULL;
+        height = 0;
+        return kv;
+    }
+
+    // shrink the tree while the root has a single child
+    while (height > 0 && root->num == 1)
+    {
+        inner = (Inner*) root;
+        root = inner->children[0];
+        DeleteInner(inner);
+        height--;
+    }
+
+    // the nodes on the left edge take all keys less than their first one from now on
+    node = root;
+    for (level = 0; level < (int) height; level++)
+    {
+        SetFences(node, 1, NULL, node->high);
+        node = ((Inner*) node)->children[0];
+    }
+    SetFences(node, 0, NULL, node->high);
+
+    return kv;
+}
+
+void StorageMemoBTree::Clear()
+{
+    if (root != NULL)
+        DeleteTree(root, height);
+
+    root = NULL;
+    height = 0;
+    head = NULL;
+    tail = NULL;
+    count = 0;
+    memoryUsage = 0;
+}
+
+StorageMemoKeyValue* StorageMemoBTree::ConcurrentLast()
+{
+    Leaf*       leaf;
+    unsigned    num;
+
+    leaf = ReadOnce(tail);
+    if (leaf == NULL)
+        return NULL;
+
+    num = ReadNum(leaf);
+    if (num == 0)
+        return NULL;
+    return leaf->keyValues[num - 1];
+}
+
+StorageMemoKeyValue* StorageMemoBTree::ConcurrentNext(StorageMemoKeyValue* kv)
+{
+    Leaf*       leaf;
+    Leaf*       next;
+    unsigned    num;
+    unsigned    i;
+
+    // the key-value may have been moved to another leaf meanwhile
+    leaf = (Leaf*) kv->GetIndexLeaf();
+    num = ReadNum(leaf);
+    for (i = 0; i < num; i++)
+    {
+        if (ReadOnce(leaf->keyValues[i]) == kv)
+            break;
+    }
+    if (i == num)
+        return NULL;
+
+    if (i + 1 < num)
+        return leaf->keyValues[i + 1];
+    next = ReadOnce(leaf->next);
+    if (next == NULL || ReadNum(next) == 0)
+        return NULL;
+    return next->keyValues[0];
+}
+
+StorageMemoKeyValue* StorageMemoBTree::ConcurrentPrev(StorageMemoKeyValue* kv)
+{
+    Leaf*       leaf;
+    Leaf*       prev;
+    unsigned    num;
+    unsigned    i;
+
+    leaf = (Leaf*) kv->GetIndexLeaf();
+    num = ReadNum(leaf);
+    for (i = 0; i < num; i++)
+    {
+        if (ReadOnce(leaf->keyValues[i]) == kv)
+            break;
+    }
+    if (i == num)
+        return NULL;
+
+    if (i > 0)
+        return leaf->keyValues[i - 1];
+    prev = ReadOnce(leaf->prev);
+    if (prev == NULL)
+        return NULL;
+    num = ReadNum(prev);
+    if (num == 0)
+        return NULL;
+    return prev->keyValues[num - 1];
+}
+
+StorageMemoKeyValue* StorageMemoBTree::ConcurrentGet(const ReadBuffer& key)
+{
+    Leaf*       leaf;
+    unsigned    num;
+    unsigned    pos;
+    int         cmpres;
+
+    leaf = ConcurrentFindLeaf(key);
+    if (leaf == NULL)
+        return NULL;
+
+    num = ReadNum(leaf);
+    pos = LowerBound(leaf, num, ReadOnce(leaf->skip), key, cmpres);
+    if (pos < num && cmpres == 0)
+        return leaf->keyValues[pos];
+
+    return NULL;
+}
+
+StorageMemoKeyValue* StorageMemoBTree::ConcurrentLocate(const ReadBuffer& key, int& cmpres)
+{
+    Leaf*       leaf;
+    Leaf*       next;
+    unsigned    num;
+    unsigned    pos;
+
+    cmpres = 0;
+    leaf = ConcurrentFindLeaf(key);
+    if (leaf == NULL)
+        return NULL;
+
+    num = ReadNum(leaf);
+    pos = LowerBound(leaf, num, ReadOnce(leaf->skip), key, cmpres);
+    if (pos < num)
+    {
+        if (cmpres != 0)
+            cmpres = -1;
+        return leaf->keyValues[pos];
+    }
+
+    next = ReadOnce(leaf->next);
+    if (next != NULL && ReadNum(next) > 0)
+    {
+        cmpres = -1;
+        return next->keyValues[0];
+    }
+
+    cmpres = 1;
+    if (num == 0)
+        return NULL;
+    return leaf->keyValues[num - 1];
+}
+
+StorageMemoBTree::Leaf* StorageMemoBTree::FindLeaf(const ReadBuffer& key)
+{
+    Node*       node;
+    unsigned    level;
+
+    node = root;
+    for (level = 0; level < height; level++)
+        node = ((Inner*) node)->children[FindChild((Inner*) node, node->num, node->skip, key)];
+
+    return (Leaf*) node;
+}
+
+StorageMemoBTree::Leaf* StorageMemoBTree::ConcurrentFindLeaf(const ReadBuffer& key)
+{
+    Node*       node;
+    unsigned    depth;
+    unsigned    num;
+
+    // the height and the root may change independently, so the descent stops at the
+    // first node of level zero
+    node = ReadOnce(root);
+    for (depth = 0; node != NULL && depth < STORAGE_MEMO_BTREE_MAX_HEIGHT; depth++)
+    {
+        if (ReadOnce(node->level) == 0)
+            return (Leaf*) node;
+
+        num = ReadNum(node);
+        if (num == 0)
+            return NULL;
+        node = ReadOnce(((Inner*) node)->children[
+         FindChild((Inner*) node, num, ReadOnce(node->skip), key)]);
+    }
+
+    return NULL;
+}
+
+unsigned StorageMemoBTree::LowerBound(Node* node, unsigned num, unsigned skip,
+ const ReadBuffer& key, int& cmpres)
+{
+    uint64_t    prefix;
+    unsigned    lo;
+    unsigned    hi;
+    unsigned    mid;
+
+    prefix = KeyPrefix(key, skip);
+    lo = 0;
+    hi = num;
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (KeyCmp(prefix, key, node->prefixes[mid], node->keyValues[mid]) > 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    cmpres = 1;
+    if (lo < num)
+        cmpres = KeyCmp(prefix, key, node->prefixes[lo], node->keyValues[lo]);
+
+    return lo;
+}
+
+unsigned StorageMemoBTree::FindChild(Inner* inner, unsigned num, unsigned skip,
+ const ReadBuffer& key)
+{
+    uint64_t    prefix;
+    unsigned    lo;
+    unsigned    hi;
+    unsigned    mid;
+
+    // the last child whose first key is not greater than the key, the first child
+    // takes all keys less than the second child's
+    prefix = KeyPrefix(key, skip);
+    lo = 1;
+    hi = num;
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (KeyCmp(prefix, key, inner->prefixes[mid], inner->keyValues[mid]) >= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo - 1;
+}
+
+void StorageMemoBTree::InsertAt(Node* node, unsigned pos, StorageMemoKeyValue* kv)
+{
+    ASSERT(node->num < STORAGE_MEMO_BTREE_ORDER && pos <= node->num);
+
+    memmove(node->prefixes + pos + 1, node->prefixes + pos,
+     (node->num - pos) * sizeof(uint64_t));
+    ShiftRight(node->keyValues, pos, node->num);
+    node->prefixes[pos] = KeyPrefix(kv->GetKey(), node->skip);
+    node->keyValues[pos] = kv;
+    // the new element is written before concurrent readers may see it
+    AtomicMemoryBarrier();
+    node->num++;
+}
+
+void StorageMemoBTree::InsertChild(int level, Node* child)
+{
+    Inner*      inner;
+    Inner*      newInner;
+    unsigned    pos;
+    unsigned    split;
+
+    // child is the new right sibling of the node at path[level]->children[pathIndex[level]]
+    if (level < 0)
+    {
+        newInner = NewInner(root->level + 1);
+        newInner->children[0] = root;
+        newInner->prefixes[0] = 0;
+        newInner->keyValues[0] = NULL;
+        newInner->num = 1;
+        AtomicMemoryBarrier();
+        root = newInner;
+        height++;
+        ASSERT(height < STORAGE_MEMO_BTREE_MAX_HEIGHT);
+        inner = newInner;
+        pos = 1;
+    }
+    else
+    {
+        inner = path[level];
+        pos = pathIndex[level] + 1;
+    }
+
+    newInner = NULL;
+    if (inner->num == STORAGE_MEMO_BTREE_ORDER)
+    {
+        split = STORAGE_MEMO_BTREE_ORDER / 2;
+        newInner = NewInner(inner->level);
+        newInner->num = STORAGE_MEMO_BTREE_ORDER - split;
+        memcpy(newInner->prefixes, inner->prefixes + split, newInner->num * sizeof(uint64_t));
+        memcpy(newInner->keyValues, inner->keyValues + split,
+         newInner->num * sizeof(StorageMemoKeyValue*));
+        memcpy(newInner->children, inner->children + split, newInner->num * sizeof(Node*));
+        newInner->skip = inner->skip;
+        inner->num = split;
+
+        // the first key of the new node is maintained, it was not the first of the old one
+        SetFences(newInner, 1, newInner->keyValues[0], inner->high);
+        SetFences(inner, 1, inner->low, newInner->keyValues[0]);
+        if (pos > split)
+        {
+            pos -= split;
+            inner = newInner;
+        }
+    }
+
+    AtomicMemoryBarrier();
+    ShiftRight(inner->children, pos, inner->num);
+    inner->children[pos] = child;
+    InsertAt(inner, pos, child->keyValues[0]);
+
+    if (newInner != NULL)
+        InsertChild(level - 1, newInner);
+}
+
+StorageMemoBTree::Leaf* StorageMemoBTree::SplitLeaf(Leaf* leaf, unsigned pos)
+{
+    Leaf*       newLeaf;
+    unsigned    split;
+    unsigned    i;
+
+    // appending to the last leaf leaves it full, ascending inserts fill the leaves
+    if (leaf == tail && pos == leaf->num)
+        split = leaf->num;
+    else
+        split = STORAGE_MEMO_BTREE_ORDER / 2;
+
+    newLeaf = NewLeaf();
+    newLeaf->num = leaf->num - split;
+    memcpy(newLeaf->prefixes, leaf->prefixes + split, newLeaf->num * sizeof(uint64_t));
+    memcpy(newLeaf->keyValues, leaf->keyValues + split,
+     newLeaf->num * sizeof(StorageMemoKeyValue*));
+    // concurrent readers may reach the new leaf from its key-values
+    AtomicMemoryBarrier();
+    for (i = 0; i < newLeaf->num; i++)
+        newLeaf->keyValues[i]->SetIndexLeaf(newLeaf);
+    newLeaf->skip = leaf->skip;
+    leaf->num = split;
+
+    // an empty new leaf gets its fences from the inserted key
+    if (newLeaf->num > 0)
+    {
+        SetFences(newLeaf, 0, newLeaf->keyValues[0], leaf->high);
+        SetFences(leaf, 0, leaf->low, newLeaf->keyValues[0]);
+    }
+
+    newLeaf->prev = leaf;
+    newLeaf->next = leaf->next;
+    AtomicMemoryBarrier();
+    if (leaf->next != NULL)
+        leaf->next->prev = newLeaf;
+    else
+        tail = newLeaf;
+    leaf->next = newLeaf;
+
+    return newLeaf;
+}
+
+void StorageMemoBTree::SetFences(Node* node, unsigned first, StorageMemoKeyValue* low,
+ StorageMemoKeyValue* high)
+{
+    unsigned    skip;
+    unsigned    i;
+
+    node->low = low;
+    node->high = high;
+    skip = CommonPrefixLength(low, high);
+    if (skip == node->skip)
+        return;
+
+    node->skip = skip;
+    for (i = first; i < node->num; i++)
+        node->prefixes[i] = KeyPrefix(node->keyValues[i]->GetKey(), skip);
+}
+
+StorageMemoBTree::Leaf* StorageMemoBTree::NewLeaf()
+{
+    Leaf*   leaf;
+
+    leaf = new Leaf;
+    leaf->num = 0;
+    leaf->level = 0;
+    leaf->skip = 0;
+    leaf->low = NULL;
+    leaf->high = NULL;
+    leaf->prev = NULL;
+    leaf->next = NULL;
+    memoryUsage += sizeof(Leaf);
+
+    return leaf;
+}
+
+StorageMemoBTree::Inner* StorageMemoBTree::NewInner(unsigned level)
+{
+    Inner*  inner;
+
+    inner = new Inner;
+    inner->num = 0;
+    inner->level = level;
+    inner->skip = 0;
+    inner->low = NULL;
+    inner->high = NULL;
+    memoryUsage += sizeof(Inner);
+
+    return inner;
+}
+
+void StorageMemoBTree::DeleteLeaf(Leaf* leaf)
+{
+    memoryUsage -= sizeof(Leaf);
+    delete leaf;
+}
+
+void StorageMemoBTree::DeleteInner(Inner* inner)
+{
+    memoryUsage -= sizeof(Inner);
+    delete inner;
+}
+
+void StorageMemoBTree::DeleteTree(Node* node, unsigned level)
+{
+    unsigned    i;
+
+    if (level == 0)
+    {
+        DeleteLeaf((Leaf*) node);
+        return;
+    }
+
+    for (i = 0; i < node->num; i++)
+        DeleteTree(((Inner*) node)->children[i], level - 1);
+    DeleteInner((Inner*) node);
+}
@@ -0,0 +1,112 @@
+#ifndef STORAGEMEMOBTREE_H
+#define STORAGEMEMOBTREE_H
+
+#include "System/Buffers/ReadBuffer.h"
+#include "StorageMemoKeyValue.h"
+
+#define STORAGE_MEMO_BTREE_ORDER        64
+#define STORAGE_MEMO_BTREE_MAX_HEIGHT   16
+
+/*
+===============================================================================================
+
+ StorageMemoBTree
+
+ B+-tree index of the key-values of a memo chunk. The nodes are wide arrays which hold
+ 8 bytes of each key next to the key-value pointers, so most comparisons are decided
+ without touching the key buffers. All keys of a node lie between its fence keys, the
+ bytes the fences have in common are skipped and the 8 bytes after them are stored.
+ The leaves are linked for in-order iteration. Only the first key-value can be removed.
+
+ The Concurrent functions may run on other threads while the main thread inserts. They
+ read the fields of a node once and descend by the level of the nodes, so they never
+ leave the nodes, but their results are only valid if the tree was not changed meanwhile.
+ Nodes are only freed by RemoveFirst() and Clear(), those must not run concurrently.
+
+===============================================================================================
+*/
+
+class StorageMemoBTree
+{
+public:
+    StorageMemoBTree();
+    ~StorageMemoBTree();
+
+    unsigned                GetCount();
+    uint64_t                GetMemoryUsage();
+
+    StorageMemoKeyValue*    First();
+    StorageMemoKeyValue*    Last();
+    StorageMemoKeyValue*    Mid();
+    StorageMemoKeyValue*    Next(StorageMemoKeyValue* kv);
+    StorageMemoKeyValue*    Prev(StorageMemoKeyValue* kv);
+
+    StorageMemoKeyValue*    Get(const ReadBuffer& key);
+    StorageMemoKeyValue*    Locate(const ReadBuffer& key, int& cmpres);
+
+    // returns the replaced key-value with the same key or NULL
+    StorageMemoKeyValue*    Insert(StorageMemoKeyValue* kv);
+    StorageMemoKeyValue*    RemoveFirst();
+
+    void                    Clear();
+
+    StorageMemoKeyValue*    ConcurrentLast();
+    StorageMemoKeyValue*    ConcurrentNext(StorageMemoKeyValue* kv);
+    StorageMemoKeyValue*    ConcurrentPrev(StorageMemoKeyValue* kv);
+    StorageMemoKeyValue*    ConcurrentGet(const ReadBuffer& key);
+    StorageMemoKeyValue*    ConcurrentLocate(const ReadBuffer& key, int& cmpres);
+
+private:
+    struct Node
+    {
+        unsigned                num;
+        uint16_t                skip;       // common prefix length of the keys
+        uint16_t                level;      // zero for leaves
+        StorageMemoKeyValue*    low;        // fence keys, NULL at the edges of the tree
+        StorageMemoKeyValue*    high;
+        uint64_t                prefixes[STORAGE_MEMO_BTREE_ORDER];
+        // in inner nodes the first key-value of each child, the first one is not maintained
+        StorageMemoKeyValue*    keyValues[STORAGE_MEMO_BTREE_ORDER];
+    };
+
+    struct Leaf : public Node
+    {
+        Leaf*                   prev;
+        Leaf*                   next;
+    };
+
+    struct Inner : public Node
+    {
+        Node*                   children[STORAGE_MEMO_BTREE_ORDER];
+    };
+
+    Leaf*                   FindLeaf(const ReadBuffer& key);
+    Leaf*                   ConcurrentFindLeaf(const ReadBuffer& key);
+    unsigned                LowerBound(Node* node, unsigned num, unsigned skip,
+                             const ReadBuffer& key, int& cmpres);
+    unsigned                FindChild(Inner* inner, unsigned num, unsigned skip,
+                             const ReadBuffer& key);
+    void                    InsertAt(Node* node, unsigned pos, StorageMemoKeyValue* kv);
+    void                    InsertChild(int level, Node* child);
+    Leaf*                   SplitLeaf(Leaf* leaf, unsigned pos);
+    void                    SetFences(Node* node, unsigned first, StorageMemoKeyValue* low,
+                             StorageMemoKeyValue* high);
+    Leaf*                   NewLeaf();
+    Inner*                  NewInner(unsigned level);
+    void                    DeleteLeaf(Leaf* leaf);
+    void                    DeleteInner(Inner* inner);
+    void                    DeleteTree(Node* node, unsigned level);
+
+    Node*                   root;
+    unsigned                height;     // number of inner levels
+    Leaf*                   head;
+    Leaf*                   tail;
+    unsigned                count;
+    uint64_t                memoryUsage;
+
+    // the path of the last descent
+    Inner*                  path[STORAGE_MEMO_BTREE_MAX_HEIGHT];
+    unsigned                pathIndex[STORAGE_MEMO_BTREE_MAX_HEIGHT];
+};
+
+#endif
@@ -4,20 +4,13 @@
 #include "StorageBulkCursor.h"
 #include "StorageEnvironment.h"
 #include "StorageAsyncGet.h"
+#include "System/Threading/Atomic.h"
 
-static inline int KeyCmp(const ReadBuffer& a, const ReadBuffer& b)
-{
-    return ReadBuffer::Cmp(a, b);
-}
+static char indexType = STORAGE_MEMO_INDEX_TREE;
 
-static inline const ReadBuffer Key(const StorageMemoKeyValue* kv)
+void StorageMemoChunk::SetIndexType(char indexType_)
 {
-    return kv->GetKey();
-}
-
-static inline const ReadBuffer Key(const StorageFileKeyValue* kv)
-{
-    return kv->GetKey();
+    indexType = indexType_;
 }
 
 uint32_t StorageMemoKeyValueAllocator::GetFreeSize()
@@ -38,6 +31,10 @@ StorageMemoChunk::StorageMemoChunk(uint64_t chunkID_, bool useBloomFilter_)
     avgSize = 0.0;
     fileChunk = NULL;
     deleted = false;    
+    writeSeq = 0;
+    numReaders = 0;
+    pendingDelete = false;
+    keyValues.Init(indexType);
 }
 
 StorageMemoChunk::~StorageMemoChunk()
@@ -52,6 +49,12 @@ StorageMemoChunk::~StorageMemoChunk()
         free((void*) allocator);
     }
 
+    FOREACH_FIRST (allocator, retiredAllocators)
+    {
+        retiredAllocators.Remove(allocator);
+        free((void*) allocator);
+    }
+
     if (fileChunk != NULL)
         delete fileChunk;
 }
@@ -166,16 +169,19 @@ bool StorageMemoChunk::Set(ReadBuffer key, ReadBuffer value)
     
     ASSERT(key.GetLength() > 0);
 
+    BeginWrite();
     kv = keyValues.Get(key);
     if (kv)
     {
         kv->Set(key, value, this);
+        EndWrite();
         return true;
     }
 
     kv = NewStorageMemoKeyValue();
     kv->Set(key, value, this);
-    keyValues.Insert<const ReadBuffer>(kv);
+    keyValues.Insert(kv);
+    EndWrite();
     
     return true;
 }
@@ -186,16 +192,19 @@ bool StorageMemoChunk::Delete(ReadBuffer key)
 
     ASSERT(key.GetLength() > 0);
     
+    BeginWrite();
     kv = keyValues.Get(key);
     if (kv)
     {
         kv->Delete(key, this);
+        EndWrite();
         return true;
     }
 
     kv = NewStorageMemoKeyValue();
     kv->Delete(key, this);
-    keyValues.Insert<const ReadBuffer>(kv);
+    keyValues.Insert(kv);
+    EndWrite();
     
     return true;
 }
@@ -250,7 +259,7 @@ ReadBuffer StorageMemoChunk::GetLastKey()
 
 uint64_t StorageMemoChunk::GetSize()
 {
-    return size;
+    return size + keyValues.GetMemoryUsage();
 }
 
 ReadBuffer StorageMemoChunk::GetMidpoint()
@@ -280,8 +289,10 @@ void StorageMemoChunk::RemoveFirst()
     StorageMemoKeyValueBlock*   block;
     StorageMemoKeyValue*        first;
 
-    first = keyValues.First();
-    keyValues.Remove(first);
+    // the key-value blocks and the index nodes are freed at once
+    ASSERT(numReaders == 0);
+
+    first = keyValues.RemoveFirst();
     
     first->Free(this);
 
@@ -296,6 +307,102 @@ void StorageMemoChunk::RemoveFirst()
     }
 }
 
+bool StorageMemoChunk::IsConcurrentReadable()
+{
+    return keyValues.IsConcurrentReadable();
+}
+
+void StorageMemoChunk::AddReader()
+{
+    ASSERT(IsConcurrentReadable());
+    numReaders++;
+}
+
+unsigned StorageMemoChunk::RemoveReader()
+{
+    StorageMemoKeyValueAllocator*   allocator;
+
+    ASSERT(numReaders > 0);
+    numReaders--;
+    if (numReaders > 0)
+        return numReaders;
+
+    FOREACH_FIRST (allocator, retiredAllocators)
+    {
+        retiredAllocators.Remove(allocator);
+        free((void*) allocator);
+    }
+    return 0;
+}
+
+unsigned StorageMemoChunk::GetNumReaders()
+{
+    return numReaders;
+}
+
+StorageMemoChunk::ReadResult StorageMemoChunk::ConcurrentGet(ReadBuffer& key, Buffer& value)
+{
+    StorageMemoKeyValue*    kv;
+    ReadBuffer              kvKey;
+    ReadBuffer              kvValue;
+    ReadResult              result;
+    uint32_t                seq;
+    unsigned                i;
+
+    for (i = 0; i < STORAGE_MEMO_READ_RETRIES; i++)
+    {
+        seq = BeginConcurrentRead();
+
+        result = READ_NOT_FOUND;
+        kv = keyValues.ConcurrentGet(key);
+        if (kv != NULL)
+        {
+            if (kv->ReadConcurrently(kvKey, kvValue) == STORAGE_KEYVALUE_TYPE_DELETE)
+            {
+                result = READ_DELETE;
+            }
+            else
+            {
+                value.Write(kvValue);
+                result = READ_SET;
+            }
+        }
+
+        if (IsConcurrentReadValid(seq))
+            return result;
+    }
+
+    return READ_CONFLICT;
+}
+
+uint32_t StorageMemoChunk::BeginConcurrentRead()
+{
+    uint32_t    seq;
+
+    seq = writeSeq;
+    AtomicMemoryBarrier();
+    return seq;
+}
+
+bool StorageMemoChunk::IsConcurrentReadValid(uint32_t seq)
+{
+    // an odd counter means a write was in progress when the read began
+    AtomicMemoryBarrier();
+    return (seq % 2 == 0 && writeSeq == seq);
+}
+
+void StorageMemoChunk::BeginWrite()
+{
+    writeSeq++;
+    AtomicMemoryBarrier();
+}
+
+void StorageMemoChunk::EndWrite()
+{
+    AtomicMemoryBarrier();
+    writeSeq++;
+}
+
 StorageMemoKeyValue* StorageMemoChunk::NewStorageMemoKeyValue()
 {
     StorageMemoKeyValueBlock*   block;
@@ -406,7 +513,11 @@ void StorageMemoChunk::Free(char* buffer)
     {
         size -= sizeof(StorageMemoKeyValueAllocator) + allocator->size;
         allocators.Remove(allocator);
-        free(allocator);
+        // concurrent readers may still read the buffers of the allocator
+        if (numReaders > 0)
+            retiredAllocators.Append(allocator);
+        else
+            free(allocator);
         
         // adjust the average size
         avgSize = (double) size / keyValues.GetCount();
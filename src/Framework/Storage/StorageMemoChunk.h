@@ -2,16 +2,17 @@
 #define STORAGEMEMOCHUNK_H
 
 #include "System/Buffers/Buffer.h"
-#include "System/Containers/InTreeMap.h"
 #include "System/Containers/InQueue.h"
 #include "System/Containers/InList.h"
 #include "StorageChunk.h"
 #include "StorageMemoKeyValue.h"
+#include "StorageMemoIndex.h"
 #include "StorageFileChunk.h"
 
 #define STORAGE_MEMO_BUNCH_GRAN             1*MB
 #define STORAGE_MEMO_ALLOCATOR_DEFAULT_SIZE 64*KiB
 #define STORAGE_MEMO_ALLOCATOR_MIN_SIZE     128
+#define STORAGE_MEMO_READ_RETRIES           16
 #define STORAGE_BLOCK_NUM_KEY_VALUE     \
     ((128*KiB-sizeof(void*)-2*sizeof(unsigned))/sizeof(StorageMemoKeyValue))
 
@@ -42,6 +43,11 @@ struct StorageMemoKeyValueAllocator
 
  StorageMemoChunk
 
+ With the B+-tree index other threads may read the chunk while the main thread writes it.
+ The main thread registers the readers, while there are readers the freed key-value
+ buffers and the chunk itself stay allocated. Writes are wrapped in a sequence counter,
+ a concurrent read is only valid if the counter was even and did not change meanwhile.
+
 ===============================================================================================
 */
 
@@ -52,10 +58,20 @@ class StorageMemoChunk : public StorageChunk
     friend class StorageMemoChunkLister;
 
 public:
-    typedef InTreeMap<StorageMemoKeyValue> KeyValueTree;
     typedef InQueue<StorageMemoKeyValueBlock> KeyValueBlockQueue;
     typedef InList<StorageMemoKeyValueAllocator> AllocatorList;
+
+    enum ReadResult
+    {
+        READ_NOT_FOUND,
+        READ_SET,
+        READ_DELETE,
+        READ_CONFLICT
+    };
     
+    // new memo chunks index their key-values with this, STORAGE_MEMO_INDEX_TREE by default
+    static void             SetIndexType(char indexType);
+
     StorageMemoChunk(uint64_t chunkID, bool useBloomFilter);
     ~StorageMemoChunk();
     
@@ -90,12 +106,24 @@ public:
     void                    RemoveFirst(); // for logstorage
 
     StorageMemoKeyValue*    NewStorageMemoKeyValue();
+
+    // concurrent readers, AddReader() and RemoveReader() are called on the main thread
+    bool                    IsConcurrentReadable();
+    void                    AddReader();
+    unsigned                RemoveReader();
+    unsigned                GetNumReaders();
+    ReadResult              ConcurrentGet(ReadBuffer& key, Buffer& value);
+    uint32_t                BeginConcurrentRead();
+    bool                    IsConcurrentReadValid(uint32_t seq);
     
     // StorageMemoKeyValue buffer allocator
     char*                   Alloc(size_t size);
     void                    Free(char* buffer);
 
 private:
+    void                    BeginWrite();
+    void                    EndWrite();
+
     bool                    serialized;
     uint64_t                chunkID;
     uint64_t                minLogSegmentID;
@@ -104,11 +132,16 @@ private:
     bool                    useBloomFilter;
     uint64_t                size;
     double                  avgSize;
-    KeyValueTree            keyValues;
+    StorageMemoIndex        keyValues;
     
     StorageFileChunk*       fileChunk; // for serialization
     KeyValueBlockQueue      keyValueBlocks;
     AllocatorList           allocators;
+
+    volatile uint32_t       writeSeq;
+    unsigned                numReaders;
+    bool                    pendingDelete;      // deleted when the last reader is removed
+    AllocatorList           retiredAllocators;  // freed when the last reader is removed
 };
 
 #endif
@@ -46,6 +46,61 @@ void StorageMemoChunkLister::Init(
     dataPage.Finalize();
 }
 
+bool StorageMemoChunkLister::ConcurrentInit(
+ StorageMemoChunk* chunk, ReadBuffer& firstKey, ReadBuffer& /*endKey*/, ReadBuffer& prefix,
+ unsigned count, bool keysOnly, bool forwardDirection)
+{
+    StorageMemoKeyValue*    kv;
+    StorageFileKeyValue     fkv;
+    ReadBuffer              key;
+    ReadBuffer              value;
+    uint32_t                seq;
+    unsigned                num;
+    unsigned                i;
+
+    // same as Init() while the main thread may write the chunk, the key-values are copied
+    // to the data page, the copy is checked at every bunch and at the end
+    seq = chunk->BeginConcurrentRead();
+    kv = ConcurrentGetFirstKey(chunk, firstKey, forwardDirection);
+
+    num = 0;
+    for (i = 1; kv != NULL; i++)
+    {
+        if (kv->ReadConcurrently(key, value) == STORAGE_KEYVALUE_TYPE_SET)
+            fkv.Set(key, value);
+        else
+            fkv.Delete(key);
+
+        if (prefix.GetLength() > 0 && !key.BeginsWith(prefix))
+            break;
+        // the key is empty if it was read while the key-value was being created
+        if (key.GetLength() == 0 || (i % STORAGE_MEMO_LISTER_CHECK_INTERVAL == 0 &&
+         !chunk->IsConcurrentReadValid(seq)))
+            break;
+
+        dataPage.Append(&fkv, keysOnly);
+        if (fkv.GetType() == STORAGE_KEYVALUE_TYPE_SET)
+        {
+            num++;
+            if (count != 0 && num == count)
+                break;
+        }
+        if (forwardDirection)
+            kv = chunk->keyValues.ConcurrentNext(kv);
+        else
+            kv = chunk->keyValues.ConcurrentPrev(kv);
+    }
+
+    if (!chunk->IsConcurrentReadValid(seq))
+    {
+        dataPage.Reset();
+        return false;
+    }
+
+    dataPage.Finalize();
+    return true;
+}
+
 void StorageMemoChunkLister::SetDirection(bool forwardDirection_)
 {
     forwardDirection = forwardDirection_;
@@ -111,3 +166,28 @@ StorageMemoKeyValue* StorageMemoChunkLister::GetFirstKey(
 
     return kv;
 }
+
+StorageMemoKeyValue* StorageMemoChunkLister::ConcurrentGetFirstKey(
+ StorageMemoChunk* chunk, ReadBuffer& startKey, bool forwardDirection)
+{
+    StorageMemoKeyValue*    kv;
+    int                     cmpres;
+
+    if (!forwardDirection && startKey.GetLength() == 0)
+        return chunk->keyValues.ConcurrentLast();
+
+    kv = chunk->keyValues.ConcurrentLocate(startKey, cmpres);
+
+    if (forwardDirection)
+    {
+        if (kv != NULL && cmpres > 0)
+            kv = chunk->keyValues.ConcurrentNext(kv);
+    }
+    else
+    {
+        if (kv != NULL && cmpres < 0)
+            kv = chunk->keyValues.ConcurrentPrev(kv);
+    }
+
+    return kv;
+}
@@ -5,6 +5,8 @@
 #include "StorageDataPage.h"
 #include "StorageMemoChunk.h"
 
+#define STORAGE_MEMO_LISTER_CHECK_INTERVAL  64
+
 /*
 ===============================================================================================
  
@@ -20,6 +22,10 @@ public:
     
     void                    Init(StorageMemoChunk* chunk, ReadBuffer& firstKey, ReadBuffer& endKey, ReadBuffer& prefix,
                              unsigned count, bool keysOnly, bool forwardDirection);
+    // returns false if the chunk was written meanwhile, then the lister is empty
+    bool                    ConcurrentInit(StorageMemoChunk* chunk, ReadBuffer& firstKey,
+                             ReadBuffer& endKey, ReadBuffer& prefix, unsigned count,
+                             bool keysOnly, bool forwardDirection);
 
     void                    SetDirection(bool forwardDirection);
     StorageFileKeyValue*    First(ReadBuffer& firstKey);
@@ -31,6 +37,8 @@ public:
 private:
     StorageMemoKeyValue*    GetFirstKey(StorageMemoChunk* chunk, 
                              ReadBuffer& firstKey, bool forwardDirection);
+    StorageMemoKeyValue*    ConcurrentGetFirstKey(StorageMemoChunk* chunk,
+                             ReadBuffer& firstKey, bool forwardDirection);
 
     bool                    forwardDirection;
     StorageDataPage         dataPage;
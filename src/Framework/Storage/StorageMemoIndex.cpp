@@ -0,0 +1,151 @@
+#include "StorageMemoIndex.h"
+
+static inline int KeyCmp(const ReadBuffer& a, const ReadBuffer& b)
+{
+    return ReadBuffer::Cmp(a, b);
+}
+
+static inline const ReadBuffer Key(const StorageMemoKeyValue* kv)
+{
+    return kv->GetKey();
+}
+
+StorageMemoIndex::StorageMemoIndex()
+{
+    btree = NULL;
+}
+
+StorageMemoIndex::~StorageMemoIndex()
+{
+    delete btree;
+}
+
+void StorageMemoIndex::Init(char type)
+{
+    ASSERT(GetCount() == 0);
+
+    delete btree;
+    btree = NULL;
+    if (type == STORAGE_MEMO_INDEX_BTREE)
+        btree = new StorageMemoBTree;
+}
+
+unsigned StorageMemoIndex::GetCount()
+{
+    if (btree)
+        return btree->GetCount();
+    return tree.GetCount();
+}
+
+uint64_t StorageMemoIndex::GetMemoryUsage()
+{
+    // the tree nodes are part of the key-values
+    if (btree)
+        return btree->GetMemoryUsage();
+    return 0;
+}
+
+StorageMemoKeyValue* StorageMemoIndex::First()
+{
+    if (btree)
+        return btree->First();
+    return tree.First();
+}
+
+StorageMemoKeyValue* StorageMemoIndex::Last()
+{
+    if (btree)
+        return btree->Last();
+    return tree.Last();
+}
+
+StorageMemoKeyValue* StorageMemoIndex::Mid()
+{
+    if (btree)
+        return btree->Mid();
+    return tree.Mid();
+}
+
+StorageMemoKeyValue* StorageMemoIndex::Next(StorageMemoKeyValue* kv)
+{
+    if (btree)
+        return btree->Next(kv);
+    return tree.Next(kv);
+}
+
+StorageMemoKeyValue* StorageMemoIndex::Prev(StorageMemoKeyValue* kv)
+{
+    if (btree)
+        return btree->Prev(kv);
+    return tree.Prev(kv);
+}
+
+StorageMemoKeyValue* StorageMemoIndex::Get(ReadBuffer& key)
+{
+    if (btree)
+        return btree->Get(key);
+    return tree.Get(key);
+}
+
+StorageMemoKeyValue* StorageMemoIndex::Locate(ReadBuffer& key, int& cmpres)
+{
+    if (btree)
+        return btree->Locate(key, cmpres);
+    return tree.Locate(key, cmpres);
+}
+
+void StorageMemoIndex::Insert(StorageMemoKeyValue* kv)
+{
+    if (btree)
+        btree->Insert(kv);
+    else
+        tree.Insert<const ReadBuffer>(kv);
+}
+
+StorageMemoKeyValue* StorageMemoIndex::RemoveFirst()
+{
+    StorageMemoKeyValue*    first;
+
+    if (btree)
+        return btree->RemoveFirst();
+
+    first = tree.First();
+    if (first != NULL)
+        tree.Remove(first);
+    return first;
+}
+
+bool StorageMemoIndex::IsConcurrentReadable()
+{
+    return (btree != NULL);
+}
+
+StorageMemoKeyValue* StorageMemoIndex::ConcurrentLast()
+{
+    ASSERT(btree);
+    return btree->ConcurrentLast();
+}
+
+StorageMemoKeyValue* StorageMemoIndex::ConcurrentNext(StorageMemoKeyValue* kv)
+{
+    ASSERT(btree);
+    return btree->ConcurrentNext(kv);
+}
+
+StorageMemoKeyValue* StorageMemoIndex::ConcurrentPrev(StorageMemoKeyValue* kv)
+{
+    ASSERT(btree);
+    return btree->ConcurrentPrev(kv);
+}
+
+StorageMemoKeyValue* StorageMemoIndex::ConcurrentGet(ReadBuffer& key)
+{
+    ASSERT(btree);
+    return btree->ConcurrentGet(key);
+}
+
+StorageMemoKeyValue* StorageMemoIndex::ConcurrentLocate(ReadBuffer& key, int& cmpres)
+{
+    ASSERT(btree);
+    return btree->ConcurrentLocate(key, cmpres);
+}
@@ -0,0 +1,59 @@
+#ifndef STORAGEMEMOINDEX_H
+#define STORAGEMEMOINDEX_H
+
+#include "System/Containers/InTreeMap.h"
+#include "StorageMemoKeyValue.h"
+#include "StorageMemoBTree.h"
+
+#define STORAGE_MEMO_INDEX_TREE         0
+#define STORAGE_MEMO_INDEX_BTREE        1
+
+/*
+===============================================================================================
+
+ StorageMemoIndex
+
+ The sorted index of a memo chunk, either the red-black tree linked through the
+ key-values or the B+-tree with wide nodes.
+
+===============================================================================================
+*/
+
+class StorageMemoIndex
+{
+public:
+    typedef InTreeMap<StorageMemoKeyValue> KeyValueTree;
+
+    StorageMemoIndex();
+    ~StorageMemoIndex();
+
+    void                    Init(char type);
+
+    unsigned                GetCount();
+    uint64_t                GetMemoryUsage();
+
+    StorageMemoKeyValue*    First();
+    StorageMemoKeyValue*    Last();
+    StorageMemoKeyValue*    Mid();
+    StorageMemoKeyValue*    Next(StorageMemoKeyValue* kv);
+    StorageMemoKeyValue*    Prev(StorageMemoKeyValue* kv);
+
+    StorageMemoKeyValue*    Get(ReadBuffer& key);
+    StorageMemoKeyValue*    Locate(ReadBuffer& key, int& cmpres);
+    void                    Insert(StorageMemoKeyValue* kv);
+    StorageMemoKeyValue*    RemoveFirst();
+
+    // only the B+-tree can be read from other threads while the main thread inserts
+    bool                    IsConcurrentReadable();
+    StorageMemoKeyValue*    ConcurrentLast();
+    StorageMemoKeyValue*    ConcurrentNext(StorageMemoKeyValue* kv);
+    StorageMemoKeyValue*    ConcurrentPrev(StorageMemoKeyValue* kv);
+    StorageMemoKeyValue*    ConcurrentGet(ReadBuffer& key);
+    StorageMemoKeyValue*    ConcurrentLocate(ReadBuffer& key, int& cmpres);
+
+private:
+    KeyValueTree            tree;
+    StorageMemoBTree*       btree;
+};
+
+#endif
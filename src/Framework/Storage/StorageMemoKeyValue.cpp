@@ -1,5 +1,6 @@
 #include "StorageMemoKeyValue.h"
 #include "StorageMemoChunk.h"
+#include "System/Threading/Atomic.h"
 
 #define DELETE_LENGTH_VALUE     ((uint32_t)-1)
 
@@ -26,32 +27,46 @@ void StorageMemoKeyValue::Free(StorageMemoChunk* memoChunk)
 
 void StorageMemoKeyValue::Set(ReadBuffer key_, ReadBuffer value_, StorageMemoChunk* memoChunk)
 {
-    if (buffer != NULL && GetLength() < key_.GetLength() + value_.GetLength())
+    char*   newBuffer;
+    char*   oldBuffer;
+
+    if (buffer != NULL && GetLength() >= key_.GetLength() + value_.GetLength())
     {
-        memoChunk->Free(buffer);
-        buffer = NULL;
+        // the key of a key-value never changes, only the value is overwritten
+        keyLength = key_.GetLength();
+        valueLength = value_.GetLength();
+        memcpy(buffer, key_.GetBuffer(), keyLength);
+        memcpy(buffer + keyLength, value_.GetBuffer(), valueLength);
+        return;
     }
-    
+
+    // concurrent readers must not see a buffer shorter than the lengths, so the new
+    // buffer is filled and published before the lengths, see ReadConcurrently()
+    newBuffer = (char*) memoChunk->Alloc(key_.GetLength() + value_.GetLength());
+    memcpy(newBuffer, key_.GetBuffer(), key_.GetLength());
+    memcpy(newBuffer + key_.GetLength(), value_.GetBuffer(), value_.GetLength());
+    AtomicMemoryBarrier();
+
+    oldBuffer = buffer;
+    buffer = newBuffer;
+    AtomicMemoryBarrier();
     keyLength = key_.GetLength();
     valueLength = value_.GetLength();
 
-    if (buffer == NULL)
-        buffer = (char*) memoChunk->Alloc(GetLength());
-    
-    memcpy(buffer, key_.GetBuffer(), keyLength);
-    memcpy(buffer + keyLength, value_.GetBuffer(), valueLength);
+    if (oldBuffer != NULL)
+        memoChunk->Free(oldBuffer);
 }
 
 void StorageMemoKeyValue::Delete(ReadBuffer key_, StorageMemoChunk* memoChunk)
 {
-    keyLength = key_.GetLength();
-    valueLength = DELETE_LENGTH_VALUE;
-
     if (buffer == NULL)
     {
-        buffer = (char*) memoChunk->Alloc(GetLength());
-        memcpy(buffer, key_.GetBuffer(), keyLength);
+        buffer = (char*) memoChunk->Alloc(key_.GetLength());
+        memcpy(buffer, key_.GetBuffer(), key_.GetLength());
     }
+
+    keyLength = key_.GetLength();
+    valueLength = DELETE_LENGTH_VALUE;
 }
 
 char StorageMemoKeyValue::GetType()
@@ -82,3 +97,37 @@ uint32_t StorageMemoKeyValue::GetLength()
     else
         return keyLength + valueLength;
 }
+
+char StorageMemoKeyValue::ReadConcurrently(ReadBuffer& key, ReadBuffer& value) const
+{
+    char*       buffer_;
+    uint16_t    keyLength_;
+    uint32_t    valueLength_;
+
+    // each field is read once, the lengths before the buffer, because Set() writes them
+    // in the opposite order, this way the lengths never exceed the buffer
+    keyLength_ = *(volatile uint16_t*) &keyLength;
+    valueLength_ = *(volatile uint32_t*) &valueLength;
+    AtomicMemoryBarrier();
+    buffer_ = *(char* volatile*) &buffer;
+
+    key.Wrap(buffer_, keyLength_);
+    if (valueLength_ == DELETE_LENGTH_VALUE)
+    {
+        value.Reset();
+        return STORAGE_KEYVALUE_TYPE_DELETE;
+    }
+
+    value.Wrap(buffer_ + keyLength_, valueLength_);
+    return STORAGE_KEYVALUE_TYPE_SET;
+}
+
+void* StorageMemoKeyValue::GetIndexLeaf()
+{
+    return (void*) treeNode.left;
+}
+
+void StorageMemoKeyValue::SetIndexLeaf(void* leaf)
+{
+    treeNode.left = (StorageMemoKeyValue*) leaf;
+}
@@ -33,6 +33,14 @@ public:
     ReadBuffer      GetValue() const;
     uint32_t        GetLength();
 
+    // reads the key-value while the main thread may change it, the results are only
+    // consistent if the memo chunk was not written meanwhile, see StorageMemoChunk
+    char            ReadConcurrently(ReadBuffer& key, ReadBuffer& value) const;
+
+    // the leaf of the B+-tree index, stored in the tree node which that index does not use
+    void*           GetIndexLeaf();
+    void            SetIndexLeaf(void* leaf);
+
     TreeNode        treeNode;
 
 private:
@@ -0,0 +1,126 @@
+#include "StorageMergeTree.h"
+#include "StorageFileKeyValue.h"
+
+// tree[0] is the winner, tree[1..k-1] are the losers of the inner nodes,
+// leaf i is node k + i, the children of node n are 2n and 2n + 1
+
+StorageMergeTree::StorageMergeTree()
+{
+    iterators = NULL;
+    tree = NULL;
+    numIterators = 0;
+    forwardDirection = true;
+}
+
+StorageMergeTree::~StorageMergeTree()
+{
+    Clear();
+}
+
+void StorageMergeTree::Init(StorageFileKeyValue** iterators_, unsigned numIterators_,
+ bool forwardDirection_)
+{
+    Clear();
+
+    iterators = iterators_;
+    numIterators = numIterators_;
+    forwardDirection = forwardDirection_;
+    if (numIterators == 0)
+        return;
+
+    tree = new unsigned[numIterators];
+    tree[0] = Build(1);
+}
+
+void StorageMergeTree::Clear()
+{
+    delete[] tree;
+    tree = NULL;
+    iterators = NULL;
+    numIterators = 0;
+}
+
+bool StorageMergeTree::IsEmpty()
+{
+    if (numIterators == 0)
+        return true;
+
+    return iterators[tree[0]] == NULL;
+}
+
+unsigned StorageMergeTree::Top()
+{
+    ASSERT(numIterators > 0);
+    return tree[0];
+}
+
+void StorageMergeTree::UpdateTop()
+{
+    unsigned    node;
+    unsigned    winner;
+    unsigned    tmp;
+
+    ASSERT(numIterators > 0);
+
+    winner = tree[0];
+    for (node = (numIterators + winner) / 2; node > 0; node /= 2)
+    {
+        if (Less(tree[node], winner))
+        {
+            tmp = tree[node];
+            tree[node] = winner;
+            winner = tmp;
+        }
+    }
+    tree[0] = winner;
+}
+
+int StorageMergeTree::CompareTop(const ReadBuffer& key)
+{
+    const ReadBuffer&   topKey = iterators[tree[0]]->GetKeyReference();
+
+    if (forwardDirection)
+        return ReadBuffer::Cmp(topKey, key);
+    else
+        return ReadBuffer::Cmp(key, topKey);
+}
+
+unsigned StorageMergeTree::Build(unsigned node)
+{
+    unsigned    left;
+    unsigned    right;
+
+    if (node >= numIterators)
+        return node - numIterators;
+
+    left = Build(2 * node);
+    right = Build(2 * node + 1);
+    if (Less(right, left))
+    {
+        tree[node] = left;
+        return right;
+    }
+    tree[node] = right;
+    return left;
+}
+
+bool StorageMergeTree::Less(unsigned i, unsigned j)
+{
+    int     cmpres;
+
+    // exhausted iterators lose against everything
+    if (iterators[i] == NULL)
+        return false;
+    if (iterators[j] == NULL)
+        return true;
+
+    if (forwardDirection)
+        cmpres = ReadBuffer::Cmp(iterators[i]->GetKeyReference(), iterators[j]->GetKeyReference());
+    else
+        cmpres = ReadBuffer::Cmp(iterators[j]->GetKeyReference(), iterators[i]->GetKeyReference());
+    if (cmpres != 0)
+        return cmpres < 0;
+
+    // on equal keys the more recent source wins
+    return i > j;
+}
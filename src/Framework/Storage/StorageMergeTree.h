@@ -0,0 +1,48 @@
+#ifndef STORAGEMERGETREE_H
+#define STORAGEMERGETREE_H
+
+#include "System/Platform.h"
+#include "System/Buffers/ReadBuffer.h"
+
+class StorageFileKeyValue;
+
+/*
+===============================================================================================
+
+ StorageMergeTree
+
+ Loser tree over an array of sorted iterators for k-way merging chunks.
+ The iterators array is owned by the caller, a NULL iterator is exhausted.
+ Sources are sorted by relevance, on equal keys the higher index wins.
+ After advancing the iterator of the winner call UpdateTop(), which replays
+ the path to the root with log2(k) key comparisons.
+
+===============================================================================================
+*/
+
+class StorageMergeTree
+{
+public:
+    StorageMergeTree();
+    ~StorageMergeTree();
+
+    void                    Init(StorageFileKeyValue** iterators, unsigned numIterators,
+                             bool forwardDirection = true);
+    void                    Clear();
+
+    bool                    IsEmpty();
+    unsigned                Top();
+    void                    UpdateTop();
+    int                     CompareTop(const ReadBuffer& key);
+
+private:
+    unsigned                Build(unsigned node);
+    bool                    Less(unsigned i, unsigned j);
+
+    StorageFileKeyValue**   iterators;
+    unsigned*               tree;
+    unsigned                numIterators;
+    bool                    forwardDirection;
+};
+
+#endif
@@ -3,6 +3,7 @@
 StoragePage::StoragePage()
 {
     prev = next = this;
+    cacheSegment = 0;
     offset = 0;
 }
 
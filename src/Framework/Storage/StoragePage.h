@@ -7,6 +7,9 @@
 
 #define STORAGE_DEFAULT_PAGE_GRAN         (4*KiB)
 
+#define STORAGE_COMPRESSION_NONE          0
+#define STORAGE_COMPRESSION_LZ            1
+
 /*
 ===============================================================================================
 
@@ -34,6 +37,7 @@ public:
     
     StoragePage*        prev;
     StoragePage*        next;
+    unsigned char       cacheSegment;   // maintained by StoragePageCache
 
 private:
     uint64_t            offset;
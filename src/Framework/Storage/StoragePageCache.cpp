@@ -2,22 +2,41 @@
 #include "System/Registry.h"
 
 StoragePageCache::PageList StoragePageCache::metaPages;
-StoragePageCache::PageList StoragePageCache::dataPages;
+StoragePageCache::PageList StoragePageCache::probationPages;
+StoragePageCache::PageList StoragePageCache::protectedPages;
 uint64_t StoragePageCache::size = 0;
 uint64_t StoragePageCache::maxSize = 0;
+uint64_t StoragePageCache::metaSize = 0;
+uint64_t StoragePageCache::maxMetaSize = 0;
+uint64_t StoragePageCache::protectedSize = 0;
+uint64_t StoragePageCache::maxProtectedSize = 0;
 static uint64_t*    numMetaPageHits;
 static uint64_t*    numMetaPageMisses;
+static uint64_t*    numMetaPageEvictions;
 static uint64_t*    numDataPageHits;
 static uint64_t*    numDataPageMisses;
+static uint64_t*    numBulkDataPageMisses;
+static uint64_t*    numProbationPageHits;
+static uint64_t*    numProbationPageEvictions;
+static uint64_t*    numProtectedPageHits;
+static uint64_t*    numProtectedPageEvictions;
 
 void StoragePageCache::Init(StorageConfig& config)
 {
     maxSize = config.GetFileChunkCacheSize();
+    maxMetaSize = MIN(config.GetMetaPageCacheSize(), maxSize / 2);
+    maxProtectedSize = maxSize * STORAGE_PAGE_CACHE_PROTECTED_RATIO / 100;
 
     numMetaPageHits = Registry::GetUintPtr("storage.pageCache.numMetaPageHits");
     numMetaPageMisses = Registry::GetUintPtr("storage.pageCache.numMetaPageMisses");
+    numMetaPageEvictions = Registry::GetUintPtr("storage.pageCache.numMetaPageEvictions");
     numDataPageHits = Registry::GetUintPtr("storage.pageCache.numDataPageHits");
     numDataPageMisses = Registry::GetUintPtr("storage.pageCache.numDataPageMisses");
+    numBulkDataPageMisses = Registry::GetUintPtr("storage.pageCache.numBulkDataPageMisses");
+    numProbationPageHits = Registry::GetUintPtr("storage.pageCache.numProbationPageHits");
+    numProbationPageEvictions = Registry::GetUintPtr("storage.pageCache.numProbationPageEvictions");
+    numProtectedPageHits = Registry::GetUintPtr("storage.pageCache.numProtectedPageHits");
+    numProtectedPageEvictions = Registry::GetUintPtr("storage.pageCache.numProtectedPageEvictions");
 }
 
 void StoragePageCache::Shutdown()
@@ -27,26 +46,14 @@ void StoragePageCache::Shutdown()
 
 void StoragePageCache::Clear()
 {
-    StoragePage*    it;
-    
-    FOREACH_FIRST (it, metaPages)
-    {
-        metaPages.Remove(it);
-        it->Unload();
-        
-        it = metaPages.First();
-    }
-
-    FOREACH_FIRST (it, dataPages)
-    {
-        dataPages.Remove(it);
-        it->Unload();
-        
-        it = dataPages.First();
-    }
+    ClearPages(metaPages);
+    ClearPages(probationPages);
+    ClearPages(protectedPages);
 
     size = 0;
-    
+    metaSize = 0;
+    protectedSize = 0;
+
     Log_Message("Page cache cleared");
 }
 
@@ -57,7 +64,7 @@ uint64_t StoragePageCache::GetSize()
 
 unsigned StoragePageCache::GetNumPages()
 {
-    return metaPages.GetLength() + dataPages.GetLength();
+    return metaPages.GetLength() + probationPages.GetLength() + protectedPages.GetLength();
 }
 
 void StoragePageCache::AddMetaPage(StoragePage* page)
@@ -68,6 +75,8 @@ void StoragePageCache::AddMetaPage(StoragePage* page)
         RemoveOnePage();
 
     size += page->GetMemorySize();
+    metaSize += page->GetMemorySize();
+    page->cacheSegment = META;
     metaPages.Append(page);
 
     *numMetaPageMisses += 1;
@@ -79,27 +88,48 @@ void StoragePageCache::AddDataPage(StoragePage* page, bool bulk)
 
     while (size + page->GetMemorySize() > maxSize)
         RemoveOnePage();
-    
+
     size += page->GetMemorySize();
+    page->cacheSegment = PROBATION;
 
+    // bulk loaded pages are the first to go unless they are hit again
     if (bulk)
-        dataPages.Prepend(page);
+    {
+        probationPages.Prepend(page);
+        *numBulkDataPageMisses += 1;
+    }
     else
-        dataPages.Append(page);
+        probationPages.Append(page);
 
     *numDataPageMisses += 1;
 }
 
 void StoragePageCache::RemoveMetaPage(StoragePage* page)
 {
+    ASSERT(page->cacheSegment == META);
+
     size -= page->GetMemorySize();
+    metaSize -= page->GetMemorySize();
+    page->cacheSegment = NONE;
     metaPages.Remove(page);
 }
 
 void StoragePageCache::RemoveDataPage(StoragePage* page)
 {
     size -= page->GetMemorySize();
-    dataPages.Remove(page);
+
+    if (page->cacheSegment == PROTECTED)
+    {
+        protectedSize -= page->GetMemorySize();
+        protectedPages.Remove(page);
+    }
+    else
+    {
+        ASSERT(page->cacheSegment == PROBATION);
+        probationPages.Remove(page);
+    }
+
+    page->cacheSegment = NONE;
 }
 
 void StoragePageCache::RegisterMetaHit(StoragePage* page)
@@ -112,30 +142,96 @@ void StoragePageCache::RegisterMetaHit(StoragePage* page)
 
 void StoragePageCache::RegisterDataHit(StoragePage* page)
 {
-    dataPages.Remove(page);
-    dataPages.Append(page);
+    if (page->cacheSegment == PROTECTED)
+    {
+        protectedSize -= page->GetMemorySize();
+        protectedPages.Remove(page);
+        *numProtectedPageHits += 1;
+    }
+    else
+    {
+        ASSERT(page->cacheSegment == PROBATION);
+        probationPages.Remove(page);
+        *numProbationPageHits += 1;
+    }
+
+    AddProtectedPage(page);
 
     *numDataPageHits += 1;
 }
 
 void StoragePageCache::RemoveOnePage()
 {
-    StoragePage* page;
-
-    if (dataPages.GetLength() > 0)
+    if (probationPages.GetLength() > 0)
     {
-        page = dataPages.First();
-        ASSERT(page);
-        size -= page->GetMemorySize();
-        dataPages.Remove(page);
-        page->Unload();
+        EvictPage(probationPages);
+        *numProbationPageEvictions += 1;
+    }
+    else if (metaSize > maxMetaSize && metaPages.GetLength() > 0)
+    {
+        EvictPage(metaPages);
+        *numMetaPageEvictions += 1;
+    }
+    else if (protectedPages.GetLength() > 0)
+    {
+        EvictPage(protectedPages);
+        *numProtectedPageEvictions += 1;
     }
     else if (metaPages.GetLength() > 0)
     {
-        page = metaPages.First();
-        ASSERT(page);
-        size -= page->GetMemorySize();
-        metaPages.Remove(page);
-        page->Unload();
+        // pinned meta pages only go when there is nothing else left
+        EvictPage(metaPages);
+        *numMetaPageEvictions += 1;
     }
-}
\ No newline at end of file
+}
+
+void StoragePageCache::EvictPage(PageList& pages)
+{
+    StoragePage*    page;
+
+    page = pages.First();
+    ASSERT(page);
+
+    size -= page->GetMemorySize();
+    if (page->cacheSegment == META)
+        metaSize -= page->GetMemorySize();
+    else if (page->cacheSegment == PROTECTED)
+        protectedSize -= page->GetMemorySize();
+
+    page->cacheSegment = NONE;
+    pages.Remove(page);
+    page->Unload();
+}
+
+void StoragePageCache::AddProtectedPage(StoragePage* page)
+{
+    StoragePage*    demoted;
+
+    page->cacheSegment = PROTECTED;
+    protectedSize += page->GetMemorySize();
+    protectedPages.Append(page);
+
+    // demote the least recently used protected pages to the hot end of probation
+    while (protectedSize > maxProtectedSize && protectedPages.GetLength() > 1)
+    {
+        demoted = protectedPages.First();
+        protectedSize -= demoted->GetMemorySize();
+        protectedPages.Remove(demoted);
+        demoted->cacheSegment = PROBATION;
+        probationPages.Append(demoted);
+    }
+}
+
+void StoragePageCache::ClearPages(PageList& pages)
+{
+    StoragePage*    it;
+
+    FOREACH_FIRST (it, pages)
+    {
+        pages.Remove(it);
+        it->cacheSegment = NONE;
+        it->Unload();
+
+        it = pages.First();
+    }
+}
@@ -5,11 +5,23 @@
 #include "StoragePage.h"
 #include "StorageConfig.h"
 
+#define STORAGE_PAGE_CACHE_PROTECTED_RATIO  80  // percent of the cache
+
 /*
 ===============================================================================================
 
  StoragePageCache
 
+ Segmented LRU cache of file chunk pages.
+
+ Data pages enter the probation segment, and are promoted to the protected segment on the
+ first hit. Bulk loads (bulk cursors, freshly written chunks) enter at the eviction end of
+ the probation segment, so a large scan cannot flush the protected working set. The
+ protected segment is capped, its least recently used pages are demoted back to probation.
+
+ Meta pages (index and bloom pages) are pinned up to metaPageCacheSize, above that they
+ are evicted before protected data pages.
+
 ===============================================================================================
 */
 
@@ -18,6 +30,14 @@ class StoragePageCache
     typedef InList<StoragePage> PageList;
 
 public:
+    enum Segment
+    {
+        NONE,
+        META,
+        PROBATION,
+        PROTECTED
+    };
+
     static void                 Init(StorageConfig& config);
     static void                 Shutdown();
 
@@ -25,7 +45,7 @@ public:
 
     static uint64_t             GetSize();
     static unsigned             GetNumPages();
-    
+
     static void                 AddMetaPage(StoragePage* page);
     static void                 AddDataPage(StoragePage* page, bool bulk = false);
     static void                 RemoveMetaPage(StoragePage* page);
@@ -35,11 +55,19 @@ public:
 
 private:
     static void                 RemoveOnePage();
+    static void                 EvictPage(PageList& pages);
+    static void                 AddProtectedPage(StoragePage* page);
+    static void                 ClearPages(PageList& pages);
 
     static uint64_t             size;
     static uint64_t             maxSize;
+    static uint64_t             metaSize;
+    static uint64_t             maxMetaSize;
+    static uint64_t             protectedSize;
+    static uint64_t             maxProtectedSize;
     static PageList             metaPages;
-    static PageList             dataPages;
+    static PageList             probationPages;
+    static PageList             protectedPages;
 };
 
 #endif
@@ -6,12 +6,57 @@
 #include "System/PointerGuard.h"
 #include "StorageChunkSerializer.h"
 #include "StorageChunkWriter.h"
+#include "System/Config.h"
+#include "System/Threading/ThreadPool.h"
 
 static bool LessThan(const Buffer* a, const Buffer* b)
 {
     return Buffer::Cmp(*a, *b) < 0;
 }
 
+StorageRecoveryPartition::StorageRecoveryPartition()
+{
+    recovery = NULL;
+    logSegmentID = 0;
+    numCommands = 0;
+}
+
+void StorageRecoveryPartition::Append(StorageRecoveryCommand& command)
+{
+    commands.Append((const char*) &command, sizeof(StorageRecoveryCommand));
+    numCommands++;
+}
+
+void StorageRecoveryPartition::Apply()
+{
+    unsigned                    i;
+    StorageRecoveryCommand*     command;
+
+    // (may run in a worker thread)
+    command = (StorageRecoveryCommand*) commands.GetBuffer();
+    for (i = 0; i < numCommands; i++, command++)
+    {
+        if (command->type == STORAGE_LOGSEGMENT_COMMAND_SET)
+            recovery->ApplySet(command->shard, logSegmentID, command->logCommandID, command->key, command->value);
+        else
+            recovery->ApplyDelete(command->shard, logSegmentID, command->logCommandID, command->key);
+    }
+
+    commands.Clear();
+    numCommands = 0;
+}
+
+StorageRecovery::StorageRecovery()
+{
+    numPartitions = 0;
+    partitions = NULL;
+}
+
+StorageRecovery::~StorageRecovery()
+{
+    delete[] partitions;
+}
+
 bool StorageRecovery::TryRecovery(StorageEnvironment* env_)
 {
     uint64_t            trackID;
@@ -22,8 +67,20 @@ bool StorageRecovery::TryRecovery(StorageEnvironment* env_)
     FS_DirEntry         entry;
     List<uint64_t>      replayedTrackIDs;
     Stopwatch           replayStopwatch;
+    Stopwatch           tocStopwatch;
+    Stopwatch           cleanupStopwatch;
+    unsigned            i;
     
     env = env_;
+
+    numPartitions = configFile.GetIntValue("database.numRecoveryThreads", 4);
+    if (numPartitions < 1)
+        numPartitions = 1;
+    partitions = new StorageRecoveryPartition[numPartitions];
+    for (i = 0; i < numPartitions; i++)
+        partitions[i].recovery = this;
+
+    tocStopwatch.Start();
     
     toc.Write(env->envPath);
     toc.Append("toc");
@@ -49,6 +106,7 @@ bool StorageRecovery::TryRecovery(StorageEnvironment* env_)
     // compute the max. (logSegmentID, commandID) for each shard's chunk
     // log entries smaller must not be applied to its memo chunk
     ComputeShardRecovery();
+    tocStopwatch.Stop();
 
     tmp.Write(env->logPath);
     tmp.NullTerminate();
@@ -85,8 +143,18 @@ bool StorageRecovery::TryRecovery(StorageEnvironment* env_)
     replayTime = replayStopwatch.Elapsed();
 
     FS_CloseDir(dir);
+    cleanupStopwatch.Start();
     DeleteOrphanedChunks();
     DeleteOrphanedTracks();
+    cleanupStopwatch.Stop();
+
+    Log_Message("Recovery done, elapsed: %U msec (TOC: %U, replay: %U, cleanup: %U)",
+     (uint64_t) (tocStopwatch.Elapsed() + replayStopwatch.Elapsed() + cleanupStopwatch.Elapsed()),
+     (uint64_t) tocStopwatch.Elapsed(), (uint64_t) replayStopwatch.Elapsed(),
+     (uint64_t) cleanupStopwatch.Elapsed());
+    Log_Message("Replay phases, read: %U msec, parse: %U msec, apply: %U msec (%u threads), write chunks: %U msec",
+     (uint64_t) readStopwatch.Elapsed(), (uint64_t) parseStopwatch.Elapsed(),
+     (uint64_t) applyStopwatch.Elapsed(), numPartitions, (uint64_t) writeStopwatch.Elapsed());
     
     return true;
 }
@@ -237,6 +305,7 @@ bool StorageRecovery::ReadShardVersion1(ReadBuffer& parse)
         shard->chunks.Add(fileChunk);
     }
 
+    env->shardIndex.Add(shardGuard.Get());
     env->shards.Append(shardGuard.Release());
     
     return true;
@@ -333,7 +402,9 @@ void StorageRecovery::ReplayLogSegments(uint64_t trackID)
         //    ReplayLogSegment(trackID, *segmentName);
         //else
         //    ReplayLogSegmentOpt(trackID, *segmentName);
+        writeStopwatch.Start();
         TryWriteChunks();
+        writeStopwatch.Stop();
     }
 
     FOREACH_FIRST (itSegmentName, segmentNames)
@@ -580,8 +651,10 @@ bool StorageRecovery::ReplayLogSegmentOpt(uint64_t trackID, Buffer& filename)
 
     replayBytes += fileSize;
 
+    readStopwatch.Start();
     fileBuffer.Allocate(fileSize);
     ret = FS_FileRead(fd.GetFD(), fileBuffer.GetBuffer(), fileSize);
+    readStopwatch.Stop();
     if (ret < 0 || (uint64_t) ret != fileSize)
         return false;
     fileBuffer.SetLength(fileSize);
@@ -600,6 +673,8 @@ bool StorageRecovery::ReplayLogSegmentOpt(uint64_t trackID, Buffer& filename)
     
     logCommandID = 1;
 
+    // commands are collected by shard while parsing and applied after the whole segment is parsed
+    parseStopwatch.Start();
     while (true)
     {
         // read header that contains the size of the block
@@ -672,16 +747,18 @@ bool StorageRecovery::ReplayLogSegmentOpt(uint64_t trackID, Buffer& filename)
                 parse.Advance(vlen);
             }
             
-            if (type == STORAGE_LOGSEGMENT_COMMAND_SET)
-                ExecuteSet(logSegmentID, logCommandID, contextID, shardID, key, value);
-            else if (type == STORAGE_LOGSEGMENT_COMMAND_DELETE)
-                ExecuteDelete(logSegmentID, logCommandID, contextID, shardID, key);
-            else
+            if (type != STORAGE_LOGSEGMENT_COMMAND_SET && type != STORAGE_LOGSEGMENT_COMMAND_DELETE)
                 ASSERT_FAIL();
+
+            AppendCommand(type, logSegmentID, logCommandID, contextID, shardID, key, value);
             
             logCommandID++;
         }
     }
+    parseStopwatch.Stop();
+
+    // fileBuffer must be kept until the commands are applied
+    ApplyCommands(logSegmentID);
     
     track = env->logManager.GetTrack(trackID);
     if (!track)
@@ -794,18 +871,45 @@ void StorageRecovery::ExecuteSet(
                          ReadBuffer& key, ReadBuffer& value)
 {
     StorageShard*       shard;
-    StorageMemoChunk*   memoChunk;
+
+    shard = GetReplayShard(logSegmentID, logCommandID, contextID, shardID, key);
+    if (shard == NULL)
+        return;
+
+    ApplySet(shard, logSegmentID, logCommandID, key, value);
+}
+
+void StorageRecovery::ExecuteDelete(
+                         uint64_t logSegmentID, uint32_t logCommandID,
+                         uint16_t contextID, uint64_t shardID,
+                         ReadBuffer& key)
+{
+    StorageShard*       shard;
+
+    shard = GetReplayShard(logSegmentID, logCommandID, contextID, shardID, key);
+    if (shard == NULL)
+        return;
+
+    ApplyDelete(shard, logSegmentID, logCommandID, key);
+}
+
+StorageShard* StorageRecovery::GetReplayShard(
+                         uint64_t logSegmentID, uint32_t logCommandID,
+                         uint16_t contextID, uint64_t shardID,
+                         ReadBuffer& key)
+{
+    StorageShard*       shard;
 
     shard  = env->GetShard(contextID, shardID);
     if (shard == NULL)
-        return; // shard was deleted
+        return NULL; // shard was deleted
 
     // shard was split and key now belongs to another shard
     if (!shard->RangeContains(key))
     {
         shard = env->GetShardByKey(contextID, shard->tableID, key);
         if (shard == NULL)
-            return;
+            return NULL;
     }
     
     //if (shard->logSegmentID > logSegmentID)
@@ -815,10 +919,19 @@ void StorageRecovery::ExecuteSet(
     //    return; // shard was deleted and re-created 
 
     if (shard->recoveryLogSegmentID > logSegmentID)
-        return; // this command is already present in a file chunk
+        return NULL; // this command is already present in a file chunk
 
     if (shard->recoveryLogSegmentID == logSegmentID && shard->recoveryLogCommandID >= logCommandID)
-        return; // this command is already present in a file chunk
+        return NULL; // this command is already present in a file chunk
+
+    return shard;
+}
+
+void StorageRecovery::ApplySet(StorageShard* shard,
+                         uint64_t logSegmentID, uint32_t logCommandID,
+                         ReadBuffer& key, ReadBuffer& value)
+{
+    StorageMemoChunk*   memoChunk;
 
     memoChunk = shard->GetMemoChunk();
     ASSERT(memoChunk != NULL);
@@ -835,41 +948,15 @@ void StorageRecovery::ExecuteSet(
     memoChunk->RegisterLogCommand(logSegmentID, logCommandID);
 }
 
-void StorageRecovery::ExecuteDelete(
+void StorageRecovery::ApplyDelete(StorageShard* shard,
                          uint64_t logSegmentID, uint32_t logCommandID,
-                         uint16_t contextID, uint64_t shardID,
                          ReadBuffer& key)
 {
-    StorageShard*       shard;
     StorageMemoChunk*   memoChunk;
-    
-    shard  = env->GetShard(contextID, shardID);
-    if (shard == NULL)
-        return; // shard was deleted
-
-    // shard was split and key now belongs to another shard
-    if (!shard->RangeContains(key))
-    {
-        shard = env->GetShardByKey(contextID, shard->tableID, key);
-        if (shard == NULL)
-            return;
-    }
 
     if (shard->GetStorageType() == STORAGE_SHARD_TYPE_LOG)
         ASSERT_FAIL();
     
-    //if (shard->logSegmentID > logSegmentID)
-    //    return; // shard was deleted and re-created
-    //
-    //if (shard->logSegmentID == logSegmentID && shard->logCommandID > logCommandID)
-    //    return; // shard was deleted and re-created 
-
-    if (shard->recoveryLogSegmentID > logSegmentID)
-        return; // this command is already present in a file chunk
-
-    if (shard->recoveryLogSegmentID == logSegmentID && shard->recoveryLogCommandID >= logCommandID)
-        return; // this command is already present in a file chunk
-        
     memoChunk = shard->GetMemoChunk();
     ASSERT(memoChunk != NULL);
     if (!memoChunk->Delete(key))
@@ -878,6 +965,69 @@ void StorageRecovery::ExecuteDelete(
     memoChunk->RegisterLogCommand(logSegmentID, logCommandID);
 }
 
+void StorageRecovery::AppendCommand(char type,
+                         uint64_t logSegmentID, uint32_t logCommandID,
+                         uint16_t contextID, uint64_t shardID,
+                         ReadBuffer& key, ReadBuffer& value)
+{
+    StorageShard*           shard;
+    StorageRecoveryCommand  command;
+
+    shard = GetReplayShard(logSegmentID, logCommandID, contextID, shardID, key);
+    if (shard == NULL)
+        return;
+
+    command.type = type;
+    command.logCommandID = logCommandID;
+    command.shard = shard;
+    command.key = key;
+    command.value = value;
+
+    // the commands of one shard always go to the same partition, so they are applied in order
+    partitions[shard->GetShardID() % numPartitions].Append(command);
+}
+
+void StorageRecovery::ApplyCommands(uint64_t logSegmentID)
+{
+    unsigned        i;
+    unsigned        numActive;
+    ThreadPool*     threadPool;
+
+    applyStopwatch.Start();
+
+    numActive = 0;
+    for (i = 0; i < numPartitions; i++)
+    {
+        partitions[i].logSegmentID = logSegmentID;
+        if (partitions[i].numCommands > 0)
+            numActive++;
+    }
+
+    if (numActive > 1)
+    {
+        threadPool = ThreadPool::Create(numActive);
+        threadPool->Start();
+        for (i = 0; i < numPartitions; i++)
+        {
+            if (partitions[i].numCommands > 0)
+                threadPool->Execute(MFUNC_OF(StorageRecoveryPartition, Apply, &partitions[i]));
+        }
+        threadPool->WaitStop();
+        delete threadPool;
+    }
+    else
+    {
+        // no need to start threads for a single partition
+        for (i = 0; i < numPartitions; i++)
+        {
+            if (partitions[i].numCommands > 0)
+                partitions[i].Apply();
+        }
+    }
+
+    applyStopwatch.Stop();
+}
+
 void StorageRecovery::TryWriteChunks()
 {
     StorageShard*           shard;
@@ -1,11 +1,55 @@
 #ifndef STORAGERECOVERY_H
 #define STORAGERECOVERY_H
 
+#include "System/Stopwatch.h"
 #include "StorageEnvironment.h"
 
 #define STORAGE_RECOVERY_PRELOAD_SIZE   (1024*1024)
 
 class StorageEnvironment;
+class StorageRecovery;
+
+/*
+===============================================================================================
+
+ StorageRecoveryCommand
+
+===============================================================================================
+*/
+
+struct StorageRecoveryCommand
+{
+    char                    type;
+    uint32_t                logCommandID;
+    StorageShard*           shard;
+    ReadBuffer              key;
+    ReadBuffer              value;
+};
+
+/*
+===============================================================================================
+
+ StorageRecoveryPartition
+
+ The commands of a log segment are partitioned by shard, the partitions are applied
+ to their memo chunks in parallel, each partition in log order.
+
+===============================================================================================
+*/
+
+class StorageRecoveryPartition
+{
+public:
+    StorageRecoveryPartition();
+
+    void                    Append(StorageRecoveryCommand& command);
+    void                    Apply();
+
+    StorageRecovery*        recovery;
+    uint64_t                logSegmentID;
+    unsigned                numCommands;
+    Buffer                  commands;   // packed StorageRecoveryCommand structs
+};
 
 /*
 ===============================================================================================
@@ -17,7 +61,13 @@ class StorageEnvironment;
 
 class StorageRecovery
 {
+    friend class StorageRecoveryPartition;
+
 public:
+    StorageRecovery();
+    ~StorageRecovery();
+
+
     bool                    TryRecovery(StorageEnvironment* env);
     uint64_t                GetReplayBytesPerSec();
     
@@ -43,6 +93,25 @@ private:
                              uint64_t logSegmentID, uint32_t logCommandID,
                              uint16_t contextID, uint64_t shardID,
                              ReadBuffer& key);
+
+    StorageShard*           GetReplayShard(
+                             uint64_t logSegmentID, uint32_t logCommandID,
+                             uint16_t contextID, uint64_t shardID,
+                             ReadBuffer& key);
+
+    void                    ApplySet(StorageShard* shard,
+                             uint64_t logSegmentID, uint32_t logCommandID,
+                             ReadBuffer& key, ReadBuffer& value);
+
+    void                    ApplyDelete(StorageShard* shard,
+                             uint64_t logSegmentID, uint32_t logCommandID,
+                             ReadBuffer& key);
+
+    void                    AppendCommand(char type,
+                             uint64_t logSegmentID, uint32_t logCommandID,
+                             uint16_t contextID, uint64_t shardID,
+                             ReadBuffer& key, ReadBuffer& value);
+    void                    ApplyCommands(uint64_t logSegmentID);
     
     void                    TryWriteChunks();
 
@@ -51,6 +120,12 @@ private:
     uint64_t                fileBufferPos;
     uint64_t                replayBytes;
     uint64_t                replayTime;
+    unsigned                numPartitions;
+    StorageRecoveryPartition* partitions;
+    Stopwatch               readStopwatch;
+    Stopwatch               parseStopwatch;
+    Stopwatch               applyStopwatch;
+    Stopwatch               writeStopwatch;
 };
 
 #endif
@@ -13,6 +13,8 @@ static inline bool operator==(const ReadBuffer& a, const ReadBuffer& b)
 StorageShard::StorageShard()
 {
     prev = next = this;
+    idNode.shard = this;
+    rangeNode.shard = this;
     trackID = 0;
     contextID = 0;
     tableID = 0;
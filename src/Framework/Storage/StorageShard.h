@@ -5,6 +5,7 @@
 #include "System/Containers/SortedList.h"
 #include "StorageMemoChunk.h"
 #include "StorageFileChunk.h"
+#include "StorageShardIndex.h"
 
 class StorageRecovery;
 class StorageBulkCursor;
@@ -76,6 +77,10 @@ public:
     StorageShard*       prev;
     StorageShard*       next;
 
+    // contextID, shardID, tableID and firstKey must not change while indexed
+    StorageShardIDNode      idNode;
+    StorageShardRangeNode   rangeNode;
+
     StorageMemoChunk*   memoChunk;
 
 private:
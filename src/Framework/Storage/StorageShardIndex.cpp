@@ -0,0 +1,222 @@
+#include "StorageShardIndex.h"
+#include "StorageShard.h"
+
+struct StorageShardIDKey
+{
+    uint16_t    contextID;
+    uint64_t    shardID;
+};
+
+struct StorageShardRangeKey
+{
+    uint16_t    contextID;
+    uint64_t    tableID;
+    ReadBuffer  key;
+    bool        infinite;   // sorts after every key of the table
+    uint64_t    shardID;    // tie-breaker, the Paxos and log shards of all quorums share the same range
+};
+
+static inline const StorageShardIDKey Key(StorageShardIDNode* node)
+{
+    StorageShardIDKey   key;
+
+    key.contextID = node->shard->GetContextID();
+    key.shardID = node->shard->GetShardID();
+    return key;
+}
+
+static inline int KeyCmp(const StorageShardIDKey& a, const StorageShardIDKey& b)
+{
+    if (a.contextID < b.contextID)
+        return -1;
+    if (a.contextID > b.contextID)
+        return 1;
+    if (a.shardID < b.shardID)
+        return -1;
+    if (a.shardID > b.shardID)
+        return 1;
+    return 0;
+}
+
+static inline const StorageShardRangeKey Key(StorageShardRangeNode* node)
+{
+    StorageShardRangeKey    key;
+
+    key.contextID = node->shard->GetContextID();
+    key.tableID = node->shard->GetTableID();
+    key.key = node->shard->GetFirstKey();
+    key.infinite = false;
+    key.shardID = node->shard->GetShardID();
+    return key;
+}
+
+static inline int KeyCmp(const StorageShardRangeKey& a, const StorageShardRangeKey& b)
+{
+    int     cmpres;
+
+    if (a.contextID < b.contextID)
+        return -1;
+    if (a.contextID > b.contextID)
+        return 1;
+    if (a.tableID < b.tableID)
+        return -1;
+    if (a.tableID > b.tableID)
+        return 1;
+    if (a.infinite || b.infinite)
+        return (int) a.infinite - (int) b.infinite;
+    cmpres = ReadBuffer::Cmp(a.key, b.key);
+    if (cmpres != 0)
+        return cmpres;
+    if (a.shardID < b.shardID)
+        return -1;
+    if (a.shardID > b.shardID)
+        return 1;
+    return 0;
+}
+
+StorageShardIDNode::StorageShardIDNode()
+{
+    shard = NULL;
+}
+
+StorageShardRangeNode::StorageShardRangeNode()
+{
+    shard = NULL;
+}
+
+void StorageShardIndex::Add(StorageShard* shard)
+{
+    StorageShardIDNode*     replacedID;
+    StorageShardRangeNode*  replacedRange;
+
+    replacedID = idTree.Insert<StorageShardIDKey>(&shard->idNode);
+    ASSERT(replacedID == NULL);
+
+    replacedRange = rangeTree.Insert<StorageShardRangeKey>(&shard->rangeNode);
+    ASSERT(replacedRange == NULL);
+}
+
+void StorageShardIndex::Remove(StorageShard* shard)
+{
+    idTree.Remove(&shard->idNode);
+    rangeTree.Remove(&shard->rangeNode);
+}
+
+void StorageShardIndex::Clear()
+{
+    idTree.Clear();
+    rangeTree.Clear();
+}
+
+unsigned StorageShardIndex::GetCount()
+{
+    return idTree.GetCount();
+}
+
+StorageShard* StorageShardIndex::Get(uint16_t contextID, uint64_t shardID)
+{
+    StorageShardIDKey   key;
+    StorageShardIDNode* node;
+
+    key.contextID = contextID;
+    key.shardID = shardID;
+
+    node = idTree.Get(key);
+    if (node == NULL)
+        return NULL;
+
+    return node->shard;
+}
+
+StorageShard* StorageShardIndex::GetByKey(uint16_t contextID, uint64_t tableID, ReadBuffer& key)
+{
+    StorageShardRangeKey    rangeKey;
+    StorageShardRangeNode*  node;
+    StorageShard*           shard;
+    int                     cmpres;
+
+    rangeKey.contextID = contextID;
+    rangeKey.tableID = tableID;
+    rangeKey.key = key;
+    rangeKey.infinite = false;
+    rangeKey.shardID = (uint64_t) -1;
+
+    // find the shard with the greatest firstKey <= key
+    node = rangeTree.Locate(rangeKey, cmpres);
+    if (node != NULL && cmpres < 0)
+        node = rangeTree.Prev(node);
+    if (node == NULL)
+        return NULL;
+
+    shard = node->shard;
+    if (shard->GetContextID() != contextID || shard->GetTableID() != tableID)
+        return NULL;
+
+    if (!shard->RangeContains(key))
+        return NULL;
+
+    return shard;
+}
+
+StorageShard* StorageShardIndex::GetByLastKey(uint16_t contextID, uint64_t tableID, ReadBuffer& lastKey)
+{
+    StorageShardRangeKey    rangeKey;
+    StorageShardRangeNode*  node;
+    StorageShard*           shard;
+    int                     cmpres;
+
+    if (lastKey.GetLength() == 0)
+    {
+        shard = GetLastInTable(contextID, tableID);
+        if (shard == NULL || shard->GetLastKey().GetLength() != 0)
+            return NULL;
+        return shard;
+    }
+
+    rangeKey.contextID = contextID;
+    rangeKey.tableID = tableID;
+    rangeKey.key = lastKey;
+    rangeKey.infinite = false;
+    rangeKey.shardID = 0;
+
+    // find the shard with the greatest firstKey < lastKey
+    node = rangeTree.Locate(rangeKey, cmpres);
+    if (node != NULL && cmpres <= 0)
+        node = rangeTree.Prev(node);
+    if (node == NULL)
+        return NULL;
+
+    shard = node->shard;
+    if (shard->GetContextID() != contextID || shard->GetTableID() != tableID)
+        return NULL;
+
+    if (!shard->GetLastKey().Equals(lastKey))
+        return NULL;
+
+    return shard;
+}
+
+StorageShard* StorageShardIndex::GetLastInTable(uint16_t contextID, uint64_t tableID)
+{
+    StorageShardRangeKey    rangeKey;
+    StorageShardRangeNode*  node;
+    StorageShard*           shard;
+    int                     cmpres;
+
+    rangeKey.contextID = contextID;
+    rangeKey.tableID = tableID;
+    rangeKey.infinite = true;
+    rangeKey.shardID = 0;
+
+    node = rangeTree.Locate(rangeKey, cmpres);
+    if (node != NULL && cmpres < 0)
+        node = rangeTree.Prev(node);
+    if (node == NULL)
+        return NULL;
+
+    shard = node->shard;
+    if (shard->GetContextID() != contextID || shard->GetTableID() != tableID)
+        return NULL;
+
+    return shard;
+}
@@ -0,0 +1,90 @@
+#ifndef STORAGESHARDINDEX_H
+#define STORAGESHARDINDEX_H
+
+#include "System/Platform.h"
+#include "System/Buffers/ReadBuffer.h"
+#include "System/Containers/InTreeMap.h"
+
+class StorageShard;
+
+/*
+===============================================================================================
+
+ StorageShardIDNode
+
+ Intrusive node of the (contextID, shardID) => StorageShard index.
+
+===============================================================================================
+*/
+
+class StorageShardIDNode
+{
+public:
+    typedef InTreeNode<StorageShardIDNode> TreeNode;
+
+    StorageShardIDNode();
+
+    StorageShard*       shard;
+    TreeNode            treeNode;
+};
+
+/*
+===============================================================================================
+
+ StorageShardRangeNode
+
+ Intrusive node of the (contextID, tableID, firstKey, shardID) => StorageShard index.
+
+===============================================================================================
+*/
+
+class StorageShardRangeNode
+{
+public:
+    typedef InTreeNode<StorageShardRangeNode> TreeNode;
+
+    StorageShardRangeNode();
+
+    StorageShard*       shard;
+    TreeNode            treeNode;
+};
+
+/*
+===============================================================================================
+
+ StorageShardIndex
+
+ Keeps the shards of a StorageEnvironment ordered by (contextID, shardID) and by
+ (contextID, tableID, firstKey, shardID), so that shard routing is O(log n) instead
+ of a linear scan over all shards. Shard ranges of the same data table are disjoint,
+ so the shard containing a key is the one with the greatest firstKey <= key. The
+ Paxos and log shards of all quorums have the same range, they are told apart by
+ shardID.
+
+===============================================================================================
+*/
+
+class StorageShardIndex
+{
+    typedef InTreeMap<StorageShardIDNode>       IDTree;
+    typedef InTreeMap<StorageShardRangeNode>    RangeTree;
+
+public:
+    void                Add(StorageShard* shard);
+    void                Remove(StorageShard* shard);
+    void                Clear();
+
+    unsigned            GetCount();
+
+    StorageShard*       Get(uint16_t contextID, uint64_t shardID);
+    StorageShard*       GetByKey(uint16_t contextID, uint64_t tableID, ReadBuffer& key);
+    StorageShard*       GetByLastKey(uint16_t contextID, uint64_t tableID, ReadBuffer& lastKey);
+
+private:
+    StorageShard*       GetLastInTable(uint16_t contextID, uint64_t tableID);
+
+    IDTree              idTree;
+    RangeTree           rangeTree;
+};
+
+#endif
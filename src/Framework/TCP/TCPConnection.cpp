@@ -93,6 +93,10 @@ void TCPConnection::Close()
 
     writeBuffers[0].Reset();
     writeBuffers[1].Reset();
+    ReleaseSegments(writeSegments[0]);
+    ReleaseSegments(writeSegments[1]);
+    while (freeSegments.GetLength() > 0)
+        delete freeSegments.Pop();
 
     socket.Close();
     state = DISCONNECTED;
@@ -109,9 +113,70 @@ Buffer& TCPConnection::GetWriteBuffer()
     return writeBuffers[writeIndex];
 }
 
+unsigned TCPConnection::GetWriteLength()
+{
+    TCPWriteSegment*    it;
+    unsigned            length;
+
+    length = writeBuffers[writeIndex].GetLength();
+    FOREACH (it, writeSegments[writeIndex])
+        length += it->data->GetLength();
+
+    return length;
+}
+
+Buffer* TCPConnection::AcquireSegment()
+{
+    Buffer*     segment;
+
+    if (freeSegments.GetLength() > 0)
+    {
+        segment = freeSegments.Pop();
+        segment->SetLength(0);
+        return segment;
+    }
+
+    return new Buffer;
+}
+
+void TCPConnection::ReleaseSegment(Buffer* segment)
+{
+    if (freeSegments.GetLength() >= TCP_SEGMENT_POOL_SIZE ||
+     segment->GetSize() > TCP_SEGMENT_POOL_MAX_SIZE)
+    {
+        delete segment;
+        return;
+    }
+
+    freeSegments.Append(segment);
+}
+
+void TCPConnection::WriteSegment(Buffer* segment)
+{
+    TCPWriteSegment     writeSegment;
+
+    writeSegment.offset = writeBuffers[writeIndex].GetLength();
+    writeSegment.data = segment;
+    writeSegments[writeIndex].Append(writeSegment);
+}
+
 uint64_t TCPConnection::GetMemoryUsage()
 {
-    return sizeof(*this) + readBuffer.GetSize() + writeBuffers[0].GetSize() + writeBuffers[1].GetSize();
+    TCPWriteSegment*    it;
+    Buffer**            itFree;
+    uint64_t            usage;
+    unsigned            i;
+
+    usage = sizeof(*this) + readBuffer.GetSize() + writeBuffers[0].GetSize() + writeBuffers[1].GetSize();
+    for (i = 0; i < 2; i++)
+    {
+        FOREACH (it, writeSegments[i])
+            usage += it->data->GetSize();
+    }
+    FOREACH (itFree, freeSegments)
+        usage += (*itFree)->GetSize();
+
+    return usage;
 }
 
 void TCPConnection::AsyncRead(bool start)
@@ -130,7 +195,8 @@ void TCPConnection::AsyncRead(bool start)
 
 void TCPConnection::TryFlush()
 {
-    if (state == DISCONNECTED || tcpwrite.active || writeBuffers[writeIndex].GetLength() == 0)
+    if (state == DISCONNECTED || tcpwrite.active ||
+     (writeBuffers[writeIndex].GetLength() == 0 && writeSegments[writeIndex].GetLength() == 0))
     {
         Log_Trace("Not flushing, fd = %d", (int) tcpwrite.fd);
         return;
@@ -139,13 +205,24 @@ void TCPConnection::TryFlush()
     writeIndex = 1 - writeIndex;
     
     writeBuffers[writeIndex].SetLength(0);
+    ReleaseSegments(writeSegments[writeIndex]);
 
     tcpwrite.SetBuffer(&writeBuffers[1 - writeIndex]);
+    tcpwrite.segments = &writeSegments[1 - writeIndex];
     tcpwrite.transferred = 0;
     IOProcessor::Add(&tcpwrite);
     Log_Trace("Flushing, added tcpwrite, fd = %d", (int) tcpwrite.fd);
 }
 
+void TCPConnection::ReleaseSegments(List<TCPWriteSegment>& segments)
+{
+    TCPWriteSegment*    it;
+
+    FOREACH (it, segments)
+        ReleaseSegment(it->data);
+    segments.Clear();
+}
+
 void TCPConnection::Init(bool startRead)
 {
     Log_Trace();
@@ -167,6 +244,8 @@ void TCPConnection::OnWrite()
     Log_Trace("Written %d bytes on fd %d, bytes: %B",
      tcpwrite.buffer->GetLength(), (int)socket.fd, tcpwrite.buffer);
 
+    // the written segments go back to the pool
+    ReleaseSegments(writeSegments[1 - writeIndex]);
     TryFlush();
     
     if (state != DISCONNECTED || !tcpwrite.active)
@@ -5,14 +5,21 @@
 #include "System/Events/Countdown.h"
 #include "System/Buffers/Buffer.h"
 #include "System/Containers/InQueue.h"
+#include "System/Containers/List.h"
 #include "System/IO/Socket.h"
 #include "System/IO/IOOperation.h"
 
+#define TCP_SEGMENT_POOL_SIZE       4
+#define TCP_SEGMENT_POOL_MAX_SIZE   (256*KiB)   // larger segment buffers are freed
+
 /*
 ===============================================================================================
 
  TCPConnection
 
+ Large messages can be queued as segments instead of being copied into the write buffer,
+ the write buffer and the segments are sent together with scatter-gather I/O.
+
 ===============================================================================================
 */
 
@@ -32,6 +39,13 @@ public:
     Socket&             GetSocket() { return socket; }
     State               GetState() { return state; }
     Buffer&             GetWriteBuffer();
+    // bytes queued since the last flush, including segments
+    unsigned            GetWriteLength();
+    // returns an empty buffer from the segment pool
+    Buffer*             AcquireSegment();
+    void                ReleaseSegment(Buffer* segment);
+    // queues the segment after the data in the write buffer, the connection owns it
+    void                WriteSegment(Buffer* segment);
     virtual uint64_t    GetMemoryUsage();
     
     void                AsyncRead(bool start = true);
@@ -43,6 +57,7 @@ public:
 
 protected:
     void                TryFlush();
+    void                ReleaseSegments(List<TCPWriteSegment>& segments);
     void                Init(bool startRead = true);
     virtual void        OnRead() = 0;
     virtual void        OnWrite();
@@ -57,6 +72,8 @@ protected:
     TCPWrite            tcpwrite;
     Buffer              readBuffer;
     Buffer              writeBuffers[2];
+    List<TCPWriteSegment> writeSegments[2];
+    List<Buffer*>       freeSegments;
     unsigned            writeIndex;
     uint64_t            connectTime;
     Countdown           connectTimeout;
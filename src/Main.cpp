@@ -93,6 +93,7 @@ static void RunApplication()
     StartClock();
     ConfigureSystemSettings();
     
+    IOProcessor::UseURing(configFile.GetBoolValue("io.uring", false));
     IOProcessor::Init(configFile.GetIntValue("io.maxfd", 32768));
     InitContextTransport();
     BloomFilter::StaticInit();
@@ -264,6 +264,23 @@ void Buffer::AppendLittle64(uint64_t x)
     Append((const char*) &x, sizeof(uint64_t));
 }
 
+void Buffer::AppendVarint(uint64_t x)
+{
+    char    buf[10];
+    int     len;
+
+    // 7 bits per byte, least significant group first, high bit set on all but the last byte
+    len = 0;
+    while (x >= 0x80)
+    {
+        buf[len++] = (char) (x | 0x80);
+        x >>= 7;
+    }
+    buf[len++] = (char) x;
+
+    Append(buf, len);
+}
+
 char Buffer::GetCharAt(unsigned i)
 {
     if (i > length - 1)
@@ -0,0 +1,231 @@
+#include "Compressor.h"
+#include "System/Macros.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#define MIN_MATCH           4
+#define MAX_OFFSET          65535
+#define LAST_LITERALS       5       // the last bytes are always literals
+#define MATCH_LIMIT         12      // no match starts this close to the end
+#define SKIP_TRIGGER        6       // speed up on incompressible input
+
+static inline uint32_t Read32(const unsigned char* p)
+{
+    uint32_t    v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t HashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - COMPRESSOR_HASH_LOG);
+}
+
+static inline unsigned char* WriteLength(unsigned char* op, unsigned length)
+{
+    while (length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (unsigned char) length;
+    return op;
+}
+
+static inline unsigned char* WriteSequence(unsigned char* op,
+ const unsigned char* literals, unsigned numLiterals, unsigned offset, unsigned matchLength)
+{
+    unsigned char*  token;
+
+    token = op++;
+
+    if (numLiterals >= 15)
+    {
+        *token = 15 << 4;
+        op = WriteLength(op, numLiterals - 15);
+    }
+    else
+        *token = numLiterals << 4;
+
+    memcpy(op, literals, numLiterals);
+    op += numLiterals;
+
+    if (matchLength == 0)
+        return op; // last sequence has literals only
+
+    *op++ = offset & 0xFF;
+    *op++ = (offset >> 8) & 0xFF;
+
+    matchLength -= MIN_MATCH;
+    if (matchLength >= 15)
+    {
+        *token |= 15;
+        op = WriteLength(op, matchLength - 15);
+    }
+    else
+        *token |= matchLength;
+
+    return op;
+}
+
+Compressor::Compressor()
+{
+    hashTable = NULL;
+}
+
+Compressor::~Compressor()
+{
+    free(hashTable);
+}
+
+unsigned Compressor::GetMaxCompressedLength(unsigned length)
+{
+    return length + length / 255 + 16;
+}
+
+void Compressor::Compress(ReadBuffer input, Buffer& output)
+{
+    const unsigned char*    base;
+    const unsigned char*    ip;
+    const unsigned char*    anchor;
+    const unsigned char*    end;
+    const unsigned char*    matchLimit;
+    const unsigned char*    ref;
+    unsigned char*          obase;
+    unsigned char*          op;
+    uint32_t                sequence;
+    uint32_t                hash;
+    unsigned                matchLength;
+    unsigned                misses;
+    unsigned                length;
+
+    if (hashTable == NULL)
+        hashTable = (uint32_t*) malloc(COMPRESSOR_HASH_SIZE * sizeof(uint32_t));
+    memset(hashTable, 0, COMPRESSOR_HASH_SIZE * sizeof(uint32_t));
+
+    length = input.GetLength();
+    output.Allocate(output.GetLength() + GetMaxCompressedLength(length));
+    obase = (unsigned char*) output.GetPosition();
+    op = obase;
+
+    base = (const unsigned char*) input.GetBuffer();
+    ip = base;
+    anchor = base;
+    end = base + length;
+    matchLimit = (length > MATCH_LIMIT) ? end - MATCH_LIMIT : base;
+    misses = 0;
+
+    while (ip < matchLimit)
+    {
+        sequence = Read32(ip);
+        hash = HashSequence(sequence);
+        ref = base + hashTable[hash];
+        hashTable[hash] = (uint32_t) (ip - base);
+
+        if (ref >= ip || ip - ref > MAX_OFFSET || Read32(ref) != sequence)
+        {
+            ip += 1 + (misses++ >> SKIP_TRIGGER);
+            continue;
+        }
+
+        matchLength = MIN_MATCH;
+        while (ip + matchLength < end - LAST_LITERALS && ref[matchLength] == ip[matchLength])
+            matchLength++;
+
+        op = WriteSequence(op, anchor, ip - anchor, ip - ref, matchLength);
+        ip += matchLength;
+        anchor = ip;
+        misses = 0;
+    }
+
+    op = WriteSequence(op, anchor, end - anchor, 0, 0);
+
+    output.SetLength(output.GetLength() + (op - obase));
+}
+
+bool Compressor::Uncompress(ReadBuffer input, Buffer& output, uint32_t uncompressedLength)
+{
+    const unsigned char*    ip;
+    const unsigned char*    end;
+    unsigned char*          obase;
+    unsigned char*          op;
+    unsigned char*          oend;
+    unsigned char           token;
+    unsigned char           b;
+    unsigned                length;
+    unsigned                offset;
+
+    output.Allocate(uncompressedLength, false);
+    obase = (unsigned char*) output.GetBuffer();
+    op = obase;
+    oend = obase + uncompressedLength;
+
+    ip = (const unsigned char*) input.GetBuffer();
+    end = ip + input.GetLength();
+
+    while (ip < end)
+    {
+        token = *ip++;
+
+        // literals
+        length = token >> 4;
+        if (length == 15)
+        {
+            do
+            {
+                if (ip >= end)
+                    return false;
+                b = *ip++;
+                length += b;
+            }
+            while (b == 255);
+        }
+        if (length > (unsigned) (end - ip) || length > (unsigned) (oend - op))
+            return false;
+        memcpy(op, ip, length);
+        ip += length;
+        op += length;
+
+        if (ip == end)
+            break; // last sequence
+
+        // match
+        if (end - ip < 2)
+            return false;
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (unsigned) (op - obase))
+            return false;
+
+        length = token & 15;
+        if (length == 15)
+        {
+            do
+            {
+                if (ip >= end)
+                    return false;
+                b = *ip++;
+                length += b;
+            }
+            while (b == 255);
+        }
+        length += MIN_MATCH;
+        if (length > (unsigned) (oend - op))
+            return false;
+
+        // byte by byte, the source may overlap the destination
+        while (length-- > 0)
+        {
+            *op = *(op - offset);
+            op++;
+        }
+    }
+
+    if (op != oend)
+        return false;
+
+    output.SetLength(uncompressedLength);
+    return true;
+}
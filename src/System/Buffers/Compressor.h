@@ -0,0 +1,40 @@
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include "System/Platform.h"
+#include "Buffer.h"
+
+#define COMPRESSOR_HASH_LOG         14
+#define COMPRESSOR_HASH_SIZE        (1 << COMPRESSOR_HASH_LOG)
+
+/*
+===============================================================================================
+
+ Compressor
+
+ LZ77 block compressor in the style of LZ4: a sequence of tokens, each holding a run of
+ literals followed by a back reference of at least 4 bytes within a 64K window.
+ There are no external dependencies and the output is deterministic, so compressing
+ the same input twice yields the same bytes.
+
+===============================================================================================
+*/
+
+class Compressor
+{
+public:
+    Compressor();
+    ~Compressor();
+
+    static unsigned     GetMaxCompressedLength(unsigned length);
+
+    // appends the compressed form of input to output
+    void                Compress(ReadBuffer input, Buffer& output);
+    // writes exactly uncompressedLength bytes to output, returns false on corrupt input
+    bool                Uncompress(ReadBuffer input, Buffer& output, uint32_t uncompressedLength);
+
+private:
+    uint32_t*           hashTable;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef INLOCKFREEQUEUE_H
+#define INLOCKFREEQUEUE_H
+
+#include "System/Common.h"
+#include "System/Macros.h"
+#include "System/Threading/Atomic.h"
+
+/*
+===============================================================================================
+
+ InLockFreeQueue for passing objects with pre-allocated next pointer between threads.
+
+ Any thread may enqueue, only one thread may dequeue. The producers push to a stack with
+ compare-and-swap, the consumer takes the whole stack at once and reverses it, so the
+ elements come out in the order they were enqueued. Elements are never popped one by one
+ from the shared stack, therefore there is no ABA problem.
+
+===============================================================================================
+*/
+
+template<class T>
+class InLockFreeQueue
+{
+public:
+    InLockFreeQueue();
+
+    // returns whether the queue was empty, then the consumer has to be notified
+    bool            Enqueue(T* elem);
+    T*              Dequeue();
+
+private:
+    T* volatile     stack;      // shared with the producers, newest first
+    T*              head;       // owned by the consumer, oldest first
+};
+
+/*
+===============================================================================================
+*/
+
+template<class T>
+InLockFreeQueue<T>::InLockFreeQueue()
+{
+    stack = NULL;
+    head = NULL;
+}
+
+template<class T>
+bool InLockFreeQueue<T>::Enqueue(T* elem)
+{
+    T*  top;
+
+    ASSERT(elem != NULL);
+    ASSERT(elem->next == elem);
+
+    do
+    {
+        top = stack;
+        elem->next = top;
+    }
+    while (!AtomicCompareAndSwapPointer(stack, top, elem));
+
+    return (top == NULL);
+}
+
+template<class T>
+T* InLockFreeQueue<T>::Dequeue()
+{
+    T*  elem;
+    T*  next;
+
+    if (head == NULL)
+    {
+        do
+            elem = stack;
+        while (elem != NULL && !AtomicCompareAndSwapPointer(stack, elem, (T*) NULL));
+
+        while (elem != NULL)
+        {
+            next = elem->next;
+            elem->next = head;
+            head = elem;
+            elem = next;
+        }
+    }
+
+    elem = head;
+    if (elem)
+    {
+        head = elem->next;
+        elem->next = elem;
+    }
+    return elem;
+}
+
+#endif
@@ -7,9 +7,10 @@ static bool                     started;
 
 long EventLoop::RunTimers()
 {
-    Timer*      timer;
-    long        wait;
-    uint64_t    prev;
+    InSortedList<Timer>&    timers = GetTimers();
+    Timer*                  timer;
+    long                    wait;
+    uint64_t                prev;
     
     wait = -1;
     prev = 0;
@@ -88,6 +89,19 @@ void EventLoop::Shutdown()
     Scheduler::Shutdown();
 }
 
+void EventLoop::InitThread()
+{
+    ASSERT(threadTimers == NULL);
+    threadTimers = new InSortedList<Timer>;
+}
+
+void EventLoop::ShutdownThread()
+{
+    Scheduler::Shutdown();
+    delete threadTimers;
+    threadTimers = NULL;
+}
+
 uint64_t EventLoop::Now()
 {
     if (now == 0)
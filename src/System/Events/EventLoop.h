@@ -22,6 +22,9 @@ public:
     static void         Run();
     static void         Init();
     static void         Shutdown();
+    // the timers added on the calling thread are run by its own RunOnce() calls
+    static void         InitThread();
+    static void         ShutdownThread();
     static uint64_t     Now();
     static void         UpdateTime();
     static void         Start();
@@ -3,6 +3,7 @@
 #include "System/IO/IOProcessor.h"
 
 InSortedList<Timer> Scheduler::timers;
+THREAD_LOCAL InSortedList<Timer>* Scheduler::threadTimers = NULL;
 #ifdef EVENTLOOP_MULTITHREADED
 Mutex Scheduler::mutex;
 #endif
@@ -46,6 +47,8 @@ void Scheduler::Reset(Timer* timer)
 
 void Scheduler::Shutdown()
 {
+    InSortedList<Timer>&    timers = GetTimers();
+
 #ifdef EVENTLOOP_MULTITHREADED
     MutexGuard guard(mutex);
 #endif
@@ -55,13 +58,21 @@ void Scheduler::Shutdown()
 
 unsigned Scheduler::GetNumTimers()
 {
-    return timers.GetLength();
+    return GetTimers().GetLength();
+}
+
+InSortedList<Timer>& Scheduler::GetTimers()
+{
+    if (threadTimers != NULL)
+        return *threadTimers;
+    return timers;
 }
 
 void Scheduler::UnprotectedAdd(Timer* timer)
 {
-    bool        complete;
-    Callable    empty;
+    InSortedList<Timer>&    timers = GetTimers();
+    bool                    complete;
+    Callable                empty;
     
     ASSERT(timer->next == timer->prev && timer->next == timer);
     timer->OnAdd();
@@ -86,6 +97,6 @@ void Scheduler::UnprotectedRemove(Timer* timer)
 {
     ASSERT(timer->active == (timer->next != timer));
     if (timer->active)
-        timers.Remove(timer);
+        GetTimers().Remove(timer);
     timer->active = false;
 }
@@ -26,7 +26,11 @@ public:
     static unsigned             GetNumTimers();
 
 protected:
+    // the timers of the calling thread, see EventLoop::InitThread()
+    static InSortedList<Timer>& GetTimers();
+
     static InSortedList<Timer>  timers;
+    static THREAD_LOCAL InSortedList<Timer>* threadTimers;
 #ifdef EVENTLOOP_MULTITHREADED
     static Mutex                mutex;
 #endif
@@ -98,6 +98,7 @@ bool FS_RecDeleteDir(const char* path)
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <sys/uio.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
@@ -301,6 +302,60 @@ ssize_t FS_FileReadOffs(FD fd, void* buf, size_t count, uint64_t offset)
     return ret;
 }
 
+char* FS_MapFile(FD fd, uint64_t size)
+{
+    void*   addr;
+
+    if (size == 0)
+        return NULL;
+
+    addr = mmap(NULL, (size_t) size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        Log_Errno("%d", fd);
+        return NULL;
+    }
+
+    return (char*) addr;
+}
+
+void FS_UnmapFile(char* addr, uint64_t size)
+{
+    if (addr == NULL)
+        return;
+
+    if (munmap(addr, (size_t) size) < 0)
+        Log_Errno();
+}
+
+bool FS_AdviseMapping(char* addr, uint64_t size, int advice)
+{
+    uintptr_t   pageSize;
+    uintptr_t   start;
+    int         flags;
+
+    switch (advice)
+    {
+        case FS_ADVICE_RANDOM:      flags = MADV_RANDOM;        break;
+        case FS_ADVICE_SEQUENTIAL:  flags = MADV_SEQUENTIAL;    break;
+        case FS_ADVICE_WILLNEED:    flags = MADV_WILLNEED;      break;
+        case FS_ADVICE_DONTNEED:    flags = MADV_DONTNEED;      break;
+        default:                    flags = MADV_NORMAL;        break;
+    }
+
+    // madvise needs a page aligned address
+    pageSize = (uintptr_t) sysconf(_SC_PAGESIZE);
+    start = (uintptr_t) addr & ~(pageSize - 1);
+    size += (uintptr_t) addr - start;
+    if (madvise((void*) start, (size_t) size, flags) < 0)
+    {
+        Log_Errno();
+        return false;
+    }
+
+    return true;
+}
+
 bool FS_Delete(const char* filename)
 {
     int ret;
@@ -742,6 +797,48 @@ ssize_t FS_FileReadOffs(FD fd, void* buf, size_t count, uint64_t offset)
     return (ssize_t) numRead;
 }
 
+char* FS_MapFile(FD fd, uint64_t size)
+{
+    HANDLE  mapping;
+    void*   addr;
+
+    if (size == 0)
+        return NULL;
+
+    mapping = CreateFileMapping((HANDLE)fd.handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        Log_Errno();
+        return NULL;
+    }
+
+    // the view keeps a reference to the mapping object
+    addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (SIZE_T) size);
+    CloseHandle(mapping);
+    if (addr == NULL)
+    {
+        Log_Errno();
+        return NULL;
+    }
+
+    return (char*) addr;
+}
+
+void FS_UnmapFile(char* addr, uint64_t /*size*/)
+{
+    if (addr == NULL)
+        return;
+
+    if (!UnmapViewOfFile(addr))
+        Log_Errno();
+}
+
+bool FS_AdviseMapping(char* /*addr*/, uint64_t /*size*/, int /*advice*/)
+{
+    // no equivalent of madvise
+    return true;
+}
+
 bool FS_Delete(const char* filename)
 {
     BOOL    ret;
@@ -24,6 +24,12 @@
 #define FS_TRUNCATE             0x0400
 #define FS_DIRECT               0x4000
 
+#define FS_ADVICE_NORMAL        0
+#define FS_ADVICE_RANDOM        1
+#define FS_ADVICE_SEQUENTIAL    2
+#define FS_ADVICE_WILLNEED      3
+#define FS_ADVICE_DONTNEED      4
+
 #define FS_INVALID_DIR          0
 #define FS_INVALID_DIR_ENTRY    0
 
@@ -54,6 +60,11 @@ ssize_t     FS_FileRead(FD fd, void* buf, size_t count);
 ssize_t     FS_FileWriteOffs(FD fd, const void* buf, size_t count, uint64_t offset);
 ssize_t     FS_FileReadOffs(FD fd, void* buf, size_t count, uint64_t offset);
 
+// read-only shared mapping of the first size bytes of the file, NULL on failure
+char*       FS_MapFile(FD fd, uint64_t size);
+void        FS_UnmapFile(char* addr, uint64_t size);
+bool        FS_AdviseMapping(char* addr, uint64_t size, int advice);
+
 bool        FS_Delete(const char* filename);
 
 bool        FS_ChangeDir(const char* filename);
@@ -7,6 +7,7 @@
 
 #include "System/Events/Callable.h"
 #include "System/Buffers/Buffer.h"
+#include "System/Containers/List.h"
 #include "Endpoint.h"
 #include "FD.h"
 
@@ -76,12 +77,34 @@ struct IOOperation
     IOOperation*    next;
 };
 
+/*
+===============================================================================
+
+ TCPWriteSegment: a buffer written after the first 'offset' bytes of
+ TCPWrite::buffer without being copied into it
+
+===============================================================================
+*/
+
+struct TCPWriteSegment
+{
+    unsigned        offset;
+    Buffer*         data;
+};
+
+struct TCPWritePiece
+{
+    const char*     data;
+    unsigned        length;
+};
+
 struct TCPWrite : public IOOperation
 {
     TCPWrite() : IOOperation()
     {
         type = TCP_WRITE;
         transferred = 0;
+        segments = NULL;
     }
     
     void AsyncConnect()
@@ -89,9 +112,69 @@ struct TCPWrite : public IOOperation
         buffer = NULL;
         // zero indicates for IOProcessor that we are waiting for connect event
     }
+
+    unsigned GetLength()
+    {
+        unsigned            length;
+        TCPWriteSegment*    it;
+
+        length = buffer->GetLength();
+        if (segments)
+        {
+            FOREACH (it, *segments)
+                length += it->data->GetLength();
+        }
+        return length;
+    }
+
+    // fills pieces with the data not yet transferred, in the order it is sent,
+    // returns the number of pieces
+    unsigned GetPieces(TCPWritePiece* pieces, unsigned maxPieces)
+    {
+        unsigned            num;
+        unsigned            position;
+        unsigned            offset;
+        unsigned            end;
+        TCPWriteSegment*    it;
+
+        num = 0;
+        position = 0;
+        offset = 0;
+        it = segments ? segments->First() : NULL;
+        while (num < maxPieces)
+        {
+            end = it ? it->offset : buffer->GetLength();
+            AddPiece(pieces, num, position, buffer->GetBuffer() + offset, end - offset);
+            offset = end;
+            if (it == NULL || num == maxPieces)
+                break;
+            AddPiece(pieces, num, position, it->data->GetBuffer(), it->data->GetLength());
+            it = segments->Next(it);
+        }
+        return num;
+    }
+
+    void AddPiece(TCPWritePiece* pieces, unsigned& num, unsigned& position,
+     const char* data, unsigned length)
+    {
+        unsigned            skip;
+
+        // skip what is already transferred
+        skip = 0;
+        if (position < transferred)
+            skip = MIN(transferred - position, length);
+        position += length;
+        if (skip == length)
+            return;
+        pieces[num].data = data + skip;
+        pieces[num].length = length - skip;
+        num++;
+    }
     
-    unsigned    transferred;        /*  the IO subsystem has given the first
-                                        'transferred' bytes to the kernel */
+    unsigned                transferred;    /*  the IO subsystem has given the first
+                                                'transferred' bytes to the kernel */
+    List<TCPWriteSegment>*  segments;       /*  written after the bytes of 'buffer'
+                                                before their offset */
 };
 
 struct TCPRead : public IOOperation
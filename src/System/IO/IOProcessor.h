@@ -8,6 +8,8 @@
 #define IOPROCESSOR_BLOCK_ALL           1
 #define IOPROCESSOR_BLOCK_INTERACTIVE   2
 
+#define IOPROCESSOR_MAX_LOOPS           64
+
 class Callable; // forward
 
 /*
@@ -27,6 +29,7 @@ public:
     uint64_t    numTCPBytesSent;
     uint64_t    numTCPBytesReceived;
     uint64_t    numCompletions;
+    uint64_t    numWakeups;         // completions that had to wake up the loop
     uint64_t    lastPollTime;
     uint64_t    totalPollTime;
     unsigned    lastNumEvents;
@@ -41,6 +44,15 @@ public:
 
  IOProcessor
 
+ Loop 0 is the main event loop. Additional loops are only supported on Linux, each has
+ its own epoll instance and runs on its own thread, which calls SetThreadLoop() first.
+ Add(), Remove() and Poll() work on the loop of the calling thread, Complete() without
+ a loopID always completes on the main loop.
+
+ UseURing() must be called before Init(). On Linux the loops then wait for socket events
+ with io_uring poll requests instead of epoll, and fall back to epoll when the kernel does
+ not support it.
+
 ===============================================================================================
 */
 
@@ -49,6 +61,11 @@ class IOProcessor
 public:
     static bool Init(int maxfd);
     static void Shutdown();
+    static void UseURing(bool useURing);
+
+    static bool InitLoop(unsigned loopID);
+    static void ShutdownLoop(unsigned loopID);
+    static void SetThreadLoop(unsigned loopID);
 
     static bool Add(IOOperation* ioop);
     static bool Remove(IOOperation* ioop);
@@ -56,6 +73,7 @@ public:
     static bool Poll(int sleep);
 
     static bool Complete(Callable* callable);
+    static bool Complete(Callable* callable, unsigned loopID);
     static void Call(Callable& callable);
     static void SetCallbackThreshold(unsigned callbackThreshold);
 
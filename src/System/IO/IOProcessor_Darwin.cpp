@@ -5,6 +5,7 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <math.h>
 #include <errno.h>
@@ -21,6 +22,7 @@
 // see http://wiki.netbsd.se/index.php/kqueue_tutorial
 
 #define MAX_KEVENTS     1024
+#define MAX_WRITE_PIECES 64     // iovecs per writev
 
 #ifdef IOPROCESSOR_MULTITHREADED
 
@@ -245,6 +247,26 @@ void IOProcessor::Shutdown()
     delete[] writeOps;
 }
 
+bool IOProcessor::InitLoop(unsigned /*loopID*/)
+{
+    Log_Message("Multiple event loops are only supported on Linux");
+    return false;
+}
+
+void IOProcessor::ShutdownLoop(unsigned /*loopID*/)
+{
+}
+
+void IOProcessor::UseURing(bool useURing)
+{
+    if (useURing)
+        Log_Message("io_uring is only supported on Linux");
+}
+
+void IOProcessor::SetThreadLoop(unsigned /*loopID*/)
+{
+}
+
 bool IOProcessor::Add(IOOperation* ioop)
 {
     short   filter;
@@ -453,6 +475,11 @@ bool IOProcessor::Poll(int sleep)
     return true;
 }
 
+bool IOProcessor::Complete(Callable* callable, unsigned /*loopID*/)
+{
+    return Complete(callable);
+}
+
 bool IOProcessor::Complete(Callable* callable)
 {
     Log_Trace();
@@ -460,6 +487,7 @@ bool IOProcessor::Complete(Callable* callable)
     int nwrite;
     
     iostat.numCompletions++;
+    iostat.numWakeups++;
     
     nwrite = write(asyncOpPipe[1], callable, sizeof(Callable));
     if (nwrite < 0)
@@ -497,7 +525,7 @@ void ProcessAsyncOp()
 
     while (1)
     {
-        nread = read(asyncOpPipe[0], callables, SIZE(callables));
+        nread = read(asyncOpPipe[0], callables, sizeof(callables));
         count = nread / sizeof(Callable);
         
         // TODO: optimization: unlock before for-loop and lock after it only once
@@ -563,8 +591,12 @@ void ProcessTCPRead(struct kevent* ev)
 
 void ProcessTCPWrite(struct kevent* ev)
 {
-    int         writelen, nwrite;
-    TCPWrite*   tcpwrite;
+    int             writelen, nwrite;
+    unsigned        i;
+    unsigned        numPieces;
+    TCPWrite*       tcpwrite;
+    TCPWritePiece   pieces[MAX_WRITE_PIECES];
+    struct iovec    iov[MAX_WRITE_PIECES];
 
     Log_Trace();
 
@@ -587,14 +619,19 @@ void ProcessTCPWrite(struct kevent* ev)
         return;
     }
 
-    writelen = tcpwrite->buffer->GetLength() - tcpwrite->transferred;
-    writelen = MIN(ev->data, writelen);
+    // the buffer and the segments are written with one writev
+    numPieces = tcpwrite->GetPieces(pieces, MAX_WRITE_PIECES);
+    writelen = 0;
+    for (i = 0; i < numPieces; i++)
+    {
+        iov[i].iov_base = (void*) pieces[i].data;
+        iov[i].iov_len = pieces[i].length;
+        writelen += pieces[i].length;
+    }
     
     if (writelen > 0)
     {
-        nwrite = write(tcpwrite->fd,
-                       tcpwrite->buffer->GetBuffer() + tcpwrite->transferred,
-                       writelen);
+        nwrite = writev(tcpwrite->fd, iov, numPieces);
         
         if (nwrite < 0)
         {
@@ -607,7 +644,7 @@ void ProcessTCPWrite(struct kevent* ev)
         {
             iostat.numTCPBytesSent += nwrite;
             tcpwrite->transferred += nwrite;
-            if (tcpwrite->transferred == tcpwrite->buffer->GetLength())
+            if (tcpwrite->transferred == tcpwrite->GetLength())
                 UNLOCKED_CALL(tcpwrite->onComplete);
             else
                 UNLOCKED_ADD(tcpwrite);
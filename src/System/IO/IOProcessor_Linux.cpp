@@ -1,10 +1,12 @@
 #ifdef PLATFORM_LINUX
 
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <signal.h>
@@ -17,10 +19,15 @@
 #include "System/Time.h"
 #include "System/Events/EventLoop.h"
 #include "System/Threading/Mutex.h"
+#include "System/Threading/Atomic.h"
+#include "System/Containers/InLockFreeQueue.h"
+#include "IOUring.h"
 #include "System/Stopwatch.h"
 
 #define MAX_EVENTS          1024
-#define PIPEOP              IOOperation::UNKNOWN
+#define MAX_WRITE_PIECES    64      // iovecs per writev
+#define URING_ENTRIES       4096
+#define ASYNCOP             IOOperation::UNKNOWN
 
 #ifdef IOPROCESSOR_MULTITHREADED
 
@@ -55,41 +62,63 @@ do                                  \
 /*
 ===============================================================================================
 
- PipeOp -- a pipe is used for notifying the IOProcessor in main thread from other threads
+ IOCompletion -- a callable completed from another thread
 
 ===============================================================================================
 */
 
-class PipeOp : public IOOperation
+class IOCompletion
 {
 public:
-    PipeOp()
+    IOCompletion()
     {
-        type = PIPEOP;
-        pipe[0] = pipe[1] = -1;
+        next = this;
+    }
+
+    Callable        callable;
+    IOCompletion*   next;
+};
+
+/*
+===============================================================================================
+
+ AsyncOp -- an eventfd is used for notifying the IOProcessor of a loop from other threads
+
+ The completions are queued in a lock-free queue and the eventfd is only written when the
+ queue was empty, so a burst of completions costs one wakeup. Poll() runs them in batches.
+
+===============================================================================================
+*/
+
+class AsyncOp : public IOOperation
+{
+public:
+    AsyncOp()
+    {
+        type = ASYNCOP;
     }
     
-    ~PipeOp()
+    ~AsyncOp()
     {
         Close();
     }
     
     void Close()
     {
-        if (pipe[0] >= 0)
-        {
-            close(pipe[0]);
-            pipe[0] = -1;
-        }
-        if (pipe[1] >= 0)
+        IOCompletion*   completion;
+
+        if (fd != INVALID_FD)
         {
-            close(pipe[1]);
-            pipe[1] = -1;
+            close(fd);
+            fd = INVALID_FD;
         }
+
+        while ((completion = completions.Dequeue()) != NULL)
+            delete completion;
     }
     
-    int         pipe[2];
-    Callable    callback;
+    Callable                        callback;
+    InLockFreeQueue<IOCompletion>   completions;
 };
 
 /*
@@ -97,6 +126,9 @@ public:
 
  EpollOp -- this class is used for simulating kqueue behaviour with epoll
 
+ With io_uring the generations identify the poll request of the read and write operation
+ in the completions, so that completions of removed operations are ignored.
+
 ===============================================================================================
 */
 
@@ -107,49 +139,89 @@ public:
     {
         read = NULL;
         write = NULL;
+        readGen = 0;
+        writeGen = 0;
     }
     
     IOOperation*    read;
     IOOperation*    write;
+    uint32_t        readGen;
+    uint32_t        writeGen;
 };
 
 
-static int              epollfd = 0;
+/*
+===============================================================================================
+
+ EpollLoop -- the epoll instance of an event loop, loop 0 is the main event loop
+
+ When io_uring is used, ring replaces the epoll instance: the poll requests are queued
+ in the ring and submitted in Poll(), in the same system call that waits for events.
+
+===============================================================================================
+*/
+
+class EpollLoop
+{
+public:
+    EpollLoop()
+    {
+        epollfd = 0;
+        epollOps = NULL;
+        ring = NULL;
+        running = false;
+    }
+
+    int                 epollfd;
+    EpollOp*            epollOps;
+    IOUring*            ring;
+    AsyncOp             asyncOp;
+    volatile bool       running;
+    IOProcessorStat     iostat;
+    struct epoll_event  events[MAX_EVENTS];
+};
+
+static EpollLoop        loops[IOPROCESSOR_MAX_LOOPS];
+static THREAD_LOCAL EpollLoop* threadLoop = NULL;
 static int              maxfd;
-static PipeOp           asyncPipeOp;
-static EpollOp*         epollOps;
 static volatile bool    terminated = false;
 static volatile int     numClient = 0;
-static volatile bool	running = false;
-static IOProcessorStat  iostat;
 static Mutex            mutex;
 static uint64_t		longCallbackThreshold = 1000;
-
-static bool             AddEvent(int fd, uint32_t filter, IOOperation* ioop);
+static bool             useURing = false;
+
+static bool             InitLoop(EpollLoop* loop);
+static void             ShutdownLoop(EpollLoop* loop);
+static bool             AddEvent(EpollLoop* loop, int fd, uint32_t filter, IOOperation* ioop);
+static bool             AddURingEvent(EpollLoop* loop, int fd, uint32_t event, IOOperation* ioop);
+static bool             RemoveURingEvent(EpollLoop* loop, IOOperation* ioop);
+static bool             PollURing(EpollLoop* loop, int sleep);
 static void             ProcessAsyncOp();
 static void             ProcessIOOperation(IOOperation* ioop);
 static void             ProcessTCPRead(TCPRead* tcpread);
 static void             ProcessTCPWrite(TCPWrite* tcpwrite);
 
-bool /*IOProcessor::*/InitPipe(PipeOp &pipeop, Callable callback)
+// the loop of the calling thread, threads without their own loop use the main loop
+static inline EpollLoop* GetLoop()
+{
+    if (threadLoop != NULL)
+        return threadLoop;
+    return &loops[0];
+}
+
+bool /*IOProcessor::*/InitAsyncOp(EpollLoop* loop, AsyncOp &asyncOp, Callable callback)
 {
-    if (pipe(pipeop.pipe) < 0)
+    asyncOp.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (asyncOp.fd < 0)
     {
         Log_Errno();
         return false;
     }
 
-    if (pipeop.pipe[0] < 0 || pipeop.pipe[1] < 0)
-        return false;
-    
-    fcntl(pipeop.pipe[0], F_SETFD, FD_CLOEXEC);
-    fcntl(pipeop.pipe[0], F_SETFL, O_NONBLOCK);
-    //fcntl(pipeop.pipe[1], F_SETFL, O_NONBLOCK);
-
-    if (!AddEvent(pipeop.pipe[0], EPOLLIN, &pipeop))
+    if (!AddEvent(loop, asyncOp.fd, EPOLLIN, &asyncOp))
         return false;
     
-    pipeop.callback = callback;
+    asyncOp.callback = callback;
 
     return true;
 }
@@ -264,13 +336,12 @@ void IOProcessor::BlockSignals(int blockMode)
 
 bool IOProcessor::Init(int maxfd_)
 {
-    int i;
     rlimit rl;
 
     terminated = false;
     numClient++;
     
-    if (epollfd > 0)
+    if (loops[0].epollOps != NULL)
         return true;
 
     if (maxfd_ < 0)
@@ -287,39 +358,112 @@ bool IOProcessor::Init(int maxfd_)
         Log_Errno();
     }
     
-    epollfd = epoll_create(maxfd);
-    if (epollfd < 0)
+    return ::InitLoop(&loops[0]);
+}
+
+void IOProcessor::Shutdown()
+{
+    numClient--;
+    
+    if (loops[0].epollOps == NULL || numClient > 0)
+        return;
+
+    ::ShutdownLoop(&loops[0]);
+}
+
+bool IOProcessor::InitLoop(unsigned loopID)
+{
+    ASSERT(loopID > 0 && loopID < IOPROCESSOR_MAX_LOOPS);
+    ASSERT(loops[0].epollOps != NULL);
+
+    if (loops[loopID].epollOps != NULL)
+        return true;
+
+    return ::InitLoop(&loops[loopID]);
+}
+
+void IOProcessor::ShutdownLoop(unsigned loopID)
+{
+    ASSERT(loopID > 0 && loopID < IOPROCESSOR_MAX_LOOPS);
+
+    if (loops[loopID].epollOps == NULL)
+        return;
+
+    ::ShutdownLoop(&loops[loopID]);
+}
+
+void IOProcessor::UseURing(bool useURing_)
+{
+    useURing = useURing_;
+}
+
+void IOProcessor::SetThreadLoop(unsigned loopID)
+{
+    ASSERT(loopID < IOPROCESSOR_MAX_LOOPS);
+
+    if (loopID == 0)
+        threadLoop = NULL;
+    else
+        threadLoop = &loops[loopID];
+}
+
+bool InitLoop(EpollLoop* loop)
+{
+    int i;
+
+    if (useURing)
     {
-        Log_Errno();
-        return false;
+        loop->ring = new IOUring;
+        if (!loop->ring->Init(URING_ENTRIES))
+        {
+            Log_Message("Cannot initialize io_uring, falling back to epoll");
+            delete loop->ring;
+            loop->ring = NULL;
+        }
+        else if (loop == &loops[0])
+            Log_Message("Using io_uring for network I/O");
+    }
+
+    if (loop->ring == NULL)
+    {
+        loop->epollfd = epoll_create(maxfd);
+        if (loop->epollfd < 0)
+        {
+            Log_Errno();
+            loop->epollfd = 0;
+            return false;
+        }
     }
 
-    epollOps = new EpollOp[maxfd];
+    loop->epollOps = new EpollOp[maxfd];
     for (i = 0; i < maxfd; i++)
     {
-        epollOps[i].read = NULL;
-        epollOps[i].write = NULL;
+        loop->epollOps[i].read = NULL;
+        loop->epollOps[i].write = NULL;
     }
     
-    if (!InitPipe(asyncPipeOp, CFunc(ProcessAsyncOp)))
+    if (!InitAsyncOp(loop, loop->asyncOp, CFunc(ProcessAsyncOp)))
         return false;
 
-    memset(&iostat, 0, sizeof(iostat));
+    memset(&loop->iostat, 0, sizeof(loop->iostat));
 
     return true;
 }
 
-void IOProcessor::Shutdown()
+void ShutdownLoop(EpollLoop* loop)
 {
-    numClient--;
-    
-    if (epollfd == 0 || numClient > 0)
-        return;
-
-    close(epollfd);
-    epollfd = 0;
-    delete[] epollOps;
-    asyncPipeOp.Close();
+    if (loop->ring)
+    {
+        loop->ring->Close();
+        delete loop->ring;
+        loop->ring = NULL;
+    }
+    else
+        close(loop->epollfd);
+    loop->epollfd = 0;
+    delete[] loop->epollOps;
+    loop->epollOps = NULL;
+    loop->asyncOp.Close();
 }
 
 bool IOProcessor::Add(IOOperation* ioop)
@@ -342,23 +486,26 @@ bool IOProcessor::Add(IOOperation* ioop)
     else if (ioop->type == IOOperation::TCP_WRITE)
         filter |= EPOLLOUT;
     
-    return AddEvent(ioop->fd, filter, ioop);
+    return AddEvent(GetLoop(), ioop->fd, filter, ioop);
 }
 
-bool AddEvent(int fd, uint32_t event, IOOperation* ioop)
+bool AddEvent(EpollLoop* loop, int fd, uint32_t event, IOOperation* ioop)
 {
     int                 nev;
     struct epoll_event  ev;
     EpollOp             *epollOp;
     bool                hasEvent;
     
-    if (epollfd < 0)
+    if (loop->ring)
+        return AddURingEvent(loop, fd, event, ioop);
+
+    if (loop->epollfd < 0)
     {
         Log_Trace("epollfd < 0");
         return false;
     }
 
-    epollOp = &epollOps[fd];
+    epollOp = &loop->epollOps[fd];
     hasEvent = epollOp->read || epollOp->write;
 
     if ((event & EPOLLIN) == EPOLLIN)
@@ -377,7 +524,7 @@ bool AddEvent(int fd, uint32_t event, IOOperation* ioop)
     ev.data.ptr = epollOp;
     
     // add our interest in the event
-    nev = epoll_ctl(epollfd, hasEvent ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
+    nev = epoll_ctl(loop->epollfd, hasEvent ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
 
     // If you add the same fd to an epoll_set twice, you
     // probably get EEXIST, but this is a harmless condition.
@@ -386,7 +533,7 @@ bool AddEvent(int fd, uint32_t event, IOOperation* ioop)
         if (errno == EEXIST)
         {
             //Log_Trace("AddEvent: fd = %d exists", fd);
-            nev = epoll_ctl(epollfd, EPOLL_CTL_MOD, fd, &ev);
+            nev = epoll_ctl(loop->epollfd, EPOLL_CTL_MOD, fd, &ev);
         }
 
         if (nev < 0)
@@ -407,10 +554,15 @@ bool IOProcessor::Remove(IOOperation* ioop)
     int                 nev;
     struct epoll_event  ev;
     EpollOp*            epollOp;
+    EpollLoop*          loop;
     
     if (!ioop->active)
         return true;
 
+    loop = GetLoop();
+    if (loop->ring)
+        return RemoveURingEvent(loop, ioop);
+
 #ifdef IOPROCESSOR_MULTITHREADED
     MutexGuard guard(mutex);
 #endif
@@ -419,7 +571,7 @@ bool IOProcessor::Remove(IOOperation* ioop)
     {
         // if the ioop is pending it doesn't need to be removed because every op is one shot
         // still, it needs to be removed from epollOps
-        epollOp = &epollOps[ioop->fd];
+        epollOp = &loop->epollOps[ioop->fd];
         if (ioop->type == IOOperation::TCP_READ)
             epollOp->read = NULL;
         else
@@ -430,7 +582,7 @@ bool IOProcessor::Remove(IOOperation* ioop)
         return true;
     }
     
-    if (epollfd < 0)
+    if (loop->epollfd < 0)
     {
         Log_Trace("eventfd < 0");
         return false;
@@ -441,7 +593,7 @@ bool IOProcessor::Remove(IOOperation* ioop)
     ev.events = EPOLLONESHOT;
     ev.data.ptr = ioop;
 
-    epollOp = &epollOps[ioop->fd];
+    epollOp = &loop->epollOps[ioop->fd];
     if (ioop->type == IOOperation::TCP_READ)
     {
         epollOp->read = NULL;
@@ -456,9 +608,9 @@ bool IOProcessor::Remove(IOOperation* ioop)
     }
 
     if (epollOp->read || epollOp->write)
-        nev = epoll_ctl(epollfd, EPOLL_CTL_MOD, ioop->fd, &ev);
+        nev = epoll_ctl(loop->epollfd, EPOLL_CTL_MOD, ioop->fd, &ev);
     else
-        nev = epoll_ctl(epollfd, EPOLL_CTL_DEL, ioop->fd, &ev /* ignored */);
+        nev = epoll_ctl(loop->epollfd, EPOLL_CTL_DEL, ioop->fd, &ev /* ignored */);
 
     if (nev < 0)
     {
@@ -476,22 +628,28 @@ bool IOProcessor::Poll(int sleep)
     
     int                         i, nevents;
     int                         ret, currentev, newfd = -1;
-    static struct epoll_event   events[MAX_EVENTS];
-    static struct epoll_event   newev;
+    struct epoll_event*         events;
+    struct epoll_event          newev;
     IOOperation*                ioop;
     EpollOp*                    epollOp;
+    EpollLoop*                  loop;
     uint64_t                    startTime;
         
-    iostat.numPolls++;    
+    loop = GetLoop();
+    if (loop->ring)
+        return PollURing(loop, sleep);
+
+    events = loop->events;
+    loop->iostat.numPolls++;    
     
     startTime = EventLoop::Now();
-    running = false;
-    nevents = epoll_wait(epollfd, events, SIZE(events), sleep);
-    running = true;
+    loop->running = false;
+    nevents = epoll_wait(loop->epollfd, events, MAX_EVENTS, sleep);
+    loop->running = true;
     EventLoop::UpdateTime();
     
-    iostat.lastPollTime = EventLoop::Now();
-    iostat.totalPollTime += iostat.lastPollTime - startTime;
+    loop->iostat.lastPollTime = EventLoop::Now();
+    loop->iostat.totalPollTime += loop->iostat.lastPollTime - startTime;
     
     if (nevents < 0 || terminated)
     {
@@ -503,8 +661,8 @@ bool IOProcessor::Poll(int sleep)
     MutexGuard guard(mutex);
 #endif
     
-    iostat.lastNumEvents = (unsigned) nevents;
-    iostat.totalNumEvents += nevents;
+    loop->iostat.lastNumEvents = (unsigned) nevents;
+    loop->iostat.totalNumEvents += nevents;
     for (i = 0; i < nevents; i++)
     {
         currentev = events[i].events;
@@ -529,11 +687,11 @@ bool IOProcessor::Poll(int sleep)
         
         if (newev.events)
         {
-            if ((epollOp->read && epollOp->read->type != PIPEOP) ||
-                (epollOp->write && epollOp->write->type != PIPEOP))
+            if ((epollOp->read && epollOp->read->type != ASYNCOP) ||
+                (epollOp->write && epollOp->write->type != ASYNCOP))
                     newev.events |= EPOLLONESHOT;
 
-            ret = epoll_ctl(epollfd, EPOLL_CTL_MOD, newfd, &newev);
+            ret = epoll_ctl(loop->epollfd, EPOLL_CTL_MOD, newfd, &newev);
             if (ret < 0)
             {
                 Log_Errno();
@@ -559,11 +717,11 @@ bool IOProcessor::Poll(int sleep)
             ioop = epollOp->read;
             ASSERT(ioop != NULL);
             ioop->pending = false;
-            if (ioop->active && ioop->type == PIPEOP)
+            if (ioop->active && ioop->type == ASYNCOP)
             {
-                // we never set pipeOps' read to NULL, they're special
-                PipeOp* pipeop = (PipeOp*) ioop;
-                UNLOCKED_CALL(pipeop->callback);
+                // we never set asyncOps' read to NULL, they're special
+                AsyncOp* asyncOp = (AsyncOp*) ioop;
+                UNLOCKED_CALL(asyncOp->callback);
             }
             else if (ioop->active)
             {
@@ -578,7 +736,7 @@ bool IOProcessor::Poll(int sleep)
             epollOp->write = NULL;
             ASSERT(ioop != NULL);
             ioop->pending = false;
-            // we don't care about write notifications for pipeOps
+            // we don't care about write notifications for asyncOps
             if (ioop->active)
                 ProcessIOOperation(ioop);
         }       
@@ -587,15 +745,178 @@ bool IOProcessor::Poll(int sleep)
     return true;
 }
 
+// the user data of a poll request: fd, generation and direction
+static uint64_t URingUserData(int fd, uint32_t gen, bool write)
+{
+    return ((uint64_t) fd << 32) | ((uint64_t) gen << 1) | (write ? 1 : 0);
+}
+
+static uint32_t NextURingGen(uint32_t gen)
+{
+    // zero is the user data of the remove requests, generations are 31 bits
+    gen = (gen + 1) & 0x7FFFFFFF;
+    return (gen == 0 ? 1 : gen);
+}
+
+bool AddURingEvent(EpollLoop* loop, int fd, uint32_t event, IOOperation* ioop)
+{
+    EpollOp*    epollOp;
+    bool        ret;
+
+    epollOp = &loop->epollOps[fd];
+    ret = true;
+
+    // every operation has its own oneshot poll request
+    if ((event & EPOLLIN) == EPOLLIN)
+    {
+        epollOp->read = ioop;
+        epollOp->readGen = NextURingGen(epollOp->readGen);
+        ret &= loop->ring->PollAdd(fd, IOURING_POLL_IN, URingUserData(fd, epollOp->readGen, false));
+    }
+    if ((event & EPOLLOUT) == EPOLLOUT)
+    {
+        epollOp->write = ioop;
+        epollOp->writeGen = NextURingGen(epollOp->writeGen);
+        ret &= loop->ring->PollAdd(fd, IOURING_POLL_OUT, URingUserData(fd, epollOp->writeGen, true));
+    }
+
+    if (!ret)
+    {
+        Log_Message("io_uring submission queue is full");
+        return false;
+    }
+
+    if (ioop)
+        ioop->active = true;
+
+    return true;
+}
+
+bool RemoveURingEvent(EpollLoop* loop, IOOperation* ioop)
+{
+    EpollOp*    epollOp;
+    uint64_t    userData;
+
+    // the completion of the cancelled request has an old generation and is ignored
+    epollOp = &loop->epollOps[ioop->fd];
+    if (ioop->type == IOOperation::TCP_READ)
+    {
+        userData = URingUserData(ioop->fd, epollOp->readGen, false);
+        epollOp->read = NULL;
+        epollOp->readGen = NextURingGen(epollOp->readGen);
+    }
+    else
+    {
+        userData = URingUserData(ioop->fd, epollOp->writeGen, true);
+        epollOp->write = NULL;
+        epollOp->writeGen = NextURingGen(epollOp->writeGen);
+    }
+
+    ioop->active = false;
+    ioop->pending = false;
+
+    return loop->ring->PollRemove(userData);
+}
+
+bool PollURing(EpollLoop* loop, int sleep)
+{
+    int             fd;
+    int             result;
+    unsigned        nevents;
+    uint32_t        gen;
+    bool            isWrite;
+    uint64_t        userData;
+    uint64_t        startTime;
+    EpollOp*        epollOp;
+    IOOperation*    ioop;
+
+    loop->iostat.numPolls++;
+
+    startTime = EventLoop::Now();
+    loop->running = false;
+    if (!loop->ring->Submit(1, sleep) || terminated)
+    {
+        loop->running = true;
+        return false;
+    }
+    loop->running = true;
+    EventLoop::UpdateTime();
+
+    loop->iostat.lastPollTime = EventLoop::Now();
+    loop->iostat.totalPollTime += loop->iostat.lastPollTime - startTime;
+
+    for (nevents = 0; nevents < MAX_EVENTS; nevents++)
+    {
+        if (!loop->ring->GetCompletion(userData, result))
+            break;
+        if (userData == 0)
+            continue;
+
+        fd = (int) (userData >> 32);
+        gen = (uint32_t) (userData & 0xFFFFFFFF) >> 1;
+        isWrite = (userData & 1) != 0;
+        epollOp = &loop->epollOps[fd];
+
+        if (isWrite)
+        {
+            ioop = epollOp->write;
+            if (ioop == NULL || epollOp->writeGen != gen)
+                continue;
+            epollOp->write = NULL;
+        }
+        else
+        {
+            ioop = epollOp->read;
+            if (ioop == NULL || epollOp->readGen != gen)
+                continue;
+            if (ioop->type == ASYNCOP)
+            {
+                // rearm first, completions may be queued while the callback runs
+                AddURingEvent(loop, fd, EPOLLIN, ioop);
+                UNLOCKED_CALL(((AsyncOp*) ioop)->callback);
+                continue;
+            }
+            epollOp->read = NULL;
+        }
+
+        // errors are reported by the read or write itself
+        ProcessIOOperation(ioop);
+    }
+
+    loop->iostat.lastNumEvents = nevents;
+    loop->iostat.totalNumEvents += nevents;
+
+    return true;
+}
+
 bool IOProcessor::Complete(Callable* callable)
+{
+    return Complete(callable, 0);
+}
+
+bool IOProcessor::Complete(Callable* callable, unsigned loopID)
 {
     Log_Trace();
     
-    int nwrite;
+    int             nwrite;
+    uint64_t        value;
+    EpollLoop*      loop;
+    IOCompletion*   completion;
+
+    ASSERT(loopID < IOPROCESSOR_MAX_LOOPS);
+    loop = &loops[loopID];
+    AtomicIncrementU64(loop->iostat.numCompletions);
 
-    iostat.numCompletions++;
+    completion = new IOCompletion;
+    completion->callable = *callable;
     
-    nwrite = write(asyncPipeOp.pipe[1], callable, sizeof(Callable));
+    // the loop is already woken up and drains the queue in ProcessAsyncOp()
+    if (!loop->asyncOp.completions.Enqueue(completion))
+        return true;
+
+    AtomicIncrementU64(loop->iostat.numWakeups);
+    value = 1;
+    nwrite = write(loop->asyncOp.fd, &value, sizeof(value));
     if (nwrite < 0)
     {
         Log_Errno();
@@ -616,7 +937,7 @@ void IOProcessor::Call(Callable& callable)
     if (elapsed >= longCallbackThreshold)
     {
         Log_Message("Callback elapsed time: %U", elapsed);
-        iostat.numLongCallbacks++;
+        GetLoop()->iostat.numLongCallbacks++;
     }
 }
 
@@ -641,35 +962,43 @@ void ProcessIOOperation(IOOperation* ioop)
     }
 }
 
-#define MAX_CALLABLE 256    
+#define MAX_COMPLETIONS 1024
 void ProcessAsyncOp()
 {
-    Callable    callables[MAX_CALLABLE];
-    int         nread;
-    int         count;
-    int         i;
+    uint64_t        value;
+    unsigned        count;
+    EpollLoop*      loop;
+    IOCompletion*   completion;
     
     Log_Trace();
 
-    while (true)
+    loop = GetLoop();
+
+    // reset the eventfd before draining, completions queued after the queue
+    // became empty write it again
+    if (read(loop->asyncOp.fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        Log_Errno();
+
+    for (count = 0; count < MAX_COMPLETIONS; count++)
     {
-        nread = read(asyncPipeOp.pipe[0], callables, SIZE(callables));
-        count = nread / sizeof(Callable);
-        
-        // TODO: optimization: unlock before for-loop and lock after it only once
-        for (i = 0; i < count; i++)
-            UNLOCKED_CALL(callables[i]);
-        
-        if (count < (int) SIZE(callables))
-            break;
+        completion = loop->asyncOp.completions.Dequeue();
+        if (completion == NULL)
+            return;
+        UNLOCKED_CALL(completion->callable);
+        delete completion;
     }
+
+    // let the other events of the loop run before the next batch
+    value = 1;
+    if (write(loop->asyncOp.fd, &value, sizeof(value)) < 0)
+        Log_Errno();
 }
 
 void ProcessTCPRead(TCPRead* tcpread)
 {
     int readlen, nread;
 
-    iostat.numTCPReads++;
+    GetLoop()->iostat.numTCPReads++;
     if (tcpread->listening)
     {
         UNLOCKED_CALL(tcpread->onComplete);
@@ -706,7 +1035,7 @@ void ProcessTCPRead(TCPRead* tcpread)
     }
     else
     {
-        iostat.numTCPBytesReceived += nread;
+        GetLoop()->iostat.numTCPBytesReceived += nread;
         tcpread->buffer->Lengthen(nread);
         if (tcpread->requested == IO_READ_ANY || 
             tcpread->buffer->GetLength() == (unsigned)tcpread->requested)
@@ -718,9 +1047,14 @@ void ProcessTCPRead(TCPRead* tcpread)
 
 void ProcessTCPWrite(TCPWrite* tcpwrite)
 {
-    int writelen, nwrite;
+    int             writelen, nwrite;
+    unsigned        i;
+    unsigned        length;
+    unsigned        numPieces;
+    TCPWritePiece   pieces[MAX_WRITE_PIECES];
+    struct iovec    iov[MAX_WRITE_PIECES];
 
-    iostat.numTCPWrites++;
+    GetLoop()->iostat.numTCPWrites++;
 
     // this indicates check for connect() readyness
     if (tcpwrite->buffer == NULL)
@@ -740,15 +1074,33 @@ void ProcessTCPWrite(TCPWrite* tcpwrite)
         return;
     }
 
-    writelen = tcpwrite->buffer->GetLength() - tcpwrite->transferred;
-    if (writelen <= 0)
+    length = tcpwrite->GetLength();
+    if (length <= tcpwrite->transferred)
     {
         ASSERT_FAIL();
     }
-    
-    nwrite = write(tcpwrite->fd,
-                   tcpwrite->buffer->GetBuffer() + tcpwrite->transferred,
-                   writelen);
+
+    // the buffer and the segments are written with one writev, more calls are
+    // only needed when there are more pieces than MAX_WRITE_PIECES
+    do
+    {
+        numPieces = tcpwrite->GetPieces(pieces, MAX_WRITE_PIECES);
+        writelen = 0;
+        for (i = 0; i < numPieces; i++)
+        {
+            iov[i].iov_base = (void*) pieces[i].data;
+            iov[i].iov_len = pieces[i].length;
+            writelen += pieces[i].length;
+        }
+
+        nwrite = writev(tcpwrite->fd, iov, numPieces);
+        if (nwrite > 0)
+        {
+            GetLoop()->iostat.numTCPBytesSent += nwrite;
+            tcpwrite->transferred += nwrite;
+        }
+    }
+    while (nwrite == writelen && tcpwrite->transferred < length);
                    
     if (nwrite < 0)
     {
@@ -768,9 +1120,7 @@ void ProcessTCPWrite(TCPWrite* tcpwrite)
     }
     else
     {
-        iostat.numTCPBytesSent += nwrite;
-        tcpwrite->transferred += nwrite;
-        if (tcpwrite->transferred == tcpwrite->buffer->GetLength())
+        if (tcpwrite->transferred == length)
             UNLOCKED_CALL(tcpwrite->onComplete);
         else
             UNLOCKED_ADD(tcpwrite);
@@ -779,12 +1129,12 @@ void ProcessTCPWrite(TCPWrite* tcpwrite)
 
 bool IOProcessor::IsRunning()
 {
-  return running;
+  return loops[0].running;
 }
 
 void IOProcessor::GetStats(IOProcessorStat* stat_)
 {
-    *stat_ = iostat;
+    *stat_ = loops[0].iostat;
 }
 
 
@@ -56,6 +56,7 @@ do                                  \
 #define ACCEPT_ADDR_LEN     (sizeof(sockaddr_in) + 16)
 #define MAX_TCP_READ        8192
 #define WRITE_BUFFER_SIZE   8000
+#define MAX_WRITE_PIECES    64
 
 enum CancelPhase {NotCanceled, CancelStarted, CancelCompleted};
 
@@ -442,6 +443,26 @@ void IOProcessor::Shutdown()
     callableQueue.DeleteQueue();
 }
 
+bool IOProcessor::InitLoop(unsigned /*loopID*/)
+{
+    Log_Message("Multiple event loops are only supported on Linux");
+    return false;
+}
+
+void IOProcessor::ShutdownLoop(unsigned /*loopID*/)
+{
+}
+
+void IOProcessor::UseURing(bool useURing)
+{
+    if (useURing)
+        Log_Message("io_uring is only supported on Linux");
+}
+
+void IOProcessor::SetThreadLoop(unsigned /*loopID*/)
+{
+}
+
 static bool RequestReadNotification(IOOperation* ioop)
 {
     DWORD   numBytes, flags;
@@ -483,10 +504,14 @@ static bool RequestReadNotification(IOOperation* ioop)
 
 static bool StartAsyncWrite(TCPWrite* tcpwrite)
 {
-    DWORD       numBytes;
-    IODesc*     iod;
-    int         ret;
-    size_t      len;
+    DWORD           numBytes;
+    IODesc*         iod;
+    int             ret;
+    size_t          len;
+    size_t          pieceLen;
+    unsigned        i;
+    unsigned        numPieces;
+    TCPWritePiece   pieces[MAX_WRITE_PIECES];
 
     ASSERT(tcpwrite->active == false);
 
@@ -503,9 +528,15 @@ static bool StartAsyncWrite(TCPWrite* tcpwrite)
         iostat.memoryUsage += WRITE_BUFFER_SIZE;
     }
 
-    // Copy the buffer
-    len = MIN(tcpwrite->buffer->GetLength() - tcpwrite->transferred, WRITE_BUFFER_SIZE);
-    memcpy(iod->writeBuffer, tcpwrite->buffer->GetBuffer() + tcpwrite->transferred, len);
+    // Copy the buffer and the segments after it
+    numPieces = tcpwrite->GetPieces(pieces, MAX_WRITE_PIECES);
+    len = 0;
+    for (i = 0; i < numPieces && len < WRITE_BUFFER_SIZE; i++)
+    {
+        pieceLen = MIN(pieces[i].length, WRITE_BUFFER_SIZE - len);
+        memcpy(iod->writeBuffer + len, pieces[i].data, pieceLen);
+        len += pieceLen;
+    }
 
     iod->wsabuf.buf = (char*) iod->writeBuffer;
     iod->wsabuf.len = len;
@@ -907,6 +938,11 @@ bool IOProcessor::Poll(int msec)
     return true;
 }
 
+bool IOProcessor::Complete(Callable* callable, unsigned /*loopID*/)
+{
+    return Complete(callable);
+}
+
 bool IOProcessor::Complete(Callable* callable)
 {
     BOOL            ret;
@@ -922,6 +958,7 @@ bool IOProcessor::Complete(Callable* callable)
     callableMutex.Unlock();
 
     iostat.numCompletions++;
+    iostat.numWakeups++;
     iostat.memoryUsage += sizeof(CallableItem);
 
     // notify IOCP that there is a new completion callback
@@ -1054,9 +1091,9 @@ bool ProcessTCPWrite(TCPWrite* tcpwrite)
         iostat.numTCPBytesSent += numBytes;
         tcpwrite->transferred += numBytes;
 
-        if (tcpwrite->transferred == tcpwrite->buffer->GetLength())
+        if (tcpwrite->transferred == tcpwrite->GetLength())
             callable = tcpwrite->onComplete;
-        else if (tcpwrite->transferred < tcpwrite->buffer->GetLength())
+        else if (tcpwrite->transferred < tcpwrite->GetLength())
         {
             iod->write = NULL;
             tcpwrite->active = false; // otherwise Add() returns
@@ -0,0 +1,381 @@
+#include "IOUring.h"
+#include "System/Log.h"
+
+#if defined(PLATFORM_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#ifdef IORING_ENTER_EXT_ARG
+#define IOURING_SUPPORTED
+#endif
+#endif
+#endif
+
+#ifdef IOURING_SUPPORTED
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#define IOURING_REQUIRED_FEATURES   \
+    (IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS | IORING_FEAT_EXT_ARG)
+
+static unsigned LoadAcquire(unsigned* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void StoreRelease(unsigned* p, unsigned value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+IOUring::IOUring()
+{
+    ringfd = -1;
+    numEntries = 0;
+    sqTail = 0;
+    sqRing = NULL;
+    sqRingSize = 0;
+    cqRing = NULL;
+    cqRingSize = 0;
+    sqEntries = NULL;
+    sqEntriesSize = 0;
+}
+
+IOUring::~IOUring()
+{
+    Close();
+}
+
+bool IOUring::Init(unsigned numEntries_)
+{
+    struct io_uring_params  params;
+    char*                   sq;
+    char*                   cq;
+
+    ASSERT(ringfd < 0);
+
+    memset(&params, 0, sizeof(params));
+    ringfd = (int) syscall(__NR_io_uring_setup, numEntries_, &params);
+    if (ringfd < 0)
+    {
+        Log_Errno();
+        return false;
+    }
+
+    if ((params.features & IOURING_REQUIRED_FEATURES) != IOURING_REQUIRED_FEATURES)
+    {
+        Log_Message("io_uring features %x are not supported by the kernel",
+         IOURING_REQUIRED_FEATURES & ~params.features);
+        Close();
+        return false;
+    }
+
+    numEntries = params.sq_entries;
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        sqRingSize = cqRingSize = MAX(sqRingSize, cqRingSize);
+
+    sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+     ringfd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+    {
+        sqRing = NULL;
+        Log_Errno();
+        Close();
+        return false;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        cqRing = sqRing;
+    else
+    {
+        cqRing = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+         ringfd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED)
+        {
+            cqRing = NULL;
+            Log_Errno();
+            Close();
+            return false;
+        }
+    }
+
+    sqEntriesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqEntries = mmap(NULL, sqEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+     ringfd, IORING_OFF_SQES);
+    if (sqEntries == MAP_FAILED)
+    {
+        sqEntries = NULL;
+        Log_Errno();
+        Close();
+        return false;
+    }
+
+    sq = (char*) sqRing;
+    sqHeadPtr = (unsigned*) (sq + params.sq_off.head);
+    sqTailPtr = (unsigned*) (sq + params.sq_off.tail);
+    sqMaskPtr = (unsigned*) (sq + params.sq_off.ring_mask);
+    sqArray = (unsigned*) (sq + params.sq_off.array);
+
+    cq = (char*) cqRing;
+    cqHeadPtr = (unsigned*) (cq + params.cq_off.head);
+    cqTailPtr = (unsigned*) (cq + params.cq_off.tail);
+    cqMaskPtr = (unsigned*) (cq + params.cq_off.ring_mask);
+    cqEntries = (void*) (cq + params.cq_off.cqes);
+
+    sqTail = *sqTailPtr;
+
+    return true;
+}
+
+void IOUring::Close()
+{
+    if (sqEntries)
+        munmap(sqEntries, sqEntriesSize);
+    if (cqRing && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+    if (sqRing)
+        munmap(sqRing, sqRingSize);
+    sqEntries = NULL;
+    cqRing = NULL;
+    sqRing = NULL;
+
+    if (ringfd >= 0)
+        close(ringfd);
+    ringfd = -1;
+}
+
+bool IOUring::IsActive()
+{
+    return (ringfd >= 0);
+}
+
+bool IOUring::PollAdd(FD fd, unsigned mask, uint64_t userData)
+{
+    struct io_uring_sqe*    sqe;
+
+    sqe = (struct io_uring_sqe*) GetEntry();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = mask;
+    sqe->user_data = userData;
+    return true;
+}
+
+bool IOUring::PollRemove(uint64_t targetUserData)
+{
+    struct io_uring_sqe*    sqe;
+
+    sqe = (struct io_uring_sqe*) GetEntry();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = targetUserData;
+    sqe->user_data = 0;
+    return true;
+}
+
+bool IOUring::Write(FD fd, const char* buffer, unsigned length, uint64_t userData, bool link)
+{
+    struct io_uring_sqe*    sqe;
+
+    sqe = (struct io_uring_sqe*) GetEntry();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->off = (uint64_t) -1;
+    sqe->addr = (uint64_t) (uintptr_t) buffer;
+    sqe->len = length;
+    sqe->user_data = userData;
+    if (link)
+        sqe->flags |= IOSQE_IO_LINK;
+    return true;
+}
+
+bool IOUring::Sync(FD fd, uint64_t userData, bool link)
+{
+    struct io_uring_sqe*    sqe;
+
+    sqe = (struct io_uring_sqe*) GetEntry();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->fd = fd;
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    sqe->user_data = userData;
+    if (link)
+        sqe->flags |= IOSQE_IO_LINK;
+    return true;
+}
+
+bool IOUring::Submit(unsigned numWait, int timeout)
+{
+    struct io_uring_getevents_arg   arg;
+    struct __kernel_timespec        ts;
+    unsigned                        flags;
+    unsigned                        numSubmit;
+    int                             ret;
+
+    StoreRelease(sqTailPtr, sqTail);
+    numSubmit = sqTail - LoadAcquire(sqHeadPtr);
+
+    flags = 0;
+    memset(&arg, 0, sizeof(arg));
+    if (numWait > 0)
+    {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg.sigmask_sz = _NSIG / 8;
+        if (timeout >= 0)
+        {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000 * 1000;
+            arg.ts = (uint64_t) (uintptr_t) &ts;
+        }
+    }
+
+    if (numSubmit == 0 && numWait == 0)
+        return true;
+
+    ret = (int) syscall(__NR_io_uring_enter, ringfd, numSubmit, numWait, flags,
+     numWait > 0 ? &arg : NULL, numWait > 0 ? sizeof(arg) : 0);
+    if (ret < 0)
+    {
+        // the completions are reaped by the caller after the timeout and when the
+        // kernel holds back overflowed completions
+        if (errno == ETIME || errno == EBUSY || errno == EAGAIN)
+            return true;
+        Log_Errno();
+        return false;
+    }
+
+    return true;
+}
+
+bool IOUring::GetCompletion(uint64_t& userData, int& result)
+{
+    struct io_uring_cqe*    cqe;
+    unsigned                head;
+
+    head = *cqHeadPtr;
+    if (head == LoadAcquire(cqTailPtr))
+        return false;
+
+    cqe = &((struct io_uring_cqe*) cqEntries)[head & *cqMaskPtr];
+    userData = cqe->user_data;
+    result = cqe->res;
+    StoreRelease(cqHeadPtr, head + 1);
+
+    return true;
+}
+
+unsigned IOUring::GetNumQueued()
+{
+    return sqTail - LoadAcquire(sqHeadPtr);
+}
+
+unsigned IOUring::GetNumFree()
+{
+    return numEntries - GetNumQueued();
+}
+
+void* IOUring::GetEntry()
+{
+    struct io_uring_sqe*    sqe;
+    unsigned                index;
+
+    // hand the queued requests to the kernel when the ring is full
+    if (sqTail - LoadAcquire(sqHeadPtr) >= numEntries)
+    {
+        if (!Submit() || sqTail - LoadAcquire(sqHeadPtr) >= numEntries)
+            return NULL;
+    }
+
+    index = sqTail & *sqMaskPtr;
+    sqe = &((struct io_uring_sqe*) sqEntries)[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    sqTail++;
+
+    return sqe;
+}
+
+#else // IOURING_SUPPORTED
+
+IOUring::IOUring()
+{
+    ringfd = -1;
+}
+
+IOUring::~IOUring()
+{
+}
+
+bool IOUring::Init(unsigned /*numEntries*/)
+{
+    Log_Message("io_uring is not supported on this platform");
+    return false;
+}
+
+void IOUring::Close()
+{
+}
+
+bool IOUring::IsActive()
+{
+    return false;
+}
+
+bool IOUring::PollAdd(FD /*fd*/, unsigned /*mask*/, uint64_t /*userData*/)
+{
+    return false;
+}
+
+bool IOUring::PollRemove(uint64_t /*targetUserData*/)
+{
+    return false;
+}
+
+bool IOUring::Write(FD /*fd*/, const char* /*buffer*/, unsigned /*length*/, uint64_t /*userData*/, bool /*link*/)
+{
+    return false;
+}
+
+bool IOUring::Sync(FD /*fd*/, uint64_t /*userData*/, bool /*link*/)
+{
+    return false;
+}
+
+bool IOUring::Submit(unsigned /*numWait*/, int /*timeout*/)
+{
+    return false;
+}
+
+bool IOUring::GetCompletion(uint64_t& /*userData*/, int& /*result*/)
+{
+    return false;
+}
+
+unsigned IOUring::GetNumQueued()
+{
+    return 0;
+}
+
+unsigned IOUring::GetNumFree()
+{
+    return 0;
+}
+
+#endif // IOURING_SUPPORTED
@@ -0,0 +1,75 @@
+#ifndef IOURING_H
+#define IOURING_H
+
+#include "System/Common.h"
+#include "FD.h"
+
+#define IOURING_POLL_IN         0x001   // POLLIN
+#define IOURING_POLL_OUT        0x004   // POLLOUT
+
+/*
+===============================================================================================
+
+ IOUring: a minimal io_uring submission and completion queue pair
+
+ Requests are queued with Poll..(), Write() and Sync() and handed to the kernel together
+ by Submit(), which can also wait for completions in the same system call. Each request
+ is identified in its completion by the userData passed when queueing it. A linked
+ request only starts after the previous one succeeded; if one in a chain fails or writes
+ less than requested, the rest of the chain completes with -ECANCELED.
+
+ Only available on Linux 5.11 or newer, on other platforms and kernels Init() fails.
+ An IOUring must only be used from one thread at a time.
+
+===============================================================================================
+*/
+
+class IOUring
+{
+public:
+    IOUring();
+    ~IOUring();
+
+    bool            Init(unsigned numEntries);
+    void            Close();
+    bool            IsActive();
+
+    bool            PollAdd(FD fd, unsigned mask, uint64_t userData);
+    bool            PollRemove(uint64_t targetUserData);
+    // writes at the current file position
+    bool            Write(FD fd, const char* buffer, unsigned length, uint64_t userData, bool link);
+    bool            Sync(FD fd, uint64_t userData, bool link);
+
+    // submits the queued requests and waits for numWait completions or timeout msec,
+    // returns false on errors other than the timeout
+    bool            Submit(unsigned numWait = 0, int timeout = -1);
+    bool            GetCompletion(uint64_t& userData, int& result);
+
+    unsigned        GetNumQueued();
+    // the number of requests that can be queued without submitting
+    unsigned        GetNumFree();
+
+private:
+    void*           GetEntry();
+
+    int             ringfd;
+    unsigned        numEntries;
+    unsigned        sqTail;
+    void*           sqRing;
+    size_t          sqRingSize;
+    void*           cqRing;
+    size_t          cqRingSize;
+    void*           sqEntries;
+    size_t          sqEntriesSize;
+
+    unsigned*       sqHeadPtr;
+    unsigned*       sqTailPtr;
+    unsigned*       sqMaskPtr;
+    unsigned*       sqArray;
+    unsigned*       cqHeadPtr;
+    unsigned*       cqTailPtr;
+    unsigned*       cqMaskPtr;
+    void*           cqEntries;
+};
+
+#endif
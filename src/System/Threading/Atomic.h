@@ -37,6 +37,13 @@
 #define AtomicExchange32(u32, v32)  InterlockedExchange(&(u32), (v32))
 #define AtomicExchange64(u64, v64)  InterlockedExchange64(&(u64), (v64))
 
+// full memory barrier, also a compiler barrier
+#define AtomicMemoryBarrier()       MemoryBarrier()
+
+// returns whether ptr was oldv and was replaced by newv
+#define AtomicCompareAndSwapPointer(ptr, oldv, newv)    \
+    (InterlockedCompareExchangePointer((PVOID volatile*) &(ptr), (newv), (oldv)) == (oldv))
+
 inline uint64_t AtomicIncrementU64(volatile uint64_t& target)
 {
     return InterlockedIncrement64((volatile LONGLONG*) &target);
@@ -71,6 +78,13 @@ inline uint64_t AtomicExchangeU64(volatile uint64_t& target, uint64_t value)
 #define AtomicExchange32(u32, v32)  __sync_bool_compare_and_swap(&(u32), (u32), (v32))
 #define AtomicExchange64(u64, v64)  __sync_bool_compare_and_swap(&(u64), (u64), (v64))
 
+// full memory barrier, also a compiler barrier
+#define AtomicMemoryBarrier()       __sync_synchronize()
+
+// returns whether ptr was oldv and was replaced by newv
+#define AtomicCompareAndSwapPointer(ptr, oldv, newv)    \
+    __sync_bool_compare_and_swap(&(ptr), (oldv), (newv))
+
 #define AtomicIncrementU32(u32)     __sync_fetch_and_add(&(u32), 1)
 #define AtomicIncrementU64(u64)     __sync_fetch_and_add(&(u64), 1)
 
@@ -0,0 +1,121 @@
+#include "Test.h"
+#include "Framework/Storage/BloomFilter.h"
+#include "System/Stopwatch.h"
+
+#define BLOOMFILTER_TEST_NUM_KEYS       (100*1000)
+#define BLOOMFILTER_TEST_BITS_PER_KEY   10
+#define BLOOMFILTER_TEST_NUM_LOOKUPS    (1000*1000)
+
+static void FillBloomFilter(BloomFilter& bloomFilter, unsigned version)
+{
+    ReadBuffer  key;
+    char        keybuf[32];
+    unsigned    i;
+    int         ret;
+
+    bloomFilter.SetVersion(version);
+    bloomFilter.SetSize(BLOOMFILTER_TEST_NUM_KEYS * BLOOMFILTER_TEST_BITS_PER_KEY / 8);
+    for (i = 0; i < BLOOMFILTER_TEST_NUM_KEYS; i++)
+    {
+        ret = snprintf(keybuf, sizeof(keybuf), "key%010u", i);
+        key.Wrap(keybuf, ret);
+        bloomFilter.Add(key);
+    }
+}
+
+// returns the number of false positives among the keys that were not added
+static unsigned CheckBloomFilter(BloomFilter& bloomFilter, unsigned num)
+{
+    ReadBuffer  key;
+    char        keybuf[32];
+    unsigned    i;
+    unsigned    numFalse;
+    int         ret;
+
+    numFalse = 0;
+    for (i = 0; i < num; i++)
+    {
+        ret = snprintf(keybuf, sizeof(keybuf), "key%010u", BLOOMFILTER_TEST_NUM_KEYS + i);
+        key.Wrap(keybuf, ret);
+        if (bloomFilter.Check(key))
+            numFalse++;
+    }
+    return numFalse;
+}
+
+TEST_DEFINE(TestBloomFilterBlocked)
+{
+    BloomFilter     bloomFilter;
+    BloomFilter     copy;
+    ReadBuffer      key;
+    ReadBuffer      data;
+    char            keybuf[32];
+    unsigned        version;
+    unsigned        numFalse;
+    unsigned        i;
+    int             ret;
+
+    BloomFilter::StaticInit();
+
+    for (version = BLOOMFILTER_VERSION_1; version <= BLOOMFILTER_VERSION; version++)
+    {
+        FillBloomFilter(bloomFilter, version);
+
+        // the filter read back from its serialized form answers the same
+        data = bloomFilter.GetData();
+        TEST_ASSERT(data.GetLength() == BLOOMFILTER_TEST_NUM_KEYS * BLOOMFILTER_TEST_BITS_PER_KEY / 8);
+        copy.SetVersion(version);
+        copy.SetData(data);
+        TEST_ASSERT(copy.GetData().GetLength() == data.GetLength());
+
+        for (i = 0; i < BLOOMFILTER_TEST_NUM_KEYS; i++)
+        {
+            ret = snprintf(keybuf, sizeof(keybuf), "key%010u", i);
+            key.Wrap(keybuf, ret);
+            TEST_ASSERT(bloomFilter.Check(key));
+            TEST_ASSERT(copy.Check(key));
+        }
+
+        // at 10 bits per key the expected false positive rate is about 1-2%
+        numFalse = CheckBloomFilter(bloomFilter, BLOOMFILTER_TEST_NUM_KEYS);
+        TEST_LOG("version %u: %u false positives in %u lookups", version, numFalse,
+         (unsigned) BLOOMFILTER_TEST_NUM_KEYS);
+        TEST_ASSERT(numFalse < BLOOMFILTER_TEST_NUM_KEYS * 4 / 100);
+        TEST_ASSERT(CheckBloomFilter(copy, BLOOMFILTER_TEST_NUM_KEYS) == numFalse);
+
+        bloomFilter.Reset();
+        copy.Reset();
+    }
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestBloomFilterBenchmark)
+{
+    BloomFilter     bloomFilter;
+    Stopwatch       sw;
+    unsigned        version;
+    unsigned        numFalse;
+
+    BloomFilter::StaticInit();
+
+    for (version = BLOOMFILTER_VERSION_1; version <= BLOOMFILTER_VERSION; version++)
+    {
+        FillBloomFilter(bloomFilter, version);
+
+        sw.Reset();
+        sw.Start();
+        numFalse = CheckBloomFilter(bloomFilter, BLOOMFILTER_TEST_NUM_LOOKUPS);
+        sw.Stop();
+
+        TEST_LOG("version %u: false positive rate = %.2f%%, elapsed: %ld, lookups/s = %f",
+         version, numFalse * 100.0 / BLOOMFILTER_TEST_NUM_LOOKUPS, (long) sw.Elapsed(),
+         BLOOMFILTER_TEST_NUM_LOOKUPS / (MAX(sw.Elapsed(), 1) / 1000.0));
+
+        bloomFilter.Reset();
+    }
+
+    return TEST_SUCCESS;
+}
+
+TEST_MAIN(TestBloomFilterBlocked, TestBloomFilterBenchmark);
@@ -1,12 +1,15 @@
 #include "Test.h"
 #include "System/FileSystem.h"
 #include "Application/ConfigState/ConfigState.h"
+#include "Application/ConfigState/ConfigStateDelta.h"
 #include "Application/ConfigServer/JSONConfigState.h"
 #include "Application/HTTP/JSONSession.h"
 
 static const char   configStateString[] = "C:Y:0:P253:N:3:2:3:32:102:2:1:1:100:0:0:0:N:21384:Y:100:2:1:101:0:1:31:0:N:32771:Y:101:1:1:4:bulk:1:2:1:1:2:4:pics:T:1:31:1:2:2:31:0::0::2:0:154360831:4:2197:2:100:15:127.0.0.1:10010:8090:7090:1:1:21384:F:0:0:0:101:15:127.0.0.1:10020:8091:7091:1:2:32771:F:0:0:0";
 static ReadBuffer   configStateBuffer(configStateString);
 
+static const char   deltaConfigStateString[] = "C:Y:1:P253:N:2:2:2:3:102:1:1:2:q1:2:100:101:0:2:1:2:5:N:7:Y:100:1:1:4:test:1:1:1:1:1:5:table:F:2:1:2:2:1:1:1:0::1:m:0:0:1000:0::1:1:2:1:m:0::0:0:2000:0::2:100:15:127.0.0.1:10010:8090:7090:T:1:1:7:F:0:0:0O:1:1:1:101:15:127.0.0.1:10020:8091:7091:T:1:1:7:F:0:0:0O:1:1:1";
+
 TEST_DEFINE(TestConfigStateJSON)
 {
     ConfigState         configState;
@@ -64,3 +67,86 @@ TEST_DEFINE(TestConfigStateCopy)
 
     return TEST_SUCCESS;
 }
+
+static bool EqualConfigStates(ConfigState& a, ConfigState& b)
+{
+    Buffer  bufferA;
+    Buffer  bufferB;
+
+    a.Write(bufferA, true);
+    b.Write(bufferB, true);
+    return (Buffer::Cmp(bufferA, bufferB) == 0);
+}
+
+TEST_DEFINE(TestConfigStateDelta)
+{
+    ConfigState         master;
+    ConfigState         listener;
+    ConfigState         lagging;
+    ConfigState         copy;
+    ConfigStateDelta    configStateDelta;
+    ConfigShard*        shard;
+    ReadBuffer          rb;
+    uint64_t            baseVersion;
+    uint64_t            version;
+
+    rb.Wrap(deltaConfigStateString);
+    TEST_ASSERT(master.Read(rb, true));
+
+    // the first delta is a snapshot
+    TEST_ASSERT(configStateDelta.Update(master));
+    TEST_ASSERT(!configStateDelta.Update(master));
+    rb = configStateDelta.GetDelta();
+    TEST_ASSERT(ConfigState::ReadDeltaVersions(rb, baseVersion, version));
+    TEST_ASSERT(baseVersion == 0 && version == 1);
+    TEST_ASSERT(listener.ReadDelta(rb));
+    TEST_ASSERT(listener.version == 1);
+    TEST_ASSERT(EqualConfigStates(master, listener));
+    lagging = listener;
+
+    // a volatile shard change is only picked up when the shards are compared
+    shard = master.shards.First();
+    shard->shardSize += 1000;
+    TEST_ASSERT(!configStateDelta.Update(master));
+    TEST_ASSERT(configStateDelta.Update(master, true));
+    rb = configStateDelta.GetDelta();
+    TEST_ASSERT(listener.ReadDelta(rb));
+    TEST_ASSERT(EqualConfigStates(master, listener));
+
+    // new, changed and removed records with a new paxosID
+    shard = new ConfigShard(*master.shards.Last());
+    shard->shardID = master.nextShardID++;
+    master.shards.Append(shard);
+    master.shardServers.Delete(master.shardServers.Last());
+    master.quorums.First()->hasPrimary = false;
+    master.paxosID++;
+    TEST_ASSERT(configStateDelta.Update(master));
+    rb = configStateDelta.GetDelta();
+    TEST_ASSERT(ConfigState::ReadDeltaVersions(rb, baseVersion, version));
+    TEST_ASSERT(baseVersion == 2 && version == 3);
+    TEST_ASSERT(rb.GetLength() < configStateDelta.GetSnapshot().GetLength());
+    TEST_ASSERT(listener.ReadDelta(rb));
+    TEST_ASSERT(listener.version == 3);
+    TEST_ASSERT(EqualConfigStates(master, listener));
+
+    // a delta based on another version is refused without changing the state
+    copy = lagging;
+    TEST_ASSERT(!lagging.ReadDelta(rb));
+    TEST_ASSERT(lagging.version == 1);
+    TEST_ASSERT(EqualConfigStates(copy, lagging));
+    rb = configStateDelta.GetSnapshot();
+    TEST_ASSERT(lagging.ReadDelta(rb));
+    TEST_ASSERT(lagging.version == 3);
+    TEST_ASSERT(EqualConfigStates(master, lagging));
+
+    // after a reset the version continues with a snapshot
+    configStateDelta.Reset();
+    TEST_ASSERT(configStateDelta.Update(master));
+    rb = configStateDelta.GetDelta();
+    TEST_ASSERT(ConfigState::ReadDeltaVersions(rb, baseVersion, version));
+    TEST_ASSERT(baseVersion == 0 && version == 4);
+    TEST_ASSERT(listener.ReadDelta(rb));
+    TEST_ASSERT(EqualConfigStates(master, listener));
+
+    return TEST_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#include "Test.h"
+#include "System/IO/IOProcessor.h"
+#include "System/Events/EventLoop.h"
+#include "System/Threading/ThreadPool.h"
+#include "System/Threading/Atomic.h"
+
+#define COMPLETION_TEST_NUM_THREADS     4
+#define COMPLETION_TEST_NUM_ITEMS       (100*1000)
+
+static volatile uint64_t    numCompleted;
+
+static void OnCompletionTestComplete()
+{
+    numCompleted++;
+}
+
+static void CompletionTestProducer()
+{
+    Callable    onComplete;
+    unsigned    i;
+
+    onComplete = CFunc(OnCompletionTestComplete);
+    for (i = 0; i < COMPLETION_TEST_NUM_ITEMS; i++)
+        IOProcessor::Complete(&onComplete);
+}
+
+TEST_DEFINE(TestIOProcessorComplete)
+{
+    ThreadPool*         producers;
+    IOProcessorStat     iostat;
+    uint64_t            num;
+    unsigned            i;
+
+    IOProcessor::Init(1024);
+    EventLoop::Init();
+
+    numCompleted = 0;
+    num = COMPLETION_TEST_NUM_THREADS * COMPLETION_TEST_NUM_ITEMS;
+
+    producers = ThreadPool::Create(COMPLETION_TEST_NUM_THREADS);
+    for (i = 0; i < COMPLETION_TEST_NUM_THREADS; i++)
+        producers->Execute(CFunc(CompletionTestProducer));
+    producers->Start();
+
+    // a lost wakeup makes this loop hang
+    while (numCompleted < num)
+        EventLoop::RunOnce();
+
+    producers->WaitStop();
+    delete producers;
+
+    IOProcessor::GetStats(&iostat);
+    TEST_LOG("%llu completions, %llu wakeups, %llu polls",
+     (unsigned long long) iostat.numCompletions, (unsigned long long) iostat.numWakeups,
+     (unsigned long long) iostat.numPolls);
+    TEST_ASSERT(iostat.numCompletions == num);
+    TEST_ASSERT(iostat.numWakeups <= iostat.numCompletions);
+
+    EventLoop::Shutdown();
+    IOProcessor::Shutdown();
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestIOProcessorWritePieces)
+{
+    TCPWrite                tcpwrite;
+    Buffer                  buffer;
+    Buffer                  segmentData[2];
+    TCPWriteSegment         segment;
+    List<TCPWriteSegment>   segments;
+    TCPWritePiece           pieces[8];
+    Buffer                  output;
+    unsigned                numPieces;
+    unsigned                i;
+
+    // "12:" + 12 bytes segment + "3:abc" + "5:" + 5 bytes segment
+    buffer.Write("12:3:abc5:");
+    segmentData[0].Write("hello world!");
+    segmentData[1].Write("12345");
+    segment.offset = 3;
+    segment.data = &segmentData[0];
+    segments.Append(segment);
+    segment.offset = buffer.GetLength();
+    segment.data = &segmentData[1];
+    segments.Append(segment);
+
+    tcpwrite.SetBuffer(&buffer);
+    tcpwrite.segments = &segments;
+    TEST_ASSERT(tcpwrite.GetLength() == 27);
+
+    // every split of the output must give back the rest of it
+    for (tcpwrite.transferred = 0; tcpwrite.transferred < 27; tcpwrite.transferred++)
+    {
+        numPieces = tcpwrite.GetPieces(pieces, SIZE(pieces));
+        output.Clear();
+        for (i = 0; i < numPieces; i++)
+        {
+            TEST_ASSERT(pieces[i].length > 0);
+            output.Append(pieces[i].data, pieces[i].length);
+        }
+        TEST_ASSERT(output.GetLength() == 27 - tcpwrite.transferred);
+        TEST_ASSERT(memcmp(output.GetBuffer(),
+         "12:hello world!3:abc5:12345" + tcpwrite.transferred, output.GetLength()) == 0);
+    }
+
+    // the pieces are limited by maxPieces
+    tcpwrite.transferred = 0;
+    TEST_ASSERT(tcpwrite.GetPieces(pieces, 2) == 2);
+    TEST_ASSERT(pieces[1].data == segmentData[0].GetBuffer());
+
+    return TEST_SUCCESS;
+}
+
+TEST_MAIN(TestIOProcessorComplete, TestIOProcessorWritePieces);
@@ -0,0 +1,111 @@
+#include "Test.h"
+#include "System/IO/IOUring.h"
+#include "System/FileSystem.h"
+
+#ifdef PLATFORM_LINUX
+#include <unistd.h>
+#endif
+
+#define IOURING_TEST_NUM_WRITES     3
+
+TEST_DEFINE(TestIOUringWriteSync)
+{
+    IOUring     ring;
+    char        filename[16 + 1];
+    const char  set[] = "0123456789ABCDEF";
+    char        readBuf[IOURING_TEST_NUM_WRITES * (sizeof(set) - 1)];
+    FD          fd;
+    unsigned    i;
+    unsigned    numCompleted;
+    uint64_t    userData;
+    int         result;
+
+    if (!ring.Init(16))
+    {
+        TEST_LOG("io_uring is not available, skipping");
+        return TEST_SUCCESS;
+    }
+
+    RandomBufferFromSet(filename, sizeof(filename) - 1, set, sizeof(set) - 1);
+    filename[sizeof(filename) - 1] = 0;
+
+    fd = FS_Open(filename, FS_CREATE | FS_WRITEONLY | FS_APPEND | FS_TRUNCATE);
+    TEST_ASSERT(fd != INVALID_FD);
+
+    // the linked writes must land in the file in the order they were queued
+    for (i = 0; i < IOURING_TEST_NUM_WRITES; i++)
+        TEST_ASSERT(ring.Write(fd, set + i, sizeof(set) - 1 - i, i + 1, true));
+    TEST_ASSERT(ring.Sync(fd, IOURING_TEST_NUM_WRITES + 1, false));
+    TEST_ASSERT(ring.GetNumQueued() == IOURING_TEST_NUM_WRITES + 1);
+
+    numCompleted = 0;
+    while (numCompleted < IOURING_TEST_NUM_WRITES + 1)
+    {
+        TEST_ASSERT(ring.Submit(1));
+        while (ring.GetCompletion(userData, result))
+        {
+            TEST_ASSERT(userData == numCompleted + 1);
+            if (userData <= IOURING_TEST_NUM_WRITES)
+                TEST_ASSERT(result == (int) (sizeof(set) - userData));
+            else
+                TEST_ASSERT(result == 0);
+            numCompleted++;
+        }
+    }
+    TEST_ASSERT(ring.GetNumQueued() == 0);
+    FS_FileClose(fd);
+
+    fd = FS_Open(filename, FS_READONLY);
+    TEST_ASSERT(fd != INVALID_FD);
+    TEST_ASSERT(FS_FileReadOffs(fd, readBuf, sizeof(readBuf), 0) == sizeof(set) - 1 + sizeof(set) - 2 + sizeof(set) - 3);
+    TEST_ASSERT(memcmp(readBuf, set, sizeof(set) - 1) == 0);
+    TEST_ASSERT(memcmp(readBuf + sizeof(set) - 1, set + 1, sizeof(set) - 2) == 0);
+    FS_FileClose(fd);
+    TEST_ASSERT(FS_Delete(filename));
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestIOUringPoll)
+{
+#ifdef PLATFORM_LINUX
+    IOUring     ring;
+    int         pipefd[2];
+    uint64_t    userData;
+    int         result;
+
+    if (!ring.Init(16))
+    {
+        TEST_LOG("io_uring is not available, skipping");
+        return TEST_SUCCESS;
+    }
+
+    TEST_ASSERT(pipe(pipefd) == 0);
+    TEST_ASSERT(ring.PollAdd(pipefd[0], IOURING_POLL_IN, 1));
+
+    // nothing to read yet, the wait times out
+    TEST_ASSERT(ring.Submit(1, 10));
+    TEST_ASSERT(!ring.GetCompletion(userData, result));
+
+    TEST_ASSERT(write(pipefd[1], "x", 1) == 1);
+    TEST_ASSERT(ring.Submit(1, 1000));
+    TEST_ASSERT(ring.GetCompletion(userData, result));
+    TEST_ASSERT(userData == 1);
+    TEST_ASSERT(result & IOURING_POLL_IN);
+
+    // a removed poll completes with -ECANCELED, the removal itself with userData 0
+    TEST_ASSERT(ring.PollAdd(pipefd[1], IOURING_POLL_IN, 2));
+    TEST_ASSERT(ring.PollRemove(2));
+    TEST_ASSERT(ring.Submit(2, 1000));
+    TEST_ASSERT(ring.GetCompletion(userData, result));
+    TEST_ASSERT(ring.GetCompletion(userData, result));
+    TEST_ASSERT(!ring.GetCompletion(userData, result));
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+#endif
+
+    return TEST_SUCCESS;
+}
+
+TEST_MAIN(TestIOUringWriteSync, TestIOUringPoll);
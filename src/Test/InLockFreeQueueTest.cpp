@@ -0,0 +1,84 @@
+#include "Test.h"
+#include "System/Containers/InLockFreeQueue.h"
+#include "System/Threading/ThreadPool.h"
+#include "System/Threading/Atomic.h"
+
+#define LOCKFREE_TEST_NUM_PRODUCERS     4
+#define LOCKFREE_TEST_NUM_ITEMS         (200*1000)
+
+struct LockFreeTestItem
+{
+    unsigned            producer;
+    unsigned            seq;
+    LockFreeTestItem*   next;
+};
+
+static InLockFreeQueue<LockFreeTestItem>    lockFreeQueue;
+static volatile unsigned                    lockFreeProducerID;
+static volatile unsigned                    lockFreeNumWakeups;
+
+static void LockFreeProducer()
+{
+    LockFreeTestItem*   item;
+    unsigned            producer;
+    unsigned            i;
+
+    // the return value of the increment differs by platform, the modulo maps both to IDs
+    producer = AtomicIncrement32(lockFreeProducerID) % LOCKFREE_TEST_NUM_PRODUCERS;
+    for (i = 0; i < LOCKFREE_TEST_NUM_ITEMS; i++)
+    {
+        item = new LockFreeTestItem;
+        item->producer = producer;
+        item->seq = i;
+        item->next = item;
+        if (lockFreeQueue.Enqueue(item))
+            AtomicIncrement32(lockFreeNumWakeups);
+    }
+}
+
+TEST_DEFINE(TestInLockFreeQueue)
+{
+    ThreadPool*         producers;
+    LockFreeTestItem*   item;
+    unsigned            nextSeq[LOCKFREE_TEST_NUM_PRODUCERS];
+    unsigned            num;
+    unsigned            i;
+
+    for (i = 0; i < LOCKFREE_TEST_NUM_PRODUCERS; i++)
+        nextSeq[i] = 0;
+    lockFreeProducerID = 0;
+    lockFreeNumWakeups = 0;
+
+    producers = ThreadPool::Create(LOCKFREE_TEST_NUM_PRODUCERS);
+    for (i = 0; i < LOCKFREE_TEST_NUM_PRODUCERS; i++)
+        producers->Execute(CFunc(LockFreeProducer));
+    producers->Start();
+
+    // the items of each producer must come out in the order they were enqueued
+    num = 0;
+    while (num < LOCKFREE_TEST_NUM_PRODUCERS * LOCKFREE_TEST_NUM_ITEMS)
+    {
+        item = lockFreeQueue.Dequeue();
+        if (item == NULL)
+        {
+            ThreadPool::YieldThread();
+            continue;
+        }
+        TEST_ASSERT(item->next == item);
+        TEST_ASSERT(item->producer < LOCKFREE_TEST_NUM_PRODUCERS);
+        TEST_ASSERT(item->seq == nextSeq[item->producer]);
+        nextSeq[item->producer]++;
+        delete item;
+        num++;
+    }
+
+    producers->WaitStop();
+    delete producers;
+    TEST_ASSERT(lockFreeQueue.Dequeue() == NULL);
+
+    TEST_LOG("%u items, %u wakeups", num, lockFreeNumWakeups);
+
+    return TEST_SUCCESS;
+}
+
+TEST_MAIN(TestInLockFreeQueue);
@@ -0,0 +1,301 @@
+#include "Test.h"
+#include "Framework/Replication/ReplicationConfig.h"
+#include "Framework/Replication/Paxos/PaxosProposer.h"
+#include "Framework/Replication/Quorums/MajorityQuorum.h"
+
+/*
+===============================================================================================
+
+ TestPaxosContext
+
+ A quorum context for driving a proposer without a database or a network. Broadcasts
+ go to nodes that are not connected, the responses are fed to the proposer by the test.
+
+===============================================================================================
+*/
+
+class TestPaxosContext : public QuorumContext
+{
+public:
+    TestPaxosContext()
+    {
+        paxosID = 0;
+        numPipelineCleared = 0;
+        quorum.AddNode(1);
+        quorum.AddNode(2);
+        quorum.AddNode(3);
+        transport.SetQuorum(&quorum);
+        transport.SetQuorumID(1);
+    }
+
+    bool                IsLeaseOwner()                          { return true; }
+    bool                IsLeaseKnown()                          { return true; }
+    uint64_t            GetLeaseOwner()                         { return MY_NODEID; }
+    bool                IsLeader()                              { return true; }
+
+    void                OnLearnLease()                          {}
+    void                OnLeaseTimeout()                        {}
+    void                OnIsLeader()                            {}
+
+    uint64_t            GetQuorumID()                           { return 1; }
+    void                SetPaxosID(uint64_t paxosID_)           { paxosID = paxosID_; }
+    uint64_t            GetPaxosID()                            { return paxosID; }
+    uint64_t            GetHighestPaxosID()                     { return paxosID; }
+    uint64_t            GetLastLearnChosenTime()                { return 0; }
+    uint64_t            GetReplicationThroughput()              { return 0; }
+
+    Quorum*             GetQuorum()                             { return &quorum; }
+    QuorumDatabase*     GetDatabase()                           { return NULL; }
+    QuorumTransport*    GetTransport()                          { return &transport; }
+
+    bool                UseSyncCommit()                         { return true; }
+    bool                UseProposeTimeouts()                    { return true; }
+    bool                UseCommitChaining()                     { return false; }
+    bool                AlwaysUseDatabaseCatchup()              { return false; }
+    bool                IsPaxosBlocked()                        { return false; }
+    Buffer&             GetNextValue()                          { return nextValue; }
+
+    void                OnStartProposing()                      {}
+    void                OnAppend(uint64_t, Buffer&, bool)       {}
+    void                OnPipelineCleared()                     { numPipelineCleared++; }
+    void                OnNextValueProposed(uint64_t)           {}
+    void                OnMessage(ReadBuffer)                   {}
+    void                OnMessageProcessed()                    {}
+    void                OnStartCatchup()                        {}
+    void                OnCatchupStarted()                      {}
+    void                OnCatchupComplete(uint64_t)             {}
+
+    void                StopReplication()                       {}
+    void                ContinueReplication()                   {}
+
+    bool                IsWaitingOnAppend()                     { return false; }
+
+    uint64_t            paxosID;
+    unsigned            numPipelineCleared;
+    MajorityQuorum      quorum;
+    QuorumTransport     transport;
+    Buffer              nextValue;
+};
+
+static void AcceptPipelined(PaxosProposer& proposer, uint64_t paxosID, uint64_t nodeID)
+{
+    PaxosMessage    msg;
+
+    msg.ProposeAccepted(paxosID, nodeID, 0);
+    proposer.OnPipelinedProposeResponse(msg);
+}
+
+static void AcceptPrepare(PaxosProposer& proposer, uint64_t paxosID, uint64_t nodeID,
+ uint64_t pipelinedPaxosID)
+{
+    PaxosMessage    msg;
+
+    msg.PrepareCurrentlyOpen(paxosID, nodeID, proposer.state.proposalID, pipelinedPaxosID);
+    proposer.OnPrepareResponse(msg);
+}
+
+TEST_DEFINE(TestPaxosMessagePipelinedPaxosID)
+{
+    PaxosMessage    msg;
+    Buffer          buffer;
+    Buffer          value;
+    ReadBuffer      rb;
+
+    value.Write("value");
+    msg.PreparePreviouslyAccepted(100, 2, 5, 0, 1, value, 107);
+    msg.Write(buffer);
+    rb.Wrap(buffer);
+    TEST_ASSERT(msg.Read(rb));
+    TEST_ASSERT(msg.type == PAXOS_PREPARE_PREVIOUSLY_ACCEPTED && msg.pipelinedPaxosID == 107);
+    TEST_ASSERT(msg.value.Equals("value"));
+
+    msg.PrepareCurrentlyOpen(100, 2, 5, 103);
+    msg.Write(buffer);
+    rb.Wrap(buffer);
+    TEST_ASSERT(msg.Read(rb));
+    TEST_ASSERT(msg.type == PAXOS_PREPARE_CURRENTLY_OPEN && msg.pipelinedPaxosID == 103);
+
+    // nodes without pipelining send prepare responses without pipelinedPaxosID
+    buffer.Write("P:4:100:2:5");
+    rb.Wrap(buffer);
+    TEST_ASSERT(msg.Read(rb));
+    TEST_ASSERT(msg.proposalID == 5 && msg.pipelinedPaxosID == 0);
+    buffer.Write("P:3:100:2:5:0:1:5:value");
+    rb.Wrap(buffer);
+    TEST_ASSERT(msg.Read(rb));
+    TEST_ASSERT(msg.runID == 1 && msg.pipelinedPaxosID == 0 && msg.value.Equals("value"));
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestPaxosProposerFailover)
+{
+    TestPaxosContext    context;
+    PaxosProposer       proposer;
+    Buffer              value;
+
+    REPLICATION_CONFIG->SetNodeID(1);
+    REPLICATION_CONFIG->SetRunID(1);
+
+    // without pipelined values at the acceptors the new leader is readable after its first round
+    context.paxosID = 100;
+    proposer.Init(&context);
+    proposer.SetUseTimeouts(true);
+    value.Write("value100");
+    proposer.Propose(value);
+    TEST_ASSERT(proposer.state.preparing && proposer.state.proposalID > 0);
+    AcceptPrepare(proposer, 100, 2, 0);
+    AcceptPrepare(proposer, 100, 3, 0);
+    TEST_ASSERT(proposer.state.proposing);
+    TEST_ASSERT(proposer.GetPipelineStart() <= 101);
+    proposer.Stop();
+
+    context.paxosID = 101;
+    proposer.state.multi = true;
+    proposer.OnNewPaxosRound();
+    TEST_ASSERT(proposer.IsLeaderReadable());
+    value.Write("value101");
+    proposer.Propose(value);
+    TEST_ASSERT(proposer.state.proposing && proposer.state.proposalID == 0);
+    proposer.Stop();
+
+    // an acceptor reports values pipelined by the previous leader up to round 104
+    context.paxosID = 102;
+    proposer.OnNewPaxosRound();
+    value.Write("value102");
+    proposer.Propose(value);
+    TEST_ASSERT(proposer.state.preparing);
+    AcceptPrepare(proposer, 102, 2, 104);
+    AcceptPrepare(proposer, 102, 3, 0);
+    TEST_ASSERT(proposer.GetPipelineStart() == 105);
+    proposer.Stop();
+
+    context.paxosID = 104;
+    proposer.state.multi = true;
+    proposer.OnNewPaxosRound();
+    TEST_ASSERT(!proposer.IsLeaderReadable());
+    value.Write("value104");
+    proposer.Propose(value);
+    TEST_ASSERT(proposer.state.preparing);
+    proposer.Stop();
+
+    context.paxosID = 105;
+    proposer.state.multi = true;
+    proposer.OnNewPaxosRound();
+    TEST_ASSERT(proposer.IsLeaderReadable());
+
+    proposer.Stop();
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestPaxosProposerPipeline)
+{
+    TestPaxosContext    context;
+    PaxosProposer       proposer;
+    Buffer              value;
+
+    REPLICATION_CONFIG->SetNodeID(1);
+    REPLICATION_CONFIG->SetRunID(1);
+
+    context.paxosID = 100;
+    proposer.Init(&context);
+    proposer.SetUseTimeouts(true);
+    proposer.state.multi = true;
+    proposer.SetPipelineStart(100);
+    TEST_ASSERT(proposer.IsLeaderReadable());
+
+    // the current round and two pipelined rounds are proposed with ballot 0
+    value.Write("value100");
+    proposer.Propose(value);
+    TEST_ASSERT(proposer.state.proposing && proposer.state.proposalID == 0);
+    value.Write("value101");
+    proposer.ProposePipelined(101, value);
+    value.Write("value102");
+    proposer.ProposePipelined(102, value);
+    TEST_ASSERT(proposer.GetNumPipelined() == 2);
+    AcceptPipelined(proposer, 101, 1);
+    AcceptPipelined(proposer, 101, 2);
+
+    // round 100 is chosen, the pipelined value of round 101 already has a majority
+    context.paxosID = 101;
+    proposer.OnNewPaxosRound();
+    TEST_ASSERT(proposer.IsLearnSent());
+    TEST_ASSERT(proposer.GetNumPipelined() == 1);
+    value.Write("value101");
+    TEST_ASSERT(BUFCMP(&proposer.state.proposedValue, &value));
+    TEST_ASSERT(context.numPipelineCleared == 0);
+    TEST_ASSERT(proposer.IsLeaderReadable());
+
+    proposer.Stop();
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestPaxosProposerPipelineClearedOnConflict)
+{
+    TestPaxosContext    context;
+    PaxosProposer       proposer;
+    Buffer              value;
+
+    REPLICATION_CONFIG->SetNodeID(1);
+    REPLICATION_CONFIG->SetRunID(1);
+
+    context.paxosID = 100;
+    proposer.Init(&context);
+    proposer.SetUseTimeouts(true);
+    proposer.state.multi = true;
+    proposer.SetPipelineStart(100);
+
+    value.Write("value100");
+    proposer.Propose(value);
+    value.Write("value101");
+    proposer.ProposePipelined(101, value);
+    value.Write("value102");
+    proposer.ProposePipelined(102, value);
+    AcceptPipelined(proposer, 101, 2);
+    AcceptPipelined(proposer, 102, 2);
+
+    // round 100 chose a conflicting value, the acceptors may still hold
+    // the pipelined values of rounds 101 and 102 with ballot 0
+    proposer.Stop();
+    proposer.state.multi = true;
+    proposer.ClearPipeline();
+    TEST_ASSERT(context.numPipelineCleared == 1);
+    TEST_ASSERT(proposer.GetNumPipelined() == 0);
+    TEST_ASSERT(proposer.GetPipelineStart() == 103);
+
+    // until the cleared rounds are learned, strict reads are not served
+    // and the rounds are proposed after a prepare phase with a higher ballot
+    context.paxosID = 101;
+    proposer.OnNewPaxosRound();
+    TEST_ASSERT(!proposer.IsLeaderReadable());
+    value.Write("other101");
+    proposer.Propose(value);
+    TEST_ASSERT(proposer.state.preparing && proposer.state.proposalID > 0);
+    proposer.Stop();
+
+    context.paxosID = 102;
+    proposer.state.multi = true;
+    proposer.OnNewPaxosRound();
+    TEST_ASSERT(!proposer.IsLeaderReadable());
+    value.Write("other102");
+    proposer.Propose(value);
+    TEST_ASSERT(proposer.state.preparing && proposer.state.proposalID > 0);
+    proposer.Stop();
+
+    // past the cleared rounds ballot 0 can be used again
+    context.paxosID = 103;
+    proposer.state.multi = true;
+    proposer.OnNewPaxosRound();
+    TEST_ASSERT(proposer.IsLeaderReadable());
+    value.Write("value103");
+    proposer.Propose(value);
+    TEST_ASSERT(proposer.state.proposing && proposer.state.proposalID == 0);
+
+    // clearing an empty pipeline does not move pipelineStart
+    proposer.ClearPipeline();
+    TEST_ASSERT(context.numPipelineCleared == 1);
+    TEST_ASSERT(proposer.GetPipelineStart() == 103);
+
+    proposer.Stop();
+    return TEST_SUCCESS;
+}
@@ -0,0 +1,238 @@
+#include "Test.h"
+#include "System/Stopwatch.h"
+#include "Application/SDBP/SDBPRequestMessage.h"
+#include "Application/SDBP/SDBPResponseMessage.h"
+#include "Framework/Messaging/MessageUtil.h"
+
+static void SetupSDBPTestRequests(ClientRequest* requests, unsigned num)
+{
+    Buffer      key;
+    Buffer      value;
+    ReadBuffer  rbKey;
+    ReadBuffer  rbValue;
+    unsigned    i;
+
+    for (i = 0; i < num; i++)
+    {
+        key.Writef("user:%010u", i);
+        value.Writef("{\"name\": \"user %u\", \"email\": \"user%u@example.com\"}", i, i);
+        rbKey.Wrap(key);
+        rbValue.Wrap(value);
+        if (i % 2 == 0)
+            requests[i].Get(1000000 + i, 123456, 42, rbKey);
+        else
+            requests[i].Set(1000000 + i, 123456, 42, rbKey, rbValue);
+    }
+}
+
+TEST_DEFINE(TestSDBPBinaryRoundTrip)
+{
+    ClientRequest       request;
+    ClientRequest       readRequest;
+    ClientResponse      response;
+    ClientResponse      readResponse;
+    SDBPRequestMessage  msg;
+    SDBPRequestMessage  readMsg;
+    SDBPResponseMessage responseMsg;
+    SDBPResponseMessage readResponseMsg;
+    ReadBuffer          key("key");
+    ReadBuffer          value("value");
+    Buffer              buffer;
+    ReadBuffer          rb;
+
+    request.Add(1, 2, 3, key, -12345);
+    request.transactional = true;
+    msg.request = &request;
+    msg.binary = true;
+    TEST_ASSERT(msg.Write(buffer));
+    TEST_ASSERT(buffer.GetCharAt(0) == SDBP_BINARY_MARKER);
+
+    rb.Wrap(buffer);
+    readMsg.request = &readRequest;
+    TEST_ASSERT(readMsg.Read(rb));
+    TEST_ASSERT(readMsg.binary);
+    TEST_ASSERT(readRequest.type == CLIENTREQUEST_ADD);
+    TEST_ASSERT(readRequest.transactional);
+    TEST_ASSERT(readRequest.commandID == 1);
+    TEST_ASSERT(readRequest.configPaxosID == 2);
+    TEST_ASSERT(readRequest.tableID == 3);
+    TEST_ASSERT(ReadBuffer::Cmp(key, readRequest.key) == 0);
+    TEST_ASSERT(readRequest.number == -12345);
+
+    // truncated messages must be rejected
+    rb.SetLength(rb.GetLength() - 1);
+    readRequest.Init();
+    TEST_ASSERT(!readMsg.Read(rb));
+
+    response.request = &request;
+    response.Value(value);
+    response.paxosID = 1ULL << 40;
+    responseMsg.response = &response;
+    responseMsg.binary = true;
+    buffer.Clear();
+    TEST_ASSERT(responseMsg.Write(buffer));
+
+    rb.Wrap(buffer);
+    readResponseMsg.response = &readResponse;
+    TEST_ASSERT(readResponseMsg.Read(rb));
+    TEST_ASSERT(readResponse.type == CLIENTRESPONSE_VALUE);
+    TEST_ASSERT(readResponse.commandID == 1);
+    TEST_ASSERT(ReadBuffer::Cmp(value, readResponse.value) == 0);
+    TEST_ASSERT(readResponse.paxosID == 1ULL << 40);
+
+    // HELLO is always text, so that old clients can read it
+    response.Hello();
+    response.number = SDBP_PROTOCOL_VERSION_BINARY;
+    buffer.Clear();
+    TEST_ASSERT(responseMsg.Write(buffer));
+    TEST_ASSERT(buffer.GetCharAt(0) == CLIENTRESPONSE_HELLO);
+    rb.Wrap(buffer);
+    readResponse.Init();
+    TEST_ASSERT(readResponseMsg.Read(rb));
+    TEST_ASSERT(readResponse.number == SDBP_PROTOCOL_VERSION_BINARY);
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestSDBPMultiRoundTrip)
+{
+    ClientRequest       request;
+    ClientRequest       readRequest;
+    SDBPRequestMessage  msg;
+    SDBPRequestMessage  readMsg;
+    Buffer              keys[10];
+    Buffer              buffer;
+    ReadBuffer          rb;
+    ReadBuffer          items;
+    ReadBuffer          key;
+    ReadBuffer          value;
+    unsigned            i;
+    int                 binary;
+
+    for (binary = 0; binary < 2; binary++)
+    {
+        request.MultiSet(1, 2, 3);
+        for (i = 0; i < 10; i++)
+        {
+            keys[i].Writef("key%u", i);
+            key.Wrap(keys[i]);
+            value.Wrap(keys[i]);
+            request.AppendMultiKeyValue(key, value);
+        }
+        TEST_ASSERT(request.count == 10);
+        TEST_ASSERT(request.IsMulti());
+
+        msg.request = &request;
+        msg.binary = (binary != 0);
+        buffer.Clear();
+        TEST_ASSERT(msg.Write(buffer));
+
+        rb.Wrap(buffer);
+        readRequest.Init();
+        readMsg.request = &readRequest;
+        TEST_ASSERT(readMsg.Read(rb));
+        TEST_ASSERT(readRequest.type == CLIENTREQUEST_MULTI_SET);
+        TEST_ASSERT(readRequest.tableID == 3);
+        TEST_ASSERT(readRequest.count == 10);
+        TEST_ASSERT(ReadBuffer::Cmp(readRequest.key, "key0") == 0);
+
+        items.Wrap(readRequest.value);
+        MessageReader reader(items);
+        for (i = 0; i < 10; i++)
+        {
+            TEST_ASSERT(reader.ReadData(key));
+            TEST_ASSERT(reader.ReadData(value));
+            TEST_ASSERT(ReadBuffer::Cmp(key, keys[i]) == 0);
+            TEST_ASSERT(ReadBuffer::Cmp(value, keys[i]) == 0);
+        }
+        TEST_ASSERT(reader.IsEnd());
+
+        request.MultiGet(4, 2, 3);
+        request.paxosID = 5;
+        for (i = 0; i < 10; i++)
+        {
+            key.Wrap(keys[i]);
+            request.AppendMultiKey(key);
+        }
+        buffer.Clear();
+        TEST_ASSERT(msg.Write(buffer));
+
+        rb.Wrap(buffer);
+        readRequest.Init();
+        TEST_ASSERT(readMsg.Read(rb));
+        TEST_ASSERT(readRequest.type == CLIENTREQUEST_MULTI_GET);
+        TEST_ASSERT(readRequest.IsList());
+        TEST_ASSERT(readRequest.paxosID == 5);
+        TEST_ASSERT(readRequest.count == 10);
+        TEST_ASSERT(ReadBuffer::Cmp(readRequest.value, request.value) == 0);
+    }
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestSDBPParserBenchmark)
+{
+    const unsigned      num = 100*1000;
+    const unsigned      numRounds = 10;
+    ClientRequest*      requests;
+    ClientRequest       request;
+    SDBPRequestMessage  msg;
+    Buffer              textBuffers[2];
+    Buffer              binaryBuffers[2];
+    Buffer*             buffers;
+    ReadBuffer          rb;
+    Stopwatch           sw;
+    unsigned            i, j, k;
+    uint64_t            textElapsed;
+
+    requests = new ClientRequest[num];
+    SetupSDBPTestRequests(requests, num);
+
+    msg.request = &request;
+    for (k = 0; k < 2; k++)
+    {
+        msg.binary = (k == 1);
+        buffers = (k == 0 ? textBuffers : binaryBuffers);
+
+        // the buffers end up holding the last GET and SET message
+        sw.Reset();
+        sw.Start();
+        for (j = 0; j < numRounds; j++)
+        {
+            for (i = 0; i < num; i++)
+            {
+                msg.request = &requests[i];
+                buffers[i % 2].Clear();
+                msg.Write(buffers[i % 2]);
+            }
+        }
+        sw.Stop();
+        TEST_LOG("%s write: %u msgs in %llu msec",
+         k == 0 ? "text" : "binary", num * numRounds, (unsigned long long) sw.Elapsed());
+
+        msg.request = &request;
+        sw.Reset();
+        sw.Start();
+        for (j = 0; j < numRounds; j++)
+        {
+            for (i = 0; i < num; i++)
+            {
+                request.Init();
+                rb.Wrap(buffers[i % 2]);
+                if (!msg.Read(rb))
+                    TEST_FAIL();
+            }
+        }
+        sw.Stop();
+        TEST_LOG("%s read: %u msgs in %llu msec, GET: %u bytes, SET: %u bytes",
+         k == 0 ? "text" : "binary", num * numRounds, (unsigned long long) sw.Elapsed(),
+         buffers[0].GetLength(), buffers[1].GetLength());
+        if (k == 0)
+            textElapsed = sw.Elapsed();
+    }
+    TEST_LOG("binary read speedup: %.2fx", (double) textElapsed / MAX(sw.Elapsed(), (uint64_t) 1));
+
+    delete[] requests;
+
+    return TEST_SUCCESS;
+}
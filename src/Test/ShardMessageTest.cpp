@@ -0,0 +1,236 @@
+#include "Test.h"
+#include "System/Stopwatch.h"
+#include "Framework/Messaging/MessageUtil.h"
+#include "Application/ShardServer/ShardMessage.h"
+
+static void SetupShardTestMessages(ShardMessage* messages, Buffer* keys, Buffer* values, unsigned num)
+{
+    unsigned    i;
+
+    for (i = 0; i < num; i++)
+    {
+        keys[i].Writef("user:%010u", i);
+        values[i].Writef("{\"name\": \"user %u\", \"email\": \"user%u@example.com\", \"active\": true}", i, i);
+        messages[i].type = SHARDMESSAGE_SET;
+        messages[i].tableID = 1000000 + i;
+        messages[i].key.Wrap(keys[i]);
+        messages[i].value.Wrap(values[i]);
+    }
+}
+
+TEST_DEFINE(TestShardMessageBinaryRoundTrip)
+{
+    ShardMessage    messages[5];
+    ShardMessage    readMessage;
+    ReadBuffer      key("key");
+    ReadBuffer      value("value");
+    ReadBuffer      splitKey("split");
+    Buffer          buffer;
+    ReadBuffer      rb;
+    unsigned        i;
+    int             read;
+
+    messages[0].type = SHARDMESSAGE_SET;
+    messages[0].tableID = 1ULL << 40;
+    messages[0].key = key;
+    messages[0].value = value;
+    messages[1].type = SHARDMESSAGE_ADD;
+    messages[1].tableID = 2;
+    messages[1].key = key;
+    messages[1].number = -12345;
+    messages[2].StartTransaction();
+    messages[3].SplitShard(3, 4, splitKey);
+    messages[4].ShardMigrationSet(5, key, value);
+
+    ShardMessage::AppendValueHeader(buffer);
+    for (i = 0; i < SIZE(messages); i++)
+        TEST_ASSERT(messages[i].AppendBinary(buffer));
+
+    rb.Wrap(buffer);
+    TEST_ASSERT(ShardMessage::ReadValueHeader(rb) == SHARDMESSAGE_VERSION_BINARY);
+    for (i = 0; i < SIZE(messages); i++)
+    {
+        read = readMessage.ReadBinary(rb);
+        TEST_ASSERT(read > 0);
+        rb.Advance(read);
+        TEST_ASSERT(readMessage.type == messages[i].type);
+    }
+    TEST_ASSERT(rb.GetLength() == 0);
+    TEST_ASSERT(readMessage.shardID == 5);
+    TEST_ASSERT(ReadBuffer::Cmp(readMessage.key, key) == 0);
+    TEST_ASSERT(ReadBuffer::Cmp(readMessage.value, value) == 0);
+
+    // first message again, and the ADD with a negative number
+    rb.Wrap(buffer);
+    ShardMessage::ReadValueHeader(rb);
+    rb.Advance(readMessage.ReadBinary(rb));
+    TEST_ASSERT(readMessage.tableID == 1ULL << 40);
+    rb.Advance(readMessage.ReadBinary(rb));
+    TEST_ASSERT(readMessage.number == -12345);
+
+    // truncated messages must be rejected
+    rb.Wrap(buffer);
+    ShardMessage::ReadValueHeader(rb);
+    rb.SetLength(5);
+    TEST_ASSERT(readMessage.ReadBinary(rb) == 0);
+
+    // values without the header are in the text format
+    buffer.Clear();
+    messages[0].Append(buffer);
+    buffer.Appendf(" ");
+    rb.Wrap(buffer);
+    TEST_ASSERT(ShardMessage::ReadValueHeader(rb) == SHARDMESSAGE_VERSION_TEXT);
+    TEST_ASSERT(rb.GetLength() == buffer.GetLength());
+    TEST_ASSERT(readMessage.Read(rb) > 0);
+    TEST_ASSERT(readMessage.tableID == 1ULL << 40);
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestShardMessageMigrationBatch)
+{
+    ShardMessage    message;
+    ShardMessage    readMessage;
+    Buffer          items;
+    Buffer          buffer;
+    Buffer          key;
+    Buffer          value;
+    ReadBuffer      rb;
+    ReadBuffer      readKey;
+    ReadBuffer      readValue;
+    char            type;
+    unsigned        i;
+    int             read;
+
+    // every third item is a delete
+    for (i = 0; i < 100; i++)
+    {
+        key.Writef("key%u", i);
+        value.Writef("value%u", i);
+        if (i % 3 == 0)
+            ShardMessage::AppendMigrationDelete(items, key);
+        else
+            ShardMessage::AppendMigrationSet(items, key, value);
+    }
+
+    rb.Wrap(items);
+    message.ShardMigrationBatch(7, rb);
+    TEST_ASSERT(message.AppendBinary(buffer));
+    rb.Wrap(buffer);
+    read = readMessage.ReadBinary(rb);
+    TEST_ASSERT(read == (int) buffer.GetLength());
+    TEST_ASSERT(readMessage.type == SHARDMESSAGE_MIGRATION_BATCH);
+    TEST_ASSERT(readMessage.shardID == 7);
+    TEST_ASSERT(ReadBuffer::Cmp(readMessage.value, items) == 0);
+
+    buffer.Clear();
+    TEST_ASSERT(message.Append(buffer));
+    rb.Wrap(buffer);
+    TEST_ASSERT(readMessage.Read(rb) == (int) buffer.GetLength());
+    TEST_ASSERT(ReadBuffer::Cmp(readMessage.value, items) == 0);
+
+    MessageReader reader(readMessage.value);
+    for (i = 0; i < 100; i++)
+    {
+        key.Writef("key%u", i);
+        value.Writef("value%u", i);
+        TEST_ASSERT(reader.ReadChar(type));
+        TEST_ASSERT(reader.ReadData(readKey));
+        TEST_ASSERT(ReadBuffer::Cmp(readKey, key) == 0);
+        if (i % 3 == 0)
+        {
+            TEST_ASSERT(type == SHARDMESSAGE_MIGRATION_DELETE);
+            continue;
+        }
+        TEST_ASSERT(type == SHARDMESSAGE_MIGRATION_SET);
+        TEST_ASSERT(reader.ReadData(readValue));
+        TEST_ASSERT(ReadBuffer::Cmp(readValue, value) == 0);
+    }
+    TEST_ASSERT(reader.IsEnd());
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestShardMessageBenchmark)
+{
+    const unsigned      num = 10*1000;
+    const unsigned      numRounds = 100;
+    ShardMessage*       messages;
+    ShardMessage        readMessage;
+    Buffer*             keys;
+    Buffer*             values;
+    Buffer              buffer;
+    ReadBuffer          rb;
+    Stopwatch           sw;
+    unsigned            i, j, k;
+    unsigned            version;
+    uint64_t            elapsed[2];
+    int                 read;
+
+    messages = new ShardMessage[num];
+    keys = new Buffer[num];
+    values = new Buffer[num];
+    SetupShardTestMessages(messages, keys, values, num);
+
+    // encode a replicated value of num messages, then decode it, like a replica does
+    for (k = 0; k < 2; k++)
+    {
+        sw.Reset();
+        sw.Start();
+        for (j = 0; j < numRounds; j++)
+        {
+            buffer.Clear();
+            if (k == 1)
+                ShardMessage::AppendValueHeader(buffer);
+            for (i = 0; i < num; i++)
+            {
+                if (k == 1)
+                    messages[i].AppendBinary(buffer);
+                else
+                {
+                    messages[i].Append(buffer);
+                    buffer.Appendf(" ");
+                }
+            }
+        }
+        sw.Stop();
+        TEST_LOG("%s encode: %u msgs in %llu msec, %u bytes/msg",
+         k == 0 ? "text" : "binary", num * numRounds, (unsigned long long) sw.Elapsed(),
+         buffer.GetLength() / num);
+
+        sw.Reset();
+        sw.Start();
+        for (j = 0; j < numRounds; j++)
+        {
+            rb.Wrap(buffer);
+            version = ShardMessage::ReadValueHeader(rb);
+            while (rb.GetLength() > 0)
+            {
+                if (version == SHARDMESSAGE_VERSION_BINARY)
+                {
+                    read = readMessage.ReadBinary(rb);
+                    TEST_ASSERT(read > 0);
+                    rb.Advance(read);
+                }
+                else
+                {
+                    read = readMessage.Read(rb);
+                    TEST_ASSERT(read > 0);
+                    rb.Advance(read + 1);
+                }
+            }
+        }
+        sw.Stop();
+        elapsed[k] = sw.Elapsed();
+        TEST_LOG("%s decode: %u msgs in %llu msec",
+         k == 0 ? "text" : "binary", num * numRounds, (unsigned long long) elapsed[k]);
+        TEST_ASSERT(ReadBuffer::Cmp(readMessage.key, messages[num - 1].key) == 0);
+    }
+    TEST_LOG("binary decode speedup: %.2fx", (double) elapsed[0] / MAX(elapsed[1], (uint64_t) 1));
+
+    delete[] messages;
+    delete[] keys;
+    delete[] values;
+
+    return TEST_SUCCESS;
+}
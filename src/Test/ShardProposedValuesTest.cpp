@@ -0,0 +1,127 @@
+#include "Test.h"
+#include "Application/ShardServer/ShardProposedValues.h"
+
+#define NUM_TEST_MESSAGES   6
+
+/*
+===============================================================================================
+
+ Builds the next value from the queued messages that are not proposed yet,
+ the same way ShardQuorumProcessor::TryAppend() does.
+
+===============================================================================================
+*/
+
+static void BuildTestValue(ShardProposedValues& proposedValues, InList<ShardMessage>& shardMessages,
+ unsigned numMessages, Buffer& value)
+{
+    ShardMessage*   message;
+
+    value.Clear();
+    FOREACH (message, shardMessages)
+    {
+        if (numMessages == 0)
+            break;
+        if (message->proposedValue != NULL)
+            continue;
+        message->Append(value);
+        value.Appendf(" ");
+        proposedValues.Add(message);
+        numMessages--;
+    }
+    proposedValues.OnAppend(value);
+}
+
+static void ExecuteTestValue(ShardProposedValues& proposedValues, InList<ShardMessage>& shardMessages,
+ ShardMessage* message)
+{
+    ShardMessage*   next;
+
+    while (message != NULL)
+    {
+        next = proposedValues.Next(message);
+        proposedValues.OnExecute(message);
+        shardMessages.Remove(message);
+        message = next;
+    }
+    proposedValues.OnChosenExecuted();
+}
+
+TEST_DEFINE(TestShardProposedValuesAdopted)
+{
+    unsigned                i;
+    Buffer                  keys[NUM_TEST_MESSAGES];
+    Buffer                  valueA, valueB, valueC, valueD, other;
+    ShardMessage            messages[NUM_TEST_MESSAGES];
+    ShardMessage*           message;
+    InList<ShardMessage>    shardMessages;
+    ShardProposedValues     proposedValues;
+
+    proposedValues.Init(&shardMessages);
+    for (i = 0; i < NUM_TEST_MESSAGES; i++)
+    {
+        keys[i].Writef("key%u", i);
+        messages[i].type = SHARDMESSAGE_DELETE;
+        messages[i].tableID = 1;
+        messages[i].key.Wrap(keys[i]);
+        shardMessages.Append(&messages[i]);
+    }
+
+    // A = {0, 1} proposed for round 101, B = {2, 3} pipelined for round 102,
+    // C = {4} waits in nextValue
+    BuildTestValue(proposedValues, shardMessages, 2, valueA);
+    proposedValues.OnPropose(101);
+    BuildTestValue(proposedValues, shardMessages, 2, valueB);
+    proposedValues.OnPropose(102);
+    BuildTestValue(proposedValues, shardMessages, 1, valueC);
+    TEST_ASSERT(proposedValues.GetNumMessages() == 5);
+
+    // round 101 chose another node's value, A and C are proposed again, B may still be chosen
+    other.Write("other");
+    TEST_ASSERT(proposedValues.OnChosen(101, other) == NULL);
+    proposedValues.ReleaseUnproposed();
+    TEST_ASSERT(proposedValues.GetNumValues() == 1 && proposedValues.GetNumMessages() == 2);
+    TEST_ASSERT(messages[0].proposedValue == NULL && messages[4].proposedValue == NULL);
+    TEST_ASSERT(messages[2].proposedValue != NULL && messages[3].proposedValue != NULL);
+
+    // D = {0, 1, 4} skips the messages of B and is proposed for round 102 after a prepare
+    BuildTestValue(proposedValues, shardMessages, 3, valueD);
+    proposedValues.OnPropose(102);
+    TEST_ASSERT(messages[4].proposedValue == messages[0].proposedValue);
+    TEST_ASSERT(proposedValues.GetNumMessages() == 5);
+
+    // the prepare phase adopted B, which does not start at the head of the queue
+    message = proposedValues.OnChosen(102, valueB);
+    TEST_ASSERT(message == &messages[2]);
+    TEST_ASSERT(proposedValues.Next(message) == &messages[3]);
+    TEST_ASSERT(proposedValues.Next(&messages[3]) == NULL);
+    TEST_ASSERT(proposedValues.GetNumValues() == 0);
+    ExecuteTestValue(proposedValues, shardMessages, message);
+    TEST_ASSERT(shardMessages.GetLength() == 4);
+    TEST_ASSERT(proposedValues.GetNumMessages() == 0);
+    FOREACH (message, shardMessages)
+        TEST_ASSERT(message->proposedValue == NULL);
+
+    // a value of ours chosen for its round is executed as ours
+    BuildTestValue(proposedValues, shardMessages, 2, valueA);
+    proposedValues.OnPropose(103);
+    message = proposedValues.OnChosen(103, valueA);
+    TEST_ASSERT(message == &messages[0]);
+    ExecuteTestValue(proposedValues, shardMessages, message);
+    TEST_ASSERT(shardMessages.GetLength() == 2 && proposedValues.GetNumMessages() == 0);
+
+    // a value whose round chose a dummy is released, unless it is proposed again in nextValue
+    BuildTestValue(proposedValues, shardMessages, 1, valueC);
+    proposedValues.OnPropose(104);
+    proposedValues.ReleaseBefore(105, true);
+    TEST_ASSERT(proposedValues.GetNumMessages() == 1);
+    proposedValues.ReleaseBefore(105, false);
+    TEST_ASSERT(proposedValues.GetNumMessages() == 0 && proposedValues.GetNumValues() == 0);
+
+    BuildTestValue(proposedValues, shardMessages, 2, valueD);
+    proposedValues.Clear();
+    TEST_ASSERT(messages[4].proposedValue == NULL && messages[5].proposedValue == NULL);
+    shardMessages.ClearMembers();
+
+    return TEST_SUCCESS;
+}
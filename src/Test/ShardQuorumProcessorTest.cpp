@@ -0,0 +1,170 @@
+#include "Test.h"
+#include "Application/ShardServer/ShardServer.h"
+#include "Application/Common/ContextTransport.h"
+#include "Application/Common/ClientSession.h"
+#include "Framework/Replication/ReplicationConfig.h"
+#include "Framework/Replication/Paxos/PaxosMessage.h"
+#include "System/Config.h"
+#include "System/Events/EventLoop.h"
+#include "System/IO/IOProcessor.h"
+
+#define TEST_QUORUMID       1
+#define TEST_MASTERID       0
+
+static bool LessThan(uint64_t a, uint64_t b)
+{
+    return a < b;
+}
+
+/*
+===============================================================================================
+
+ TestClientSession
+
+===============================================================================================
+*/
+
+class TestClientSession : public ClientSession
+{
+public:
+    TestClientSession()                                 { numCompleted = 0; }
+
+    void            OnComplete(ClientRequest*, bool)    { numCompleted++; }
+    bool            IsActive()                          { return true; }
+
+    unsigned        numCompleted;
+};
+
+static void SendPaxosMessage(PaxosMessage& msg)
+{
+    Buffer      buffer;
+    ReadBuffer  rb;
+
+    msg.Write(buffer);
+    rb.Wrap(buffer);
+    CONTEXT_TRANSPORT->GetQuorumContext(TEST_QUORUMID)->OnMessage(rb);
+}
+
+// runs a Paxos round for the dummy the primary proposes after a prepare phase,
+// the other nodes report the highest round they hold a pipelined value for
+static void RunPreparedRound(ShardQuorumProcessor& processor, uint64_t& proposalID,
+ uint64_t pipelinedPaxosID)
+{
+    uint64_t        paxosID;
+    Buffer          dummy;
+    PaxosMessage    msg;
+
+    paxosID = processor.GetPaxosID();
+    proposalID = REPLICATION_CONFIG->NextProposalID(proposalID);
+    dummy.Write("dummy");
+
+    msg.PrepareCurrentlyOpen(paxosID, 2, proposalID, pipelinedPaxosID);
+    SendPaxosMessage(msg);
+    msg.PrepareCurrentlyOpen(paxosID, 3, proposalID, 0);
+    SendPaxosMessage(msg);
+
+    // the propose request to this node itself
+    msg.ProposeRequest(paxosID, MY_NODEID, proposalID, REPLICATION_CONFIG->GetRunID(), dummy);
+    SendPaxosMessage(msg);
+    // the following messages are queued until the acceptor's state is committed
+    EventLoop::RunOnce();
+    msg.ProposeAccepted(paxosID, 2, proposalID);
+    SendPaxosMessage(msg);
+    msg.ProposeAccepted(paxosID, 3, proposalID);
+    SendPaxosMessage(msg);
+
+    msg.LearnProposal(paxosID, MY_NODEID, proposalID);
+    SendPaxosMessage(msg);
+}
+
+static bool IsStrictReadServed(ShardQuorumProcessor& processor)
+{
+    ReadBuffer          key("key");
+    ClientRequest*      request;
+    TestClientSession   session;
+    bool                served;
+
+    request = new ClientRequest;
+    request->Get(1, 0, 1, key);
+    request->paxosID = 1;
+    request->session = &session;
+    processor.OnClientRequest(request);
+
+    // served requests wait in the database manager's read queue
+    served = (session.numCompleted == 0);
+    if (!served)
+    {
+        ASSERT(request->response.type == CLIENTRESPONSE_NOSERVICE);
+        delete request;
+    }
+    return served;
+}
+
+TEST_DEFINE(TestShardQuorumProcessorStrictReadAfterFailover)
+{
+    unsigned                i;
+    uint64_t                proposalID;
+    uint64_t                paxosID;
+    ShardServer             shardServer;
+    ShardQuorumProcessor    processor;
+    ConfigState*            configState;
+    ConfigQuorum*           configQuorum;
+    ClusterMessage          lease;
+    SortedList<uint64_t>    shards;
+
+    IOProcessor::Init(1024);
+    EventLoop::Init();
+
+    configFile.SetValue("database.dir", "test/quorumprocessor");
+    configFile.SetIntValue("database.numAsyncGets", 1);
+    shardServer.GetDatabaseManager()->Init(&shardServer);
+    REPLICATION_CONFIG->SetNodeID(1);
+    REPLICATION_CONFIG->SetRunID(1);
+
+    configState = shardServer.GetConfigState();
+    configState->hasMaster = true;
+    configState->masterID = TEST_MASTERID;
+    configQuorum = new ConfigQuorum;
+    configQuorum->quorumID = TEST_QUORUMID;
+    for (i = 1; i <= 3; i++)
+        configQuorum->activeNodes.Add(i);
+    configState->quorums.Append(configQuorum);
+
+    shardServer.GetDatabaseManager()->SetQuorumShards(TEST_QUORUMID);
+    processor.Init(configQuorum, &shardServer);
+
+    // without the lease strict reads are not served
+    TEST_ASSERT(!IsStrictReadServed(processor));
+
+    processor.OnRequestLeaseTimeout();
+    proposalID = REPLICATION_CONFIG->NextProposalID(0);
+    lease.ReceiveLease(MY_NODEID, TEST_QUORUMID, proposalID, 0, PAXOSLEASE_MAX_LEASE_TIME,
+     false, configQuorum->activeNodes, shards);
+    processor.OnReceiveLease(TEST_MASTERID, lease);
+    TEST_ASSERT(processor.IsLeaseValid());
+
+    // the new primary is not the leader until it completes a round
+    TEST_ASSERT(!IsStrictReadServed(processor));
+
+    // the previous primary pipelined values up to two rounds ahead
+    paxosID = processor.GetPaxosID();
+    proposalID = 0;
+    RunPreparedRound(processor, proposalID, paxosID + 2);
+    TEST_ASSERT(processor.GetPaxosID() == paxosID + 1);
+    TEST_ASSERT(!IsStrictReadServed(processor));
+    RunPreparedRound(processor, proposalID, 0);
+    TEST_ASSERT(processor.GetPaxosID() == paxosID + 2);
+    TEST_ASSERT(!IsStrictReadServed(processor));
+    RunPreparedRound(processor, proposalID, 0);
+    TEST_ASSERT(processor.GetPaxosID() == paxosID + 3);
+
+    // the rounds the acceptors reported are learned, reads do not wait for a full window
+    TEST_ASSERT(IsStrictReadServed(processor));
+
+    processor.Shutdown();
+    shardServer.GetDatabaseManager()->Shutdown();
+    EventLoop::Shutdown();
+    IOProcessor::Shutdown();
+
+    return TEST_SUCCESS;
+}
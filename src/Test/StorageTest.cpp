@@ -3,9 +3,21 @@
 #include "Framework/Storage/StorageBulkCursor.h"
 #include "Framework/Storage/StorageEnvironment.h"
 #include "Framework/Storage/StorageAsyncList.h"
+#include "Framework/Storage/StorageShardIndex.h"
+#include "Framework/Storage/StorageDataPage.h"
+#include "Framework/Storage/StoragePageCache.h"
+#include "Framework/Storage/StorageMergeTree.h"
+#include "Framework/Storage/StorageMemoChunk.h"
+#include "Framework/Storage/StorageMemoChunkLister.h"
+#include "Framework/Storage/StorageFileChunk.h"
+#include "Framework/Storage/FDGuard.h"
+#include "Framework/Replication/Quorums/QuorumDatabase.h"
 #include "System/Events/EventLoop.h"
 #include "System/IO/IOProcessor.h"
 #include "System/Stopwatch.h"
+#include "System/Threading/ThreadPool.h"
+#include "System/Threading/Atomic.h"
+#include "System/FileSystem.h"
 #include "System/Config.h"
 
 static StorageConfig    storageConfig;
@@ -176,3 +188,1175 @@ TEST_DEFINE(TestStorageSet)
     
     return TEST_SUCCESS;
 }
+
+static unsigned numGroupCommitCallbacks;
+
+static void OnGroupCommitTestCommit()
+{
+    numGroupCommitCallbacks++;
+}
+
+TEST_DEFINE(TestStorageGroupCommit)
+{
+    StorageEnvironment  env;
+    Buffer              dbPath;
+    Buffer              key;
+    ReadBuffer          empty;
+    Callable            onCommit;
+    uint64_t            numCommits;
+    uint64_t            numGroupCommits;
+    uint64_t            trackID;
+
+    IOProcessor::Init(1024);
+    EventLoop::Init();
+    StartClock();
+    SetupDefaultStorageConfig();
+
+    dbPath.Write("test/groupcommit");
+    env.Open(dbPath, storageConfig);
+
+    numCommits = *Registry::GetUintPtr("storage.commit.numCommits");
+    numGroupCommits = *Registry::GetUintPtr("storage.commit.numGroupCommits");
+
+    // one data shard in each track, and the Paxos and log shards of the quorum, which have
+    // the same range in every track, like quorums on a shard server
+    for (trackID = 1; trackID <= 3; trackID++)
+    {
+        if (env.GetShard(QUORUM_DATABASE_QUORUM_PAXOS_CONTEXT, trackID) == NULL)
+            env.CreateShard(trackID, QUORUM_DATABASE_QUORUM_PAXOS_CONTEXT, trackID, 0,
+             empty, empty, true, STORAGE_SHARD_TYPE_DUMP);
+        if (env.GetShard(QUORUM_DATABASE_QUORUM_LOG_CONTEXT, trackID) == NULL)
+            env.CreateShard(trackID, QUORUM_DATABASE_QUORUM_LOG_CONTEXT, trackID, 0,
+             empty, empty, true, STORAGE_SHARD_TYPE_LOG);
+        if (env.GetShard(1, trackID) == NULL)
+            env.CreateShard(trackID, 1, trackID, 1, empty, empty, false, STORAGE_SHARD_TYPE_STANDARD);
+        key.Writef("%U", trackID);
+        TEST_ASSERT(env.Set(QUORUM_DATABASE_QUORUM_PAXOS_CONTEXT, trackID, key, key));
+        TEST_ASSERT(env.Set(1, trackID, key, key));
+    }
+
+    // the first commit starts immediately, the others are written by one group job
+    numGroupCommitCallbacks = 0;
+    onCommit = CFunc(OnGroupCommitTestCommit);
+    for (trackID = 1; trackID <= 3; trackID++)
+    {
+        TEST_ASSERT(env.Commit(trackID, onCommit));
+        TEST_ASSERT(env.IsCommitting(trackID));
+    }
+
+    while (numGroupCommitCallbacks < 3)
+        EventLoop::RunOnce();
+
+    TEST_ASSERT(*Registry::GetUintPtr("storage.commit.numCommits") == numCommits + 3);
+    TEST_ASSERT(*Registry::GetUintPtr("storage.commit.numGroupCommits") == numGroupCommits + 2);
+    for (trackID = 1; trackID <= 3; trackID++)
+    {
+        TEST_ASSERT(!env.IsCommitting(trackID));
+        TEST_ASSERT(env.GetShard(QUORUM_DATABASE_QUORUM_PAXOS_CONTEXT, trackID)->GetTrackID() == trackID);
+        TEST_ASSERT(env.GetShard(QUORUM_DATABASE_QUORUM_LOG_CONTEXT, trackID)->GetTrackID() == trackID);
+    }
+
+    EventLoop::Shutdown();
+    IOProcessor::Shutdown();
+    env.Close();
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestStorageParallelRecovery)
+{
+    StorageEnvironment* env;
+    Buffer              dbPath;
+    Buffer              key;
+    Buffer              value;
+    ReadBuffer          rbValue;
+    ReadBuffer          empty;
+    uint64_t            shardID;
+    unsigned            i;
+    unsigned            run;
+
+    IOProcessor::Init(1024);
+    EventLoop::Init();
+    StartClock();
+    SetupDefaultStorageConfig();
+
+    // values are unique to this run, so replayed logs of previous runs are not accepted
+    run = (unsigned) Now();
+    dbPath.Write("test/recovery");
+
+    env = new StorageEnvironment;
+    env->Open(dbPath, storageConfig);
+    for (shardID = 1; shardID <= 8; shardID++)
+    {
+        if (env->GetShard(1, shardID) == NULL)
+            env->CreateShard(1, 1, shardID, shardID, empty, empty, true, STORAGE_SHARD_TYPE_STANDARD);
+        for (i = 0; i < 1000; i++)
+        {
+            key.Writef("%U:%u", shardID, i);
+            value.Writef("%u:%u", run, i);
+            TEST_ASSERT(env->Set(1, shardID, key, value));
+            if (i % 10 == 0)
+                TEST_ASSERT(env->Delete(1, shardID, key));
+        }
+    }
+    env->Commit(1);
+    env->Close();
+    delete env;
+
+    // the shards are replayed from the log in parallel partitions
+    env = new StorageEnvironment;
+    env->Open(dbPath, storageConfig);
+    for (shardID = 1; shardID <= 8; shardID++)
+    {
+        for (i = 0; i < 1000; i++)
+        {
+            key.Writef("%U:%u", shardID, i);
+            value.Writef("%u:%u", run, i);
+            if (i % 10 == 0)
+            {
+                TEST_ASSERT(!env->Get(1, shardID, key, rbValue));
+                continue;
+            }
+            TEST_ASSERT(env->Get(1, shardID, key, rbValue));
+            TEST_ASSERT(ReadBuffer::Cmp(rbValue, value) == 0);
+        }
+    }
+    env->Close();
+    delete env;
+
+    EventLoop::Shutdown();
+    IOProcessor::Shutdown();
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestStorageShardIndex)
+{
+    InList<StorageShard>    shards;
+    StorageShardIndex       shardIndex;
+    StorageShard*           shard;
+    StorageShard*           it;
+    StorageShard*           found;
+    Buffer                  firstKey;
+    Buffer                  lastKey;
+    Buffer                  key;
+    ReadBuffer              rbKey;
+    Stopwatch               sw;
+    uint64_t                scanSum;
+    uint64_t                indexSum;
+    unsigned                num;
+    unsigned                numLookups;
+    unsigned                i;
+
+    // Initialization ==============================================================================
+    num = 10*1000;
+    numLookups = 10*1000;
+    for (i = 0; i < num; i++)
+    {
+        shard = new StorageShard;
+        shard->SetContextID(4);
+        shard->SetTableID(1);
+        shard->SetShardID(i + 1);
+        firstKey.Writef("%010u", i * 10);
+        lastKey.Writef("%010u", (i + 1) * 10);
+        shard->SetFirstKey(i == 0 ? ReadBuffer() : ReadBuffer(firstKey));
+        shard->SetLastKey(i == num - 1 ? ReadBuffer() : ReadBuffer(lastKey));
+        shards.Append(shard);
+        shardIndex.Add(shard);
+    }
+    TEST_ASSERT(shardIndex.GetCount() == num);
+
+    // Linear scan =================================================================================
+    scanSum = 0;
+    sw.Start();
+    for (i = 0; i < numLookups; i++)
+    {
+        key.Writef("%010u", (i * 7919) % (num * 10));
+        rbKey.Wrap(key);
+        FOREACH (it, shards)
+        {
+            if (it->GetContextID() == 4 && it->GetTableID() == 1 && it->RangeContains(rbKey))
+            {
+                scanSum += it->GetShardID();
+                break;
+            }
+        }
+    }
+    sw.Stop();
+    TEST_LOG("%u lookups by linear scan over %u shards took %ld msec", numLookups, num, (long) sw.Elapsed());
+
+    // Index lookup ================================================================================
+    indexSum = 0;
+    sw.Reset();
+    sw.Start();
+    for (i = 0; i < numLookups; i++)
+    {
+        key.Writef("%010u", (i * 7919) % (num * 10));
+        rbKey.Wrap(key);
+        found = shardIndex.GetByKey(4, 1, rbKey);
+        TEST_ASSERT(found != NULL);
+        indexSum += found->GetShardID();
+    }
+    sw.Stop();
+    TEST_LOG("%u lookups by shard index over %u shards took %ld msec", numLookups, num, (long) sw.Elapsed());
+    TEST_ASSERT(scanSum == indexSum);
+
+    // Consistency =================================================================================
+    FOREACH (it, shards)
+    {
+        TEST_ASSERT(shardIndex.Get(4, it->GetShardID()) == it);
+        rbKey = it->GetLastKey();
+        TEST_ASSERT(shardIndex.GetByLastKey(4, 1, rbKey) == it);
+    }
+    TEST_ASSERT(shardIndex.Get(4, num + 1) == NULL);
+    TEST_ASSERT(shardIndex.Get(3, 1) == NULL);
+    rbKey.Wrap(key);
+    TEST_ASSERT(shardIndex.GetByKey(4, 2, rbKey) == NULL);
+
+    // Shutdown ====================================================================================
+    shardIndex.Clear();
+    shards.DeleteList();
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestStorageShardIndexSharedRange)
+{
+    StorageShardIndex       shardIndex;
+    StorageShard*           shards[3];
+    ReadBuffer              rbKey;
+    unsigned                i;
+
+    // the Paxos shards of several quorums all have tableID 0 and an unbounded range
+    for (i = 0; i < 3; i++)
+    {
+        shards[i] = new StorageShard;
+        shards[i]->SetContextID(2);
+        shards[i]->SetTableID(0);
+        shards[i]->SetShardID(i + 1);
+        shards[i]->SetFirstKey(ReadBuffer());
+        shards[i]->SetLastKey(ReadBuffer());
+        shardIndex.Add(shards[i]);
+    }
+    TEST_ASSERT(shardIndex.GetCount() == 3);
+
+    for (i = 0; i < 3; i++)
+        TEST_ASSERT(shardIndex.Get(2, i + 1) == shards[i]);
+
+    rbKey.Wrap("key");
+    TEST_ASSERT(shardIndex.GetByKey(2, 0, rbKey) != NULL);
+    rbKey.Reset();
+    TEST_ASSERT(shardIndex.GetByLastKey(2, 0, rbKey) != NULL);
+
+    // removing one of them leaves the others indexed
+    shardIndex.Remove(shards[1]);
+    TEST_ASSERT(shardIndex.GetCount() == 2);
+    TEST_ASSERT(shardIndex.Get(2, 1) == shards[0]);
+    TEST_ASSERT(shardIndex.Get(2, 2) == NULL);
+    TEST_ASSERT(shardIndex.Get(2, 3) == shards[2]);
+    rbKey.Wrap("key");
+    TEST_ASSERT(shardIndex.GetByKey(2, 0, rbKey) == shards[2]);
+
+    shardIndex.Clear();
+    for (i = 0; i < 3; i++)
+        delete shards[i];
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestStorageDataPageCompression)
+{
+    StorageDataPage*        page;
+    StorageDataPage*        readPage;
+    StorageFileKeyValue     kv;
+    StorageFileKeyValue*    it;
+    Buffer                  key;
+    Buffer                  value;
+    Buffer                  serialized;
+    Buffer                  uncompressed;
+    unsigned                num;
+    unsigned                i;
+
+    num = 1000;
+    page = new StorageDataPage(NULL, 0);
+    page->SetCompression(STORAGE_COMPRESSION_LZ);
+    for (i = 0; i < num; i++)
+    {
+        key.Writef("user:%010u", i);
+        value.Writef("{\"name\": \"user %u\", \"email\": \"user%u@example.com\"}", i, i);
+        kv.Set(ReadBuffer(key), ReadBuffer(value));
+        page->Append(&kv);
+    }
+    page->Finalize();
+    page->Serialize(serialized);
+    TEST_LOG("%u keys, page size: %u, compressed size: %u",
+     num, page->GetSize(), page->GetCompressedSize());
+    TEST_ASSERT(serialized.GetLength() == page->GetCompressedSize());
+    TEST_ASSERT(page->GetCompressedSize() < page->GetSize());
+    TEST_ASSERT(page->GetCompressedSize() % STORAGE_DEFAULT_PAGE_GRAN == 0);
+
+    readPage = new StorageDataPage(NULL, 0);
+    readPage->SetCompression(STORAGE_COMPRESSION_LZ);
+    TEST_ASSERT(readPage->Read(serialized));
+    TEST_ASSERT(readPage->GetNumKeys() == num);
+    TEST_ASSERT(readPage->GetSize() == page->GetSize());
+    i = 0;
+    for (it = readPage->First(); it != NULL; it = readPage->Next(it))
+    {
+        key.Writef("user:%010u", i);
+        value.Writef("{\"name\": \"user %u\", \"email\": \"user%u@example.com\"}", i, i);
+        TEST_ASSERT(ReadBuffer::Cmp(it->GetKey(), key) == 0);
+        TEST_ASSERT(ReadBuffer::Cmp(it->GetValue(), value) == 0);
+        i++;
+    }
+    TEST_ASSERT(i == num);
+
+    // corrupt payload must be rejected
+    delete readPage;
+    readPage = new StorageDataPage(NULL, 0);
+    readPage->SetCompression(STORAGE_COMPRESSION_LZ);
+    serialized.GetBuffer()[24] ^= 0x5A;
+    serialized.GetBuffer()[25] ^= 0x5A;
+    TEST_ASSERT(!readPage->Read(serialized) || readPage->GetNumKeys() != num);
+
+    // incompressible data is stored as is
+    delete page;
+    page = new StorageDataPage(NULL, 0);
+    page->SetCompression(STORAGE_COMPRESSION_LZ);
+    key.Write("key");
+    value.Clear();
+    for (i = 0; i < 32*KiB; i++)
+        value.Append((char) RandomInt(0, 255));
+    kv.Set(ReadBuffer(key), ReadBuffer(value));
+    page->Append(&kv);
+    page->Finalize();
+    serialized.Clear();
+    page->Serialize(serialized);
+
+    delete readPage;
+    readPage = new StorageDataPage(NULL, 0);
+    readPage->SetCompression(STORAGE_COMPRESSION_LZ);
+    TEST_ASSERT(readPage->Read(serialized));
+    TEST_ASSERT(readPage->GetNumKeys() == 1);
+    TEST_ASSERT(ReadBuffer::Cmp(readPage->First()->GetValue(), value) == 0);
+
+    delete page;
+    delete readPage;
+
+    return TEST_SUCCESS;
+}
+
+class TestCachePage : public StoragePage
+{
+public:
+    TestCachePage() { loaded = true; }
+
+    uint32_t            GetSize() { return STORAGE_DEFAULT_PAGE_GRAN; }
+    uint32_t            GetMemorySize() { return STORAGE_DEFAULT_PAGE_GRAN; }
+    void                Write(Buffer&) {}
+    void                Unload() { loaded = false; }
+
+    bool                loaded;
+};
+
+TEST_DEFINE(TestStoragePageCacheScanResistance)
+{
+    StorageConfig       config;
+    TestCachePage       metaPages[10];
+    TestCachePage       hotPages[50];
+    TestCachePage       scanPages[500];
+    TestCachePage       newPages[30];
+    unsigned            i;
+
+    config.SetFileChunkCacheSize(100 * STORAGE_DEFAULT_PAGE_GRAN);
+    config.SetMetaPageCacheSize(10 * STORAGE_DEFAULT_PAGE_GRAN);
+    StoragePageCache::Init(config);
+
+    for (i = 0; i < SIZE(metaPages); i++)
+        StoragePageCache::AddMetaPage(&metaPages[i]);
+
+    // point reads, every page is hit after it was loaded
+    for (i = 0; i < SIZE(hotPages); i++)
+        StoragePageCache::AddDataPage(&hotPages[i]);
+    for (i = 0; i < SIZE(hotPages); i++)
+        StoragePageCache::RegisterDataHit(&hotPages[i]);
+
+    // a scan much larger than the cache
+    for (i = 0; i < SIZE(scanPages); i++)
+        StoragePageCache::AddDataPage(&scanPages[i], true);
+
+    TEST_ASSERT(StoragePageCache::GetSize() <= 100 * STORAGE_DEFAULT_PAGE_GRAN);
+    for (i = 0; i < SIZE(metaPages); i++)
+        TEST_ASSERT(metaPages[i].loaded && metaPages[i].IsCached());
+    for (i = 0; i < SIZE(hotPages); i++)
+        TEST_ASSERT(hotPages[i].loaded && hotPages[i].IsCached());
+
+    // pages that are never hit again are evicted first
+    for (i = 0; i < SIZE(newPages); i++)
+        StoragePageCache::AddDataPage(&newPages[i]);
+    TEST_ASSERT(StoragePageCache::GetSize() <= 100 * STORAGE_DEFAULT_PAGE_GRAN);
+    for (i = 0; i < SIZE(newPages); i++)
+        TEST_ASSERT(newPages[i].loaded && newPages[i].IsCached());
+    for (i = 0; i < SIZE(hotPages); i++)
+        TEST_ASSERT(hotPages[i].loaded && hotPages[i].IsCached());
+
+    StoragePageCache::Clear();
+    for (i = 0; i < SIZE(hotPages); i++)
+        TEST_ASSERT(!hotPages[i].loaded && !hotPages[i].IsCached());
+
+    return TEST_SUCCESS;
+}
+
+static StorageFileKeyValue* TestMergeLinearNext(StorageDataPage** pages,
+ StorageFileKeyValue** iterators, unsigned numPages)
+{
+    unsigned                i;
+    unsigned                smallestIndex;
+    StorageFileKeyValue*    smallestKv;
+    int                     cmpres;
+
+    smallestIndex = 0;
+    smallestKv = NULL;
+    for (i = 0; i < numPages; i++)
+    {
+        if (iterators[i] == NULL)
+            continue;
+        if (smallestKv == NULL)
+            cmpres = -1;
+        else
+            cmpres = ReadBuffer::Cmp(iterators[i]->GetKey(), smallestKv->GetKey());
+        if (cmpres <= 0)
+        {
+            if (smallestKv != NULL && cmpres == 0)
+                iterators[smallestIndex] = pages[smallestIndex]->Next(iterators[smallestIndex]);
+            smallestKv = iterators[i];
+            smallestIndex = i;
+        }
+    }
+    if (smallestKv != NULL)
+        iterators[smallestIndex] = pages[smallestIndex]->Next(iterators[smallestIndex]);
+
+    return smallestKv;
+}
+
+static StorageFileKeyValue* TestMergeTreeNext(StorageDataPage** pages,
+ StorageFileKeyValue** iterators, StorageMergeTree& mergeTree)
+{
+    unsigned                i;
+    StorageFileKeyValue*    smallestKv;
+
+    if (mergeTree.IsEmpty())
+        return NULL;
+
+    i = mergeTree.Top();
+    smallestKv = iterators[i];
+    iterators[i] = pages[i]->Next(iterators[i]);
+    mergeTree.UpdateTop();
+    while (!mergeTree.IsEmpty() && mergeTree.CompareTop(smallestKv->GetKeyReference()) == 0)
+    {
+        i = mergeTree.Top();
+        iterators[i] = pages[i]->Next(iterators[i]);
+        mergeTree.UpdateTop();
+    }
+
+    return smallestKv;
+}
+
+TEST_DEFINE(TestStorageMergeTree)
+{
+    StorageDataPage*        pages[64];
+    StorageFileKeyValue*    iterators[64];
+    StorageFileKeyValue*    it;
+    StorageFileKeyValue     kv;
+    StorageMergeTree        mergeTree;
+    Stopwatch               linearWatch;
+    Stopwatch               treeWatch;
+    Buffer                  key;
+    Buffer                  value;
+    unsigned*               latest;
+    unsigned                numKeys;
+    unsigned                keyRange;
+    unsigned                keyGap;
+    unsigned                numPages;
+    unsigned                num;
+    unsigned                i;
+    unsigned                k;
+
+    numKeys = 10000;
+    keyGap = 2 * SIZE(pages);
+    latest = new unsigned[numKeys * keyGap];
+
+    for (numPages = 16; numPages <= SIZE(pages); numPages *= 2)
+    {
+        // every page has about numKeys sorted random keys, on average a key is
+        // in every other page, the value is the index of the page,
+        // so the latest one must win
+        keyRange = numKeys * 2 * numPages;
+        for (i = 0; i < keyRange; i++)
+            latest[i] = numPages;
+        for (k = 0; k < numPages; k++)
+        {
+            pages[k] = new StorageDataPage(NULL, 0);
+            for (i = RandomInt(0, 2 * numPages - 1); i < keyRange; i += RandomInt(1, 4 * numPages - 1))
+            {
+                key.Writef("%010u", i);
+                value.Writef("%u", k);
+                kv.Set(ReadBuffer(key), ReadBuffer(value));
+                pages[k]->Append(&kv);
+                latest[i] = k;
+            }
+            pages[k]->Finalize();
+        }
+
+        linearWatch.Reset();
+        linearWatch.Start();
+        for (k = 0; k < numPages; k++)
+            iterators[k] = pages[k]->First();
+        num = 0;
+        while (TestMergeLinearNext(pages, iterators, numPages) != NULL)
+            num++;
+        linearWatch.Stop();
+
+        treeWatch.Reset();
+        treeWatch.Start();
+        for (k = 0; k < numPages; k++)
+            iterators[k] = pages[k]->First();
+        mergeTree.Init(iterators, numPages);
+        i = 0;
+        while (TestMergeTreeNext(pages, iterators, mergeTree) != NULL)
+            i++;
+        treeWatch.Stop();
+        TEST_ASSERT(i == num);
+
+        // check the order and the winners
+        for (k = 0; k < numPages; k++)
+            iterators[k] = pages[k]->First();
+        mergeTree.Init(iterators, numPages);
+        i = 0;
+        while ((it = TestMergeTreeNext(pages, iterators, mergeTree)) != NULL)
+        {
+            while (latest[i] == numPages)
+                i++;
+            key.Writef("%010u", i);
+            value.Writef("%u", latest[i]);
+            TEST_ASSERT(ReadBuffer::Cmp(it->GetKey(), key) == 0);
+            TEST_ASSERT(ReadBuffer::Cmp(it->GetValue(), value) == 0);
+            i++;
+        }
+        while (i < keyRange && latest[i] == numPages)
+            i++;
+        TEST_ASSERT(i == keyRange);
+
+        // backward direction
+        for (k = 0; k < numPages; k++)
+            iterators[k] = pages[k]->Last();
+        mergeTree.Init(iterators, numPages, false);
+        i = keyRange;
+        while (!mergeTree.IsEmpty())
+        {
+            k = mergeTree.Top();
+            it = iterators[k];
+            iterators[k] = pages[k]->Prev(iterators[k]);
+            mergeTree.UpdateTop();
+            while (!mergeTree.IsEmpty() && mergeTree.CompareTop(it->GetKeyReference()) == 0)
+            {
+                iterators[mergeTree.Top()] = pages[mergeTree.Top()]->Prev(iterators[mergeTree.Top()]);
+                mergeTree.UpdateTop();
+            }
+
+            do i--; while (latest[i] == numPages);
+            key.Writef("%010u", i);
+            value.Writef("%u", latest[i]);
+            TEST_ASSERT(ReadBuffer::Cmp(it->GetKey(), key) == 0);
+            TEST_ASSERT(ReadBuffer::Cmp(it->GetValue(), value) == 0);
+        }
+        while (i > 0 && latest[i - 1] == numPages)
+            i--;
+        TEST_ASSERT(i == 0);
+
+        TEST_LOG("%u chunks, %u merged keys, linear scan: %ld msec, loser tree: %ld msec",
+         numPages, num, (long) linearWatch.Elapsed(), (long) treeWatch.Elapsed());
+
+        for (k = 0; k < numPages; k++)
+            delete pages[k];
+    }
+
+    mergeTree.Clear();
+    delete[] latest;
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestStorageMappedDataPage)
+{
+    StorageDataPage*        page;
+    StorageDataPage*        copyPage;
+    StorageDataPage*        mappedPage;
+    StorageFileKeyValue     kv;
+    StorageFileKeyValue*    it;
+    Buffer                  key;
+    Buffer                  value;
+    Buffer                  serialized;
+    Buffer                  reserialized;
+    char*                   mapped;
+    const char              filename[] = "test/mappeddatapage";
+    FD                      fd;
+    unsigned                num;
+    unsigned                i;
+
+    num = 1000;
+    page = new StorageDataPage(NULL, 0);
+    for (i = 0; i < num; i++)
+    {
+        key.Writef("user:%010u", i);
+        value.Writef("{\"name\": \"user %u\", \"email\": \"user%u@example.com\"}", i, i);
+        kv.Set(ReadBuffer(key), ReadBuffer(value));
+        page->Append(&kv);
+    }
+    page->Finalize();
+    page->Serialize(serialized);
+
+    fd = FS_Open(filename, FS_CREATE | FS_WRITEONLY | FS_TRUNCATE);
+    TEST_ASSERT(fd != INVALID_FD);
+    TEST_ASSERT(FS_FileWrite(fd, serialized.GetBuffer(), serialized.GetLength()) == serialized.GetLength());
+    FS_FileClose(fd);
+
+    fd = FS_Open(filename, FS_READONLY);
+    TEST_ASSERT(fd != INVALID_FD);
+    mapped = FS_MapFile(fd, serialized.GetLength());
+    TEST_ASSERT(mapped != NULL);
+    TEST_ASSERT(FS_AdviseMapping(mapped, serialized.GetLength(), FS_ADVICE_RANDOM));
+
+    copyPage = new StorageDataPage(NULL, 0);
+    TEST_ASSERT(copyPage->Read(serialized));
+    mappedPage = new StorageDataPage(NULL, 0);
+    TEST_ASSERT(mappedPage->ReadMapped(ReadBuffer(mapped, serialized.GetLength())));
+    TEST_ASSERT(mappedPage->IsMapped());
+    TEST_ASSERT(mappedPage->GetNumKeys() == num);
+    TEST_ASSERT(mappedPage->GetSize() == copyPage->GetSize());
+    TEST_LOG("%u keys, page size: %u, memory size copied: %u, mapped: %u",
+     num, mappedPage->GetSize(), copyPage->GetMemorySize(), mappedPage->GetMemorySize());
+    TEST_ASSERT(mappedPage->GetMemorySize() + serialized.GetLength() <= copyPage->GetMemorySize());
+
+    i = 0;
+    for (it = mappedPage->First(); it != NULL; it = mappedPage->Next(it))
+    {
+        key.Writef("user:%010u", i);
+        value.Writef("{\"name\": \"user %u\", \"email\": \"user%u@example.com\"}", i, i);
+        TEST_ASSERT(ReadBuffer::Cmp(it->GetKey(), key) == 0);
+        TEST_ASSERT(ReadBuffer::Cmp(it->GetValue(), value) == 0);
+        // keys and values are not copied
+        TEST_ASSERT(it->GetKey().GetBuffer() >= mapped && it->GetKey().GetBuffer() < mapped + serialized.GetLength());
+        i++;
+    }
+    TEST_ASSERT(i == num);
+
+    mappedPage->Serialize(reserialized);
+    TEST_ASSERT(ReadBuffer::Cmp(ReadBuffer(reserialized), ReadBuffer(serialized)) == 0);
+
+    // a truncated mapping must be rejected
+    delete mappedPage;
+    mappedPage = new StorageDataPage(NULL, 0);
+    TEST_ASSERT(!mappedPage->ReadMapped(ReadBuffer(mapped, serialized.GetLength() / 2)));
+    TEST_ASSERT(!mappedPage->IsMapped());
+
+    delete page;
+    delete copyPage;
+    delete mappedPage;
+    FS_UnmapFile(mapped, serialized.GetLength());
+    FS_FileClose(fd);
+    TEST_ASSERT(FS_Delete(filename));
+
+    return TEST_SUCCESS;
+}
+
+#define MEMO_INDEX_TEST_KEY_LENGTH      15
+#define MEMO_INDEX_TEST_KEY(keys, i)    \
+    ReadBuffer((keys) + (i) * MEMO_INDEX_TEST_KEY_LENGTH, MEMO_INDEX_TEST_KEY_LENGTH)
+
+TEST_DEFINE(TestStorageMemoChunkIndex)
+{
+    StorageMemoChunk*       chunk;
+    StorageMemoChunkLister* lister;
+    StorageFileKeyValue*    it;
+    StorageKeyValue*        kv;
+    Stopwatch               insertWatch;
+    Stopwatch               getWatch;
+    Stopwatch               walkWatch;
+    Buffer                  key;
+    ReadBuffer              empty;
+    ReadBuffer              startKey;
+    char*                   keys;
+    unsigned*               order;
+    unsigned                numKeys;
+    unsigned                i;
+    unsigned                j;
+    unsigned                tmp;
+    unsigned                k;
+
+    // the keys are formatted in advance, only the index is measured
+    numKeys = 1000*1000;
+    keys = new char[numKeys * MEMO_INDEX_TEST_KEY_LENGTH + 1];
+    order = new unsigned[numKeys];
+    for (i = 0; i < numKeys; i++)
+    {
+        snprintf(keys + i * MEMO_INDEX_TEST_KEY_LENGTH, MEMO_INDEX_TEST_KEY_LENGTH + 1, "user:%010u", i);
+        order[i] = i;
+    }
+    for (i = numKeys - 1; i > 0; i--)
+    {
+        j = RandomInt(0, i);
+        tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    for (k = 0; k < 2; k++)
+    {
+        StorageMemoChunk::SetIndexType(k == 0 ? STORAGE_MEMO_INDEX_TREE : STORAGE_MEMO_INDEX_BTREE);
+        chunk = new StorageMemoChunk(1, false);
+
+        insertWatch.Reset();
+        insertWatch.Start();
+        for (i = 0; i < numKeys; i++)
+        {
+            startKey = MEMO_INDEX_TEST_KEY(keys, order[i]);
+            chunk->Set(startKey, startKey);
+        }
+        insertWatch.Stop();
+
+        getWatch.Reset();
+        getWatch.Start();
+        for (i = 0; i < numKeys; i++)
+        {
+            startKey = MEMO_INDEX_TEST_KEY(keys, order[numKeys - 1 - i]);
+            kv = chunk->Get(startKey);
+            TEST_ASSERT(kv != NULL);
+        }
+        getWatch.Stop();
+
+        // the same in-order walk as listing and serialization
+        lister = new StorageMemoChunkLister;
+        walkWatch.Reset();
+        walkWatch.Start();
+        lister->Init(chunk, empty, empty, empty, 0, false, true);
+        walkWatch.Stop();
+
+        TEST_ASSERT(lister->GetNumKeys() == numKeys);
+        i = 0;
+        for (it = lister->First(empty); it != NULL; it = lister->Next(it))
+        {
+            startKey = MEMO_INDEX_TEST_KEY(keys, i);
+            TEST_ASSERT(ReadBuffer::Cmp(it->GetKey(), startKey) == 0);
+            TEST_ASSERT(ReadBuffer::Cmp(it->GetValue(), startKey) == 0);
+            i++;
+        }
+        delete lister;
+
+        // start keys between and beyond the stored keys, in both directions
+        key.Writef("user:%010u!", numKeys / 2);
+        startKey.Wrap(key);
+        lister = new StorageMemoChunkLister;
+        lister->Init(chunk, startKey, empty, empty, 2, true, false);
+        key.Writef("user:%010u", numKeys / 2);
+        TEST_ASSERT(ReadBuffer::Cmp(lister->First(empty)->GetKey(), key) == 0);
+        delete lister;
+
+        key.Writef("user:%010u!", numKeys / 2);
+        startKey.Wrap(key);
+        lister = new StorageMemoChunkLister;
+        lister->Init(chunk, startKey, empty, empty, 2, true, true);
+        key.Writef("user:%010u", numKeys / 2 + 1);
+        TEST_ASSERT(ReadBuffer::Cmp(lister->First(empty)->GetKey(), key) == 0);
+        delete lister;
+
+        key.Writef("user:~");
+        startKey.Wrap(key);
+        lister = new StorageMemoChunkLister;
+        lister->Init(chunk, startKey, empty, empty, 1, true, false);
+        key.Writef("user:%010u", numKeys - 1);
+        TEST_ASSERT(ReadBuffer::Cmp(lister->First(empty)->GetKey(), key) == 0);
+        delete lister;
+
+        TEST_ASSERT(chunk->GetMidpoint().GetLength() > 0);
+
+        TEST_LOG("%s: %u keys, insert: %ld msec, lookup: %ld msec, in-order walk: %ld msec, size: %u MB",
+         k == 0 ? "tree" : "btree", numKeys, (long) insertWatch.Elapsed(), (long) getWatch.Elapsed(),
+         (long) walkWatch.Elapsed(), (unsigned) (chunk->GetSize() / MB));
+
+        delete chunk;
+    }
+
+    // the log storage removes the key-values in ascending order, here from the B+-tree
+    chunk = new StorageMemoChunk(1, false);
+    for (i = 0; i < 10000; i++)
+    {
+        key.Writef("%010u", i);
+        chunk->Set(ReadBuffer(key), ReadBuffer(key));
+    }
+    for (i = 0; i < 10000; i++)
+    {
+        key.Writef("%010u", i);
+        TEST_ASSERT(ReadBuffer::Cmp(chunk->GetFirstKey(), key) == 0);
+        chunk->RemoveFirst();
+    }
+    TEST_ASSERT(chunk->GetFirstKey().GetLength() == 0);
+    delete chunk;
+
+    StorageMemoChunk::SetIndexType(STORAGE_MEMO_INDEX_TREE);
+    delete[] order;
+    delete[] keys;
+
+    return TEST_SUCCESS;
+}
+
+#define MEMO_READ_TEST_NUM_KEYS         100*1000
+#define MEMO_READ_TEST_NUM_READERS      4
+
+static StorageMemoChunk*    memoReadChunk;
+static volatile bool        memoReadStop;
+static volatile unsigned    memoReadErrors;
+static volatile unsigned    memoReadGets;
+static volatile unsigned    memoReadConflicts;
+static volatile unsigned    memoReadLists;
+static volatile unsigned    memoReadListConflicts;
+
+// the values begin with their keys, a torn read shows up as a mismatch
+static bool IsMemoReadValid(ReadBuffer key, ReadBuffer value)
+{
+    return (value.GetLength() > key.GetLength() &&
+     memcmp(value.GetBuffer(), key.GetBuffer(), key.GetLength()) == 0);
+}
+
+static void MemoChunkReader()
+{
+    StorageMemoChunkLister*     lister;
+    StorageFileKeyValue*        it;
+    StorageMemoChunk::ReadResult result;
+    Buffer                      key;
+    Buffer                      prevKey;
+    Buffer                      value;
+    ReadBuffer                  rk;
+    ReadBuffer                  empty;
+    unsigned                    i;
+
+    for (i = 0; !memoReadStop; i++)
+    {
+        key.Writef("user:%010u", RandomInt(0, MEMO_READ_TEST_NUM_KEYS - 1));
+        rk.Wrap(key);
+
+        if (i % 100 != 0)
+        {
+            result = memoReadChunk->ConcurrentGet(rk, value);
+            if (result == StorageMemoChunk::READ_SET && !IsMemoReadValid(rk, ReadBuffer(value)))
+                AtomicIncrement32(memoReadErrors);
+            if (result == StorageMemoChunk::READ_CONFLICT)
+                AtomicIncrement32(memoReadConflicts);
+            AtomicIncrement32(memoReadGets);
+            continue;
+        }
+
+        lister = new StorageMemoChunkLister;
+        if (lister->ConcurrentInit(memoReadChunk, rk, empty, empty, 100, false, true))
+        {
+            prevKey.Clear();
+            for (it = lister->First(empty); it != NULL; it = lister->Next(it))
+            {
+                if (!IsMemoReadValid(it->GetKey(), it->GetValue()) ||
+                 ReadBuffer::Cmp(ReadBuffer(prevKey), it->GetKey()) >= 0)
+                    AtomicIncrement32(memoReadErrors);
+                prevKey.Write(it->GetKey());
+            }
+        }
+        else
+            AtomicIncrement32(memoReadListConflicts);
+        AtomicIncrement32(memoReadLists);
+        delete lister;
+    }
+}
+
+TEST_DEFINE(TestStorageMemoChunkConcurrentReads)
+{
+    ThreadPool*     readers;
+    Stopwatch       sw;
+    Buffer          key;
+    Buffer          value;
+    unsigned        i;
+    unsigned        round;
+    unsigned        numWrites;
+
+    StorageMemoChunk::SetIndexType(STORAGE_MEMO_INDEX_BTREE);
+    memoReadChunk = new StorageMemoChunk(1, false);
+    TEST_ASSERT(memoReadChunk->IsConcurrentReadable());
+    memoReadStop = false;
+
+    // the readers run while the main thread inserts, grows and overwrites the values
+    memoReadChunk->AddReader();
+    readers = ThreadPool::Create(MEMO_READ_TEST_NUM_READERS);
+    for (i = 0; i < MEMO_READ_TEST_NUM_READERS; i++)
+        readers->Execute(CFunc(MemoChunkReader));
+    readers->Start();
+
+    numWrites = 0;
+    sw.Start();
+    for (round = 0; round < 5; round++)
+    {
+        for (i = 0; i < MEMO_READ_TEST_NUM_KEYS; i++)
+        {
+            key.Writef("user:%010u", RandomInt(0, MEMO_READ_TEST_NUM_KEYS - 1));
+            value.Write(key);
+            value.Appendf(":%u:%s", round, round % 2 == 0 ? "" : "some padding to move the value");
+            memoReadChunk->Set(ReadBuffer(key), ReadBuffer(value));
+            numWrites++;
+        }
+    }
+    sw.Stop();
+
+    memoReadStop = true;
+    readers->Stop();
+    delete readers;
+    TEST_ASSERT(memoReadChunk->RemoveReader() == 0);
+
+    TEST_LOG("%u writes in %ld msec, %u gets, %u conflicts, %u lists, %u list conflicts",
+     numWrites, (long) sw.Elapsed(), memoReadGets, memoReadConflicts, memoReadLists,
+     memoReadListConflicts);
+    TEST_ASSERT(memoReadErrors == 0);
+
+    delete memoReadChunk;
+    StorageMemoChunk::SetIndexType(STORAGE_MEMO_INDEX_TREE);
+
+    return TEST_SUCCESS;
+}
+
+static bool CopyFile(const char* src, const char* dst)
+{
+    FDGuard     srcFD;
+    FDGuard     dstFD;
+    Buffer      buffer;
+    int64_t     size;
+
+    if (srcFD.Open(src, FS_READONLY) == INVALID_FD)
+        return false;
+    size = FS_FileSize(srcFD.GetFD());
+    buffer.Allocate(size);
+    if (FS_FileRead(srcFD.GetFD(), buffer.GetBuffer(), size) != size)
+        return false;
+    buffer.SetLength(size);
+
+    if (dstFD.Open(dst, FS_CREATE | FS_WRITEONLY | FS_TRUNCATE) == INVALID_FD)
+        return false;
+    if (FS_FileWrite(dstFD.GetFD(), buffer.GetBuffer(), size) != size)
+        return false;
+    
+    return true;
+}
+
+TEST_DEFINE(TestStorageImportFileChunk)
+{
+    StorageEnvironment* src;
+    StorageEnvironment* dst;
+    StorageFileChunk*   fileChunk;
+    StorageBulkCursor*  cursor;
+    StorageKeyValue*    kv;
+    List<uint64_t>      chunkIDs;
+    Buffer              dbPath;
+    Buffer              filename;
+    Buffer              srcFilename;
+    Buffer              key;
+    Buffer              value;
+    ReadBuffer          rbValue;
+    ReadBuffer          empty;
+    uint64_t            chunkID;
+    unsigned            i;
+    unsigned            run;
+
+    IOProcessor::Init(1024);
+    EventLoop::Init();
+    StartClock();
+    SetupDefaultStorageConfig();
+
+    run = (unsigned) Now();
+    FS_RecDeleteDir("test/import_src");
+    FS_RecDeleteDir("test/import_dst");
+
+    // write a chunk file on the source
+    dbPath.Write("test/import_src");
+    src = new StorageEnvironment;
+    src->Open(dbPath, storageConfig);
+    src->CreateShard(1, 1, 1, 1, empty, empty, true, STORAGE_SHARD_TYPE_STANDARD);
+    for (i = 0; i < 1000; i++)
+    {
+        key.Writef("%u", i);
+        value.Writef("%u:%u", run, i);
+        TEST_ASSERT(src->Set(1, 1, key, value));
+    }
+    src->Commit(1);
+    TEST_ASSERT(src->PushMemoChunk(1, 1));
+    for (i = 0; i < 1000 && chunkIDs.GetLength() == 0; i++)
+    {
+        EventLoop::RunOnce();
+        src->GetWrittenFileChunkIDs(1, 1, chunkIDs);
+    }
+    TEST_ASSERT(chunkIDs.GetLength() == 1);
+    fileChunk = src->GetFileChunk(*chunkIDs.First());
+    TEST_ASSERT(fileChunk != NULL);
+    srcFilename.Write(fileChunk->GetFilename());
+
+    // the file deleter and the page cache are process-wide, so only one environment is open
+    // at a time, the chunk file stays on disk after the source is closed
+    src->Close();
+    delete src;
+
+    // copy it byte-for-byte and add it to an empty shard on the destination
+    dbPath.Write("test/import_dst");
+    dst = new StorageEnvironment;
+    dst->Open(dbPath, storageConfig);
+    dst->CreateShard(1, 1, 1, 1, empty, empty, true, STORAGE_SHARD_TYPE_STANDARD);
+    dst->Commit(1);
+    chunkID = dst->NextChunkID();
+    dst->GetChunkFilename(chunkID, filename);
+    TEST_ASSERT(CopyFile(srcFilename.GetBuffer(), filename.GetBuffer()));
+    TEST_ASSERT(dst->ImportFileChunk(1, 1, chunkID));
+
+    // later writes override the imported values
+    key.Write("0");
+    value.Write("override");
+    TEST_ASSERT(dst->Set(1, 1, key, value));
+    dst->Commit(1);
+
+    for (i = 0; i < 1000; i++)
+    {
+        key.Writef("%u", i);
+        value.Writef("%u:%u", run, i);
+        if (i == 0)
+            value.Write("override");
+        TEST_ASSERT(dst->Get(1, 1, key, rbValue));
+        TEST_ASSERT(ReadBuffer::Cmp(rbValue, value) == 0);
+    }
+
+    // a cursor started after the imported chunk only sees the later writes
+    cursor = dst->GetBulkCursor(1, 1);
+    i = 0;
+    for (kv = cursor->FirstAfter(chunkID); kv != NULL; kv = cursor->Next(kv))
+        i++;
+    delete cursor;
+    TEST_ASSERT(i == 1);
+    dst->Close();
+    delete dst;
+
+    // the imported chunk is part of the shard after recovery
+    dst = new StorageEnvironment;
+    dst->Open(dbPath, storageConfig);
+    for (i = 0; i < 1000; i++)
+    {
+        key.Writef("%u", i);
+        value.Writef("%u:%u", run, i);
+        if (i == 0)
+            value.Write("override");
+        TEST_ASSERT(dst->Get(1, 1, key, rbValue));
+        TEST_ASSERT(ReadBuffer::Cmp(rbValue, value) == 0);
+    }
+    dst->Close();
+    delete dst;
+
+    EventLoop::Shutdown();
+    IOProcessor::Shutdown();
+
+    return TEST_SUCCESS;
+}
+
+TEST_DEFINE(TestStorageSplitShard)
+{
+    StorageEnvironment* env;
+    StorageShard*       shard;
+    StorageBulkCursor*  cursor;
+    StorageKeyValue*    kv;
+    List<uint64_t>      chunkIDs;
+    List<uint64_t>      newChunkIDs;
+    Buffer              dbPath;
+    Buffer              key;
+    Buffer              value;
+    ReadBuffer          rbValue;
+    ReadBuffer          empty;
+    ReadBuffer          splitKey;
+    unsigned            i;
+    unsigned            num;
+
+    IOProcessor::Init(1024);
+    EventLoop::Init();
+    StartClock();
+    SetupDefaultStorageConfig();
+
+    FS_RecDeleteDir("test/split");
+    dbPath.Write("test/split");
+    env = new StorageEnvironment;
+    env->Open(dbPath, storageConfig);
+    env->CreateShard(1, 1, 1, 1, empty, empty, true, STORAGE_SHARD_TYPE_STANDARD);
+    for (i = 0; i < 1000; i++)
+    {
+        key.Writef("%04u", i);
+        value.Writef("%u", i);
+        TEST_ASSERT(env->Set(1, 1, key, value));
+    }
+
+    // split with uncommitted writes, the memo chunk is shared instead of copied
+    splitKey.Wrap("0500");
+    TEST_ASSERT(env->SplitShard(1, 1, 2, splitKey));
+    shard = env->GetShard(1, 2);
+    TEST_ASSERT(shard->GetMemoChunk()->GetSize() == 0);
+    TEST_ASSERT(shard->GetChunks().GetLength() == 1);
+    env->Commit(1);
+
+    for (i = 0; i < 1000; i++)
+    {
+        key.Writef("%04u", i);
+        value.Writef("%u", i);
+        TEST_ASSERT(env->Get(1, i < 500 ? 1 : 2, key, rbValue));
+        TEST_ASSERT(ReadBuffer::Cmp(rbValue, value) == 0);
+        TEST_ASSERT(!env->Get(1, i < 500 ? 2 : 1, key, rbValue));
+    }
+
+    // cursors only return the keys in the shard's range
+    for (i = 1; i <= 2; i++)
+    {
+        cursor = env->GetBulkCursor(1, i);
+        num = 0;
+        for (kv = cursor->First(); kv != NULL; kv = cursor->Next(kv))
+        {
+            TEST_ASSERT(env->GetShard(1, i)->RangeContains(kv->GetKey()));
+            num++;
+        }
+        delete cursor;
+        TEST_ASSERT(num == 500);
+    }
+
+    // the shared chunk is serialized and written in the background
+    for (i = 0; i < 1000 && chunkIDs.GetLength() == 0; i++)
+    {
+        EventLoop::RunOnce();
+        env->GetWrittenFileChunkIDs(1, 1, chunkIDs);
+    }
+    env->GetWrittenFileChunkIDs(1, 2, newChunkIDs);
+    TEST_ASSERT(chunkIDs.GetLength() == 1);
+    TEST_ASSERT(newChunkIDs.GetLength() == 1);
+    TEST_ASSERT(*chunkIDs.First() == *newChunkIDs.First());
+    env->Close();
+    delete env;
+
+    env = new StorageEnvironment;
+    env->Open(dbPath, storageConfig);
+    for (i = 0; i < 1000; i++)
+    {
+        key.Writef("%04u", i);
+        value.Writef("%u", i);
+        TEST_ASSERT(env->Get(1, i < 500 ? 1 : 2, key, rbValue));
+        TEST_ASSERT(ReadBuffer::Cmp(rbValue, value) == 0);
+    }
+    env->Close();
+    delete env;
+
+    EventLoop::Shutdown();
+    IOProcessor::Shutdown();
+
+    return TEST_SUCCESS;
+}
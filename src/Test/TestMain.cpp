@@ -6,6 +6,8 @@ TEST_START(TestMain);
 TEST_LOG_INIT(TEST_LOG_TRACE, LOG_TARGET_STDOUT|LOG_TARGET_FILE);
 TEST_ADD(TestArrayListBasic);
 TEST_ADD(TestArrayListRemove);
+TEST_ADD(TestBloomFilterBlocked);
+TEST_ADD(TestBloomFilterBenchmark);
 TEST_ADD(TestClientAdd);
 TEST_ADD(TestClientBasic);
 TEST_ADD(TestClientBatchedDelete);
@@ -51,6 +53,7 @@ TEST_ADD(TestCommonRandomDistribution);
 TEST_ADD(TestCommonUInt64ToBufferWithBase);
 TEST_ADD(TestConfigStateCopy);
 TEST_ADD(TestConfigStateJSON);
+TEST_ADD(TestConfigStateDelta);
 TEST_ADD(TestEndpointValidity);
 TEST_ADD(TestFileSystemDiskSpace);
 TEST_ADD(TestFileSystemFileSize);
@@ -59,6 +62,11 @@ TEST_ADD(TestFormattingFD);
 TEST_ADD(TestFormattingOverflow);
 TEST_ADD(TestFormattingUnsigned);
 TEST_ADD(TestFormattingPadding);
+TEST_ADD(TestIOProcessorComplete);
+TEST_ADD(TestIOProcessorWritePieces);
+TEST_ADD(TestIOUringWriteSync);
+TEST_ADD(TestIOUringPoll);
+TEST_ADD(TestInLockFreeQueue);
 TEST_ADD(TestInTreeMap);
 TEST_ADD(TestInTreeMapInsert);
 TEST_ADD(TestInTreeMapInsertRandom);
@@ -81,10 +89,34 @@ TEST_ADD(TestLogRotateMultiThreaded);
 TEST_ADD(TestLogTraceBuffer);
 TEST_ADD(TestManualBasic);
 TEST_ADD(TestMemoryOutOfMemoryError);
+TEST_ADD(TestPaxosMessagePipelinedPaxosID);
+TEST_ADD(TestPaxosProposerFailover);
+TEST_ADD(TestPaxosProposerPipeline);
+TEST_ADD(TestPaxosProposerPipelineClearedOnConflict);
 TEST_ADD(TestSafeFormattingBasic);
+TEST_ADD(TestSDBPBinaryRoundTrip);
+TEST_ADD(TestSDBPMultiRoundTrip);
+TEST_ADD(TestSDBPParserBenchmark);
 TEST_ADD(TestShardExtensionBasic);
+TEST_ADD(TestShardMessageBinaryRoundTrip);
+TEST_ADD(TestShardMessageMigrationBatch);
+TEST_ADD(TestShardMessageBenchmark);
+TEST_ADD(TestShardProposedValuesAdopted);
+TEST_ADD(TestShardQuorumProcessorStrictReadAfterFailover);
 TEST_ADD(TestStorageAsyncList);
 TEST_ADD(TestStorageSet);
+TEST_ADD(TestStorageGroupCommit);
+TEST_ADD(TestStorageParallelRecovery);
+TEST_ADD(TestStorageShardIndex);
+TEST_ADD(TestStorageShardIndexSharedRange);
+TEST_ADD(TestStorageDataPageCompression);
+TEST_ADD(TestStoragePageCacheScanResistance);
+TEST_ADD(TestStorageMergeTree);
+TEST_ADD(TestStorageMappedDataPage);
+TEST_ADD(TestStorageMemoChunkIndex);
+TEST_ADD(TestStorageMemoChunkConcurrentReads);
+TEST_ADD(TestStorageImportFileChunk);
+TEST_ADD(TestStorageSplitShard);
 TEST_ADD(TestTimeMultithreadedNow);
 TEST_ADD(TestTimingBasicWrite);
 TEST_ADD(TestTimingSnprintf);